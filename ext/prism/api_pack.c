@@ -172,91 +172,239 @@ pack_encoding_to_ruby(pm_pack_encoding encoding) {
 }
 
 /**
- * call-seq:
- *   Pack::parse(version, variant, source) -> Format
- *
- * Parse the given source and return a format object.
+ * The number of compiled templates that are kept around for Pack::parse and
+ * Pack::parse_all, which tend to be called with the same templates over and
+ * over again by tools that check the templates in a codebase.
  */
-static VALUE
-pack_parse(VALUE self, VALUE version_symbol, VALUE variant_symbol, VALUE format_string) {
+#define PACK_CACHE_CAPACITY 256
+
+/**
+ * The compiled templates that Pack::parse and Pack::parse_all have seen most
+ * recently. It is only accessed while holding the GVL.
+ */
+static pm_pack_cache_t pack_cache;
+
+/**
+ * Check the version and variant arguments that were passed to Pack::parse or
+ * Pack::parse_all, and return the variant.
+ */
+static pm_pack_variant
+pack_variant(VALUE version_symbol, VALUE variant_symbol) {
     if (version_symbol != v3_2_0_symbol) {
         rb_raise(rb_eArgError, "invalid version");
     }
 
-    pm_pack_variant variant;
     if (variant_symbol == pack_symbol) {
-        variant = PM_PACK_VARIANT_PACK;
+        return PM_PACK_VARIANT_PACK;
     } else if (variant_symbol == unpack_symbol) {
-        variant = PM_PACK_VARIANT_UNPACK;
+        return PM_PACK_VARIANT_UNPACK;
     } else {
         rb_raise(rb_eArgError, "invalid variant");
     }
+}
 
-    StringValue(format_string);
+/**
+ * Create the exception that describes the given failure to parse a template.
+ */
+static VALUE
+pack_error(pm_pack_result result) {
+    switch (result) {
+        case PM_PACK_ERROR_UNSUPPORTED_DIRECTIVE:
+            return rb_exc_new_cstr(rb_eArgError, "unsupported directive");
+        case PM_PACK_ERROR_UNKNOWN_DIRECTIVE:
+            return rb_exc_new_cstr(rb_eArgError, "unsupported directive");
+        case PM_PACK_ERROR_LENGTH_TOO_BIG:
+            return rb_exc_new_cstr(rb_eRangeError, "pack length too big");
+        case PM_PACK_ERROR_BANG_NOT_ALLOWED:
+            return rb_exc_new_cstr(rb_eRangeError, "bang not allowed");
+        case PM_PACK_ERROR_DOUBLE_ENDIAN:
+            return rb_exc_new_cstr(rb_eRangeError, "double endian");
+        default:
+            rb_bug("parse result");
+    }
+}
 
+/**
+ * Parse the given template through the cache and return a format object, or
+ * the exception that describes why the template could not be parsed.
+ */
+static VALUE
+pack_format_new(VALUE version_symbol, VALUE variant_symbol, pm_pack_variant variant, VALUE format_string) {
+    // Take a frozen snapshot of the template, since creating the Ruby objects
+    // below can switch threads and another thread could modify the string.
+    format_string = rb_str_new_frozen(StringValue(format_string));
     const char *format = RSTRING_PTR(format_string);
-    const char *format_end = format + RSTRING_LEN(format_string);
-    pm_pack_encoding encoding = PM_PACK_ENCODING_START;
+    const pm_pack_format_t *compiled = pm_pack_cache_fetch(&pack_cache, variant, format, (size_t) RSTRING_LEN(format_string));
 
-    VALUE directives_array = rb_ary_new();
+    if (compiled == NULL) rb_raise(rb_eNoMemError, "failed to allocate memory");
+    if (compiled->result != PM_PACK_OK) return pack_error(compiled->result);
 
-    while (format < format_end) {
-        pm_pack_type type;
-        pm_pack_signed signed_type;
-        pm_pack_endian endian;
-        pm_pack_size size;
-        pm_pack_length_type length_type;
-        uint64_t length;
+    // The compiled format is owned by the cache, and creating the Ruby objects
+    // below can run other threads that evict and free it. So copy out
+    // everything that is needed before calling back into Ruby.
+    size_t size = compiled->size;
+    pm_pack_encoding encoding = compiled->encoding;
 
-        const char *directive_start = format;
+    VALUE directives_buffer;
+    pm_pack_directive_t *directives = ALLOCV_N(pm_pack_directive_t, directives_buffer, size);
+    if (size > 0) memcpy(directives, compiled->directives, size * sizeof(pm_pack_directive_t));
 
-        pm_pack_result parse_result = pm_pack_parse(variant, &format, format_end, &type, &signed_type, &endian,
-                                                    &size, &length_type, &length, &encoding);
+    VALUE directives_array = rb_ary_new_capa((long) size);
 
-        const char *directive_end = format;
-
-        switch (parse_result) {
-            case PM_PACK_OK:
-                break;
-            case PM_PACK_ERROR_UNSUPPORTED_DIRECTIVE:
-                rb_raise(rb_eArgError, "unsupported directive");
-            case PM_PACK_ERROR_UNKNOWN_DIRECTIVE:
-                rb_raise(rb_eArgError, "unsupported directive");
-            case PM_PACK_ERROR_LENGTH_TOO_BIG:
-                rb_raise(rb_eRangeError, "pack length too big");
-            case PM_PACK_ERROR_BANG_NOT_ALLOWED:
-                rb_raise(rb_eRangeError, "bang not allowed");
-            case PM_PACK_ERROR_DOUBLE_ENDIAN:
-                rb_raise(rb_eRangeError, "double endian");
-            default:
-                rb_bug("parse result");
-        }
-
-        if (type == PM_PACK_END) {
-            break;
-        }
+    for (size_t index = 0; index < size; index++) {
+        const pm_pack_directive_t *directive = &directives[index];
 
         VALUE directive_args[9] = {
             version_symbol,
             variant_symbol,
-            rb_usascii_str_new(directive_start, directive_end - directive_start),
-            pack_type_to_symbol(type),
-            pack_signed_to_symbol(signed_type),
-            pack_endian_to_symbol(endian),
-            pack_size_to_symbol(size),
-            pack_length_type_to_symbol(length_type),
-            UINT64T2NUM(length)
+            rb_usascii_str_new(format + directive->start, (long) directive->source_length),
+            pack_type_to_symbol(directive->type),
+            pack_signed_to_symbol(directive->signed_type),
+            pack_endian_to_symbol(directive->endian),
+            pack_size_to_symbol(directive->size),
+            pack_length_type_to_symbol(directive->length_type),
+            UINT64T2NUM(directive->length)
         };
 
         rb_ary_push(directives_array, rb_class_new_instance(9, directive_args, rb_cPrismPackDirective));
     }
 
+    ALLOCV_END(directives_buffer);
+    RB_GC_GUARD(format_string);
+
     VALUE format_args[2];
     format_args[0] = directives_array;
     format_args[1] = pack_encoding_to_ruby(encoding);
     return rb_class_new_instance(2, format_args, rb_cPrismPackFormat);
 }
 
+/**
+ * call-seq:
+ *   Pack::parse(version, variant, source) -> Format
+ *
+ * Parse the given source and return a format object.
+ */
+static VALUE
+pack_parse(VALUE self, VALUE version_symbol, VALUE variant_symbol, VALUE format_string) {
+    pm_pack_variant variant = pack_variant(version_symbol, variant_symbol);
+    VALUE result = pack_format_new(version_symbol, variant_symbol, variant, format_string);
+
+    if (rb_obj_is_kind_of(result, rb_eException)) rb_exc_raise(result);
+    return result;
+}
+
+/**
+ * call-seq:
+ *   Pack::parse_all(version, variant, sources) -> Array
+ *
+ * Parse each of the given sources and return an array with a format object for
+ * each of them. Instead of raising an error for a source that cannot be parsed
+ * like Pack::parse does, the error is returned in its place.
+ */
+static VALUE
+pack_parse_all(VALUE self, VALUE version_symbol, VALUE variant_symbol, VALUE format_strings) {
+    pm_pack_variant variant = pack_variant(version_symbol, variant_symbol);
+    Check_Type(format_strings, T_ARRAY);
+
+    long length = RARRAY_LEN(format_strings);
+    VALUE results = rb_ary_new_capa(length);
+
+    for (long index = 0; index < length; index++) {
+        rb_ary_push(results, pack_format_new(version_symbol, variant_symbol, variant, RARRAY_AREF(format_strings, index)));
+    }
+
+    return results;
+}
+
+/**
+ * Find the entry in the given cache for the given unpack template, or return
+ * NULL if there is none, without changing the order of the entries.
+ */
+static const pm_pack_cache_entry_t *
+pack_cache_debug_find(const pm_pack_cache_t *cache, VALUE source) {
+    size_t length = (size_t) RSTRING_LEN(source);
+
+    for (const pm_pack_cache_entry_t *entry = cache->newest; entry != NULL; entry = entry->older) {
+        if (entry->variant == PM_PACK_VARIANT_UNPACK && entry->source_length == length && memcmp(entry->source, RSTRING_PTR(source), length) == 0) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * call-seq:
+ *   Debug::pack_cache(capacity, sources) -> [Array, Array]
+ *
+ * Fetch each of the given unpack templates in order through a new cache with
+ * the given capacity. Returns whether each fetch found the template already in
+ * the cache, and the templates left in the cache from the most to the least
+ * recently used.
+ */
+static VALUE
+pack_cache_debug(VALUE self, VALUE capacity, VALUE sources) {
+    Check_Type(sources, T_ARRAY);
+    size_t cache_capacity = NUM2SIZET(capacity);
+    long length = RARRAY_LEN(sources);
+
+    for (long index = 0; index < length; index++) {
+        Check_Type(RARRAY_AREF(sources, index), T_STRING);
+    }
+
+    // The results are recorded as plain C values while the cache is in use, so
+    // that nothing can raise until it has been freed.
+    VALUE hits_buffer;
+    bool *hits = ALLOCV_N(bool, hits_buffer, (size_t) length);
+
+    VALUE order_buffer;
+    long *order = ALLOCV_N(long, order_buffer, (size_t) length);
+    long order_size = 0;
+
+    pm_pack_cache_t cache;
+    if (!pm_pack_cache_init(&cache, cache_capacity)) {
+        rb_raise(rb_eNoMemError, "failed to allocate memory");
+    }
+
+    for (long index = 0; index < length; index++) {
+        VALUE source = RARRAY_AREF(sources, index);
+        hits[index] = pack_cache_debug_find(&cache, source) != NULL;
+
+        if (pm_pack_cache_fetch(&cache, PM_PACK_VARIANT_UNPACK, RSTRING_PTR(source), (size_t) RSTRING_LEN(source)) == NULL) {
+            pm_pack_cache_free(&cache);
+            rb_raise(rb_eNoMemError, "failed to allocate memory");
+        }
+    }
+
+    // Record each entry as the index of the last source that it was fetched
+    // with, from the most to the least recently used.
+    for (const pm_pack_cache_entry_t *entry = cache.newest; entry != NULL; entry = entry->older) {
+        for (long index = length - 1; index >= 0; index--) {
+            if (pack_cache_debug_find(&cache, RARRAY_AREF(sources, index)) == entry) {
+                order[order_size++] = index;
+                break;
+            }
+        }
+    }
+
+    pm_pack_cache_free(&cache);
+
+    VALUE hits_array = rb_ary_new_capa(length);
+    for (long index = 0; index < length; index++) {
+        rb_ary_push(hits_array, hits[index] ? Qtrue : Qfalse);
+    }
+
+    VALUE order_array = rb_ary_new_capa(order_size);
+    for (long index = 0; index < order_size; index++) {
+        rb_ary_push(order_array, RARRAY_AREF(sources, order[index]));
+    }
+
+    ALLOCV_END(hits_buffer);
+    ALLOCV_END(order_buffer);
+
+    return rb_assoc_new(hits_array, order_array);
+}
+
 /**
  * The function that gets called when Ruby initializes the prism extension.
  */
@@ -267,6 +415,15 @@ Init_prism_pack(void) {
     rb_cPrismPackDirective = rb_define_class_under(rb_cPrismPack, "Directive", rb_cObject);
     rb_cPrismPackFormat = rb_define_class_under(rb_cPrismPack, "Format", rb_cObject);
     rb_define_singleton_method(rb_cPrismPack, "parse", pack_parse, 3);
+    rb_define_singleton_method(rb_cPrismPack, "parse_all", pack_parse_all, 3);
+
+    // The cache is exposed through the private Debug module for testing.
+    VALUE rb_cPrismDebug = rb_define_module_under(rb_cPrism, "Debug");
+    rb_define_singleton_method(rb_cPrismDebug, "pack_cache", pack_cache_debug, 2);
+
+    if (!pm_pack_cache_init(&pack_cache, PACK_CACHE_CAPACITY)) {
+        rb_raise(rb_eNoMemError, "failed to allocate memory");
+    }
 
     v3_2_0_symbol = ID2SYM(rb_intern("v3_2_0"));
     pack_symbol = ID2SYM(rb_intern("pack"));
@@ -115,6 +115,17 @@ if enable_config("build-debug", ENV["PRISM_BUILD_DEBUG"] || false)
   append_cflags("-DPRISM_BUILD_DEBUG")
 end
 
+# If `--enable-build-stats` is passed to this script or the
+# `PRISM_BUILD_STATS` environment variable is defined, we'll build with the
+# `PRISM_BUILD_STATS` macro defined. This causes the parser to collect counters
+# and timings about each parse, which can be read with `Prism::Debug.stats`.
+# The macro changes the layout of `pm_parser_t`, so libprism.a has to be built
+# with it as well.
+if enable_config("build-stats", ENV["PRISM_BUILD_STATS"] || false)
+  append_cflags("-DPRISM_BUILD_STATS")
+  env["CFLAGS"] = [env["CFLAGS"], "-DPRISM_BUILD_STATS"].compact.join(" ")
+end
+
 # If `--enable-build-minimal` is passed to this script or the
 # `PRISM_BUILD_MINIMAL` environment variable is defined, we'll build with the
 # set of defines that comprise the minimal set. This causes the parser to be
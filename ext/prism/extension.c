@@ -12,6 +12,7 @@ VALUE rb_cPrismNode;
 VALUE rb_cPrismSource;
 VALUE rb_cPrismToken;
 VALUE rb_cPrismLocation;
+VALUE rb_cPrismLazyTree;
 
 VALUE rb_cPrismComment;
 VALUE rb_cPrismInlineComment;
@@ -26,11 +27,15 @@ VALUE rb_cPrismParseLexResult;
 VALUE rb_cPrismDebugEncoding;
 
 ID rb_option_id_command_line;
+ID rb_option_id_delta_locations;
+ID rb_option_id_node_lengths;
 ID rb_option_id_encoding;
 ID rb_option_id_filepath;
 ID rb_option_id_frozen_string_literal;
 ID rb_option_id_line;
+ID rb_option_id_mark_newlines;
 ID rb_option_id_scopes;
+ID rb_option_id_semantics_only;
 ID rb_option_id_version;
 ID rb_prism_source_id_for;
 
@@ -61,15 +66,20 @@ check_string(VALUE value) {
 
 /**
  * Load the contents and size of the given string into the given pm_string_t.
+ * The contents are read out of a frozen copy of the string that is returned, so
+ * that they can't change underneath the parser while the GVL is released. The
+ * caller must keep the returned string alive for as long as the input is used.
  */
-static void
+static VALUE
 input_load_string(pm_string_t *input, VALUE string) {
     // Check if the string is a string. If it's not, then raise a type error.
     if (!RB_TYPE_P(string, T_STRING)) {
         rb_raise(rb_eTypeError, "wrong argument type %"PRIsVALUE" (expected String)", rb_obj_class(string));
     }
 
+    string = rb_str_new_frozen(string);
     pm_string_constant_init(input, RSTRING_PTR(string), RSTRING_LEN(string));
+    return string;
 }
 
 /******************************************************************************/
@@ -127,12 +137,34 @@ build_options_scopes(pm_options_t *options, VALUE scopes) {
     }
 }
 
+/**
+ * Set or clear one of the serialization flags on the given options.
+ */
+static void
+build_options_serialization(pm_options_t *options, uint8_t flag, bool value) {
+    uint8_t serialization = (uint8_t) (options->serialization & ~flag);
+    pm_options_serialization_set(options, value ? (uint8_t) (serialization | flag) : serialization);
+}
+
+/**
+ * We need a struct here to pass through rb_protect and it has to be a single
+ * value. Because the sizeof(VALUE) == sizeof(void *), we're going to pass this
+ * through as an opaque pointer and cast it on both sides. The mark_newlines
+ * field is NULL unless the method accepts the mark_newlines keyword.
+ */
+struct build_options_data {
+    pm_options_t *options;
+    VALUE keywords;
+    bool *mark_newlines;
+};
+
 /**
  * An iterator function that is called for each key-value in the keywords hash.
  */
 static int
 build_options_i(VALUE key, VALUE value, VALUE argument) {
-    pm_options_t *options = (pm_options_t *) argument;
+    struct build_options_data *data = (struct build_options_data *) argument;
+    pm_options_t *options = data->options;
     ID key_id = SYM2ID(key);
 
     if (key_id == rb_option_id_filepath) {
@@ -172,6 +204,14 @@ build_options_i(VALUE key, VALUE value, VALUE argument) {
 
             pm_options_command_line_set(options, command_line);
         }
+    } else if (key_id == rb_option_id_semantics_only) {
+        if (!NIL_P(value)) build_options_serialization(options, PM_OPTIONS_SERIALIZATION_SEMANTICS_ONLY, RTEST(value));
+    } else if (key_id == rb_option_id_delta_locations) {
+        if (!NIL_P(value)) build_options_serialization(options, PM_OPTIONS_SERIALIZATION_DELTA_LOCATIONS, RTEST(value));
+    } else if (key_id == rb_option_id_node_lengths) {
+        if (!NIL_P(value)) build_options_serialization(options, PM_OPTIONS_SERIALIZATION_NODE_LENGTHS, RTEST(value));
+    } else if (key_id == rb_option_id_mark_newlines && data->mark_newlines != NULL) {
+        *data->mark_newlines = RTEST(value);
     } else {
         rb_raise(rb_eArgError, "unknown keyword: %" PRIsVALUE, key);
     }
@@ -179,16 +219,6 @@ build_options_i(VALUE key, VALUE value, VALUE argument) {
     return ST_CONTINUE;
 }
 
-/**
- * We need a struct here to pass through rb_protect and it has to be a single
- * value. Because the sizeof(VALUE) == sizeof(void *), we're going to pass this
- * through as an opaque pointer and cast it on both sides.
- */
-struct build_options_data {
-    pm_options_t *options;
-    VALUE keywords;
-};
-
 /**
  * Build the set of options from the given keywords. Note that this can raise a
  * Ruby error if the options are not valid.
@@ -196,18 +226,19 @@ struct build_options_data {
 static VALUE
 build_options(VALUE argument) {
     struct build_options_data *data = (struct build_options_data *) argument;
-    rb_hash_foreach(data->keywords, build_options_i, (VALUE) data->options);
+    rb_hash_foreach(data->keywords, build_options_i, argument);
     return Qnil;
 }
 
 /**
- * Extract the options from the given keyword arguments.
+ * Extract the options from the given keyword arguments. If mark_newlines is not
+ * NULL, then the mark_newlines keyword is also accepted and stored there.
  */
 static void
-extract_options(pm_options_t *options, VALUE filepath, VALUE keywords) {
+extract_parse_options(pm_options_t *options, VALUE filepath, VALUE keywords, bool *mark_newlines) {
     options->line = 1; // default
     if (!NIL_P(keywords)) {
-        struct build_options_data data = { .options = options, .keywords = keywords };
+        struct build_options_data data = { .options = options, .keywords = keywords, .mark_newlines = mark_newlines };
         struct build_options_data *argument = &data;
 
         int state = 0;
@@ -230,30 +261,50 @@ extract_options(pm_options_t *options, VALUE filepath, VALUE keywords) {
 }
 
 /**
- * Read options for methods that look like (source, **options).
+ * Extract the options from the given keyword arguments.
  */
 static void
-string_options(int argc, VALUE *argv, pm_string_t *input, pm_options_t *options) {
+extract_options(pm_options_t *options, VALUE filepath, VALUE keywords) {
+    extract_parse_options(options, filepath, keywords, NULL);
+}
+
+/**
+ * Read options for methods that look like (source, **options), which may also
+ * accept the mark_newlines keyword (see extract_parse_options). Returns the
+ * string that backs the input, which the caller must keep alive.
+ */
+static VALUE
+string_parse_options(int argc, VALUE *argv, pm_string_t *input, pm_options_t *options, bool *mark_newlines) {
     VALUE string;
     VALUE keywords;
     rb_scan_args(argc, argv, "1:", &string, &keywords);
 
-    extract_options(options, Qnil, keywords);
-    input_load_string(input, string);
+    extract_parse_options(options, Qnil, keywords, mark_newlines);
+    return input_load_string(input, string);
 }
 
 /**
- * Read options for methods that look like (filepath, **options).
+ * Read options for methods that look like (source, **options). Returns the
+ * string that backs the input, which the caller must keep alive.
+ */
+static VALUE
+string_options(int argc, VALUE *argv, pm_string_t *input, pm_options_t *options) {
+    return string_parse_options(argc, argv, input, options, NULL);
+}
+
+/**
+ * Read options for methods that look like (filepath, **options), which may also
+ * accept the mark_newlines keyword (see extract_parse_options).
  */
 static void
-file_options(int argc, VALUE *argv, pm_string_t *input, pm_options_t *options) {
+file_parse_options(int argc, VALUE *argv, pm_string_t *input, pm_options_t *options, bool *mark_newlines) {
     VALUE filepath;
     VALUE keywords;
     rb_scan_args(argc, argv, "1:", &filepath, &keywords);
 
     Check_Type(filepath, T_STRING);
 
-    extract_options(options, filepath, keywords);
+    extract_parse_options(options, filepath, keywords, mark_newlines);
 
     const char * string_source = (const char *) pm_string_source(&options->filepath);
 
@@ -270,6 +321,96 @@ file_options(int argc, VALUE *argv, pm_string_t *input, pm_options_t *options) {
     }
 }
 
+/**
+ * Read options for methods that look like (filepath, **options).
+ */
+static void
+file_options(int argc, VALUE *argv, pm_string_t *input, pm_options_t *options) {
+    file_parse_options(argc, argv, input, options, NULL);
+}
+
+/******************************************************************************/
+/* Parsing without the GVL                                                    */
+/******************************************************************************/
+
+/**
+ * Releasing and reacquiring the GVL has a fixed cost that outweighs the benefit
+ * for small sources, which parse in a few microseconds. Sources shorter than
+ * this many bytes are parsed while holding the GVL.
+ */
+#define PARSE_WITHOUT_GVL_MINIMUM_SIZE 4096
+
+/**
+ * Returns true if the source that the given parser has been initialized with is
+ * large enough to be worth releasing the GVL to parse.
+ */
+static inline bool
+parse_without_gvl_p(const pm_parser_t *parser) {
+    return (parser->end - parser->start) >= PARSE_WITHOUT_GVL_MINIMUM_SIZE;
+}
+
+/**
+ * Parse the source that the given parser has been initialized with. This is
+ * called without holding the GVL, so it must not touch any Ruby objects.
+ */
+static void *
+parse_without_gvl_func(void *argument) {
+    return pm_parse((pm_parser_t *) argument);
+}
+
+/**
+ * Parse the source that the given parser has been initialized with, releasing
+ * the GVL for the duration of the parse so that other Ruby threads can run in
+ * the meantime. The parser itself never touches Ruby objects, so this is safe as
+ * long as the source can't change, no callbacks that call back into Ruby have
+ * been registered on the parser, and no other thread can use the same parser in
+ * the meantime. Parsers that outlive a single call, like the one wrapped by
+ * Prism::ReusableParser, have to be marked as in use for that reason.
+ */
+static pm_node_t *
+parse_without_gvl(pm_parser_t *parser) {
+    if (!parse_without_gvl_p(parser)) return pm_parse(parser);
+    return (pm_node_t *) rb_thread_call_without_gvl(parse_without_gvl_func, parser, NULL, NULL);
+}
+
+/**
+ * The arguments that are passed through to lex_without_gvl_func.
+ */
+typedef struct {
+    /** The parser that has been initialized with the source to lex. */
+    pm_parser_t *parser;
+
+    /** The callback that the tokens are handed to. */
+    const pm_lex_tokens_callback_t *callback;
+} lex_without_gvl_t;
+
+/**
+ * Lex the source that the given parser has been initialized with. This is
+ * called without holding the GVL, so it must not touch any Ruby objects.
+ */
+static void *
+lex_without_gvl_func(void *argument) {
+    lex_without_gvl_t *arguments = (lex_without_gvl_t *) argument;
+    pm_lex(arguments->parser, arguments->callback);
+    return NULL;
+}
+
+/**
+ * Lex the source that the given parser has been initialized with, releasing
+ * the GVL in the same way as parse_without_gvl. The callback must not touch any
+ * Ruby objects.
+ */
+static void
+lex_without_gvl(pm_parser_t *parser, const pm_lex_tokens_callback_t *callback) {
+    lex_without_gvl_t arguments = { .parser = parser, .callback = callback };
+
+    if (parse_without_gvl_p(parser)) {
+        rb_thread_call_without_gvl(lex_without_gvl_func, &arguments, NULL, NULL);
+    } else {
+        lex_without_gvl_func(&arguments);
+    }
+}
+
 #ifndef PRISM_EXCLUDE_SERIALIZATION
 
 /******************************************************************************/
@@ -277,10 +418,33 @@ file_options(int argc, VALUE *argv, pm_string_t *input, pm_options_t *options) {
 /******************************************************************************/
 
 /**
- * Dump the AST corresponding to the given input to a string.
+ * The arguments that are passed through to dump_input_without_gvl.
+ */
+typedef struct {
+    /** The parser that has been initialized with the source to dump. */
+    pm_parser_t *parser;
+
+    /** The buffer that the serialized tree is written into. */
+    pm_buffer_t *buffer;
+} dump_input_data_t;
+
+/**
+ * Parse and serialize the source. This is called without holding the GVL, so it
+ * must not touch any Ruby objects.
+ */
+static void *
+dump_input_without_gvl(void *argument) {
+    dump_input_data_t *data = (dump_input_data_t *) argument;
+    pm_serialize(data->parser, pm_parse(data->parser), data->buffer);
+    return NULL;
+}
+
+/**
+ * Dump the AST corresponding to the given input to a string. If cache is true,
+ * then the trailer that pm_serialize_parse_cache writes is appended as well.
  */
 static VALUE
-dump_input(pm_string_t *input, const pm_options_t *options) {
+dump_input(pm_string_t *input, const pm_options_t *options, bool cache) {
     pm_buffer_t buffer;
     if (!pm_buffer_init(&buffer)) {
         rb_raise(rb_eNoMemError, "failed to allocate memory");
@@ -289,13 +453,22 @@ dump_input(pm_string_t *input, const pm_options_t *options) {
     pm_parser_t parser;
     pm_parser_init(&parser, pm_string_source(input), pm_string_length(input), options);
 
-    pm_node_t *node = pm_parse(&parser);
-    pm_serialize(&parser, node, &buffer);
+    pm_arena_t arena = { 0 };
+    pm_parser_arena_set(&parser, &arena);
+
+    dump_input_data_t data = { .parser = &parser, .buffer = &buffer };
+    if (parse_without_gvl_p(&parser)) {
+        rb_thread_call_without_gvl(dump_input_without_gvl, &data, NULL, NULL);
+    } else {
+        dump_input_without_gvl(&data);
+    }
+
+    if (cache) pm_serialize_cache_trailer(&buffer, pm_string_source(input), pm_string_length(input), options);
 
     VALUE result = rb_str_new(pm_buffer_value(&buffer), pm_buffer_length(&buffer));
-    pm_node_destroy(&parser, node);
     pm_buffer_free(&buffer);
     pm_parser_free(&parser);
+    pm_arena_free(&arena);
 
     return result;
 }
@@ -305,13 +478,26 @@ dump_input(pm_string_t *input, const pm_options_t *options) {
  *   Prism::dump(source, **options) -> String
  *
  * Dump the AST corresponding to the given string to a string. For supported
- * options, see Prism::parse.
+ * options, see Prism::parse. In addition, this supports:
+ *
+ * * `delta_locations` - whether or not to serialize the location of each node
+ *       and its location fields as a delta from the start of the node that
+ *       contains it. This makes the output smaller, and it can still be read
+ *       back with Prism::load. This should be a boolean or nil.
+ * * `node_lengths` - whether or not to prefix every node with the length of
+ *       its serialized form, so that a reader can skip over any subtree. This
+ *       is required by Prism::Serialize.load_lazy. This should be a boolean or
+ *       nil.
+ * * `semantics_only` - whether or not to leave the location fields of each
+ *       node and the comments out of the serialized output. This makes the
+ *       output much smaller for consumers that do not need them, but it cannot
+ *       be read back with Prism::load. This should be a boolean or nil.
  */
 static VALUE
 dump(int argc, VALUE *argv, VALUE self) {
     pm_string_t input;
     pm_options_t options = { 0 };
-    string_options(argc, argv, &input, &options);
+    VALUE string = string_options(argc, argv, &input, &options);
 
 #ifdef PRISM_BUILD_DEBUG
     size_t length = pm_string_length(&input);
@@ -320,12 +506,13 @@ dump(int argc, VALUE *argv, VALUE self) {
     pm_string_constant_init(&input, dup, length);
 #endif
 
-    VALUE value = dump_input(&input, &options);
+    VALUE value = dump_input(&input, &options, false);
 
 #ifdef PRISM_BUILD_DEBUG
     xfree(dup);
 #endif
 
+    RB_GC_GUARD(string);
     pm_string_free(&input);
     pm_options_free(&options);
 
@@ -337,7 +524,7 @@ dump(int argc, VALUE *argv, VALUE self) {
  *   Prism::dump_file(filepath, **options) -> String
  *
  * Dump the AST corresponding to the given file to a string. For supported
- * options, see Prism::parse.
+ * options, see Prism::dump.
  */
 static VALUE
 dump_file(int argc, VALUE *argv, VALUE self) {
@@ -346,13 +533,74 @@ dump_file(int argc, VALUE *argv, VALUE self) {
 
     file_options(argc, argv, &input, &options);
 
-    VALUE value = dump_input(&input, &options);
+    VALUE value = dump_input(&input, &options, false);
+    pm_string_free(&input);
+    pm_options_free(&options);
+
+    return value;
+}
+
+/**
+ * call-seq:
+ *   Prism::dump_cache(source, **options) -> String
+ *
+ * Dump the AST corresponding to the given string to a string that can be
+ * stored and reused for later parses of the same source with the same options.
+ * This is the output of Prism::dump followed by a trailer that identifies the
+ * source and the options, and it can be read back with Prism::load as-is. Use
+ * Prism::cache_valid? to check that it still matches before reusing it. For
+ * supported options, see Prism::dump.
+ */
+static VALUE
+dump_cache(int argc, VALUE *argv, VALUE self) {
+    pm_string_t input;
+    pm_options_t options = { 0 };
+    VALUE string = string_options(argc, argv, &input, &options);
+
+    VALUE value = dump_input(&input, &options, true);
+    RB_GC_GUARD(string);
     pm_string_free(&input);
     pm_options_free(&options);
 
     return value;
 }
 
+/**
+ * call-seq:
+ *   Prism::cache_valid?(cache, source, **options) -> bool
+ *
+ * Returns true if the given string, which was returned by Prism::dump_cache,
+ * was written by this version of prism for the given source and options.
+ */
+static VALUE
+cache_valid_p(int argc, VALUE *argv, VALUE self) {
+    VALUE cache;
+    VALUE string;
+    VALUE keywords;
+    rb_scan_args(argc, argv, "2:", &cache, &string, &keywords);
+    StringValue(cache);
+
+    pm_string_t input;
+    pm_options_t options = { 0 };
+    extract_options(&options, Qnil, keywords);
+    VALUE source = input_load_string(&input, string);
+
+    bool valid = pm_serialize_cache_options_valid_p(
+        (const uint8_t *) RSTRING_PTR(cache),
+        (size_t) RSTRING_LEN(cache),
+        pm_string_source(&input),
+        pm_string_length(&input),
+        &options
+    );
+
+    RB_GC_GUARD(cache);
+    RB_GC_GUARD(source);
+    pm_string_free(&input);
+    pm_options_free(&options);
+
+    return valid ? Qtrue : Qfalse;
+}
+
 #endif
 
 /******************************************************************************/
@@ -367,15 +615,9 @@ parser_comments(pm_parser_t *parser, VALUE source) {
     VALUE comments = rb_ary_new();
 
     for (pm_comment_t *comment = (pm_comment_t *) parser->comment_list.head; comment != NULL; comment = (pm_comment_t *) comment->node.next) {
-        VALUE location_argv[] = {
-            source,
-            LONG2FIX(comment->location.start - parser->start),
-            LONG2FIX(comment->location.end - comment->location.start)
-        };
-
         VALUE type = (comment->type == PM_COMMENT_EMBDOC) ? rb_cPrismEmbDocComment : rb_cPrismInlineComment;
-        VALUE comment_argv[] = { rb_class_new_instance(3, location_argv, rb_cPrismLocation) };
-        rb_ary_push(comments, rb_class_new_instance(1, comment_argv, type));
+        VALUE comment_argv[] = { source, pm_location_new(parser, comment->location.start, comment->location.end) };
+        rb_ary_push(comments, rb_class_new_instance(2, comment_argv, type));
     }
 
     return comments;
@@ -537,55 +779,36 @@ parse_result_create(VALUE class, pm_parser_t *parser, VALUE value, rb_encoding *
 /******************************************************************************/
 
 /**
- * This struct gets stored in the parser and passed in to the lex callback any
- * time a new token is found. We use it to store the necessary information to
- * initialize a Token instance.
+ * This struct gets passed in to the lex callbacks any time new tokens are
+ * found. Lexing happens without the GVL, so the tokens are accumulated in C and
+ * only turned into Token instances once parsing is done.
  */
 typedef struct {
-    VALUE source;
-    VALUE tokens;
-    rb_encoding *encoding;
+    /** The buffer of pm_lex_token_t structs that have been found so far. */
+    pm_buffer_t tokens;
 } parse_lex_data_t;
 
 /**
- * This is passed as a callback to the parser. It gets called every time a new
- * token is found. Once found, we initialize a new instance of Token and push it
- * onto the tokens array.
+ * This is passed as a callback to the parser when the nodes are also being
+ * returned. It gets called every time a new token is found, and records the
+ * token so that a Token instance can be created for it afterward.
  */
 static void
 parse_lex_token(void *data, pm_parser_t *parser, pm_token_t *token) {
-    parse_lex_data_t *parse_lex_data = (parse_lex_data_t *) parser->lex_callback->data;
-
-    VALUE yields = rb_ary_new_capa(2);
-    rb_ary_push(yields, pm_token_new(parser, token, parse_lex_data->encoding, parse_lex_data->source));
-    rb_ary_push(yields, INT2FIX(parser->lex_state));
-
-    rb_ary_push(parse_lex_data->tokens, yields);
+    parse_lex_data_t *parse_lex_data = (parse_lex_data_t *) data;
+    pm_lex_token_t entry = { .token = *token, .lex_state = parser->lex_state };
+    pm_buffer_append_string(&parse_lex_data->tokens, (const char *) &entry, sizeof(pm_lex_token_t));
 }
 
 /**
- * This is called whenever the encoding changes based on the magic comment at
- * the top of the file. We use it to update the encoding that we are using to
- * create tokens.
+ * This is passed as a callback to pm_lex when only the tokens are being
+ * returned. It gets called with each batch of tokens that are found, and
+ * records them so that Token instances can be created for them afterward.
  */
 static void
-parse_lex_encoding_changed_callback(pm_parser_t *parser) {
-    parse_lex_data_t *parse_lex_data = (parse_lex_data_t *) parser->lex_callback->data;
-    parse_lex_data->encoding = rb_enc_find(parser->encoding->name);
-
-    // Since the encoding changed, we need to go back and change the encoding of
-    // the tokens that were already lexed. This is only going to end up being
-    // one or two tokens, since the encoding can only change at the top of the
-    // file.
-    VALUE tokens = parse_lex_data->tokens;
-    for (long index = 0; index < RARRAY_LEN(tokens); index++) {
-        VALUE yields = rb_ary_entry(tokens, index);
-        VALUE token = rb_ary_entry(yields, 0);
-
-        VALUE value = rb_ivar_get(token, rb_intern("@value"));
-        rb_enc_associate(value, parse_lex_data->encoding);
-        ENC_CODERANGE_CLEAR(value);
-    }
+parse_lex_tokens(void *data, PRISM_ATTRIBUTE_UNUSED pm_parser_t *parser, const pm_lex_token_t *tokens, size_t size) {
+    parse_lex_data_t *parse_lex_data = (parse_lex_data_t *) data;
+    pm_buffer_append_string(&parse_lex_data->tokens, (const char *) tokens, size * sizeof(pm_lex_token_t));
 }
 
 /**
@@ -596,50 +819,71 @@ static VALUE
 parse_lex_input(pm_string_t *input, const pm_options_t *options, bool return_nodes) {
     pm_parser_t parser;
     pm_parser_init(&parser, pm_string_source(input), pm_string_length(input), options);
-    pm_parser_register_encoding_changed_callback(&parser, parse_lex_encoding_changed_callback);
 
-    VALUE source_string = rb_str_new((const char *) pm_string_source(input), pm_string_length(input));
-    VALUE offsets = rb_ary_new();
-    VALUE source = rb_funcall(rb_cPrismSource, rb_prism_source_id_for, 3, source_string, LONG2NUM(parser.start_line), offsets);
+    pm_arena_t arena = { 0 };
+    pm_parser_arena_set(&parser, &arena);
 
-    parse_lex_data_t parse_lex_data = {
-        .source = source,
-        .tokens = rb_ary_new(),
-        .encoding = rb_utf8_encoding()
-    };
+    parse_lex_data_t parse_lex_data = { .tokens = { 0 } };
+    const pm_encoding_t *initial_encoding = parser.encoding;
 
-    parse_lex_data_t *data = &parse_lex_data;
-    pm_lex_callback_t lex_callback = (pm_lex_callback_t) {
-        .data = (void *) data,
-        .callback = parse_lex_token,
-    };
+    pm_node_t *node = NULL;
+    if (return_nodes) {
+        pm_lex_callback_t lex_callback = (pm_lex_callback_t) {
+            .data = (void *) &parse_lex_data,
+            .callback = parse_lex_token,
+        };
 
-    parser.lex_callback = &lex_callback;
-    pm_node_t *node = pm_parse(&parser);
+        parser.lex_callback = &lex_callback;
+        node = parse_without_gvl(&parser);
+        parser.lex_callback = NULL;
+    } else {
+        pm_lex_tokens_callback_t lex_callback = (pm_lex_tokens_callback_t) {
+            .data = (void *) &parse_lex_data,
+            .callback = parse_lex_tokens,
+        };
+
+        lex_without_gvl(&parser, &lex_callback);
+    }
 
-    // Here we need to update the Source object to have the correct
-    // encoding for the source string and the correct newline offsets.
-    // We do it here because we've already created the Source object and given
-    // it over to all of the tokens, and both of these are only set after pm_parse().
+    // Tokens are created with UTF-8 unless a magic comment changed the
+    // encoding, in which case they are all created with the new encoding.
     rb_encoding *encoding = rb_enc_find(parser.encoding->name);
-    rb_enc_associate(source_string, encoding);
+    rb_encoding *token_encoding = (parser.encoding != initial_encoding) ? encoding : rb_utf8_encoding();
+
+    VALUE source_string = rb_enc_str_new((const char *) pm_string_source(input), pm_string_length(input), encoding);
+    VALUE offsets = rb_ary_new_capa((long) parser.newline_list.size);
 
     for (size_t index = 0; index < parser.newline_list.size; index++) {
         rb_ary_push(offsets, ULONG2NUM(parser.newline_list.offsets[index]));
     }
 
+    VALUE source = rb_funcall(rb_cPrismSource, rb_prism_source_id_for, 3, source_string, LONG2NUM(parser.start_line), offsets);
+
+    const pm_lex_token_t *entries = (const pm_lex_token_t *) pm_buffer_value(&parse_lex_data.tokens);
+    size_t entries_size = pm_buffer_length(&parse_lex_data.tokens) / sizeof(pm_lex_token_t);
+    VALUE tokens = rb_ary_new_capa((long) entries_size);
+
+    for (size_t index = 0; index < entries_size; index++) {
+        VALUE yields = rb_ary_new_capa(2);
+        rb_ary_push(yields, pm_token_new(&parser, &entries[index].token, token_encoding, source));
+        rb_ary_push(yields, INT2FIX(entries[index].lex_state));
+        rb_ary_push(tokens, yields);
+    }
+
+    pm_buffer_free(&parse_lex_data.tokens);
+
     VALUE value;
     if (return_nodes) {
         value = rb_ary_new_capa(2);
-        rb_ary_push(value, pm_ast_new(&parser, node, parse_lex_data.encoding, source));
-        rb_ary_push(value, parse_lex_data.tokens);
+        rb_ary_push(value, pm_ast_new(&parser, node, token_encoding, source, Qnil));
+        rb_ary_push(value, tokens);
     } else {
-        value = parse_lex_data.tokens;
+        value = tokens;
     }
 
-    VALUE result = parse_result_create(rb_cPrismParseLexResult, &parser, value, parse_lex_data.encoding, source);
-    pm_node_destroy(&parser, node);
+    VALUE result = parse_result_create(rb_cPrismParseLexResult, &parser, value, token_encoding, source);
     pm_parser_free(&parser);
+    pm_arena_free(&arena);
 
     return result;
 }
@@ -655,9 +899,10 @@ static VALUE
 lex(int argc, VALUE *argv, VALUE self) {
     pm_string_t input;
     pm_options_t options = { 0 };
-    string_options(argc, argv, &input, &options);
+    VALUE string = string_options(argc, argv, &input, &options);
 
     VALUE result = parse_lex_input(&input, &options, false);
+    RB_GC_GUARD(string);
     pm_string_free(&input);
     pm_options_free(&options);
 
@@ -689,23 +934,57 @@ lex_file(int argc, VALUE *argv, VALUE self) {
 /* Parsing Ruby code                                                          */
 /******************************************************************************/
 
+/**
+ * Find the nodes that ParseResult#mark_newlines! will mark, if they were asked
+ * for with the mark_newlines keyword. Returns the array that pm_ast_new should
+ * collect them into, or nil if they should not be collected.
+ */
+static VALUE
+parse_result_newline_nodes(const pm_parser_t *parser, pm_node_t *node, bool mark_newlines) {
+    return (mark_newlines && pm_node_mark_newlines(parser, node)) ? rb_ary_new() : Qnil;
+}
+
+/**
+ * Build a ParseResult instance out of the given parser and the tree that it has
+ * already parsed.
+ */
+static VALUE
+parse_result_build(pm_parser_t *parser, pm_node_t *node, bool mark_newlines) {
+    rb_encoding *encoding = rb_enc_find(parser->encoding->name);
+
+    VALUE source = pm_source_new(parser, encoding);
+    VALUE newline_nodes = parse_result_newline_nodes(parser, node, mark_newlines);
+    VALUE value = pm_ast_new(parser, node, encoding, source, newline_nodes);
+
+    VALUE result = parse_result_create(rb_cPrismParseResult, parser, value, encoding, source);
+    if (!NIL_P(newline_nodes)) rb_ivar_set(result, rb_intern("@newline_nodes"), newline_nodes);
+    return result;
+}
+
+/**
+ * Parse the source that the given parser has been initialized with and return a
+ * ParseResult instance.
+ */
+static VALUE
+parse_parser(pm_parser_t *parser, bool mark_newlines) {
+    return parse_result_build(parser, parse_without_gvl(parser), mark_newlines);
+}
+
 /**
  * Parse the given input and return a ParseResult instance.
  */
 static VALUE
-parse_input(pm_string_t *input, const pm_options_t *options) {
+parse_input(pm_string_t *input, const pm_options_t *options, bool mark_newlines) {
     pm_parser_t parser;
     pm_parser_init(&parser, pm_string_source(input), pm_string_length(input), options);
 
-    pm_node_t *node = pm_parse(&parser);
-    rb_encoding *encoding = rb_enc_find(parser.encoding->name);
+    pm_arena_t arena = { 0 };
+    pm_parser_arena_set(&parser, &arena);
 
-    VALUE source = pm_source_new(&parser, encoding);
-    VALUE value = pm_ast_new(&parser, node, encoding, source);
-    VALUE result = parse_result_create(rb_cPrismParseResult, &parser, value, encoding, source) ;
+    VALUE result = parse_parser(&parser, mark_newlines);
 
-    pm_node_destroy(&parser, node);
     pm_parser_free(&parser);
+    pm_arena_free(&arena);
 
     return result;
 }
@@ -728,6 +1007,11 @@ parse_input(pm_string_t *input, const pm_options_t *options) {
  *       has been set. This should be a boolean or nil.
  * * `line` - the line number that the parse starts on. This should be an
  *       integer or nil. Note that this is 1-indexed.
+ * * `mark_newlines` - whether or not to find the nodes that
+ *       ParseResult#mark_newlines! marks while the tree is being built, which
+ *       makes that method much faster. This should be a boolean or nil. It is
+ *       only accepted by Prism::parse, Prism::parse_file, and
+ *       Prism::parse_stream.
  * * `scopes` - the locals that are in scope surrounding the code that is being
  *       parsed. This should be an array of arrays of symbols or nil. Scopes are
  *       ordered from the outermost scope to the innermost one.
@@ -741,7 +1025,8 @@ static VALUE
 parse(int argc, VALUE *argv, VALUE self) {
     pm_string_t input;
     pm_options_t options = { 0 };
-    string_options(argc, argv, &input, &options);
+    bool mark_newlines = false;
+    VALUE string = string_parse_options(argc, argv, &input, &options, &mark_newlines);
 
 #ifdef PRISM_BUILD_DEBUG
     size_t length = pm_string_length(&input);
@@ -750,12 +1035,13 @@ parse(int argc, VALUE *argv, VALUE self) {
     pm_string_constant_init(&input, dup, length);
 #endif
 
-    VALUE value = parse_input(&input, &options);
+    VALUE value = parse_input(&input, &options, mark_newlines);
 
 #ifdef PRISM_BUILD_DEBUG
     xfree(dup);
 #endif
 
+    RB_GC_GUARD(string);
     pm_string_free(&input);
     pm_options_free(&options);
     return value;
@@ -796,7 +1082,8 @@ parse_stream(int argc, VALUE *argv, VALUE self) {
     rb_scan_args(argc, argv, "1:", &stream, &keywords);
 
     pm_options_t options = { 0 };
-    extract_options(&options, Qnil, keywords);
+    bool mark_newlines = false;
+    extract_parse_options(&options, Qnil, keywords, &mark_newlines);
 
     pm_parser_t parser;
     pm_buffer_t buffer;
@@ -805,8 +1092,11 @@ parse_stream(int argc, VALUE *argv, VALUE self) {
     rb_encoding *encoding = rb_enc_find(parser.encoding->name);
 
     VALUE source = pm_source_new(&parser, encoding);
-    VALUE value = pm_ast_new(&parser, node, encoding, source);
+    VALUE newline_nodes = parse_result_newline_nodes(&parser, node, mark_newlines);
+    VALUE value = pm_ast_new(&parser, node, encoding, source, newline_nodes);
+
     VALUE result = parse_result_create(rb_cPrismParseResult, &parser, value, encoding, source);
+    if (!NIL_P(newline_nodes)) rb_ivar_set(result, rb_intern("@newline_nodes"), newline_nodes);
 
     pm_node_destroy(&parser, node);
     pm_buffer_free(&buffer);
@@ -826,10 +1116,11 @@ static VALUE
 parse_file(int argc, VALUE *argv, VALUE self) {
     pm_string_t input;
     pm_options_t options = { 0 };
+    bool mark_newlines = false;
 
-    file_options(argc, argv, &input, &options);
+    file_parse_options(argc, argv, &input, &options, &mark_newlines);
 
-    VALUE value = parse_input(&input, &options);
+    VALUE value = parse_input(&input, &options, mark_newlines);
     pm_string_free(&input);
     pm_options_free(&options);
 
@@ -837,99 +1128,310 @@ parse_file(int argc, VALUE *argv, VALUE self) {
 }
 
 /**
- * Parse the given input and return an array of Comment objects.
+ * Parse the given input with the parser of a new Prism::LazyTree instance,
+ * which is returned along with the root of the tree. The tree takes ownership
+ * of the input and the options, along with the Ruby string that the input
+ * points into (if there is one).
  */
 static VALUE
-parse_input_comments(pm_string_t *input, const pm_options_t *options) {
-    pm_parser_t parser;
-    pm_parser_init(&parser, pm_string_source(input), pm_string_length(input), options);
+parse_lazy_tree(pm_string_t *input, pm_options_t *options, VALUE string, pm_lazy_tree_t **result, pm_node_t **node) {
+    pm_lazy_tree_t *tree;
+    VALUE lazy = pm_lazy_tree_new(&tree);
+
+    tree->input = *input;
+    tree->options = *options;
+    tree->strings = rb_ary_new_capa(2);
+    if (!NIL_P(string)) rb_ary_push(tree->strings, string);
+
+    // The filepath points into a Ruby string that can change or be collected
+    // before the tree is, so it is replaced with a copy that the tree retains.
+    if (pm_string_length(&tree->options.filepath) > 0) {
+        pm_string_t *filepath = &tree->options.filepath;
+        VALUE copy = rb_obj_freeze(rb_str_new((const char *) pm_string_source(filepath), (long) pm_string_length(filepath)));
+
+        rb_ary_push(tree->strings, copy);
+        pm_string_constant_init(filepath, RSTRING_PTR(copy), RSTRING_LEN(copy));
+    }
 
-    pm_node_t *node = pm_parse(&parser);
-    rb_encoding *encoding = rb_enc_find(parser.encoding->name);
+    pm_parser_init(&tree->parser, pm_string_source(&tree->input), pm_string_length(&tree->input), &tree->options);
+    pm_parser_arena_set(&tree->parser, &tree->arena);
+    tree->initialized = true;
 
-    VALUE source = pm_source_new(&parser, encoding);
-    VALUE comments = parser_comments(&parser, source);
+    *node = parse_without_gvl(&tree->parser);
+    *result = tree;
+    return lazy;
+}
 
-    pm_node_destroy(&parser, node);
-    pm_parser_free(&parser);
+/**
+ * Parse the given input and return a ParseResult instance whose nodes are
+ * created as they are accessed. This takes ownership of the input and options.
+ */
+static VALUE
+parse_lazy_input(pm_string_t *input, pm_options_t *options, VALUE string) {
+    pm_lazy_tree_t *tree;
+    pm_node_t *node;
+    VALUE lazy = parse_lazy_tree(input, options, string, &tree, &node);
 
-    return comments;
+    pm_parser_t *parser = &tree->parser;
+    rb_encoding *encoding = rb_enc_find(parser->encoding->name);
+
+    VALUE source = pm_source_new(parser, encoding);
+    VALUE value = pm_lazy_ast_new(lazy, node, encoding, source);
+    VALUE result = parse_result_create(rb_cPrismParseResult, parser, value, encoding, source);
+
+    RB_GC_GUARD(lazy);
+    return result;
 }
 
 /**
  * call-seq:
- *   Prism::parse_comments(source, **options) -> Array
+ *   Prism::parse_lazy(source, **options) -> ParseResult
  *
- * Parse the given string and return an array of Comment objects. For supported
- * options, see Prism::parse.
+ * Parse the given string and return a ParseResult instance, the same as
+ * Prism::parse. The difference is that only the root node is created up front.
+ * Each child node is created from the retained C tree the first time that it
+ * is accessed, which is much cheaper when only a fraction of the tree is ever
+ * looked at. For supported options, see Prism::parse.
  */
 static VALUE
-parse_comments(int argc, VALUE *argv, VALUE self) {
+parse_lazy(int argc, VALUE *argv, VALUE self) {
     pm_string_t input;
     pm_options_t options = { 0 };
-    string_options(argc, argv, &input, &options);
-
-    VALUE result = parse_input_comments(&input, &options);
-    pm_string_free(&input);
-    pm_options_free(&options);
+    VALUE string = string_options(argc, argv, &input, &options);
 
-    return result;
+    return parse_lazy_input(&input, &options, string);
 }
 
 /**
  * call-seq:
- *   Prism::parse_file_comments(filepath, **options) -> Array
+ *   Prism::parse_file_lazy(filepath, **options) -> ParseResult
  *
- * Parse the given file and return an array of Comment objects. For supported
- * options, see Prism::parse.
+ * Parse the given file and return a ParseResult instance whose nodes are
+ * created as they are accessed. For more details, see Prism::parse_lazy.
  */
 static VALUE
-parse_file_comments(int argc, VALUE *argv, VALUE self) {
+parse_file_lazy(int argc, VALUE *argv, VALUE self) {
     pm_string_t input;
     pm_options_t options = { 0 };
-
     file_options(argc, argv, &input, &options);
 
-    VALUE value = parse_input_comments(&input, &options);
-    pm_string_free(&input);
-    pm_options_free(&options);
+    return parse_lazy_input(&input, &options, Qnil);
+}
 
-    return value;
+/**
+ * Parse the given input and return the nodes in its tree that match the given
+ * compiled pattern. This takes ownership of the input and options.
+ */
+static VALUE
+scan_lazy_input(VALUE pattern, pm_string_t *input, pm_options_t *options, VALUE string) {
+    pm_lazy_tree_t *tree;
+    pm_node_t *node;
+    VALUE lazy = parse_lazy_tree(input, options, string, &tree, &node);
+
+    rb_encoding *encoding = rb_enc_find(tree->parser.encoding->name);
+    VALUE source = pm_source_new(&tree->parser, encoding);
+    VALUE result = pm_lazy_pattern_scan(lazy, node, encoding, source, pattern);
+
+    RB_GC_GUARD(lazy);
+    return result;
 }
 
 /**
  * call-seq:
- *   Prism::parse_lex(source, **options) -> ParseResult
- *
- * Parse the given string and return a ParseResult instance that contains a
- * 2-element array, where the first element is the AST and the second element is
- * an array of Token instances.
+ *   LazyTree::scan(pattern, source, **options) -> Array
  *
- * This API is only meant to be used in the case where you need both the AST and
- * the tokens. If you only need one or the other, use either Prism::parse or
- * Prism::lex.
- *
- * For supported options, see Prism::parse.
+ * Parse the given string and return the nodes that match the given pattern, as
+ * compiled by Prism::Pattern. The pattern is matched against the C tree, so
+ * only the nodes that match are created as Ruby objects. For supported options,
+ * see Prism::parse.
  */
 static VALUE
-parse_lex(int argc, VALUE *argv, VALUE self) {
+lazy_tree_scan(int argc, VALUE *argv, VALUE self) {
+    rb_check_arity(argc, 2, 3);
+
     pm_string_t input;
     pm_options_t options = { 0 };
-    string_options(argc, argv, &input, &options);
+    VALUE string = string_options(argc - 1, argv + 1, &input, &options);
 
-    VALUE value = parse_lex_input(&input, &options, true);
-    pm_string_free(&input);
-    pm_options_free(&options);
-
-    return value;
+    return scan_lazy_input(argv[0], &input, &options, string);
 }
 
 /**
  * call-seq:
- *   Prism::parse_lex_file(filepath, **options) -> ParseResult
+ *   LazyTree::scan_file(pattern, filepath, **options) -> Array
  *
- * Parse the given file and return a ParseResult instance that contains a
- * 2-element array, where the first element is the AST and the second element is
+ * Parse the given file and return the nodes that match the given pattern. For
+ * more details, see LazyTree::scan.
+ */
+static VALUE
+lazy_tree_scan_file(int argc, VALUE *argv, VALUE self) {
+    rb_check_arity(argc, 2, 3);
+
+    pm_string_t input;
+    pm_options_t options = { 0 };
+    file_options(argc - 1, argv + 1, &input, &options);
+
+    return scan_lazy_input(argv[0], &input, &options, Qnil);
+}
+
+/**
+ * Parse the given input and yield the nodes in its tree that fire any of the
+ * given events. This takes ownership of the input and options.
+ */
+static VALUE
+dispatch_lazy_input(VALUE events, pm_string_t *input, pm_options_t *options, VALUE string) {
+    pm_lazy_tree_t *tree;
+    pm_node_t *node;
+    VALUE lazy = parse_lazy_tree(input, options, string, &tree, &node);
+
+    rb_encoding *encoding = rb_enc_find(tree->parser.encoding->name);
+    VALUE source = pm_source_new(&tree->parser, encoding);
+    pm_lazy_dispatch(lazy, node, encoding, source, events);
+
+    RB_GC_GUARD(lazy);
+    return Qnil;
+}
+
+/**
+ * call-seq:
+ *   LazyTree::dispatch(events, source, **options) { |node, event| ... } -> nil
+ *
+ * Parse the given string and walk its tree depth-first, yielding each node
+ * along with each of the given Prism::Dispatcher events that it fires, in the
+ * same order as Prism::Dispatcher#dispatch. The tree is walked in C, so only
+ * the yielded nodes are created as Ruby objects. For supported options, see
+ * Prism::parse.
+ */
+static VALUE
+lazy_tree_dispatch(int argc, VALUE *argv, VALUE self) {
+    rb_check_arity(argc, 2, 3);
+    VALUE events = rb_ary_to_ary(argv[0]);
+
+    pm_string_t input;
+    pm_options_t options = { 0 };
+    VALUE string = string_options(argc - 1, argv + 1, &input, &options);
+
+    return dispatch_lazy_input(events, &input, &options, string);
+}
+
+/**
+ * call-seq:
+ *   LazyTree::dispatch_file(events, filepath, **options) { |node, event| ... } -> nil
+ *
+ * Parse the given file and yield the nodes in its tree that fire any of the
+ * given events. For more details, see LazyTree::dispatch.
+ */
+static VALUE
+lazy_tree_dispatch_file(int argc, VALUE *argv, VALUE self) {
+    rb_check_arity(argc, 2, 3);
+    VALUE events = rb_ary_to_ary(argv[0]);
+
+    pm_string_t input;
+    pm_options_t options = { 0 };
+    file_options(argc - 1, argv + 1, &input, &options);
+
+    return dispatch_lazy_input(events, &input, &options, Qnil);
+}
+
+/**
+ * Parse the given input and return an array of Comment objects.
+ */
+static VALUE
+parse_input_comments(pm_string_t *input, const pm_options_t *options) {
+    pm_parser_t parser;
+    pm_parser_init(&parser, pm_string_source(input), pm_string_length(input), options);
+
+    pm_arena_t arena = { 0 };
+    pm_parser_arena_set(&parser, &arena);
+
+    parse_without_gvl(&parser);
+    rb_encoding *encoding = rb_enc_find(parser.encoding->name);
+
+    VALUE source = pm_source_new(&parser, encoding);
+    VALUE comments = parser_comments(&parser, source);
+
+    pm_parser_free(&parser);
+    pm_arena_free(&arena);
+
+    return comments;
+}
+
+/**
+ * call-seq:
+ *   Prism::parse_comments(source, **options) -> Array
+ *
+ * Parse the given string and return an array of Comment objects. For supported
+ * options, see Prism::parse.
+ */
+static VALUE
+parse_comments(int argc, VALUE *argv, VALUE self) {
+    pm_string_t input;
+    pm_options_t options = { 0 };
+    VALUE string = string_options(argc, argv, &input, &options);
+
+    VALUE result = parse_input_comments(&input, &options);
+    RB_GC_GUARD(string);
+    pm_string_free(&input);
+    pm_options_free(&options);
+
+    return result;
+}
+
+/**
+ * call-seq:
+ *   Prism::parse_file_comments(filepath, **options) -> Array
+ *
+ * Parse the given file and return an array of Comment objects. For supported
+ * options, see Prism::parse.
+ */
+static VALUE
+parse_file_comments(int argc, VALUE *argv, VALUE self) {
+    pm_string_t input;
+    pm_options_t options = { 0 };
+
+    file_options(argc, argv, &input, &options);
+
+    VALUE value = parse_input_comments(&input, &options);
+    pm_string_free(&input);
+    pm_options_free(&options);
+
+    return value;
+}
+
+/**
+ * call-seq:
+ *   Prism::parse_lex(source, **options) -> ParseResult
+ *
+ * Parse the given string and return a ParseResult instance that contains a
+ * 2-element array, where the first element is the AST and the second element is
+ * an array of Token instances.
+ *
+ * This API is only meant to be used in the case where you need both the AST and
+ * the tokens. If you only need one or the other, use either Prism::parse or
+ * Prism::lex.
+ *
+ * For supported options, see Prism::parse.
+ */
+static VALUE
+parse_lex(int argc, VALUE *argv, VALUE self) {
+    pm_string_t input;
+    pm_options_t options = { 0 };
+    VALUE string = string_options(argc, argv, &input, &options);
+
+    VALUE value = parse_lex_input(&input, &options, true);
+    RB_GC_GUARD(string);
+    pm_string_free(&input);
+    pm_options_free(&options);
+
+    return value;
+}
+
+/**
+ * call-seq:
+ *   Prism::parse_lex_file(filepath, **options) -> ParseResult
+ *
+ * Parse the given file and return a ParseResult instance that contains a
+ * 2-element array, where the first element is the AST and the second element is
  * an array of Token instances.
  *
  * This API is only meant to be used in the case where you need both the AST and
@@ -952,86 +1454,655 @@ parse_lex_file(int argc, VALUE *argv, VALUE self) {
     return value;
 }
 
-/**
- * Parse the given input and return true if it parses without errors.
- */
-static VALUE
-parse_input_success_p(pm_string_t *input, const pm_options_t *options) {
-    pm_parser_t parser;
-    pm_parser_init(&parser, pm_string_source(input), pm_string_length(input), options);
+/**
+ * Parse the given input and return true if it parses without errors.
+ */
+static VALUE
+parse_input_success_p(pm_string_t *input, const pm_options_t *options) {
+    pm_parser_t parser;
+    pm_parser_init(&parser, pm_string_source(input), pm_string_length(input), options);
+
+    pm_arena_t arena = { 0 };
+    pm_parser_arena_set(&parser, &arena);
+
+    // Only the result is returned, so there is no need to keep parsing once
+    // the first error has been found.
+    parser.stop_at_first_error = true;
+    parse_without_gvl(&parser);
+
+    VALUE result = parser.error_list.size == 0 ? Qtrue : Qfalse;
+    pm_parser_free(&parser);
+    pm_arena_free(&arena);
+
+    return result;
+}
+
+/**
+ * call-seq:
+ *   Prism::parse_success?(source, **options) -> bool
+ *
+ * Parse the given string and return true if it parses without errors. For
+ * supported options, see Prism::parse.
+ */
+static VALUE
+parse_success_p(int argc, VALUE *argv, VALUE self) {
+    pm_string_t input;
+    pm_options_t options = { 0 };
+    VALUE string = string_options(argc, argv, &input, &options);
+
+    VALUE result = parse_input_success_p(&input, &options);
+    RB_GC_GUARD(string);
+    pm_string_free(&input);
+    pm_options_free(&options);
+
+    return result;
+}
+
+/**
+ * call-seq:
+ *   Prism::parse_failure?(source, **options) -> bool
+ *
+ * Parse the given string and return true if it parses with errors. For
+ * supported options, see Prism::parse.
+ */
+static VALUE
+parse_failure_p(int argc, VALUE *argv, VALUE self) {
+    return RTEST(parse_success_p(argc, argv, self)) ? Qfalse : Qtrue;
+}
+
+/**
+ * call-seq:
+ *   Prism::parse_file_success?(filepath, **options) -> bool
+ *
+ * Parse the given file and return true if it parses without errors. For
+ * supported options, see Prism::parse.
+ */
+static VALUE
+parse_file_success_p(int argc, VALUE *argv, VALUE self) {
+    pm_string_t input;
+    pm_options_t options = { 0 };
+
+    file_options(argc, argv, &input, &options);
+
+    VALUE result = parse_input_success_p(&input, &options);
+    pm_string_free(&input);
+    pm_options_free(&options);
+
+    return result;
+}
+
+/**
+ * call-seq:
+ *   Prism::parse_file_failure?(filepath, **options) -> bool
+ *
+ * Parse the given file and return true if it parses with errors. For
+ * supported options, see Prism::parse.
+ */
+static VALUE
+parse_file_failure_p(int argc, VALUE *argv, VALUE self) {
+    return RTEST(parse_file_success_p(argc, argv, self)) ? Qfalse : Qtrue;
+}
+
+/******************************************************************************/
+/* Reusable parsers                                                           */
+/******************************************************************************/
+
+/**
+ * The data that is wrapped by a Prism::ReusableParser instance. The parser and
+ * the arena are kept alive between calls so that their memory can be reused.
+ */
+typedef struct {
+    /** The parser that is reset for each new parse. */
+    pm_parser_t parser;
+
+    /** The arena that the syntax tree is allocated from. */
+    pm_arena_t arena;
+
+    /** Whether or not the parser has been initialized yet. */
+    bool initialized;
+
+    /**
+     * Whether or not a call is currently using the parser. Building the parse
+     * result calls back into Ruby and large sources are parsed without the
+     * GVL, so another thread can get a chance to enter the same instance
+     * before the first call is done with the parser.
+     */
+    bool in_use;
+} parser_data_t;
+
+/**
+ * Free the memory held by the parser and arena within the given parser data.
+ */
+static void
+parser_data_clear(parser_data_t *parser_data) {
+    if (parser_data->initialized) pm_parser_free(&parser_data->parser);
+    pm_arena_free(&parser_data->arena);
+    parser_data->initialized = false;
+}
+
+/**
+ * Free the memory associated with a Prism::ReusableParser instance.
+ */
+static void
+parser_data_free(void *data) {
+    parser_data_t *parser_data = (parser_data_t *) data;
+    parser_data_clear(parser_data);
+    xfree(parser_data);
+}
+
+/**
+ * Return the amount of memory retained by a Prism::ReusableParser instance.
+ */
+static size_t
+parser_data_memsize(const void *data) {
+    const parser_data_t *parser_data = (const parser_data_t *) data;
+    return sizeof(parser_data_t) + pm_arena_memsize(&parser_data->arena);
+}
+
+/**
+ * The type information for Prism::ReusableParser instances.
+ */
+static const rb_data_type_t parser_data_type = {
+    .wrap_struct_name = "Prism::ReusableParser",
+    .function = {
+        .dmark = NULL,
+        .dfree = parser_data_free,
+        .dsize = parser_data_memsize,
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+/**
+ * Allocate a new Prism::ReusableParser instance.
+ */
+static VALUE
+reusable_parser_allocate(VALUE klass) {
+    parser_data_t *parser_data;
+    return TypedData_Make_Struct(klass, parser_data_t, &parser_data_type, parser_data);
+}
+
+/**
+ * Prepare the given parser data to parse the given input. The first time this
+ * is called the parser is initialized, and every time after that it is reset so
+ * that its memory is reused.
+ */
+static pm_parser_t *
+parser_data_prepare(parser_data_t *parser_data, const pm_string_t *input, const pm_options_t *options) {
+    pm_parser_t *parser = &parser_data->parser;
+    const uint8_t *source = pm_string_source(input);
+    size_t length = pm_string_length(input);
+
+    if (parser_data->initialized) {
+        pm_parser_reset(parser, source, length, options);
+    } else {
+        pm_parser_init(parser, source, length, options);
+        pm_parser_arena_set(parser, &parser_data->arena);
+        parser_data->initialized = true;
+    }
+
+    return parser;
+}
+
+/**
+ * The state of a single call to Prism::ReusableParser#parse or
+ * Prism::ReusableParser#parse_file.
+ */
+typedef struct {
+    /** The data wrapped by the instance that is being called. */
+    parser_data_t *parser_data;
+
+    /** The source to parse. */
+    pm_string_t input;
+
+    /** The options to parse with. */
+    pm_options_t options;
+} reusable_parser_call_t;
+
+/**
+ * Parse the source of the given call with the parser of its instance.
+ */
+static VALUE
+reusable_parser_call_parse(VALUE argument) {
+    reusable_parser_call_t *call = (reusable_parser_call_t *) argument;
+    return parse_parser(parser_data_prepare(call->parser_data, &call->input, &call->options), false);
+}
+
+/**
+ * Release the instance of the given call for use by other calls, and free the
+ * memory that the call allocated.
+ */
+static VALUE
+reusable_parser_call_release(VALUE argument) {
+    reusable_parser_call_t *call = (reusable_parser_call_t *) argument;
+    call->parser_data->in_use = false;
+    pm_string_free(&call->input);
+    pm_options_free(&call->options);
+    return Qnil;
+}
+
+/**
+ * Parse the source of the given call with the parser wrapped by the given
+ * Prism::ReusableParser instance. The instance is marked as in use for the
+ * duration of the call, and a ThreadError is raised if it is already in use.
+ */
+static VALUE
+reusable_parser_call(VALUE self, reusable_parser_call_t *call) {
+    parser_data_t *parser_data;
+    TypedData_Get_Struct(self, parser_data_t, &parser_data_type, parser_data);
+
+    if (parser_data->in_use) {
+        pm_string_free(&call->input);
+        pm_options_free(&call->options);
+        rb_raise(rb_eThreadError, "Prism::ReusableParser is already in use by another call");
+    }
+
+    parser_data->in_use = true;
+    call->parser_data = parser_data;
+    return rb_ensure(reusable_parser_call_parse, (VALUE) call, reusable_parser_call_release, (VALUE) call);
+}
+
+/**
+ * call-seq:
+ *   ReusableParser#parse(source, **options) -> ParseResult
+ *
+ * Parse the given string and return a ParseResult instance. This is the same as
+ * Prism::parse, except that the memory the parser allocates is retained by this
+ * object and reused across calls, which makes it well-suited to parsing many
+ * files in a row. For supported options, see Prism::parse.
+ *
+ * An instance can only parse one source at a time. Calling this while another
+ * thread is parsing with the same instance raises a ThreadError, so each
+ * thread should use its own instance.
+ */
+static VALUE
+reusable_parser_parse(int argc, VALUE *argv, VALUE self) {
+    reusable_parser_call_t call = { 0 };
+    VALUE string = string_options(argc, argv, &call.input, &call.options);
+
+    VALUE value = reusable_parser_call(self, &call);
+    RB_GC_GUARD(string);
+
+    return value;
+}
+
+/**
+ * call-seq:
+ *   ReusableParser#parse_file(filepath, **options) -> ParseResult
+ *
+ * Parse the given file and return a ParseResult instance, reusing the memory
+ * retained by this object. For supported options, see Prism::parse.
+ */
+static VALUE
+reusable_parser_parse_file(int argc, VALUE *argv, VALUE self) {
+    reusable_parser_call_t call = { 0 };
+    file_options(argc, argv, &call.input, &call.options);
+
+    return reusable_parser_call(self, &call);
+}
+
+/******************************************************************************/
+/* Parsing many files in parallel                                             */
+/******************************************************************************/
+
+/**
+ * The state that is shared between all of the threads that are parsing a batch
+ * of files.
+ */
+typedef struct {
+    /** The array of frozen file paths that are being parsed. */
+    VALUE filepaths;
+
+    /** The array of parse results, in the same order as the file paths. */
+    VALUE results;
+
+    /** The options to parse with, which are only ever read by the workers. */
+    const pm_options_t *options;
+
+    /**
+     * The index of the next file path to parse. This is only read or written
+     * while holding the GVL, so it does not need to be synchronized.
+     */
+    long index;
+
+    /** The error number of the first file that could not be read, or 0. */
+    int error;
+
+    /** The file path that could not be read, if there was an error. */
+    VALUE error_filepath;
+} parse_files_data_t;
+
+/**
+ * The state that is owned by a single thread that is parsing files.
+ */
+typedef struct {
+    /** The state that is shared with the rest of the threads. */
+    parse_files_data_t *data;
+
+    /** The parser that is reused for every file this thread parses. */
+    parser_data_t parser_data;
+} parse_files_worker_t;
+
+/**
+ * A single file that is being parsed by a worker, which is passed to the part of
+ * the parse that runs without the GVL.
+ */
+typedef struct {
+    /** The parser data owned by the worker that is parsing this file. */
+    parser_data_t *parser_data;
+
+    /** The options for this file, which includes its file path. */
+    pm_options_t options;
+
+    /** The contents of the file. */
+    pm_string_t input;
+
+    /** The root of the tree once the file has been parsed. */
+    pm_node_t *node;
+
+    /** The error number if the file could not be read, otherwise 0. */
+    int error;
+} parse_files_job_t;
+
+/**
+ * Read and parse a single file. This runs without holding the GVL, so it must
+ * not touch any Ruby objects.
+ */
+static void *
+parse_files_job_parse(void *argument) {
+    parse_files_job_t *job = (parse_files_job_t *) argument;
+    const char *filepath = (const char *) pm_string_source(&job->options.filepath);
+
+    if (!pm_string_mapped_init(&job->input, filepath)) {
+#ifdef _WIN32
+        job->error = rb_w32_map_errno(GetLastError());
+#else
+        job->error = errno;
+#endif
+        return NULL;
+    }
+
+    pm_parser_t *parser = parser_data_prepare(job->parser_data, &job->input, &job->options);
+    job->node = pm_parse(parser);
+
+    return NULL;
+}
+
+/**
+ * Build the parse result for a file that has been parsed. This holds the GVL.
+ */
+static VALUE
+parse_files_job_build(VALUE argument) {
+    parse_files_job_t *job = (parse_files_job_t *) argument;
+    return parse_result_build(&job->parser_data->parser, job->node, false);
+}
+
+/**
+ * Release the contents of a file once its parse result has been built, or once
+ * building it has raised an error.
+ */
+static VALUE
+parse_files_job_free(VALUE argument) {
+    parse_files_job_t *job = (parse_files_job_t *) argument;
+    pm_string_free(&job->input);
+    return Qnil;
+}
+
+/**
+ * The body of each of the threads that is parsing files. Each one repeatedly
+ * claims the next file path, parses it without the GVL, and then reacquires the
+ * GVL to build the parse result.
+ */
+static VALUE
+parse_files_worker(void *argument) {
+    parse_files_worker_t *worker = (parse_files_worker_t *) argument;
+    parse_files_data_t *data = worker->data;
+
+    while (data->index < RARRAY_LEN(data->filepaths)) {
+        long index = data->index++;
+        VALUE filepath = RARRAY_AREF(data->filepaths, index);
+
+        parse_files_job_t job = {
+            .parser_data = &worker->parser_data,
+            .options = *data->options,
+            .node = NULL,
+            .error = 0
+        };
+
+        pm_options_filepath_set(&job.options, RSTRING_PTR(filepath));
+        rb_thread_call_without_gvl(parse_files_job_parse, &job, NULL, NULL);
+
+        if (job.error != 0) {
+            // Stop the other workers from claiming any more files, since the
+            // error is going to be raised out of the whole batch.
+            data->index = RARRAY_LEN(data->filepaths);
+
+            if (data->error == 0) {
+                data->error = job.error;
+                data->error_filepath = filepath;
+            }
+
+            break;
+        }
+
+        VALUE result = rb_ensure(parse_files_job_build, (VALUE) &job, parse_files_job_free, (VALUE) &job);
+        rb_ary_store(data->results, index, result);
+    }
+
+    return Qnil;
+}
+
+/**
+ * Wait for the given thread to finish, raising its error if it had one.
+ */
+static VALUE
+parse_files_join(VALUE thread) {
+    return rb_funcall(thread, rb_intern("join"), 0);
+}
+
+/**
+ * call-seq:
+ *   Prism::parse_files(filepaths, threads: nil, **options) -> Array
+ *
+ * Parse each of the given files and return an array of ParseResult instances in
+ * the same order. The files are divided between a pool of threads that each own
+ * their own parser and do the parsing without holding the GVL, so that a large
+ * batch of files can make use of every core. The number of threads defaults to
+ * the number of processors. For other supported options, see Prism::parse.
+ */
+static VALUE
+parse_files(int argc, VALUE *argv, VALUE self) {
+    VALUE paths;
+    VALUE keywords;
+    rb_scan_args(argc, argv, "1:", &paths, &keywords);
+    Check_Type(paths, T_ARRAY);
+
+    VALUE threads = Qnil;
+    if (!NIL_P(keywords)) {
+        keywords = rb_hash_dup(keywords);
+        threads = rb_hash_delete(keywords, ID2SYM(rb_intern("threads")));
+    }
+
+    long thread_count;
+    if (NIL_P(threads)) {
+        rb_require("etc");
+        thread_count = NUM2LONG(rb_funcall(rb_path2class("Etc"), rb_intern("nprocessors"), 0));
+    } else {
+        thread_count = NUM2LONG(threads);
+        if (thread_count < 1) rb_raise(rb_eArgError, "threads must be positive: %ld", thread_count);
+    }
+
+    // Copy the file paths into frozen strings up front, to validate them and so
+    // that they can't be mutated while the workers are reading them.
+    long length = RARRAY_LEN(paths);
+    VALUE filepaths = rb_ary_new_capa(length);
+
+    for (long index = 0; index < length; index++) {
+        VALUE filepath = RARRAY_AREF(paths, index);
+        Check_Type(filepath, T_STRING);
+
+        filepath = rb_str_new_frozen(filepath);
+        StringValueCStr(filepath);
+        rb_ary_push(filepaths, filepath);
+    }
+
+    VALUE results = rb_ary_new_capa(length);
+    if (length == 0) return results;
+    if (thread_count > length) thread_count = length;
+
+    pm_options_t options = { 0 };
+    extract_options(&options, Qnil, keywords);
+
+    parse_files_data_t data = {
+        .filepaths = filepaths,
+        .results = results,
+        .options = &options,
+        .index = 0,
+        .error = 0,
+        .error_filepath = Qnil
+    };
+
+    parse_files_worker_t *workers = ZALLOC_N(parse_files_worker_t, thread_count);
+    VALUE workers_threads = rb_ary_new_capa(thread_count);
+
+    for (long index = 0; index < thread_count; index++) {
+        workers[index].data = &data;
+
+        VALUE thread = rb_thread_create(parse_files_worker, &workers[index]);
+        rb_funcall(thread, rb_intern("report_on_exception="), 1, Qfalse);
+        rb_ary_push(workers_threads, thread);
+    }
+
+    // Wait for every thread to finish before releasing any of the state they
+    // share, even if one of them fails. The first error is raised afterward.
+    int error_state = 0;
+    VALUE error = Qnil;
+
+    for (long index = 0; index < thread_count; index++) {
+        int state = 0;
+        rb_protect(parse_files_join, RARRAY_AREF(workers_threads, index), &state);
+
+        if (state != 0) {
+            data.index = length;
+
+            if (error_state == 0) {
+                error_state = state;
+                error = rb_errinfo();
+            }
+
+            rb_set_errinfo(Qnil);
+
+            // If it was this thread that was interrupted while joining, then
+            // try the same worker again so that it is finished before its state
+            // is released.
+            if (rb_funcall(RARRAY_AREF(workers_threads, index), rb_intern("alive?"), 0) == Qtrue) index--;
+        }
+    }
+
+    for (long index = 0; index < thread_count; index++) {
+        parser_data_clear(&workers[index].parser_data);
+    }
+
+    xfree(workers);
+    pm_options_free(&options);
+
+    RB_GC_GUARD(filepaths);
+    RB_GC_GUARD(workers_threads);
 
-    pm_node_t *node = pm_parse(&parser);
-    pm_node_destroy(&parser, node);
+    if (error_state != 0) {
+        rb_set_errinfo(error);
+        rb_jump_tag(error_state);
+    }
 
-    VALUE result = parser.error_list.size == 0 ? Qtrue : Qfalse;
-    pm_parser_free(&parser);
+    if (data.error != 0) {
+        rb_syserr_fail_str(data.error, data.error_filepath);
+    }
 
-    return result;
+    return results;
 }
 
+/******************************************************************************/
+/* Converting offsets in a source                                             */
+/******************************************************************************/
+
 /**
  * call-seq:
- *   Prism::parse_success?(source, **options) -> bool
+ *   Source::line_unit_offsets(source, offsets, utf16) -> Array
  *
- * Parse the given string and return true if it parses without errors. For
- * supported options, see Prism::parse.
+ * Return an array with an entry for each of the given line offsets, containing
+ * the number of characters in the source that come before that line. If utf16
+ * is true, the number of UTF-16 code units is returned instead, in which case
+ * the source must be valid UTF-8. The offsets must be in increasing order and
+ * within the source.
  */
 static VALUE
-parse_success_p(int argc, VALUE *argv, VALUE self) {
-    pm_string_t input;
-    pm_options_t options = { 0 };
-    string_options(argc, argv, &input, &options);
+source_line_unit_offsets(VALUE self, VALUE source, VALUE offsets, VALUE utf16) {
+    Check_Type(source, T_STRING);
+    Check_Type(offsets, T_ARRAY);
 
-    VALUE result = parse_input_success_p(&input, &options);
-    pm_string_free(&input);
-    pm_options_free(&options);
+    rb_encoding *encoding = rb_enc_get(source);
+    const char *start = RSTRING_PTR(source);
+    size_t length = RSTRING_LEN(source);
+    bool code_units = RTEST(utf16);
 
-    return result;
-}
+    long size = RARRAY_LEN(offsets);
+    VALUE result = rb_ary_new_capa(size);
 
-/**
- * call-seq:
- *   Prism::parse_failure?(source, **options) -> bool
- *
- * Parse the given string and return true if it parses with errors. For
- * supported options, see Prism::parse.
- */
-static VALUE
-parse_failure_p(int argc, VALUE *argv, VALUE self) {
-    return RTEST(parse_success_p(argc, argv, self)) ? Qfalse : Qtrue;
-}
+    size_t previous = 0;
+    size_t units = 0;
 
-/**
- * call-seq:
- *   Prism::parse_file_success?(filepath, **options) -> bool
- *
- * Parse the given file and return true if it parses without errors. For
- * supported options, see Prism::parse.
- */
-static VALUE
-parse_file_success_p(int argc, VALUE *argv, VALUE self) {
-    pm_string_t input;
-    pm_options_t options = { 0 };
+    for (long index = 0; index < size; index++) {
+        size_t offset = NUM2SIZET(rb_ary_entry(offsets, index));
+        if (offset < previous || offset > length) rb_raise(rb_eArgError, "invalid line offset: %" PRIuSIZE, offset);
 
-    file_options(argc, argv, &input, &options);
+        if (code_units) {
+            // In valid UTF-8, every byte that is not a continuation byte
+            // starts a character, and only the characters that take four
+            // bytes need a surrogate pair in UTF-16.
+            for (size_t cursor = previous; cursor < offset; cursor++) {
+                uint8_t byte = (uint8_t) start[cursor];
+                units += ((byte & 0xC0) != 0x80) + (byte >= 0xF0);
+            }
+        } else {
+            units += (size_t) rb_enc_strlen(start + previous, start + offset, encoding);
+        }
 
-    VALUE result = parse_input_success_p(&input, &options);
-    pm_string_free(&input);
-    pm_options_free(&options);
+        rb_ary_push(result, SIZET2NUM(units));
+        previous = offset;
+    }
 
     return result;
 }
 
 /**
  * call-seq:
- *   Prism::parse_file_failure?(filepath, **options) -> bool
+ *   Source::byte_character_offsets(source) -> Array
  *
- * Parse the given file and return true if it parses with errors. For
- * supported options, see Prism::parse.
+ * Return an array with an entry for each byte in the source and one more for
+ * the end of the source, containing the offset in characters of the character
+ * that the byte belongs to. Invalid bytes are counted as characters of their
+ * own, in the same way as String#each_char.
  */
 static VALUE
-parse_file_failure_p(int argc, VALUE *argv, VALUE self) {
-    return RTEST(parse_file_success_p(argc, argv, self)) ? Qfalse : Qtrue;
+source_byte_character_offsets(VALUE self, VALUE source) {
+    Check_Type(source, T_STRING);
+
+    rb_encoding *encoding = rb_enc_get(source);
+    const char *cursor = RSTRING_PTR(source);
+    const char *end = cursor + RSTRING_LEN(source);
+
+    VALUE result = rb_ary_new_capa(RSTRING_LEN(source) + 1);
+    long characters = 0;
+
+    while (cursor < end) {
+        int width = rb_enc_mbclen(cursor, end, encoding);
+        VALUE offset = LONG2FIX(characters++);
+
+        for (int index = 0; index < width; index++) rb_ary_push(result, offset);
+        cursor += width;
+    }
+
+    rb_ary_push(result, LONG2FIX(characters));
+    return result;
 }
 
 /******************************************************************************/
@@ -1120,6 +2191,66 @@ memsize(VALUE self, VALUE string) {
     return result;
 }
 
+/**
+ * call-seq:
+ *   Debug::stats(source) -> Hash | nil
+ *
+ * Parse and serialize the given source string and return the statistics that
+ * the parser collected along the way, or nil if prism was not compiled with
+ * PRISM_BUILD_STATS. Times are in nanoseconds, and the counts of the nodes in
+ * the resulting tree are keyed by node type under :nodes.
+ */
+static VALUE
+stats(VALUE self, VALUE string) {
+    pm_parser_t parser;
+    pm_parser_init(&parser, (const uint8_t *) RSTRING_PTR(string), RSTRING_LEN(string), NULL);
+
+    pm_arena_t arena = { 0 };
+    pm_parser_arena_set(&parser, &arena);
+    pm_node_t *node = pm_parse(&parser);
+
+#ifndef PRISM_EXCLUDE_SERIALIZATION
+    pm_buffer_t buffer = { 0 };
+    pm_serialize(&parser, node, &buffer);
+    pm_buffer_free(&buffer);
+#else
+    (void) node;
+#endif
+
+    pm_parser_stats_t parser_stats;
+    bool collected = pm_parser_stats(&parser, &parser_stats);
+
+    pm_parser_free(&parser);
+    pm_arena_free(&arena);
+
+    if (!collected) return Qnil;
+
+    VALUE nodes = rb_hash_new();
+    for (size_t index = 0; index < PM_PARSER_STATS_NODE_TYPES; index++) {
+        if (parser_stats.nodes[index] == 0) continue;
+
+        // Turn PM_CALL_NODE into :call_node to match Node#type.
+        const char *name = pm_node_type_to_str((pm_node_type_t) index) + 3;
+        VALUE type = rb_funcall(rb_str_new_cstr(name), rb_intern("downcase"), 0);
+        rb_hash_aset(nodes, rb_str_intern(type), ULL2NUM(parser_stats.nodes[index]));
+    }
+
+    VALUE result = rb_hash_new();
+    rb_hash_aset(result, ID2SYM(rb_intern("tokens")), ULL2NUM(parser_stats.tokens));
+    rb_hash_aset(result, ID2SYM(rb_intern("nodes_allocated")), ULL2NUM(parser_stats.nodes_allocated));
+    rb_hash_aset(result, ID2SYM(rb_intern("node_bytes_allocated")), ULL2NUM(parser_stats.node_bytes_allocated));
+    rb_hash_aset(result, ID2SYM(rb_intern("nodes")), nodes);
+    rb_hash_aset(result, ID2SYM(rb_intern("constant_pool_inserts")), ULL2NUM(parser_stats.constant_pool_inserts));
+    rb_hash_aset(result, ID2SYM(rb_intern("constant_pool_collisions")), ULL2NUM(parser_stats.constant_pool_collisions));
+    rb_hash_aset(result, ID2SYM(rb_intern("lex_mode_pushes")), ULL2NUM(parser_stats.lex_mode_pushes));
+    rb_hash_aset(result, ID2SYM(rb_intern("context_pushes")), ULL2NUM(parser_stats.context_pushes));
+    rb_hash_aset(result, ID2SYM(rb_intern("strpbrk_bytes")), ULL2NUM(parser_stats.strpbrk_bytes));
+    rb_hash_aset(result, ID2SYM(rb_intern("lex_time")), ULL2NUM(parser_stats.lex_time));
+    rb_hash_aset(result, ID2SYM(rb_intern("parse_time")), ULL2NUM(parser_stats.parse_time));
+    rb_hash_aset(result, ID2SYM(rb_intern("serialize_time")), ULL2NUM(parser_stats.serialize_time));
+    return result;
+}
+
 /**
  * call-seq:
  *   Debug::profile_file(filepath) -> nil
@@ -1150,9 +2281,12 @@ profile_file(VALUE self, VALUE filepath) {
     pm_parser_t parser;
     pm_parser_init(&parser, pm_string_source(&input), pm_string_length(&input), &options);
 
-    pm_node_t *node = pm_parse(&parser);
-    pm_node_destroy(&parser, node);
+    pm_arena_t arena = { 0 };
+    pm_parser_arena_set(&parser, &arena);
+
+    pm_parse(&parser);
     pm_parser_free(&parser);
+    pm_arena_free(&arena);
     pm_options_free(&options);
     pm_string_free(&input);
 
@@ -1257,6 +2391,313 @@ static_inspect(int argc, VALUE *argv, VALUE self) {
     return result;
 }
 
+#if !defined(PRISM_EXCLUDE_SERIALIZATION) || !defined(PRISM_EXCLUDE_JSON)
+
+/**
+ * The state of the sinks used by the debug functions that write output in
+ * chunks. Every chunk is collected into an array, and writes start failing once
+ * limit chunks have been accepted (unless limit is negative).
+ */
+typedef struct {
+    /** The array of strings that every chunk is pushed onto. */
+    VALUE chunks;
+
+    /** The number of chunks to accept before failing, or -1 for no limit. */
+    long limit;
+
+    /** The number of times the output was flushed. */
+    long flushes;
+
+    /**
+     * The state of the error that was raised while pushing a chunk, or 0. Once
+     * it is set, every write fails, and the error is raised again after the
+     * parser has been freed.
+     */
+    int state;
+} debug_sink_t;
+
+/**
+ * A single chunk that is being pushed onto the array of a debug sink, which is
+ * passed through rb_protect.
+ */
+typedef struct {
+    /** The sink that the chunk belongs to. */
+    debug_sink_t *sink;
+
+    /** The bytes of the chunk. */
+    const char *bytes;
+
+    /** The number of bytes in the chunk. */
+    size_t length;
+} debug_sink_chunk_t;
+
+/**
+ * Push a chunk onto the array of chunks of its sink.
+ */
+static VALUE
+debug_sink_push(VALUE argument) {
+    debug_sink_chunk_t *chunk = (debug_sink_chunk_t *) argument;
+    rb_ary_push(chunk->sink->chunks, rb_str_new(chunk->bytes, (long) chunk->length));
+    return Qnil;
+}
+
+/**
+ * Push a chunk onto the array of chunks, and fail if the limit was reached.
+ * This is called from the middle of serializing, so any error that is raised is
+ * caught and recorded on the sink instead of unwinding through the serializer.
+ */
+static bool
+debug_sink_write(debug_sink_t *sink, const char *bytes, size_t length) {
+    if (sink->state != 0) return false;
+
+    bool accepted = sink->limit < 0 || RARRAY_LEN(sink->chunks) < sink->limit;
+    debug_sink_chunk_t chunk = { .sink = sink, .bytes = bytes, .length = length };
+
+    rb_protect(debug_sink_push, (VALUE) &chunk, &sink->state);
+    return accepted && sink->state == 0;
+}
+
+/**
+ * Return the limit of a debug sink from the given Ruby value.
+ */
+static long
+debug_sink_limit(VALUE limit) {
+    return NIL_P(limit) ? -1 : NUM2LONG(limit);
+}
+
+/**
+ * The state of a call to one of the debug functions that parse a source and
+ * write it out through a debug sink. Everything that needs to be freed is held
+ * here so that it can be released under rb_ensure.
+ */
+typedef struct {
+    /** The source that is being parsed. */
+    pm_string_t input;
+
+    /** The options that the source is being parsed with. */
+    pm_options_t options;
+
+    /** The parser that is parsing the source. */
+    pm_parser_t parser;
+
+    /** The arena that the nodes of the tree are allocated in. */
+    pm_arena_t arena;
+
+    /** The sink that the output is being written to. */
+    debug_sink_t sink;
+
+    /** The chunk size to serialize with, for Debug::dump_sink. */
+    size_t chunk_size;
+
+    /** The fields to dump, for Debug::dump_json_stream. */
+    uint32_t fields;
+
+    /** Whether or not writing out the tree succeeded. */
+    bool success;
+} debug_dump_t;
+
+/**
+ * Initialize the parser of the given debug call. The input and the options must
+ * already have been set, and nothing that follows may raise until the call has
+ * been released by debug_dump_free.
+ */
+static void
+debug_dump_init(debug_dump_t *dump) {
+    pm_parser_init(&dump->parser, pm_string_source(&dump->input), pm_string_length(&dump->input), &dump->options);
+    pm_parser_arena_set(&dump->parser, &dump->arena);
+}
+
+/**
+ * Free everything that was allocated by the given debug call.
+ */
+static VALUE
+debug_dump_free(VALUE argument) {
+    debug_dump_t *dump = (debug_dump_t *) argument;
+
+    pm_parser_free(&dump->parser);
+    pm_arena_free(&dump->arena);
+    pm_string_free(&dump->input);
+    pm_options_free(&dump->options);
+
+    return Qnil;
+}
+
+/**
+ * Build the result of the given debug call once it has been released, or raise
+ * the error that was raised while pushing one of its chunks.
+ */
+static VALUE
+debug_dump_result(const debug_dump_t *dump) {
+    if (dump->sink.state != 0) rb_jump_tag(dump->sink.state);
+
+    VALUE result = rb_hash_new();
+    rb_hash_aset(result, ID2SYM(rb_intern("chunks")), dump->sink.chunks);
+    rb_hash_aset(result, ID2SYM(rb_intern("success")), dump->success ? Qtrue : Qfalse);
+    return result;
+}
+
+#endif
+
+#ifndef PRISM_EXCLUDE_SERIALIZATION
+
+/**
+ * The write callback of the sink used by Debug::dump_sink.
+ */
+static bool
+dump_sink_write(void *data, const uint8_t *bytes, size_t length) {
+    return debug_sink_write((debug_sink_t *) data, (const char *) bytes, length);
+}
+
+/**
+ * The flush callback of the sink used by Debug::dump_sink.
+ */
+static bool
+dump_sink_flush(void *data) {
+    ((debug_sink_t *) data)->flushes++;
+    return true;
+}
+
+/**
+ * Parse and serialize the source of the given Debug::dump_sink call.
+ */
+static VALUE
+dump_sink_serialize(VALUE argument) {
+    debug_dump_t *dump = (debug_dump_t *) argument;
+    pm_node_t *node = pm_parse(&dump->parser);
+
+    pm_serialize_sink_t sink = {
+        .write = dump_sink_write,
+        .flush = dump_sink_flush,
+        .data = &dump->sink,
+        .chunk_size = dump->chunk_size
+    };
+
+    dump->success = pm_serialize_sink(&dump->parser, node, &sink);
+    return Qnil;
+}
+
+/**
+ * call-seq:
+ *   Debug::dump_sink(source, chunk_size, limit, **options) -> Hash
+ *
+ * Serialize the AST that represents the given source through pm_serialize_sink
+ * with the given chunk size. If limit is an integer, then the sink fails every
+ * write after the first limit chunks. Returns the chunks that were passed to
+ * the sink, whether the serialization succeeded, and how many times the sink
+ * was flushed. For supported options, see Prism::dump.
+ */
+static VALUE
+dump_sink(int argc, VALUE *argv, VALUE self) {
+    VALUE source;
+    VALUE chunk_size;
+    VALUE limit;
+    VALUE keywords;
+    rb_scan_args(argc, argv, "3:", &source, &chunk_size, &limit, &keywords);
+
+    // Convert every argument before anything is allocated, since any of these
+    // conversions can raise.
+    debug_dump_t dump = {
+        .sink = { .chunks = rb_ary_new(), .limit = debug_sink_limit(limit), .flushes = 0, .state = 0 },
+        .chunk_size = NUM2SIZET(chunk_size)
+    };
+
+    VALUE string = input_load_string(&dump.input, source);
+    extract_options(&dump.options, Qnil, keywords);
+
+    debug_dump_init(&dump);
+    rb_ensure(dump_sink_serialize, (VALUE) &dump, debug_dump_free, (VALUE) &dump);
+    RB_GC_GUARD(string);
+
+    VALUE result = debug_dump_result(&dump);
+    rb_hash_aset(result, ID2SYM(rb_intern("flushes")), LONG2NUM(dump.sink.flushes));
+    return result;
+}
+
+#endif
+
+#ifndef PRISM_EXCLUDE_JSON
+
+/**
+ * call-seq:
+ *   Debug::dump_json(source) -> String
+ *
+ * Dump the AST that represents the given source as JSON through pm_dump_json.
+ */
+static VALUE
+dump_json(VALUE self, VALUE source) {
+    pm_string_t input;
+    VALUE string = input_load_string(&input, source);
+
+    pm_parser_t parser;
+    pm_parser_init(&parser, pm_string_source(&input), pm_string_length(&input), NULL);
+
+    pm_arena_t arena = { 0 };
+    pm_parser_arena_set(&parser, &arena);
+    pm_node_t *node = pm_parse(&parser);
+
+    pm_buffer_t buffer = { 0 };
+    pm_dump_json(&buffer, &parser, node);
+    VALUE result = rb_str_new(pm_buffer_value(&buffer), (long) pm_buffer_length(&buffer));
+
+    pm_buffer_free(&buffer);
+    pm_parser_free(&parser);
+    pm_arena_free(&arena);
+    pm_string_free(&input);
+    RB_GC_GUARD(string);
+
+    return result;
+}
+
+/**
+ * The write callback used by Debug::dump_json_stream.
+ */
+static bool
+dump_json_stream_write(const char *data, size_t length, void *stream) {
+    return debug_sink_write((debug_sink_t *) stream, data, length);
+}
+
+/**
+ * Parse the source of the given Debug::dump_json_stream call and dump it.
+ */
+static VALUE
+dump_json_stream_dump(VALUE argument) {
+    debug_dump_t *dump = (debug_dump_t *) argument;
+    pm_node_t *node = pm_parse(&dump->parser);
+
+    dump->success = pm_dump_json_stream(&dump->parser, node, dump->fields, &dump->sink, dump_json_stream_write);
+    return Qnil;
+}
+
+/**
+ * call-seq:
+ *   Debug::dump_json_stream(source, fields, limit) -> Hash
+ *
+ * Dump the given fields of the AST that represents the given source as JSON
+ * through pm_dump_json_stream. If limit is an integer, then every write after
+ * the first limit chunks fails. Returns the chunks that were written and
+ * whether the dump succeeded.
+ */
+static VALUE
+dump_json_stream(VALUE self, VALUE source, VALUE fields, VALUE limit) {
+    // Convert every argument before anything is allocated, since any of these
+    // conversions can raise.
+    debug_dump_t dump = {
+        .sink = { .chunks = rb_ary_new(), .limit = debug_sink_limit(limit), .flushes = 0, .state = 0 },
+        .fields = NUM2UINT(fields)
+    };
+
+    VALUE string = input_load_string(&dump.input, source);
+    extract_options(&dump.options, Qnil, Qnil);
+
+    debug_dump_init(&dump);
+    rb_ensure(dump_json_stream_dump, (VALUE) &dump, debug_dump_free, (VALUE) &dump);
+    RB_GC_GUARD(string);
+
+    return debug_dump_result(&dump);
+}
+
+#endif
+
 /**
  * call-seq: Debug::Encoding.all -> Array[Debug::Encoding]
  *
@@ -1372,11 +2813,15 @@ Init_prism(void) {
     // Intern all of the options that we support so that we don't have to do it
     // every time we parse.
     rb_option_id_command_line = rb_intern_const("command_line");
+    rb_option_id_delta_locations = rb_intern_const("delta_locations");
+    rb_option_id_node_lengths = rb_intern_const("node_lengths");
     rb_option_id_encoding = rb_intern_const("encoding");
     rb_option_id_filepath = rb_intern_const("filepath");
     rb_option_id_frozen_string_literal = rb_intern_const("frozen_string_literal");
     rb_option_id_line = rb_intern_const("line");
+    rb_option_id_mark_newlines = rb_intern_const("mark_newlines");
     rb_option_id_scopes = rb_intern_const("scopes");
+    rb_option_id_semantics_only = rb_intern_const("semantics_only");
     rb_option_id_version = rb_intern_const("version");
 
     rb_prism_source_id_for = rb_intern("for");
@@ -1392,6 +2837,8 @@ Init_prism(void) {
     rb_define_singleton_method(rb_cPrism, "parse", parse, -1);
     rb_define_singleton_method(rb_cPrism, "parse_stream", parse_stream, -1);
     rb_define_singleton_method(rb_cPrism, "parse_file", parse_file, -1);
+    rb_define_singleton_method(rb_cPrism, "parse_lazy", parse_lazy, -1);
+    rb_define_singleton_method(rb_cPrism, "parse_file_lazy", parse_file_lazy, -1);
     rb_define_singleton_method(rb_cPrism, "parse_comments", parse_comments, -1);
     rb_define_singleton_method(rb_cPrism, "parse_file_comments", parse_file_comments, -1);
     rb_define_singleton_method(rb_cPrism, "parse_lex", parse_lex, -1);
@@ -1400,22 +2847,43 @@ Init_prism(void) {
     rb_define_singleton_method(rb_cPrism, "parse_failure?", parse_failure_p, -1);
     rb_define_singleton_method(rb_cPrism, "parse_file_success?", parse_file_success_p, -1);
     rb_define_singleton_method(rb_cPrism, "parse_file_failure?", parse_file_failure_p, -1);
+    rb_define_singleton_method(rb_cPrism, "parse_files", parse_files, -1);
+    rb_define_singleton_method(rb_cPrismSource, "line_unit_offsets", source_line_unit_offsets, 3);
+    rb_define_singleton_method(rb_cPrismSource, "byte_character_offsets", source_byte_character_offsets, 1);
 
 #ifndef PRISM_EXCLUDE_SERIALIZATION
     rb_define_singleton_method(rb_cPrism, "dump", dump, -1);
     rb_define_singleton_method(rb_cPrism, "dump_file", dump_file, -1);
+    rb_define_singleton_method(rb_cPrism, "dump_cache", dump_cache, -1);
+    rb_define_singleton_method(rb_cPrism, "cache_valid?", cache_valid_p, -1);
 #endif
 
+    // Next, the reusable parser object for parsing many sources in a row.
+    VALUE rb_cPrismReusableParser = rb_define_class_under(rb_cPrism, "ReusableParser", rb_cObject);
+    rb_define_alloc_func(rb_cPrismReusableParser, reusable_parser_allocate);
+    rb_define_method(rb_cPrismReusableParser, "parse", reusable_parser_parse, -1);
+    rb_define_method(rb_cPrismReusableParser, "parse_file", reusable_parser_parse_file, -1);
+
     // Next, the functions that will be called by the parser to perform various
     // internal tasks. We expose these to make them easier to test.
     VALUE rb_cPrismDebug = rb_define_module_under(rb_cPrism, "Debug");
     rb_define_singleton_method(rb_cPrismDebug, "named_captures", named_captures, 1);
     rb_define_singleton_method(rb_cPrismDebug, "integer_parse", integer_parse, 1);
     rb_define_singleton_method(rb_cPrismDebug, "memsize", memsize, 1);
+    rb_define_singleton_method(rb_cPrismDebug, "stats", stats, 1);
     rb_define_singleton_method(rb_cPrismDebug, "profile_file", profile_file, 1);
     rb_define_singleton_method(rb_cPrismDebug, "format_errors", format_errors, 2);
     rb_define_singleton_method(rb_cPrismDebug, "static_inspect", static_inspect, -1);
 
+#ifndef PRISM_EXCLUDE_SERIALIZATION
+    rb_define_singleton_method(rb_cPrismDebug, "dump_sink", dump_sink, -1);
+#endif
+
+#ifndef PRISM_EXCLUDE_JSON
+    rb_define_singleton_method(rb_cPrismDebug, "dump_json", dump_json, 1);
+    rb_define_singleton_method(rb_cPrismDebug, "dump_json_stream", dump_json_stream, 3);
+#endif
+
 #ifndef PRISM_EXCLUDE_PRETTYPRINT
     rb_define_singleton_method(rb_cPrismDebug, "inspect_node", inspect_node, 1);
 #endif
@@ -1431,5 +2899,9 @@ Init_prism(void) {
 
     // Next, initialize the other APIs.
     Init_prism_api_node();
+    rb_define_singleton_method(rb_cPrismLazyTree, "scan", lazy_tree_scan, -1);
+    rb_define_singleton_method(rb_cPrismLazyTree, "scan_file", lazy_tree_scan_file, -1);
+    rb_define_singleton_method(rb_cPrismLazyTree, "dispatch", lazy_tree_dispatch, -1);
+    rb_define_singleton_method(rb_cPrismLazyTree, "dispatch_file", lazy_tree_dispatch_file, -1);
     Init_prism_pack();
 }
@@ -5,11 +5,67 @@
 
 #include <ruby.h>
 #include <ruby/encoding.h>
+#include <ruby/thread.h>
 #include "prism.h"
 
+/**
+ * The state that is kept alive behind a syntax tree that was parsed lazily. The
+ * parser, its arena, and the source they point into are retained for as long as
+ * any of the Ruby nodes are reachable, so that each child node can be created
+ * from the C tree when it is first accessed.
+ */
+typedef struct {
+    /** The source that was parsed, which the tree points into. */
+    pm_string_t input;
+
+    /** The Ruby strings that the input and the options point into. */
+    VALUE strings;
+
+    /** The options that were used to parse, which the parser points into. */
+    pm_options_t options;
+
+    /** The arena that the syntax tree is allocated from. */
+    pm_arena_t arena;
+
+    /** The parser that parsed the tree. */
+    pm_parser_t parser;
+
+    /** Whether or not the parser has been initialized yet. */
+    bool initialized;
+
+    /** The encoding of the source. */
+    rb_encoding *encoding;
+
+    /** The Prism::Source instance that the nodes are created with. */
+    VALUE source;
+
+    /** The symbols for the constants in the pool, interned as they are needed. */
+    VALUE constants;
+
+    /** The nodes that have been handed out as indices to Ruby nodes. */
+    const pm_node_t **nodes;
+
+    /** The number of nodes in the list. */
+    size_t size;
+
+    /** The number of nodes that have been allocated in the list. */
+    size_t capacity;
+
+    /**
+     * The Ruby nodes that have been created, keyed by their C nodes. This is
+     * only used while the tree is being walked from C.
+     */
+    st_table *cache;
+} pm_lazy_tree_t;
+
 VALUE pm_source_new(const pm_parser_t *parser, rb_encoding *encoding);
+VALUE pm_location_new(const pm_parser_t *parser, const uint8_t *start, const uint8_t *end);
 VALUE pm_token_new(const pm_parser_t *parser, const pm_token_t *token, rb_encoding *encoding, VALUE source);
-VALUE pm_ast_new(const pm_parser_t *parser, const pm_node_t *node, rb_encoding *encoding, VALUE source);
+VALUE pm_ast_new(const pm_parser_t *parser, const pm_node_t *node, rb_encoding *encoding, VALUE source, VALUE newline_nodes);
+VALUE pm_lazy_tree_new(pm_lazy_tree_t **tree);
+VALUE pm_lazy_ast_new(VALUE lazy, const pm_node_t *node, rb_encoding *encoding, VALUE source);
+VALUE pm_lazy_pattern_scan(VALUE lazy, const pm_node_t *node, rb_encoding *encoding, VALUE source, VALUE pattern);
+void pm_lazy_dispatch(VALUE lazy, const pm_node_t *node, rb_encoding *encoding, VALUE source, VALUE events);
 VALUE pm_integer_new(const pm_integer_t *integer);
 
 void Init_prism_api_node(void);
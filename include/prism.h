@@ -7,6 +7,7 @@
 #define PRISM_H
 
 #include "prism/defines.h"
+#include "prism/util/pm_arena.h"
 #include "prism/util/pm_buffer.h"
 #include "prism/util/pm_char.h"
 #include "prism/util/pm_integer.h"
@@ -22,6 +23,7 @@
 #include "prism/prettyprint.h"
 #include "prism/regexp.h"
 #include "prism/static_literals.h"
+#include "prism/stats.h"
 #include "prism/version.h"
 
 #include <assert.h>
@@ -65,6 +67,21 @@ PRISM_EXPORTED_FUNCTION void pm_parser_init(pm_parser_t *parser, const uint8_t *
  */
 PRISM_EXPORTED_FUNCTION void pm_parser_register_encoding_changed_callback(pm_parser_t *parser, pm_encoding_changed_callback_t callback);
 
+/**
+ * Attach an arena to the parser. When an arena is attached, the nodes of the
+ * syntax tree (along with their lists, owned strings, and integer digits) are
+ * allocated out of it instead of being individually allocated on the heap. This
+ * must be called after pm_parser_init and before pm_parse.
+ *
+ * The tree remains valid until the arena is freed, and pm_node_destroy becomes
+ * a no-op. The caller retains ownership of the arena and must free it with
+ * pm_arena_free once it is done with the tree.
+ *
+ * @param parser The parser to attach the arena to.
+ * @param arena The arena to allocate the syntax tree from.
+ */
+PRISM_EXPORTED_FUNCTION void pm_parser_arena_set(pm_parser_t *parser, pm_arena_t *arena);
+
 /**
  * Free any memory associated with the given parser.
  *
@@ -72,6 +89,38 @@ PRISM_EXPORTED_FUNCTION void pm_parser_register_encoding_changed_callback(pm_par
  */
 PRISM_EXPORTED_FUNCTION void pm_parser_free(pm_parser_t *parser);
 
+/**
+ * Reset a parser that has already been initialized so that it can be used to
+ * parse a new source. This behaves like calling pm_parser_free followed by
+ * pm_parser_init, except that the memory the parser has already allocated (the
+ * constant pool and newline list, along with the attached arena if there is
+ * one) is kept and reused. When parsing many files in a row, this means that
+ * once the buffers have grown to fit, subsequent parses allocate very little.
+ *
+ * Any syntax tree produced by a previous parse must be destroyed before calling
+ * this function. If an arena is attached, it is reset and remains attached, so
+ * any tree allocated from it is invalidated. Callbacks registered on the parser
+ * are cleared, just as they would be by pm_parser_init.
+ *
+ * @param parser The parser to reset.
+ * @param source The source to parse.
+ * @param size The size of the source.
+ * @param options The optional options to use when parsing.
+ */
+PRISM_EXPORTED_FUNCTION void pm_parser_reset(pm_parser_t *parser, const uint8_t *source, size_t size, const pm_options_t *options);
+
+/**
+ * Copy the statistics that the given parser has collected since it was
+ * initialized or reset into the given struct. Statistics are only collected
+ * when prism is compiled with PRISM_BUILD_STATS.
+ *
+ * @param parser The parser to read the statistics from.
+ * @param stats The struct to copy the statistics into.
+ * @return Whether or not statistics were collected. If they were not, the
+ *     given struct is left untouched.
+ */
+PRISM_EXPORTED_FUNCTION bool pm_parser_stats(const pm_parser_t *parser, pm_parser_stats_t *stats);
+
 /**
  * Initiate the parser with the given parser.
  *
@@ -80,6 +129,19 @@ PRISM_EXPORTED_FUNCTION void pm_parser_free(pm_parser_t *parser);
  */
 PRISM_EXPORTED_FUNCTION pm_node_t * pm_parse(pm_parser_t *parser);
 
+/**
+ * Lex the source of the given parser, handing the tokens to the given callback
+ * in batches. The state of the lexer depends on the grammar, so the source is
+ * still parsed, but no tree is returned. If the parser does not already have an
+ * arena attached, the tree is allocated out of an internal one that is released
+ * in bulk before this function returns. Errors, warnings, and comments are
+ * still recorded on the parser as they would be by pm_parse.
+ *
+ * @param parser The parser to use.
+ * @param callback The callback to hand the tokens to.
+ */
+PRISM_EXPORTED_FUNCTION void pm_lex(pm_parser_t *parser, const pm_lex_tokens_callback_t *callback);
+
 /**
  * This function is used in pm_parse_stream to retrieve a line of input from a
  * stream. It closely mirrors that of fgets so that fgets can be used as the
@@ -141,6 +203,50 @@ void pm_serialize_encoding(const pm_encoding_t *encoding, pm_buffer_t *buffer);
  */
 void pm_serialize_content(pm_parser_t *parser, pm_node_t *node, pm_buffer_t *buffer);
 
+/**
+ * A sink that serialized output is written to as it is produced, so that it
+ * never has to be held in memory all at once. This can be used to stream the
+ * output to a file, a pipe, or a socket.
+ */
+typedef struct {
+    /**
+     * The function that is called with each chunk of output, in order. It
+     * should return false if the chunk could not be written, in which case it
+     * will not be called again.
+     */
+    bool (*write)(void *data, const uint8_t *bytes, size_t length);
+
+    /**
+     * The optional function that is called once all of the output has been
+     * written. It should return false if the output could not be flushed.
+     */
+    bool (*flush)(void *data);
+
+    /** The opaque data that is passed to each of the callbacks. */
+    void *data;
+
+    /**
+     * The size that output is buffered up to before it is written. Chunks are
+     * cut between nodes, so they can be larger than this. The constant pool is
+     * always written as a single chunk.
+     */
+    size_t chunk_size;
+} pm_serialize_sink_t;
+
+/**
+ * Serialize the encoding, metadata, nodes, and constant pool by writing them to
+ * the given sink in chunks. The given buffer is used to build each chunk, and
+ * can already contain bytes that should be written first. When this returns,
+ * the buffer can contain bytes that have not been written yet.
+ *
+ * @param parser The parser to serialize.
+ * @param node The node to serialize.
+ * @param buffer The buffer to build each chunk in.
+ * @param sink The sink to write to.
+ * @return Whether or not every chunk was written successfully.
+ */
+bool pm_serialize_content_sink(pm_parser_t *parser, pm_node_t *node, pm_buffer_t *buffer, pm_serialize_sink_t *sink);
+
 /**
  * Serialize the AST represented by the given node to the given buffer.
  *
@@ -160,6 +266,103 @@ PRISM_EXPORTED_FUNCTION void pm_serialize(pm_parser_t *parser, pm_node_t *node,
  */
 PRISM_EXPORTED_FUNCTION void pm_serialize_parse(pm_buffer_t *buffer, const uint8_t *source, size_t size, const char *data);
 
+/**
+ * Serialize the AST represented by the given node to the given sink. This is
+ * the same output as pm_serialize, but it is written out in chunks of about
+ * sink->chunk_size bytes as it is produced instead of being built up in a
+ * single buffer. Since the offset of the constant pool comes before the nodes,
+ * the nodes are serialized twice: once to find it, and once to write them.
+ *
+ * @param parser The parser to serialize.
+ * @param node The node to serialize.
+ * @param sink The sink to write to.
+ * @return Whether or not the output was written and flushed successfully.
+ */
+PRISM_EXPORTED_FUNCTION bool pm_serialize_sink(pm_parser_t *parser, pm_node_t *node, pm_serialize_sink_t *sink);
+
+/**
+ * Parse the given source to the AST and dump the AST to the given sink. See
+ * pm_serialize_sink for how the output is written.
+ *
+ * @param sink The sink to write to.
+ * @param source The source to parse.
+ * @param size The size of the source.
+ * @param data The optional data to pass to the parser.
+ * @return Whether or not the output was written and flushed successfully.
+ */
+PRISM_EXPORTED_FUNCTION bool pm_serialize_parse_sink(pm_serialize_sink_t *sink, const uint8_t *source, size_t size, const char *data);
+
+/**
+ * The number of bytes in the trailer that pm_serialize_parse_cache writes after
+ * the serialized AST. The serialized AST itself starts at the beginning of the
+ * cache, and can be handed directly to any of the loaders.
+ */
+#define PM_SERIALIZE_CACHE_TRAILER_SIZE 32
+
+/**
+ * Parse the given source to the AST and dump the AST to the given buffer in a
+ * form that can be written to disk and reused for later parses of the same
+ * source with the same options. This is the same output as pm_serialize_parse,
+ * followed by a trailer of PM_SERIALIZE_CACHE_TRAILER_SIZE bytes that holds the
+ * size and a digest of the source and a digest of the options.
+ *
+ * The serialized AST only contains offsets that are relative to the start of
+ * the source and of the serialization, so the cache is valid wherever it is
+ * loaded into memory, including when it is mapped with pm_string_mapped_init.
+ * It is specific to the version of prism and to the byte order of the machine
+ * that wrote it.
+ *
+ * @param buffer The empty buffer to serialize to.
+ * @param source The source to parse.
+ * @param size The size of the source.
+ * @param data The optional data to pass to the parser.
+ */
+PRISM_EXPORTED_FUNCTION void pm_serialize_parse_cache(pm_buffer_t *buffer, const uint8_t *source, size_t size, const char *data);
+
+/**
+ * Check whether a cache that was written by pm_serialize_parse_cache can be used
+ * in place of parsing the given source with the given options. This checks the
+ * version of prism that wrote it, and compares the size and digest of the
+ * source and the digest of the options. The digests are not cryptographic, so
+ * this guards against stale caches and not against caches that have been
+ * crafted to collide. If this returns true, then the serialized AST is the
+ * first cache_size - PM_SERIALIZE_CACHE_TRAILER_SIZE bytes of the cache.
+ *
+ * @param cache The cache to check.
+ * @param cache_size The size of the cache.
+ * @param source The source that is about to be parsed.
+ * @param size The size of the source.
+ * @param data The optional data that would be passed to the parser.
+ * @return Whether the cache matches the source and options.
+ */
+PRISM_EXPORTED_FUNCTION bool pm_serialize_cache_valid_p(const uint8_t *cache, size_t cache_size, const uint8_t *source, size_t size, const char *data);
+
+/**
+ * Append the trailer that pm_serialize_parse_cache writes after the serialized
+ * AST to the given buffer. This is for bindings that parse and serialize with
+ * an options struct themselves, and that want to write the same cache as
+ * pm_serialize_parse_cache.
+ *
+ * @param buffer The buffer that holds the serialized AST.
+ * @param source The source that was parsed.
+ * @param size The size of the source.
+ * @param options The options that the source was parsed with.
+ */
+PRISM_EXPORTED_FUNCTION void pm_serialize_cache_trailer(pm_buffer_t *buffer, const uint8_t *source, size_t size, const pm_options_t *options);
+
+/**
+ * The same as pm_serialize_cache_valid_p, but with an options struct in place of
+ * the serialized options.
+ *
+ * @param cache The cache to check.
+ * @param cache_size The size of the cache.
+ * @param source The source that is about to be parsed.
+ * @param size The size of the source.
+ * @param options The options that would be passed to the parser.
+ * @return Whether the cache matches the source and options.
+ */
+PRISM_EXPORTED_FUNCTION bool pm_serialize_cache_options_valid_p(const uint8_t *cache, size_t cache_size, const uint8_t *source, size_t size, const pm_options_t *options);
+
 /**
  * Parse and serialize the comments in the given source to the given buffer.
  *
@@ -203,6 +406,19 @@ PRISM_EXPORTED_FUNCTION void pm_serialize_parse_lex(pm_buffer_t *buffer, const u
  */
 PRISM_EXPORTED_FUNCTION bool pm_parse_success_p(const uint8_t *source, size_t size, const char *data);
 
+/**
+ * Walk the tree that was produced by the given parser and set
+ * PM_NODE_FLAG_MARKED_NEWLINE on the nodes that fire the :line event of the
+ * Ruby VM. This follows the same rules as ParseResult#mark_newlines! in the
+ * Ruby library, so that the extension can hand the result of it over instead
+ * of walking the Ruby tree a second time.
+ *
+ * @param parser The parser that produced the tree.
+ * @param node The root of the tree.
+ * @return True if the nodes were marked, false if an allocation failed.
+ */
+PRISM_EXPORTED_FUNCTION bool pm_node_mark_newlines(const pm_parser_t *parser, pm_node_t *node);
+
 /**
  * Returns a string representation of the given token type.
  *
@@ -243,6 +459,46 @@ PRISM_EXPORTED_FUNCTION void pm_parser_errors_format(const pm_parser_t *parser,
  */
 PRISM_EXPORTED_FUNCTION void pm_dump_json(pm_buffer_t *buffer, const pm_parser_t *parser, const pm_node_t *node);
 
+/**
+ * The kinds of fields that pm_dump_json_stream can dump, which can be combined
+ * to pick the fields that are needed. The type of every node and the fields
+ * that hold child nodes are always dumped.
+ */
+typedef enum {
+    /** The location of every node, along with the location fields. */
+    PM_DUMP_JSON_FIELDS_LOCATIONS = 1 << 0,
+
+    /** The flags fields. */
+    PM_DUMP_JSON_FIELDS_FLAGS = 1 << 1,
+
+    /** The string, constant, integer, and float fields. */
+    PM_DUMP_JSON_FIELDS_VALUES = 1 << 2,
+
+    /** Every field, which is what pm_dump_json dumps. */
+    PM_DUMP_JSON_FIELDS_ALL = (1 << 3) - 1
+} pm_dump_json_fields_t;
+
+/**
+ * This function is used in pm_dump_json_stream to write a chunk of the JSON
+ * out to a stream. It should return false if the write failed, in which case
+ * no more JSON is generated.
+ */
+typedef bool (pm_dump_json_write_t)(const char *data, size_t length, void *stream);
+
+/**
+ * Dump JSON to the given stream. The JSON is generated into a small buffer
+ * that is handed to the write function whenever it fills up, so that the
+ * JSON for a large tree never has to be held in memory all at once.
+ *
+ * @param parser The parser that parsed the node.
+ * @param node The node to serialize.
+ * @param fields The set of pm_dump_json_fields_t values to dump.
+ * @param stream The stream to write to.
+ * @param write The function to use to write to the stream.
+ * @return Whether or not every write succeeded.
+ */
+PRISM_EXPORTED_FUNCTION bool pm_dump_json_stream(const pm_parser_t *parser, const pm_node_t *node, uint32_t fields, void *stream, pm_dump_json_write_t *write);
+
 #endif
 
 /**
@@ -295,6 +551,33 @@ PRISM_EXPORTED_FUNCTION void pm_dump_json(pm_buffer_t *buffer, const pm_parser_t
  * their first member. This means you can downcast and upcast any node in the
  * tree to a `pm_node_t`.
  *
+ * If you are going to parse many sources in a row, you can attach an arena to
+ * the parser with `pm_parser_arena_set` so that the tree is allocated in bulk,
+ * and reuse the parser with `pm_parser_reset` so that its internal buffers are
+ * kept between parses. That would look something like:
+ *
+ * ```c
+ * void parse_all(const uint8_t **sources, const size_t *lengths, size_t count) {
+ *     pm_arena_t arena = { 0 };
+ *     pm_parser_t parser;
+ *
+ *     for (size_t index = 0; index < count; index++) {
+ *         if (index == 0) {
+ *             pm_parser_init(&parser, sources[index], lengths[index], NULL);
+ *             pm_parser_arena_set(&parser, &arena);
+ *         } else {
+ *             pm_parser_reset(&parser, sources[index], lengths[index], NULL);
+ *         }
+ *
+ *         pm_node_t *root = pm_parse(&parser);
+ *         printf("PARSED %s!\n", pm_node_type_to_str(PM_NODE_TYPE(root)));
+ *     }
+ *
+ *     if (count > 0) pm_parser_free(&parser);
+ *     pm_arena_free(&arena);
+ * }
+ * ```
+ *
  * @section serializing Serializing
  *
  * Prism provides the ability to serialize the AST and its related metadata into
@@ -118,6 +118,22 @@
 #   endif
 #endif
 
+/**
+ * Some of the hot loops in the lexer can scan 16 bytes at a time using vector
+ * instructions. We only use instruction sets that are part of the baseline of
+ * the target architecture (SSE2 on x86-64 and NEON on AArch64), so no runtime
+ * CPU detection is necessary. The vector code also relies on GCC and clang
+ * builtins. Every other platform and compiler falls back to portable code.
+ * Define PRISM_EXCLUDE_SIMD to force the portable code on every platform.
+ */
+#if !defined(PRISM_EXCLUDE_SIMD) && (defined(__GNUC__) || defined(__clang__))
+#   if defined(__SSE2__)
+#       define PRISM_HAS_SSE2
+#   elif defined(__aarch64__) && defined(__ARM_NEON)
+#       define PRISM_HAS_NEON
+#   endif
+#endif
+
 /**
  * isinf on Windows is defined as accepting a float, but on POSIX systems it
  * accepts a float, a double, or a long double. We want to mirror this behavior
@@ -89,6 +89,18 @@ typedef struct {
  */
 size_t pm_encoding_utf_8_char_width(const uint8_t *b, ptrdiff_t n);
 
+/**
+ * Return the number of bytes at the start of the string that form a run of
+ * valid multibyte UTF-8 characters. This stops at the first ASCII byte, the
+ * first invalid or truncated character, or after n bytes, whichever comes
+ * first.
+ *
+ * @param b The bytes to read.
+ * @param n The number of bytes that can be read.
+ * @returns The number of bytes in the run of valid multibyte characters.
+ */
+size_t pm_encoding_utf_8_multibyte_run(const uint8_t *b, ptrdiff_t n);
+
 /**
  * Return the size of the next character in the UTF-8 encoding if it is an
  * alphabetical character.
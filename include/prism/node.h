@@ -25,6 +25,17 @@
  */
 void pm_node_list_append(pm_node_list_t *list, pm_node_t *node);
 
+/**
+ * Append a new node onto the end of the node list. If the list needs to grow,
+ * the new memory is allocated out of the given arena. If the arena is NULL,
+ * this is equivalent to pm_node_list_append.
+ *
+ * @param arena The optional arena to allocate from.
+ * @param list The list to append to.
+ * @param node The node to append.
+ */
+void pm_node_list_arena_append(pm_arena_t *arena, pm_node_list_t *list, pm_node_t *node);
+
 /**
  * Prepend a new node onto the beginning of the node list.
  *
@@ -33,6 +44,17 @@ void pm_node_list_append(pm_node_list_t *list, pm_node_t *node);
  */
 void pm_node_list_prepend(pm_node_list_t *list, pm_node_t *node);
 
+/**
+ * Prepend a new node onto the beginning of the node list. If the list needs to
+ * grow, the new memory is allocated out of the given arena. If the arena is
+ * NULL, this is equivalent to pm_node_list_prepend.
+ *
+ * @param arena The optional arena to allocate from.
+ * @param list The list to prepend to.
+ * @param node The node to prepend.
+ */
+void pm_node_list_arena_prepend(pm_arena_t *arena, pm_node_list_t *list, pm_node_t *node);
+
 /**
  * Concatenate the given node list onto the end of the other node list.
  *
@@ -41,6 +63,17 @@ void pm_node_list_prepend(pm_node_list_t *list, pm_node_t *node);
  */
 void pm_node_list_concat(pm_node_list_t *list, pm_node_list_t *other);
 
+/**
+ * Concatenate the given node list onto the end of the other node list. If the
+ * list needs to grow, the new memory is allocated out of the given arena. If
+ * the arena is NULL, this is equivalent to pm_node_list_concat.
+ *
+ * @param arena The optional arena to allocate from.
+ * @param list The list to concatenate onto.
+ * @param other The list to concatenate.
+ */
+void pm_node_list_arena_concat(pm_arena_t *arena, pm_node_list_t *list, pm_node_list_t *other);
+
 /**
  * Free the internal memory associated with the given node list.
  *
@@ -49,7 +82,9 @@ void pm_node_list_concat(pm_node_list_t *list, pm_node_list_t *other);
 void pm_node_list_free(pm_node_list_t *list);
 
 /**
- * Deallocate a node and all of its children.
+ * Deallocate a node and all of its children. If the parser is allocating out of
+ * an arena, this function does nothing and the memory is instead released when
+ * the arena is freed.
  *
  * @param parser The parser that owns the node.
  * @param node The node to deallocate.
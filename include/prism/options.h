@@ -95,6 +95,13 @@ typedef struct {
     /** A bitset of the various options that were set on the command line. */
     uint8_t command_line;
 
+    /**
+     * A bitset of the options that control how the syntax tree is serialized
+     * by the pm_serialize family of functions. These have no effect on the
+     * parse itself.
+     */
+    uint8_t serialization;
+
     /**
     * Whether or not the frozen string literal option has been set.
     * May be:
@@ -103,6 +110,17 @@ typedef struct {
     *  - PM_OPTIONS_FROZEN_STRING_LITERAL_UNSET
     */
     int8_t frozen_string_literal;
+
+    /**
+     * Whether or not the parser should find every newline in the source in a
+     * single pass when it is initialized, as opposed to recording them as they
+     * are lexed. The resulting list covers the entire source from the start of
+     * the parse, including any content after the point where lexing stops
+     * (for example after a NUL byte or an unrecoverable syntax error). This
+     * option is only available through the C API, and is not part of the
+     * serialized options.
+     */
+    bool newline_index;
 } pm_options_t;
 
 /**
@@ -142,6 +160,32 @@ static const uint8_t PM_OPTIONS_COMMAND_LINE_P = 0x10;
  */
 static const uint8_t PM_OPTIONS_COMMAND_LINE_X = 0x20;
 
+/**
+ * A bit representing whether or not only the semantic fields of each node
+ * should be serialized. When it is set, location fields and comments are left
+ * out of the serialized output, which makes it much smaller and faster to
+ * load for consumers that do not need them. The header of the serialized
+ * output records whether or not this was set.
+ */
+static const uint8_t PM_OPTIONS_SERIALIZATION_SEMANTICS_ONLY = 0x1;
+
+/**
+ * A bit representing whether or not the locations of nodes should be
+ * serialized as deltas from the start of the node that contains them, instead
+ * of as absolute offsets into the source. Since most locations are close to the
+ * start of their node, this usually fits each start into a single byte. The
+ * header of the serialized output records whether or not this was set.
+ */
+static const uint8_t PM_OPTIONS_SERIALIZATION_DELTA_LOCATIONS = 0x2;
+
+/**
+ * A bit representing whether or not every node should be prefixed with the
+ * length of its serialized form, instead of only DefNode. This allows a reader
+ * to skip over any subtree without decoding it and to come back to it later.
+ * The header of the serialized output records whether or not this was set.
+ */
+static const uint8_t PM_OPTIONS_SERIALIZATION_NODE_LENGTHS = 0x4;
+
 /**
  * Set the filepath option on the given options struct.
  *
@@ -174,6 +218,14 @@ PRISM_EXPORTED_FUNCTION void pm_options_encoding_set(pm_options_t *options, cons
  */
 PRISM_EXPORTED_FUNCTION void pm_options_frozen_string_literal_set(pm_options_t *options, bool frozen_string_literal);
 
+/**
+ * Set the newline index option on the given options struct.
+ *
+ * @param options The options struct to set the newline index value on.
+ * @param newline_index Whether or not every newline should be found upfront.
+ */
+PRISM_EXPORTED_FUNCTION void pm_options_newline_index_set(pm_options_t *options, bool newline_index);
+
 /**
  * Sets the command line option on the given options struct.
  *
@@ -182,6 +234,14 @@ PRISM_EXPORTED_FUNCTION void pm_options_frozen_string_literal_set(pm_options_t *
  */
 PRISM_EXPORTED_FUNCTION void pm_options_command_line_set(pm_options_t *options, uint8_t command_line);
 
+/**
+ * Sets the serialization option on the given options struct.
+ *
+ * @param options The options struct to set the serialization option on.
+ * @param serialization The serialization value to set.
+ */
+PRISM_EXPORTED_FUNCTION void pm_options_serialization_set(pm_options_t *options, uint8_t serialization);
+
 /**
  * Set the version option on the given options struct by parsing the given
  * string. If the string contains an invalid option, this returns false.
@@ -261,6 +321,7 @@ PRISM_EXPORTED_FUNCTION void pm_options_free(pm_options_t *options);
  * | `1`     | -l command line option     |
  * | `1`     | -a command line option     |
  * | `1`     | the version                |
+ * | `1`     | serialization flags        |
  * | `4`     | the number of scopes       |
  * | ...     | the scopes                 |
  *
@@ -17,6 +17,7 @@ void pm_pack_parse(void);
 
 #else
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -110,7 +111,8 @@ typedef enum pm_pack_result {
     PM_PACK_ERROR_UNKNOWN_DIRECTIVE,
     PM_PACK_ERROR_LENGTH_TOO_BIG,
     PM_PACK_ERROR_BANG_NOT_ALLOWED,
-    PM_PACK_ERROR_DOUBLE_ENDIAN
+    PM_PACK_ERROR_DOUBLE_ENDIAN,
+    PM_PACK_ERROR_NO_MEMORY
 } pm_pack_result;
 
 /**
@@ -149,6 +151,156 @@ pm_pack_parse(
     pm_pack_encoding *encoding
 );
 
+/** A single directive within a compiled pack template. */
+typedef struct pm_pack_directive {
+    /** The type of the directive. */
+    pm_pack_type type;
+
+    /** Whether the value is signed. */
+    pm_pack_signed signed_type;
+
+    /** The endianness of the value. */
+    pm_pack_endian endian;
+
+    /** The size of the value. */
+    pm_pack_size size;
+
+    /** What kind of length is specified. */
+    pm_pack_length_type length_type;
+
+    /** The length of the directive. */
+    uint64_t length;
+
+    /** The offset of the directive within the format string. */
+    size_t start;
+
+    /** The number of bytes of the format string that the directive spans. */
+    size_t source_length;
+} pm_pack_directive_t;
+
+/**
+ * A pack template that has been parsed all at once into a list of directives,
+ * so that it can be inspected again without parsing it again.
+ */
+typedef struct pm_pack_format {
+    /** The directives in the template, up to the first error if any. */
+    pm_pack_directive_t *directives;
+
+    /** The number of directives in the template. */
+    size_t size;
+
+    /**
+     * The encoding of the string that would result from the template, which
+     * is still PM_PACK_ENCODING_START if the template is empty.
+     */
+    pm_pack_encoding encoding;
+
+    /** The result of parsing the template. */
+    pm_pack_result result;
+} pm_pack_format_t;
+
+/**
+ * Parse a whole pack or unpack format string into a list of directives, by
+ * calling pm_pack_parse until the end of the string or the first error.
+ *
+ * @param variant pack or unpack
+ * @param format the format string to parse
+ * @param length the length of the format string
+ * @param compiled the format to fill in, which should be freed with
+ *     pm_pack_format_free afterward regardless of the result
+ * @return `PM_PACK_OK` on success or `PM_PACK_ERROR_*` on error
+ */
+PRISM_EXPORTED_FUNCTION pm_pack_result pm_pack_compile(pm_pack_variant variant, const char *format, size_t length, pm_pack_format_t *compiled);
+
+/**
+ * Free the memory associated with a compiled pack template.
+ *
+ * @param compiled the format to free
+ */
+PRISM_EXPORTED_FUNCTION void pm_pack_format_free(pm_pack_format_t *compiled);
+
+/** An entry in a cache of compiled pack templates. */
+typedef struct pm_pack_cache_entry {
+    /** The format string, which is owned by the entry. */
+    char *source;
+
+    /** The length of the format string. */
+    size_t source_length;
+
+    /** The hash of the variant and the format string. */
+    uint32_t hash;
+
+    /** The variant that the format string was compiled for. */
+    pm_pack_variant variant;
+
+    /** The compiled format. */
+    pm_pack_format_t format;
+
+    /** The next entry in the same bucket. */
+    struct pm_pack_cache_entry *next;
+
+    /** The entry that was used more recently than this one, if any. */
+    struct pm_pack_cache_entry *newer;
+
+    /** The entry that was used less recently than this one, if any. */
+    struct pm_pack_cache_entry *older;
+} pm_pack_cache_entry_t;
+
+/**
+ * A cache of compiled pack templates keyed by the variant and the format
+ * string. When it is full, the least recently used template is evicted to make
+ * room for a new one.
+ */
+typedef struct pm_pack_cache {
+    /** The buckets of the hash table, whose number is a power of two. */
+    pm_pack_cache_entry_t **buckets;
+
+    /** The number of buckets. */
+    size_t buckets_size;
+
+    /** The number of entries in the cache. */
+    size_t size;
+
+    /** The maximum number of entries in the cache. */
+    size_t capacity;
+
+    /** The most recently used entry. */
+    pm_pack_cache_entry_t *newest;
+
+    /** The least recently used entry. */
+    pm_pack_cache_entry_t *oldest;
+} pm_pack_cache_t;
+
+/**
+ * Initialize a cache of compiled pack templates.
+ *
+ * @param cache the cache to initialize
+ * @param capacity the maximum number of templates to hold, at least 1
+ * @return whether or not the cache could be allocated
+ */
+PRISM_EXPORTED_FUNCTION bool pm_pack_cache_init(pm_pack_cache_t *cache, size_t capacity);
+
+/**
+ * Return the compiled form of the given format string, compiling it and adding
+ * it to the cache if it is not already there.
+ *
+ * @param cache the cache to look in
+ * @param variant pack or unpack
+ * @param format the format string
+ * @param length the length of the format string
+ * @return the compiled format, which is owned by the cache and valid until the
+ *     next call to pm_pack_cache_fetch or pm_pack_cache_free, or NULL if an
+ *     allocation failed
+ */
+PRISM_EXPORTED_FUNCTION const pm_pack_format_t * pm_pack_cache_fetch(pm_pack_cache_t *cache, pm_pack_variant variant, const char *format, size_t length);
+
+/**
+ * Free the memory associated with a cache of compiled pack templates.
+ *
+ * @param cache the cache to free
+ */
+PRISM_EXPORTED_FUNCTION void pm_pack_cache_free(pm_pack_cache_t *cache);
+
 /**
  * Prism abstracts sizes away from the native system - this converts an abstract
  * size to a native size.
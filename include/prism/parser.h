@@ -11,6 +11,8 @@
 #include "prism/encoding.h"
 #include "prism/options.h"
 #include "prism/static_literals.h"
+#include "prism/stats.h"
+#include "prism/util/pm_arena.h"
 #include "prism/util/pm_constant_pool.h"
 #include "prism/util/pm_list.h"
 #include "prism/util/pm_newline_list.h"
@@ -502,6 +504,42 @@ typedef struct {
     void (*callback)(void *data, pm_parser_t *parser, pm_token_t *token);
 } pm_lex_callback_t;
 
+/**
+ * A token that was found by pm_lex, along with the state that the lexer was in
+ * once the token was found.
+ */
+typedef struct {
+    /** The token that was found. */
+    pm_token_t token;
+
+    /** The state of the lexer after the token was found. */
+    pm_lex_state_t lex_state;
+} pm_lex_token_t;
+
+/**
+ * The number of tokens that pm_lex accumulates before handing them out.
+ */
+#define PM_LEX_TOKENS_BATCH_SIZE 256
+
+/**
+ * A struct that can be passed to pm_lex to receive the tokens of the source in
+ * batches, as opposed to pm_lex_callback_t which is called once per token.
+ */
+typedef struct {
+    /**
+     * This opaque pointer is passed through to the callback unchanged.
+     */
+    void *data;
+
+    /**
+     * This is the callback that is called with each batch of tokens. It is
+     * passed the opaque data pointer, the parser, and an array of up to
+     * PM_LEX_TOKENS_BATCH_SIZE tokens. The array is only valid for the
+     * duration of the call.
+     */
+    void (*callback)(void *data, pm_parser_t *parser, const pm_lex_token_t *tokens, size_t size);
+} pm_lex_tokens_callback_t;
+
 /** The type of shareable constant value that can be set. */
 typedef uint8_t pm_shareable_constant_value_t;
 static const pm_shareable_constant_value_t PM_SCOPE_SHAREABLE_CONSTANT_NONE = 0x0;
@@ -662,6 +700,13 @@ struct pm_parser {
 
         /** The current index into the lexer mode stack. */
         size_t index;
+
+        /**
+         * Lex modes beyond the pre-allocated stack that have been popped,
+         * linked through their prev pointers, so that they can be reused by
+         * the next push.
+         */
+        pm_lex_mode_t *free;
     } lex_modes;
 
     /** The pointer to the start of the source. */
@@ -713,9 +758,25 @@ struct pm_parser {
     /** The current local scope. */
     pm_scope_t *current_scope;
 
+    /**
+     * Scopes that have been popped, linked through their previous pointers.
+     * These are reused by the next scopes that are pushed (along with the
+     * memory for their locals) so that files with many small blocks do not
+     * allocate for every one. They survive pm_parser_reset.
+     */
+    pm_scope_t *free_scopes;
+
     /** The current parsing context. */
     pm_context_node_t *current_context;
 
+    /**
+     * Context nodes that have been popped, linked through their prev pointers.
+     * These are reused by the next contexts that are pushed, since contexts
+     * are pushed and popped for nearly every construct in the tree. They
+     * survive pm_parser_reset.
+     */
+    pm_context_node_t *free_contexts;
+
     /**
      * The hash keys for the hash that is currently being parsed. This is not
      * usually necessary because it can pass it down the various call chains,
@@ -765,6 +826,15 @@ struct pm_parser {
     /** This is the list of newline offsets in the source file. */
     pm_newline_list_t newline_list;
 
+    /**
+     * An optional arena that the nodes of the tree are allocated out of. When
+     * this is NULL, every node is allocated individually on the heap and must
+     * be released with pm_node_destroy. When it is set, nodes, the lists they
+     * contain, and their owned strings all live in the arena, and the whole
+     * tree is released at once by freeing the arena.
+     */
+    pm_arena_t *arena;
+
     /**
      * We want to add a flag to integer nodes that indicates their base. We only
      * want to parse these once, but we don't have space on the token itself to
@@ -835,6 +905,9 @@ struct pm_parser {
     /** The command line flags given from the options. */
     uint8_t command_line;
 
+    /** The serialization flags given from the options. */
+    uint8_t serialization;
+
     /**
      * Whether or not we have found a frozen_string_literal magic comment with
      * a true or false value.
@@ -884,6 +957,23 @@ struct pm_parser {
      * characters.
      */
     bool current_regular_expression_ascii_only;
+
+    /**
+     * Whether or not the parser should stop looking at the source as soon as
+     * an error has been found. This is used when the caller only cares about
+     * whether or not the source is valid, in which case the lexer treats the
+     * rest of the source as if it were not there. The tree and the diagnostics
+     * that result are therefore incomplete.
+     */
+    bool stop_at_first_error;
+
+#ifdef PRISM_BUILD_STATS
+    /**
+     * The statistics collected about the current parse. These are retrieved
+     * through pm_parser_stats.
+     */
+    pm_parser_stats_t stats;
+#endif
 };
 
 #endif
@@ -20,6 +20,13 @@ typedef struct {
     /** The array of nodes in the hash table. */
     pm_node_t **nodes;
 
+    /**
+     * The hash of each node in the hash table, so that nodes do not need to be
+     * rehashed when the table grows and most mismatches can be rejected
+     * without comparing the nodes. This shares an allocation with nodes.
+     */
+    uint32_t *hashes;
+
     /** The size of the hash table. */
     uint32_t size;
 
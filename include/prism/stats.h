@@ -0,0 +1,94 @@
+/**
+ * @file stats.h
+ *
+ * Counters and timings that the parser can collect about a parse, for finding
+ * out where a given source spends its time.
+ */
+#ifndef PRISM_STATS_H
+#define PRISM_STATS_H
+
+#include "prism/defines.h"
+#include "prism/ast.h"
+
+#include <stdint.h>
+
+/**
+ * The number of entries in the per-type node counts, one for every node type
+ * including the scope node.
+ */
+#define PM_PARSER_STATS_NODE_TYPES ((size_t) PM_SCOPE_NODE + 1)
+
+/**
+ * The statistics that the parser collects as it runs. They are only collected
+ * when prism is compiled with PRISM_BUILD_STATS, as the extra bookkeeping
+ * slows down the lexer and the parser. Timings are in nanoseconds and include
+ * the overhead of reading the clock, which is noticeable for lex_time since
+ * the clock is read around every token.
+ */
+typedef struct {
+    /** The number of tokens that were lexed. */
+    uint64_t tokens;
+
+    /** The number of nodes that were allocated, including discarded ones. */
+    uint64_t nodes_allocated;
+
+    /** The number of bytes that were allocated for nodes. */
+    uint64_t node_bytes_allocated;
+
+    /**
+     * The number of nodes of each type in the resulting tree, indexed by
+     * pm_node_type_t.
+     */
+    uint64_t nodes[PM_PARSER_STATS_NODE_TYPES];
+
+    /** The number of times a constant was inserted into the constant pool. */
+    uint64_t constant_pool_inserts;
+
+    /**
+     * The number of occupied buckets that were passed over while inserting
+     * constants into the constant pool.
+     */
+    uint64_t constant_pool_collisions;
+
+    /** The number of lex modes that were pushed. */
+    uint64_t lex_mode_pushes;
+
+    /** The number of contexts that were pushed. */
+    uint64_t context_pushes;
+
+    /** The number of bytes that pm_strpbrk scanned over. */
+    uint64_t strpbrk_bytes;
+
+    /** The time spent lexing tokens, which is a part of parse_time. */
+    uint64_t lex_time;
+
+    /** The time spent in pm_parse. */
+    uint64_t parse_time;
+
+    /** The time spent in pm_serialize. */
+    uint64_t serialize_time;
+} pm_parser_stats_t;
+
+#ifdef PRISM_BUILD_STATS
+
+/**
+ * Add the given value to one of the counters in the statistics of the given
+ * parser.
+ */
+#define PM_STATS_ADD(parser, field, value) ((parser)->stats.field += (uint64_t) (value))
+
+/**
+ * Return the current value of a monotonic clock in nanoseconds.
+ *
+ * @return The current time in nanoseconds.
+ */
+uint64_t pm_stats_time(void);
+
+#else
+
+/** Collecting statistics is disabled, so this does nothing. */
+#define PM_STATS_ADD(parser, field, value) ((void) 0)
+
+#endif
+
+#endif
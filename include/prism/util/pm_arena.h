@@ -0,0 +1,140 @@
+/**
+ * @file pm_arena.h
+ *
+ * A bump allocator that hands out memory from a linked list of large blocks.
+ */
+#ifndef PRISM_ARENA_H
+#define PRISM_ARENA_H
+
+#include "prism/defines.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The size of the first block that is allocated by an arena that has not been
+ * given an explicit size hint. Each subsequent block doubles in size until it
+ * reaches PM_ARENA_BLOCK_SIZE_MAX.
+ */
+#define PM_ARENA_BLOCK_SIZE_MIN ((size_t) 4096)
+
+/**
+ * The largest size that an arena will grow a block to by default. Allocations
+ * that are larger than this will still succeed, but will receive a block of
+ * their own.
+ */
+#define PM_ARENA_BLOCK_SIZE_MAX ((size_t) (1 << 20))
+
+/**
+ * A single block of memory within an arena. The memory that is handed out is
+ * carved out of the bytes that directly follow this header.
+ */
+typedef struct pm_arena_block {
+    /** The block that was allocated before this one, or NULL. */
+    struct pm_arena_block *previous;
+
+    /** The number of bytes available after the header of this block. */
+    size_t capacity;
+
+    /** The number of bytes that have been handed out from this block. */
+    size_t size;
+} pm_arena_block_t;
+
+/**
+ * An arena is a region of memory from which allocations are made by bumping a
+ * pointer. Individual allocations are never freed. Instead, all of the memory
+ * is released at once when the arena is freed. This makes it well-suited to
+ * holding the nodes of a syntax tree, which all share the same lifetime.
+ *
+ * An arena that is zero-initialized is valid and empty. No memory is allocated
+ * until the first call to pm_arena_alloc.
+ */
+typedef struct {
+    /** The block that allocations are currently being made from. */
+    pm_arena_block_t *current;
+
+    /** The size of the next block that will be allocated. */
+    size_t next_block_size;
+
+    /** The total number of bytes that have been allocated for blocks. */
+    size_t capacity;
+} pm_arena_t;
+
+/**
+ * Initialize an arena with a hint as to how much memory it is going to need.
+ * This does not allocate, it only sizes the first block.
+ *
+ * @param arena The arena to initialize.
+ * @param size_hint The expected total size of all allocations.
+ */
+void pm_arena_init(pm_arena_t *arena, size_t size_hint);
+
+/**
+ * Allocate memory from the arena. The memory is suitably aligned for any of
+ * the structures in the syntax tree, but it is not zeroed.
+ *
+ * @param arena The arena to allocate from.
+ * @param size The number of bytes to allocate.
+ * @return A pointer to the allocated memory, or NULL if the allocation failed.
+ */
+void * pm_arena_alloc(pm_arena_t *arena, size_t size);
+
+/**
+ * Resize an allocation that was previously made from the arena. If the
+ * allocation was the most recent one made from the current block and there is
+ * room left in that block, it will be resized in place. Otherwise a new
+ * allocation is made and the contents are copied over. The memory for the old
+ * allocation is not reclaimed until the arena is freed.
+ *
+ * @param arena The arena that owns the allocation.
+ * @param pointer The allocation to resize, which may be NULL.
+ * @param old_size The size that was previously requested for the allocation.
+ * @param new_size The requested size of the allocation.
+ * @return A pointer to the resized memory, or NULL if the allocation failed.
+ */
+void * pm_arena_realloc(pm_arena_t *arena, void *pointer, size_t old_size, size_t new_size);
+
+/**
+ * Copy the given bytes into memory allocated from the arena.
+ *
+ * @param arena The arena to allocate from.
+ * @param source The bytes to copy.
+ * @param size The number of bytes to copy.
+ * @return A pointer to the copied bytes, or NULL if the allocation failed.
+ */
+void * pm_arena_memdup(pm_arena_t *arena, const void *source, size_t size);
+
+/**
+ * Returns the number of bytes that have been allocated for blocks within the
+ * arena, including the space that has not yet been handed out.
+ *
+ * @param arena The arena to measure.
+ * @return The memory footprint of the arena in bytes.
+ */
+size_t pm_arena_memsize(const pm_arena_t *arena);
+
+/**
+ * Release every allocation that has been made from the arena while retaining
+ * its memory for future allocations. If the arena spans multiple blocks, they
+ * are coalesced into a single block large enough to hold all of them, so that
+ * a workload of similar size can be served again without allocating. Every
+ * pointer that was handed out by the arena is invalid after this call.
+ *
+ * @param arena The arena to reset.
+ */
+void pm_arena_reset(pm_arena_t *arena);
+
+/**
+ * Free all of the memory associated with the arena. Every pointer that was
+ * handed out by the arena is invalid after this call. The arena may be reused
+ * after it has been freed.
+ *
+ * @param arena The arena to free.
+ */
+PRISM_EXPORTED_FUNCTION void pm_arena_free(pm_arena_t *arena);
+
+#endif
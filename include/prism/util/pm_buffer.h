@@ -70,6 +70,17 @@ PRISM_EXPORTED_FUNCTION char * pm_buffer_value(const pm_buffer_t *buffer);
  */
 PRISM_EXPORTED_FUNCTION size_t pm_buffer_length(const pm_buffer_t *buffer);
 
+/**
+ * Ensure that the buffer has space for at least the given number of additional
+ * bytes, so that a caller that knows (or can estimate) how much it is about to
+ * write can grow the buffer once instead of as it goes.
+ *
+ * @param buffer The buffer to reserve space in.
+ * @param length The number of additional bytes to reserve.
+ * @return Whether or not the space was successfully reserved.
+ */
+bool pm_buffer_reserve(pm_buffer_t *buffer, size_t length);
+
 /**
  * Append the given amount of space as zeroes to the buffer.
  *
@@ -129,6 +140,14 @@ void pm_buffer_append_varuint(pm_buffer_t *buffer, uint32_t value);
  */
 void pm_buffer_append_varsint(pm_buffer_t *buffer, int32_t value);
 
+/**
+ * Append a 32-bit unsigned integer to the buffer as decimal digits.
+ *
+ * @param buffer The buffer to append to.
+ * @param value The integer to append.
+ */
+void pm_buffer_append_decimal(pm_buffer_t *buffer, uint32_t value);
+
 /**
  * Append a double to the buffer.
  *
@@ -179,7 +198,7 @@ void pm_buffer_concat(pm_buffer_t *destination, const pm_buffer_t *source);
  *
  * @param buffer The buffer to clear.
  */
-void pm_buffer_clear(pm_buffer_t *buffer);
+PRISM_EXPORTED_FUNCTION void pm_buffer_clear(pm_buffer_t *buffer);
 
 /**
  * Strip the whitespace from the end of the buffer.
@@ -48,6 +48,43 @@ pm_strspn_whitespace_newlines(const uint8_t *string, ptrdiff_t length, pm_newlin
  */
 size_t pm_strspn_inline_whitespace(const uint8_t *string, ptrdiff_t length);
 
+/**
+ * Returns the number of characters at the start of the string that are spaces,
+ * tabs, form feeds, or vertical tabs. This is every kind of inline whitespace
+ * except for carriage returns, which the lexer needs to handle separately.
+ * Disallows searching past the given maximum number of characters.
+ *
+ * @param string The string to search.
+ * @param length The maximum number of characters to search.
+ * @return The number of characters at the start of the string that are spaces,
+ *     tabs, form feeds, or vertical tabs.
+ */
+size_t pm_strspn_blank(const uint8_t *string, ptrdiff_t length);
+
+/**
+ * Returns the number of characters at the start of the string that are ASCII
+ * letters, digits, or underscores, which is the common case for the characters
+ * of an identifier. Multi-byte characters are not included, and are left for
+ * the caller to check. Disallows searching past the given maximum number of
+ * characters.
+ *
+ * @param string The string to search.
+ * @param length The maximum number of characters to search.
+ * @return The number of characters at the start of the string that are ASCII
+ *     letters, digits, or underscores.
+ */
+size_t pm_strspn_identifier(const uint8_t *string, ptrdiff_t length);
+
+/**
+ * Returns the number of characters at the start of the string that are ASCII.
+ * Disallows searching past the given maximum number of characters.
+ *
+ * @param string The string to search.
+ * @param length The maximum number of characters to search.
+ * @return The number of characters at the start of the string that are ASCII.
+ */
+size_t pm_strspn_ascii(const uint8_t *string, ptrdiff_t length);
+
 /**
  * Returns the number of characters at the start of the string that are decimal
  * digits. Disallows searching past the given maximum number of characters.
@@ -151,6 +151,14 @@ typedef struct {
 
     /** The number of buckets that have been allocated in the hash map. */
     uint32_t capacity;
+
+#ifdef PRISM_BUILD_STATS
+    /** The number of constants that have been inserted. */
+    uint64_t inserts;
+
+    /** The number of occupied buckets passed over while inserting. */
+    uint64_t collisions;
+#endif
 } pm_constant_pool_t;
 
 /**
@@ -216,6 +224,49 @@ pm_constant_id_t pm_constant_pool_insert_owned(pm_constant_pool_t *pool, uint8_t
  */
 pm_constant_id_t pm_constant_pool_insert_constant(pm_constant_pool_t *pool, const uint8_t *start, size_t length);
 
+/**
+ * Find a string within the set of common constants that is generated from the
+ * constants list in config.yml. These are the identifiers that show up in most
+ * Ruby files, like `new`, `initialize`, and `require`. Each one has an id that
+ * is stable across every parse (though not across versions of prism), so
+ * consumers can use it to cache data for a constant across files, e.g.,
+ * through pm_constant_pool_common_find(constant->start, constant->length).
+ * Returns the id of the common constant, or 0 if the string is not one of
+ * them.
+ *
+ * Common ids are their own namespace, distinct from the ids of any particular
+ * constant pool.
+ *
+ * @param start A pointer to the start of the string.
+ * @param length The length of the string.
+ * @return The stable id of the common constant.
+ */
+pm_constant_id_t pm_constant_pool_common_find(const uint8_t *start, size_t length);
+
+/**
+ * Return the common constant with the given stable id.
+ *
+ * @param common_id The stable id of the common constant.
+ * @return A pointer to the common constant.
+ */
+const pm_constant_t * pm_constant_pool_common_constant(pm_constant_id_t common_id);
+
+/**
+ * Return the number of common constants. Stable ids are in the range from 1 to
+ * this number, inclusive.
+ *
+ * @return The number of common constants.
+ */
+uint32_t pm_constant_pool_common_size(void);
+
+/**
+ * Remove all of the constants from a constant pool while keeping its buckets
+ * allocated so that it can be reused without growing again.
+ *
+ * @param pool The pool to clear.
+ */
+void pm_constant_pool_clear(pm_constant_pool_t *pool);
+
 /**
  * Free the memory associated with a constant pool.
  *
@@ -37,6 +37,13 @@ typedef struct {
 
     /** The list of offsets. */
     size_t *offsets;
+
+    /**
+     * Whether or not the list already holds every newline in the source
+     * because it was built by pm_newline_list_index. In that case appending
+     * is a no-op.
+     */
+    bool indexed;
 } pm_newline_list_t;
 
 /**
@@ -61,6 +68,20 @@ typedef struct {
  */
 bool pm_newline_list_init(pm_newline_list_t *list, const uint8_t *start, size_t capacity);
 
+/**
+ * Fill the list with the offset of every newline in the source in a single
+ * pass, replacing any offsets that were already in the list. The list is
+ * resized to hold exactly the number of newlines that were found unless it
+ * already has enough capacity. After this call, appending to the list is a
+ * no-op until the list is cleared.
+ *
+ * @param list The list to fill.
+ * @param start A pointer to the start of the source string.
+ * @param length The length of the source string in bytes.
+ * @return True if the allocation of the offsets succeeds, otherwise false.
+ */
+bool pm_newline_list_index(pm_newline_list_t *list, const uint8_t *start, size_t length);
+
 /**
  * Clear out the newlines that have been appended to the list.
  *
@@ -71,7 +92,8 @@ pm_newline_list_clear(pm_newline_list_t *list);
 
 /**
  * Append a new offset to the newline list. Returns true if the reallocation of
- * the offsets succeeds (if one was necessary), otherwise returns false.
+ * the offsets succeeds (if one was necessary), otherwise returns false. If the
+ * list has been filled by pm_newline_list_index, then this does nothing.
  *
  * @param list The list to append to.
  * @param cursor A pointer to the offset to append.
@@ -92,6 +114,24 @@ bool pm_newline_list_append(pm_newline_list_t *list, const uint8_t *cursor);
  */
 pm_line_column_t pm_newline_list_line_column(const pm_newline_list_t *list, const uint8_t *cursor, int32_t start_line);
 
+/**
+ * Returns the line and column of the given offset, using a hint to avoid
+ * searching the whole list. The hint is the index of the line that the search
+ * starts from. If the offset is on that line or one of the few lines right
+ * after it, the result is found without a binary search. The hint is then
+ * updated to the index of the line that was found. This makes it cheap to look
+ * up many offsets in increasing order by passing the same hint to each call.
+ * A hint of 0 is always valid.
+ *
+ * @param list The list to search.
+ * @param cursor A pointer to the offset to search for.
+ * @param start_line The line to start counting from.
+ * @param hint The index of the line to start searching from, which will be
+ *     updated to the index of the line that was found.
+ * @return The line and column of the given offset.
+ */
+pm_line_column_t pm_newline_list_line_column_hint(const pm_newline_list_t *list, const uint8_t *cursor, int32_t start_line, size_t *hint);
+
 /**
  * Free the internal memory allocated for the newline list.
  *
@@ -18,6 +18,7 @@
 #ifdef _WIN32
 #include <windows.h>
 #elif defined(_POSIX_MAPPED_FILES)
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
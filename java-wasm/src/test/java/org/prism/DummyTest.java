@@ -6,11 +6,13 @@ import com.dylibso.chicory.wasm.types.Value;
 import org.junit.jupiter.api.Test;
 
 import java.io.File;
+import java.nio.ByteBuffer;
 import java.nio.charset.StandardCharsets;
 import java.util.Arrays;
 import java.util.EnumSet;
 
 import static org.junit.jupiter.api.Assertions.assertEquals;
+import static org.junit.jupiter.api.Assertions.assertFalse;
 import static org.junit.jupiter.api.Assertions.assertTrue;
 
 public class DummyTest {
@@ -118,4 +120,58 @@ public class DummyTest {
         assertTrue(pr.value.childNodes()[0].toString().contains("CallNode"));
     }
 
+    @Test
+    public void test3() {
+        var wasmPrism = Module.builder("prism.wasm").build().instantiate();
+        var memory = wasmPrism.memory();
+        var calloc = wasmPrism.export("calloc");
+        var pmSerializeParse = wasmPrism.export("pm_serialize_parse");
+        var pmBufferInit = wasmPrism.export("pm_buffer_init");
+        var pmBufferSizeof = wasmPrism.export("pm_buffer_sizeof");
+        var pmBufferValue = wasmPrism.export("pm_buffer_value");
+        var pmBufferLength = wasmPrism.export("pm_buffer_length");
+
+        // The Ruby source code to be processed, which has a syntax error
+        var source = "def foo(bar";
+        var sourceBytes = source.getBytes(StandardCharsets.US_ASCII);
+
+        var sourcePointer = calloc.apply(Value.i32(1), Value.i32(source.length()));
+        memory.writeString(sourcePointer[0].asInt(), source);
+
+        var packedOptions = ParsingOptions.serialize(
+            new byte[] {},
+            1,
+            new byte[] {},
+            false,
+            EnumSet.noneOf(ParsingOptions.CommandLine.class),
+            ParsingOptions.SyntaxVersion.LATEST,
+            new byte[][][] {}
+        );
+
+        var optionsPointer = calloc.apply(Value.i32(1), Value.i32(packedOptions.length));
+        memory.write(optionsPointer[0].asInt(), packedOptions);
+
+        var bufferPointer = calloc.apply(pmBufferSizeof.apply()[0], Value.i32(1));
+        pmBufferInit.apply(bufferPointer);
+
+        pmSerializeParse.apply(
+                bufferPointer[0], sourcePointer[0], Value.i32(source.length()), optionsPointer[0]);
+
+        var result = memory.readBytes(
+                pmBufferValue.apply(bufferPointer[0])[0].asInt(),
+                pmBufferLength.apply(bufferPointer[0])[0].asInt());
+
+        var serialized = ByteBuffer.allocateDirect(result.length);
+        serialized.put(result).flip();
+
+        LazyParseResult pr = Loader.loadLazy(serialized, sourceBytes);
+
+        assertTrue(pr.errors.length > 0);
+        assertFalse(pr.isLoaded());
+
+        assertEquals(1, pr.getValue().childNodes().length);
+        assertTrue(pr.isLoaded());
+        assertTrue(pr.getValue().childNodes()[0].toString().contains("DefNode"));
+    }
+
 }
@@ -0,0 +1,55 @@
+package org.prism;
+
+/**
+ * The result of loading a serialized parse without building the tree. The
+ * magic comments, data location, errors, and warnings are loaded up front,
+ * since they are small and are often all that is needed, while the nodes are
+ * only loaded the first time getValue() is called.
+ *
+ * Until then the serialized bytes are read in place, so when they are given
+ * as a direct ByteBuffer they are never copied onto the Java heap. The buffer
+ * must not be modified or released until the value has been loaded, after
+ * which it is no longer referenced.
+ */
+// @formatter:off
+public final class LazyParseResult {
+
+    private Loader loader;
+    private Nodes.Node value;
+
+    public final ParseResult.MagicComment[] magicComments;
+    public final Nodes.Location dataLocation;
+    public final ParseResult.Error[] errors;
+    public final ParseResult.Warning[] warnings;
+    public final Nodes.Source source;
+
+    LazyParseResult(Loader loader, ParseResult.MagicComment[] magicComments, Nodes.Location dataLocation, ParseResult.Error[] errors, ParseResult.Warning[] warnings, Nodes.Source source) {
+        this.loader = loader;
+        this.magicComments = magicComments;
+        this.dataLocation = dataLocation;
+        this.errors = errors;
+        this.warnings = warnings;
+        this.source = source;
+    }
+
+    /** Whether or not the nodes have been loaded yet. */
+    public synchronized boolean isLoaded() {
+        return loader == null;
+    }
+
+    /** Load the nodes if they have not been loaded yet, and return the root. */
+    public synchronized Nodes.Node getValue() {
+        if (loader != null) {
+            value = loader.loadValue();
+            loader = null;
+        }
+
+        return value;
+    }
+
+    /** Load the nodes, and return the same result as an eager load would. */
+    public ParseResult toParseResult() {
+        return new ParseResult(getValue(), magicComments, dataLocation, errors, warnings, source);
+    }
+}
+// @formatter:on
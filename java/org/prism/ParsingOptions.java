@@ -35,7 +35,16 @@ public abstract class ParsingOptions {
     public enum CommandLine { A, E, L, N, P, X };
 
     /**
-     * Serialize parsing options into byte array.
+     * The options that control how the syntax tree is serialized.
+     * See PM_OPTIONS_SERIALIZATION_* in include/prism/options.h.
+     *
+     * NOTE: positions should match PM_OPTIONS_SERIALIZATION_* constants values
+     */
+    public enum Serialization { SEMANTICS_ONLY, DELTA_LOCATIONS, NODE_LENGTHS };
+
+    /**
+     * Serialize parsing options into byte array. The serialized output will only contain the semantic fields of each
+     * node, which is what the Loader expects.
      *
      * @param filepath the name of the file that is currently being parsed
      * @param line the line within the file that the parser starts on. This value is 1-indexed
@@ -47,6 +56,24 @@ public abstract class ParsingOptions {
      *            ordered from the outermost scope to the innermost one
      */
     public static byte[] serialize(byte[] filepath, int line, byte[] encoding, boolean frozenStringLiteral, EnumSet<CommandLine> commandLine, SyntaxVersion version, byte[][][] scopes) {
+        return serialize(filepath, line, encoding, frozenStringLiteral, commandLine, version, EnumSet.of(Serialization.SEMANTICS_ONLY), scopes);
+    }
+
+    /**
+     * Serialize parsing options into byte array.
+     *
+     * @param filepath the name of the file that is currently being parsed
+     * @param line the line within the file that the parser starts on. This value is 1-indexed
+     * @param encoding the name of the encoding that the source file is in
+     * @param frozenStringLiteral whether the frozen string literal option has been set
+     * @param commandLine the set of flags that were set on the command line
+     * @param version code of Ruby version which syntax will be used to parse
+     * @param serialization the set of options that control how the syntax tree is serialized. The Loader requires
+     *            SEMANTICS_ONLY to be set
+     * @param scopes scopes surrounding the code that is being parsed with local variable names defined in every scope
+     *            ordered from the outermost scope to the innermost one
+     */
+    public static byte[] serialize(byte[] filepath, int line, byte[] encoding, boolean frozenStringLiteral, EnumSet<CommandLine> commandLine, SyntaxVersion version, EnumSet<Serialization> serialization, byte[][][] scopes) {
         final ByteArrayOutputStream output = new ByteArrayOutputStream();
 
         // filepath
@@ -69,6 +96,9 @@ public abstract class ParsingOptions {
         // version
         output.write(version.getValue());
 
+        // serialization
+        output.write(serializeEnumSet(serialization));
+
         // scopes
 
         // number of scopes
@@ -3,15 +3,20 @@ import { readFile } from "node:fs/promises";
 import { fileURLToPath } from "node:url";
 
 import { ParseResult } from "./deserialize.js";
-import { parsePrism } from "./parsePrism.js";
+import { parsePrism, parsePrismBatch } from "./parsePrism.js";
 
 export * from "./visitor.js";
 export * from "./nodes.js";
 
 /**
- * Load the prism wasm module and return a parse function.
+ * Load the prism wasm module and return a parse function. The function also
+ * has a batch property, which parses an array of sources with the same options
+ * and returns an array of results.
  *
- * @returns {Promise<(source: string) => ParseResult>}
+ * @returns {Promise<{
+ *   (source: string | Uint8Array, options?: Object): ParseResult,
+ *   batch: (sources: Iterable<string | Uint8Array>, options?: Object) => ParseResult[]
+ * }>}
  */
 export async function loadPrism() {
   const wasm = await WebAssembly.compile(await readFile(fileURLToPath(new URL("prism.wasm", import.meta.url))));
@@ -20,7 +25,13 @@ export async function loadPrism() {
   const instance = await WebAssembly.instantiate(wasm, wasi.getImportObject());
   wasi.initialize(instance);
 
-  return function (source) {
-    return parsePrism(instance.exports, source);
-  }
+  const parse = function (source, options = {}) {
+    return parsePrism(instance.exports, source, options);
+  };
+
+  parse.batch = function (sources, options = {}) {
+    return parsePrismBatch(instance.exports, sources, options);
+  };
+
+  return parse;
 }
@@ -3,36 +3,139 @@ import { ParseResult, deserialize } from "./deserialize.js";
 /**
  * Parse the given source code.
  *
+ * The source can either be a string, or a Uint8Array that already holds the
+ * source encoded as UTF-8, in which case it is not encoded again.
+ *
  * @param {WebAssembly.Exports} prism
- * @param {string} source
+ * @param {string | Uint8Array} source
  * @param {Object} options
  * @returns {ParseResult}
  */
 export function parsePrism(prism, source, options = {}) {
-  const sourceArray = new TextEncoder().encode(source);
-  const sourcePointer = prism.calloc(1, sourceArray.length);
+  const scratch = scratchFor(prism);
+  writeOptions(prism, scratch, options);
+  return parseScratch(prism, scratch, source);
+}
+
+/**
+ * Parse each of the given sources with the same options. This is the same as
+ * calling parsePrism for each source, except that the options are only
+ * serialized once.
+ *
+ * @param {WebAssembly.Exports} prism
+ * @param {Iterable<string | Uint8Array>} sources
+ * @param {Object} options
+ * @returns {ParseResult[]}
+ */
+export function parsePrismBatch(prism, sources, options = {}) {
+  const scratch = scratchFor(prism);
+  writeOptions(prism, scratch, options);
+
+  const results = [];
+  for (const source of sources) {
+    results.push(parseScratch(prism, scratch, source));
+  }
+
+  return results;
+}
+
+// The memory that is reused between parses, keyed by the exports of the
+// instance that it was allocated in. It is released along with the instance.
+const SCRATCH = new WeakMap();
+const ENCODER = new TextEncoder();
+
+// Returns the scratch memory for the given instance, allocating it the first
+// time the instance is used. The source and options regions grow as needed,
+// and the output buffer is cleared rather than freed after each parse.
+function scratchFor(prism) {
+  let scratch = SCRATCH.get(prism);
+
+  if (scratch === undefined) {
+    const bufferPointer = prism.calloc(prism.pm_buffer_sizeof(), 1);
+    prism.pm_buffer_init(bufferPointer);
+
+    scratch = {
+      sourcePointer: 0,
+      sourceCapacity: 0,
+      optionsPointer: 0,
+      optionsCapacity: 0,
+      bufferPointer
+    };
+
+    SCRATCH.set(prism, scratch);
+  }
+
+  return scratch;
+}
+
+// Ensure that the region with the given name has at least the given number
+// of bytes of capacity.
+function reserve(prism, scratch, name, size) {
+  const capacity = scratch[`${name}Capacity`];
+  if (capacity >= size && capacity > 0) {
+    return;
+  }
 
+  let newCapacity = Math.max(capacity * 2, 1024);
+  while (newCapacity < size) {
+    newCapacity *= 2;
+  }
+
+  if (scratch[`${name}Pointer`] !== 0) {
+    prism.free(scratch[`${name}Pointer`]);
+  }
+
+  const pointer = prism.calloc(1, newCapacity);
+  if (pointer === 0) {
+    throw new Error(`Failed to allocate ${newCapacity} bytes`);
+  }
+
+  scratch[`${name}Pointer`] = pointer;
+  scratch[`${name}Capacity`] = newCapacity;
+}
+
+// Serialize the options into the options region of the scratch memory.
+function writeOptions(prism, scratch, options) {
   const packedOptions = dumpOptions(options);
-  const optionsPointer = prism.calloc(1, packedOptions.length);
+  reserve(prism, scratch, "options", packedOptions.length);
+  new Uint8Array(prism.memory.buffer, scratch.optionsPointer, packedOptions.length).set(packedOptions);
+}
 
-  const bufferPointer = prism.calloc(prism.pm_buffer_sizeof(), 1);
-  prism.pm_buffer_init(bufferPointer);
+// Copy the source into the source region of the scratch memory, returning its
+// length in bytes. Strings are encoded directly into the region.
+function writeSource(prism, scratch, source) {
+  if (source instanceof Uint8Array) {
+    reserve(prism, scratch, "source", source.length);
+    new Uint8Array(prism.memory.buffer, scratch.sourcePointer, source.length).set(source);
+    return source.length;
+  }
 
-  const sourceView = new Uint8Array(prism.memory.buffer, sourcePointer, sourceArray.length);
-  sourceView.set(sourceArray);
+  if (typeof source !== "string") {
+    throw new TypeError("source must be a string or a Uint8Array");
+  }
 
-  const optionsView = new Uint8Array(prism.memory.buffer, optionsPointer, packedOptions.length);
-  optionsView.set(packedOptions);
+  // Each UTF-16 code unit encodes to at most three bytes of UTF-8.
+  reserve(prism, scratch, "source", source.length * 3);
+  const view = new Uint8Array(prism.memory.buffer, scratch.sourcePointer, scratch.sourceCapacity);
+  return ENCODER.encodeInto(source, view).written;
+}
 
-  prism.pm_serialize_parse(bufferPointer, sourcePointer, sourceArray.length, optionsPointer);
-  const serializedView = new Uint8Array(prism.memory.buffer, prism.pm_buffer_value(bufferPointer), prism.pm_buffer_length(bufferPointer));
-  const result = deserialize(sourceArray, serializedView);
+// Parse the given source using the options that have already been written
+// into the scratch memory.
+function parseScratch(prism, scratch, source) {
+  const length = writeSource(prism, scratch, source);
+  const { sourcePointer, optionsPointer, bufferPointer } = scratch;
 
-  prism.pm_buffer_free(bufferPointer);
-  prism.free(sourcePointer);
-  prism.free(bufferPointer);
-  prism.free(optionsPointer);
-  return result;
+  prism.pm_buffer_clear(bufferPointer);
+  prism.pm_serialize_parse(bufferPointer, sourcePointer, length, optionsPointer);
+
+  // The views are created after parsing, since the memory may have grown
+  // while parsing, which detaches any views that were created before. The
+  // deserializer reads directly out of these views, and everything that it
+  // returns has been decoded before the memory is reused.
+  const sourceView = new Uint8Array(prism.memory.buffer, sourcePointer, length);
+  const serializedView = new Uint8Array(prism.memory.buffer, prism.pm_buffer_value(bufferPointer), prism.pm_buffer_length(bufferPointer));
+  return deserialize(sourceView, serializedView);
 }
 
 // Dump the command line options into a serialized format.
@@ -106,6 +209,9 @@ function dumpOptions(options) {
     throw new Error(`Unsupported version '${options.version}' in compiler options`);
   }
 
+  template.push("C");
+  values.push((options.semantics_only ? 1 : 0) | (options.delta_locations ? 2 : 0));
+
   template.push("L");
   if (options.scopes) {
     const scopes = options.scopes;
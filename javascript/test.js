@@ -108,3 +108,26 @@ test("double", () => {
   const result = parse("1.0");
   assert(result.value.statements.body[0].value == 1.0);
 });
+
+test("Uint8Array source", () => {
+  const result = parse(new TextEncoder().encode('"café"'));
+  assert(result.value.statements.body[0].unescaped === "café");
+});
+
+test("reuse", () => {
+  const large = "foo = 1\n".repeat(10000);
+  assert(parse(large).value.statements.body.length === 10000);
+
+  const result = parse("bar");
+  assert(result.value.statements.body.length === 1);
+  assert(result.value.statements.body[0].name === "bar");
+});
+
+test("batch", () => {
+  const results = parse.batch(["foo", new TextEncoder().encode("bar = 1"), ""]);
+
+  assert(results.length === 3);
+  assert(results[0].value.statements.body[0].name === "foo");
+  assert(results[1].value.locals[0] === "bar");
+  assert(results[2].value.statements.body.length === 0);
+});
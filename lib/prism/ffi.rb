@@ -81,6 +81,8 @@ module Prism
       "pm_serialize_parse_comments",
       "pm_serialize_lex",
       "pm_serialize_parse_lex",
+      "pm_serialize_parse_cache",
+      "pm_serialize_cache_valid_p",
       "pm_parse_success_p",
       [:pm_parse_stream_fgets_t]
     )
@@ -210,6 +212,23 @@ module Prism
       LibRubyParser::PrismString.with_file(filepath) { |string| dump_common(string, options) }
     end
 
+    # Mirror the Prism.dump_cache API by using the serialization API.
+    def dump_cache(code, **options)
+      LibRubyParser::PrismString.with_string(code) do |string|
+        LibRubyParser::PrismBuffer.with do |buffer|
+          LibRubyParser.pm_serialize_parse_cache(buffer.pointer, string.pointer, string.length, dump_options(options))
+          buffer.read
+        end
+      end
+    end
+
+    # Mirror the Prism.cache_valid? API by using the serialization API.
+    def cache_valid?(cache, code, **options)
+      LibRubyParser::PrismString.with_string(code) do |string|
+        LibRubyParser.pm_serialize_cache_valid_p(cache, cache.bytesize, string.pointer, string.length, dump_options(options))
+      end
+    end
+
     # Mirror the Prism.lex API by using the serialization API.
     def lex(code, **options)
       LibRubyParser::PrismString.with_string(code) { |string| lex_common(string, code, options) }
@@ -234,6 +253,18 @@ module Prism
       LibRubyParser::PrismString.with_file(filepath) { |string| parse_common(string, string.read, options) }
     end
 
+    # Mirror the Prism.parse_lazy API. The tree is deserialized all at once, so
+    # this is the same as Prism.parse.
+    def parse_lazy(code, **options)
+      parse(code, **options)
+    end
+
+    # Mirror the Prism.parse_file_lazy API. The tree is deserialized all at
+    # once, so this is the same as Prism.parse_file.
+    def parse_file_lazy(filepath, **options)
+      parse_file(filepath, **options)
+    end
+
     # Mirror the Prism.parse_stream API by using the serialization API.
     def parse_stream(stream, **options)
       LibRubyParser::PrismBuffer.with do |buffer|
@@ -302,6 +333,13 @@ module Prism
       !parse_file_success?(filepath, **options)
     end
 
+    # Mirror the Prism.parse_files API by using the serialization API. The FFI
+    # backend parses the files one after another on the calling thread, so the
+    # threads option is accepted for compatibility and otherwise ignored.
+    def parse_files(filepaths, threads: nil, **options)
+      filepaths.map { |filepath| parse_file(filepath, **options) }
+    end
+
     private
 
     def dump_common(string, options) # :nodoc:
@@ -410,6 +448,9 @@ module Prism
       template << "C"
       values << { nil => 0, "3.3.0" => 1, "3.3.1" => 1, "3.4.0" => 0, "latest" => 0 }.fetch(options[:version])
 
+      template << "C"
+      values << ((options.fetch(:semantics_only, false) ? 1 : 0) | (options.fetch(:delta_locations, false) ? 2 : 0) | (options.fetch(:node_lengths, false) ? 4 : 0))
+
       template << "L"
       if (scopes = options[:scopes])
         values << scopes.length
@@ -434,4 +475,21 @@ module Prism
       values.pack(template)
     end
   end
+
+  # Mirror the Prism::ReusableParser API. The FFI backend goes through the
+  # serialization API, which does not retain a native parser between calls, so
+  # these methods delegate to their module-level counterparts and do not reuse
+  # any memory between calls.
+  class ReusableParser
+    # Mirror the Prism::ReusableParser#parse API by using the serialization API.
+    def parse(code, **options)
+      Prism.parse(code, **options)
+    end
+
+    # Mirror the Prism::ReusableParser#parse_file API by using the serialization
+    # API.
+    def parse_file(filepath, **options)
+      Prism.parse_file(filepath, **options)
+    end
+  end
 end
@@ -206,22 +206,22 @@ module Prism
 
       # The location of the token in the source.
       def location
-        self[0]
+        __getobj__[0]
       end
 
       # The type of the token.
       def event
-        self[1]
+        __getobj__[1]
       end
 
       # The slice of the source that this token represents.
       def value
-        self[2]
+        __getobj__[2]
       end
 
       # The state of the lexer when this token was produced.
       def state
-        self[3]
+        __getobj__[3]
       end
     end
 
@@ -614,6 +614,15 @@ module Prism
 
     private_constant :Heredoc
 
+    # The events after which a closed heredoc is flushed into the token stream.
+    HEREDOC_FLUSH_EVENTS = %i[on_nl on_ignored_nl on_comment].freeze
+    private_constant :HEREDOC_FLUSH_EVENTS
+
+    # How much each event changes the depth of embedded expressions when
+    # walking backward through the tokens.
+    EMBEXPR_BALANCE = { on_embexpr_beg: -1, on_embexpr_end: 1 }.freeze
+    private_constant :EMBEXPR_BALANCE
+
     attr_reader :source, :options
 
     def initialize(source, **options)
@@ -629,9 +638,15 @@ module Prism
 
       result = Prism.lex(source, **options)
       result_value = result.value
+      result_source = result.source
       previous_state = nil #: Ripper::Lexer::State?
       last_heredoc_end = nil #: Integer?
 
+      # Ripper::Lexer::State objects are frozen and build the name of the state
+      # when they are created, so they are shared between the tokens that have
+      # the same state.
+      lex_states = Hash.new { |hash, key| hash[key] = Ripper::Lexer::State.new(key) } #: Hash[Integer, Ripper::Lexer::State]
+
       # In previous versions of Ruby, Ripper wouldn't flush the bom before the
       # first token, so we had to have a hack in place to account for that. This
       # checks for that behavior.
@@ -639,8 +654,9 @@ module Prism
       bom = source.byteslice(0..2) == "\xEF\xBB\xBF"
 
       result_value.each_with_index do |(token, lex_state), index|
-        lineno = token.location.start_line
-        column = token.location.start_column
+        start_offset = token.start_offset
+        lineno = result_source.line(start_offset)
+        column = result_source.column(start_offset)
 
         # If there's a UTF-8 byte-order mark as the start of the file, then for
         # certain tokens ripper sets the first token back by 3 bytes. It also
@@ -674,7 +690,7 @@ module Prism
 
         event = RIPPER.fetch(token.type)
         value = token.value
-        lex_state = Ripper::Lexer::State.new(lex_state)
+        lex_state = lex_states[lex_state]
 
         token =
           case event
@@ -685,7 +701,7 @@ module Prism
           when :on_heredoc_end
             # Heredoc end tokens can be emitted in an odd order, so we don't
             # want to bother comparing the state on them.
-            last_heredoc_end = token.location.end_offset
+            last_heredoc_end = token.end_offset
             IgnoreStateToken.new([[lineno, column], event, value, lex_state])
           when :on_ident
             if lex_state == Ripper::EXPR_END
@@ -735,10 +751,10 @@ module Prism
                 until counter == 0
                   current_index -= 1
                   current_event = RIPPER.fetch(result_value[current_index][0].type)
-                  counter += { on_embexpr_beg: -1, on_embexpr_end: 1 }[current_event] || 0
+                  counter += EMBEXPR_BALANCE[current_event] || 0
                 end
 
-                Ripper::Lexer::State.new(result_value[current_index][1])
+                lex_states[result_value[current_index][1]]
               else
                 previous_state
               end
@@ -758,8 +774,8 @@ module Prism
               # there is trailing whitespace after the last token.
               # Use the greater offset of the two to determine the start of
               # the trailing whitespace.
-              start_offset = [previous_token.location.end_offset, last_heredoc_end].compact.max
-              end_offset = token.location.start_offset
+              start_offset = [previous_token.end_offset, last_heredoc_end].compact.max
+              end_offset = token.start_offset
 
               if start_offset < end_offset
                 if bom
@@ -820,7 +836,7 @@ module Prism
             state = :heredoc_closed
           end
         when :heredoc_closed
-          if %i[on_nl on_ignored_nl on_comment].include?(event) || (event == :on_tstring_content && value.end_with?("\n"))
+          if HEREDOC_FLUSH_EVENTS.include?(event) || (event == :on_tstring_content && value.end_with?("\n"))
             if heredoc_stack.size > 1
               flushing = heredoc_stack.pop
               heredoc_stack.last.last << token
@@ -858,8 +874,13 @@ module Prism
       # Drop the EOF token from the list
       tokens = tokens[0...-1]
 
-      # We sort by location to compare against Ripper's output
-      tokens.sort_by!(&:location)
+      # We sort by location to compare against Ripper's output. The line and
+      # column are packed into a single integer so that the keys compare
+      # without going through Array#<=>.
+      tokens.sort_by! do |token|
+        location = token.location
+        (location[0] << 32) + location[1]
+      end
 
       Result.new(tokens, result.comments, result.magic_comments, result.data_loc, result.errors, result.warnings, Source.for(source))
     end
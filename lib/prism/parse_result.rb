@@ -27,6 +27,10 @@ module Prism
       @source = source
       @start_line = start_line # set after parsing is done
       @offsets = offsets # set after parsing is done
+      @last_line = 0 # the index of the line that was most recently found
+      @character_offsets = nil # computed the first time a character offset is needed
+      @utf16_offsets = nil # computed the first time a UTF-16 offset is needed
+      @lazy_tree = nil # set after parsing is done if the tree is built lazily
     end
 
     # Returns the encoding of the source code, which is set by parameters to the
@@ -71,7 +75,14 @@ module Prism
 
     # Return the character offset for the given byte offset.
     def character_offset(byte_offset)
-      (source.byteslice(0, byte_offset) or raise).length
+      index = find_line(byte_offset)
+
+      if index >= 0 && (line_offsets = character_offsets)
+        line_start = offsets[index]
+        line_offsets[index] + (source.byteslice(line_start, byte_offset - line_start) or raise).length
+      else
+        (source.byteslice(0, byte_offset) or raise).length
+      end
     end
 
     # Return the column number in characters for the given byte offset.
@@ -86,8 +97,17 @@ module Prism
     # concept of code units that differs from the number of characters in other
     # encodings, it is not captured here.
     def code_units_offset(byte_offset, encoding)
-      byteslice = (source.byteslice(0, byte_offset) or raise).encode(encoding)
-      (encoding == Encoding::UTF_16LE || encoding == Encoding::UTF_16BE) ? (byteslice.bytesize / 2) : byteslice.length
+      utf16 = (encoding == Encoding::UTF_16LE || encoding == Encoding::UTF_16BE)
+      index = find_line(byte_offset)
+
+      if index >= 0 && (line_offsets = code_units_offsets(encoding, utf16))
+        line_start = offsets[index]
+        byteslice = (source.byteslice(line_start, byte_offset - line_start) or raise).encode(encoding)
+        line_offsets[index] + (utf16 ? (byteslice.bytesize / 2) : byteslice.length)
+      else
+        byteslice = (source.byteslice(0, byte_offset) or raise).encode(encoding)
+        utf16 ? (byteslice.bytesize / 2) : byteslice.length
+      end
     end
 
     # Returns the column number in code units for the given encoding for the
@@ -96,26 +116,122 @@ module Prism
       code_units_offset(byte_offset, encoding) - code_units_offset(line_start(byte_offset), encoding)
     end
 
+    # Freeze the source. The per-line tables used to convert offsets cannot be
+    # filled in once the source is frozen, so they are built beforehand.
+    def freeze
+      build_line_unit_offsets
+      super
+    end
+
+    # Create the node at the given index of the tree that this source was
+    # lazily parsed into. Nodes from a lazy parse hold these indices in place of
+    # their children until each child is first accessed.
+    def lazy_node(index) # :nodoc:
+      (@lazy_tree or raise).node(index)
+    end
+
+    # Dump the source with Marshal. The tree of a lazily parsed source cannot be
+    # dumped, so it is left out. Nodes fill in their children before they are
+    # dumped (see Node::LazyMarshal), so it is not needed once loaded.
+    def marshal_dump # :nodoc:
+      [source, start_line, offsets]
+    end
+
+    # Load a source that was dumped with Marshal.
+    def marshal_load(data) # :nodoc:
+      initialize(*data)
+    end
+
     private
 
-    # Binary search through the offsets to find the line number for the given
-    # byte offset.
+    # The encodings that a valid UTF-8 source can be converted into one
+    # character at a time, such that each line can be converted on its own.
+    UNICODE_ENCODINGS = [
+      Encoding::UTF_8,
+      Encoding::UTF_16LE,
+      Encoding::UTF_16BE,
+      Encoding::UTF_32LE,
+      Encoding::UTF_32BE
+    ].freeze
+    private_constant :UNICODE_ENCODINGS
+
+    # For each line, the number of characters that come before it. This is
+    # computed the first time it is needed, so that converting an offset only
+    # has to count the characters on its own line. If the source was frozen
+    # without building it (for example by Ractor.make_shareable), this returns
+    # nil and offsets are converted by counting from the start of the source.
+    def character_offsets
+      @character_offsets || (@character_offsets = line_unit_offsets(false) unless frozen?)
+    end
+
+    # For each line, the number of code units in the given encoding that come
+    # before it, or nil if the lines of this source cannot be converted into
+    # that encoding independently of one another. As with character_offsets,
+    # this is computed the first time it is needed.
+    def code_units_offsets(encoding, utf16)
+      return unless source.encoding == Encoding::UTF_8 && UNICODE_ENCODINGS.include?(encoding) && source.valid_encoding?
+      return character_offsets unless utf16
+
+      @utf16_offsets || (@utf16_offsets = line_unit_offsets(true) unless frozen?)
+    end
+
+    # Build the tables that convert byte offsets into character and UTF-16
+    # offsets, which is done before the source is frozen.
+    def build_line_unit_offsets
+      return if frozen?
+
+      character_offsets
+      code_units_offsets(Encoding::UTF_16LE, true)
+    end
+
+    # Count the number of characters (or UTF-16 code units if utf16 is true)
+    # that come before each line, using the extension if it is available.
+    def line_unit_offsets(utf16)
+      if Source.respond_to?(:line_unit_offsets)
+        Source.line_unit_offsets(source, offsets, utf16)
+      else
+        units = 0
+        offsets.each_with_index.map do |offset, index|
+          if index > 0
+            previous = offsets[index - 1]
+            line = source.byteslice(previous, offset - previous) or raise
+            units += utf16 ? (line.encode(Encoding::UTF_16LE).bytesize / 2) : line.length
+          end
+
+          units
+        end
+      end
+    end
+
+    # The number of lines that find_line will step forward from the line it
+    # most recently found before it falls back to a binary search.
+    FIND_LINE_STEPS = 8
+    private_constant :FIND_LINE_STEPS
+
+    # Find the index of the line that contains the given byte offset. Lookups
+    # tend to come in increasing order (for example when walking the tree), so
+    # this first checks the line that was most recently found and the few lines
+    # right after it before falling back to a binary search through the offsets.
     def find_line(byte_offset)
-      left = 0
-      right = offsets.length - 1
+      offsets = self.offsets
+      index = @last_line || 0
 
-      while left <= right
-        mid = left + (right - left) / 2
-        return mid if (offset = offsets[mid]) == byte_offset
+      if (offset = offsets[index]) && offset <= byte_offset
+        FIND_LINE_STEPS.times do
+          following = offsets[index + 1]
 
-        if offset < byte_offset
-          left = mid + 1
-        else
-          right = mid - 1
+          if following.nil? || byte_offset < following
+            @last_line = index unless frozen?
+            return index
+          end
+
+          index += 1
         end
       end
 
-      left - 1
+      index = (offsets.bsearch_index { |line_offset| line_offset > byte_offset } || offsets.length) - 1
+      @last_line = index unless frozen?
+      index
     end
   end
 
@@ -150,6 +266,13 @@ module Prism
     def code_units_column(byte_offset, encoding)
       byte_offset - line_start(byte_offset)
     end
+
+    private
+
+    # Offsets in an ASCII source do not need any per-line tables, so there is
+    # nothing to build before it is frozen.
+    def build_line_unit_offsets
+    end
   end
 
   # This represents a location in the source.
@@ -364,12 +487,44 @@ module Prism
   # This represents a comment that was encountered during parsing. It is the
   # base class for all comment types.
   class Comment
+    # The Source object that represents the source this comment came from.
+    attr_reader :source
+    private :source
+
+    # Create a new comment object with the given source and location. The
+    # location is either a Location object or the start offset and length of the
+    # comment packed into an integer, in which case the Location object is only
+    # created if it is requested. For compatibility, a comment can also be
+    # created with only its Location object, which already knows its source.
+    def initialize(source, location = nil)
+      if location.nil?
+        @source = nil
+        @location = source
+      else
+        @source = source
+        @location = location
+      end
+    end
+
     # The location of this comment in the source.
-    attr_reader :location
+    def location
+      location = @location
+      return location if location.is_a?(Location)
+      @location = Location.new((source or raise), location >> 32, location & 0xFFFFFFFF)
+    end
 
-    # Create a new comment object with the given location.
-    def initialize(location)
-      @location = location
+    # The start offset of the comment in the source. This method is effectively
+    # a delegate method to the location object.
+    def start_offset
+      location = @location
+      location.is_a?(Location) ? location.start_offset : location >> 32
+    end
+
+    # The end offset of the comment in the source. This method is effectively a
+    # delegate method to the location object.
+    def end_offset
+      location = @location
+      location.is_a?(Location) ? location.end_offset : ((location >> 32) + (location & 0xFFFFFFFF))
     end
 
     # Implement the hash pattern matching interface for Comment.
@@ -586,6 +741,7 @@ module Prism
     # Create a new parse result object with the given values.
     def initialize(value, comments, magic_comments, data_loc, errors, warnings, source)
       @value = value
+      @newline_nodes = nil
       super(comments, magic_comments, data_loc, errors, warnings, source)
     end
 
@@ -602,7 +758,14 @@ module Prism
     # Walk the tree and mark nodes that are on a new line, loosely emulating
     # the behavior of CRuby's `:line` tracepoint event.
     def mark_newlines!
-      value.accept(Newlines.new(source.offsets.size)) # steep:ignore
+      if (newline_nodes = @newline_nodes)
+        # The C extension has already found these nodes while it was building
+        # the tree (because the mark_newlines keyword was passed when parsing),
+        # so there is no need to walk it again.
+        Newlines.mark(newline_nodes) # steep:ignore
+      else
+        value.accept(Newlines.new(source.offsets.size)) # steep:ignore
+      end
     end
   end
 
@@ -673,6 +836,20 @@ module Prism
       @location = Location.new(source, location >> 32, location & 0xFFFFFFFF)
     end
 
+    # The start offset of the token in the source. This method is effectively a
+    # delegate method to the location object.
+    def start_offset
+      location = @location
+      location.is_a?(Location) ? location.start_offset : location >> 32
+    end
+
+    # The end offset of the token in the source. This method is effectively a
+    # delegate method to the location object.
+    def end_offset
+      location = @location
+      location.is_a?(Location) ? location.end_offset : ((location >> 32) + (location & 0xFFFFFFFF))
+    end
+
     # Implement the pretty print interface for Token.
     def pretty_print(q)
       q.group do
@@ -35,8 +35,8 @@ module Prism
         end
 
         def encloses?(comment)
-          start_offset <= comment.location.start_offset &&
-            comment.location.end_offset <= end_offset
+          start_offset <= comment.start_offset &&
+            comment.end_offset <= end_offset
         end
 
         def leading_comment(comment)
@@ -85,11 +85,18 @@ module Prism
       # parse result.
       def initialize(parse_result)
         @parse_result = parse_result
+        @targets_cache = nil
       end
 
       # Attach the comments to their respective locations in the tree by
       # mutating the parse result.
       def attach!
+        # The sorted targets of every node that has been searched so far. Most
+        # comments are found in the same few nodes (the top-level statements of
+        # a file or the body of a class), so this avoids building and sorting
+        # the same list for each one.
+        @targets_cache = {}.compare_by_identity
+
         parse_result.comments.each do |comment|
           preceding, enclosing, following = nearest_targets(parse_result.value, comment)
 
@@ -110,6 +117,8 @@ module Prism
             end
           end
         end
+      ensure
+        @targets_cache = nil
       end
 
       private
@@ -117,22 +126,10 @@ module Prism
       # Responsible for finding the nearest targets to the given comment within
       # the context of the given encapsulating node.
       def nearest_targets(node, comment)
-        comment_start = comment.location.start_offset
-        comment_end = comment.location.end_offset
+        comment_start = comment.start_offset
+        comment_end = comment.end_offset
 
-        targets = [] #: Array[_Target]
-        node.comment_targets.map do |value|
-          case value
-          when StatementsNode
-            targets.concat(value.body.map { |node| NodeTarget.new(node) })
-          when Node
-            targets << NodeTarget.new(value)
-          when Location
-            targets << LocationTarget.new(value)
-          end
-        end
-
-        targets.sort_by!(&:start_offset)
+        targets = (@targets_cache[node] ||= targets(node))
         preceding = nil #: _Target?
         following = nil #: _Target?
 
@@ -182,6 +179,24 @@ module Prism
 
         [preceding, NodeTarget.new(node), following]
       end
+
+      # Build the list of targets within the given node that comments can be
+      # attached to, sorted by their start offsets.
+      def targets(node)
+        targets = [] #: Array[_Target]
+        node.comment_targets.map do |value|
+          case value
+          when StatementsNode
+            targets.concat(value.body.map { |node| NodeTarget.new(node) })
+          when Node
+            targets << NodeTarget.new(value)
+          when Location
+            targets << LocationTarget.new(value)
+          end
+        end
+
+        targets.sort_by!(&:start_offset)
+      end
     end
   end
 end
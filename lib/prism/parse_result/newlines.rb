@@ -16,13 +16,20 @@ module Prism
     #
     # Note that the logic in this file should be kept in sync with the Java
     # MarkNewlinesVisitor, since that visitor is responsible for marking the
-    # newlines for JRuby/TruffleRuby.
+    # newlines for JRuby/TruffleRuby, and with pm_node_mark_newlines in C,
+    # which finds the nodes to mark for results built by the C extension.
     #
     # This file is autoloaded only when `mark_newlines!` is called, so the
     # re-opening of the various nodes in this file will only be performed in
     # that case. We do that to avoid storing the extra `@newline` instance
     # variable on every node if we don't need it.
     class Newlines < Visitor
+      # Mark the given nodes, which have already been found by
+      # pm_node_mark_newlines.
+      def self.mark(nodes)
+        nodes.each(&:newline_flag!)
+      end
+
       # Create a new Newlines visitor with the given newline offsets.
       def initialize(lines)
         @lines = Array.new(1 + lines, false)
@@ -72,6 +79,10 @@ module Prism
         @newline = true
       end
     end
+
+    def newline_flag! # :nodoc:
+      @newline = true
+    end
   end
 
   class BeginNode < Node
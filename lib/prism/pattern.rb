@@ -30,6 +30,12 @@ module Prism
   #     when callable
   #     end
   #
+  # To search through source code that hasn't been parsed yet, use #scan_source
+  # or #scan_file. On CRuby these match the pattern against the tree in C, so
+  # that only the nodes that match are ever created as Ruby objects:
+  #
+  #     Prism::Pattern.new("CallNode[name: :where]").scan_file("app/models/user.rb")
+  #
   # If the query given to the initializer cannot be compiled into a valid
   # matcher (either because of a syntax error or because it is using syntax we
   # do not yet support) then a Prism::Pattern::CompilationError will be
@@ -63,20 +69,13 @@ module Prism
     def initialize(query)
       @query = query
       @compiled = nil
+      @native = nil
     end
 
     # Compile the query into a callable object that can be used to match against
     # nodes.
     def compile
-      result = Prism.parse("case nil\nin #{query}\nend")
-
-      case_match_node = result.value.statements.body.last
-      raise CompilationError, case_match_node.inspect unless case_match_node.is_a?(CaseMatchNode)
-
-      in_node = case_match_node.conditions.last
-      raise CompilationError, in_node.inspect unless in_node.is_a?(InNode)
-
-      compile_node(in_node.pattern)
+      compile_node(parse_pattern)
     end
 
     # Scan the given node and all of its children for nodes that match the
@@ -95,8 +94,96 @@ module Prism
       end
     end
 
+    # Parse the given source and return an array of the nodes in its tree that
+    # match the pattern, in the same order as #scan. The options are the same as
+    # those accepted by Prism::parse.
+    def scan_source(source, **options)
+      if (native = compile_native)
+        LazyTree.scan(native, source, **options)
+      else
+        scan(Prism.parse(source, **options).value).to_a
+      end
+    end
+
+    # Parse the given file and return an array of the nodes in its tree that
+    # match the pattern, in the same order as #scan. The options are the same as
+    # those accepted by Prism::parse_file.
+    def scan_file(filepath, **options)
+      if (native = compile_native)
+        LazyTree.scan_file(native, filepath, **options)
+      else
+        scan(Prism.parse_file(filepath, **options).value).to_a
+      end
+    end
+
     private
 
+    # Compile the query into the nested arrays that the C extension matches
+    # against the tree natively. This returns false if the query uses anything
+    # that can only be matched in Ruby (like regular expressions or classes
+    # other than nodes), or if the C extension is not available.
+    def compile_native
+      return @native unless @native.nil?
+
+      @compiled ||= compile
+      @native = (BACKEND == :CEXT && compile_native_node(parse_pattern)) || false
+    end
+
+    # Compile any kind of node into its native representation, or return nil if
+    # it cannot be matched natively.
+    def compile_native_node(node)
+      case node
+      when AlternationPatternNode
+        left = compile_native_node(node.left)
+        right = compile_native_node(node.right)
+        [:or, left, right] if left && right
+      when ArrayPatternNode
+        requireds = node.requireds.map { |required| compile_native_node(required) }
+        compile_native_constant(node.constant, [:array, requireds]) unless requireds.include?(nil)
+      when ConstantPathNode
+        compile_native_constant_name(node.name)
+      when ConstantReadNode
+        compile_native_constant_name(node.name)
+      when HashPatternNode
+        elements = node.elements.map { |element| [element.key.unescaped.to_sym, compile_native_node(element.value)] }
+        compile_native_constant(node.constant, [:hash, elements]) unless elements.any? { |(_, value)| value.nil? }
+      when NilNode
+        [:nil]
+      when StringNode
+        [:string, node.unescaped]
+      when SymbolNode
+        [:symbol, node.unescaped]
+      end
+    end
+
+    # Combine the native representation of an optional constant with the given
+    # native pattern.
+    def compile_native_constant(constant, pattern)
+      return pattern unless constant
+
+      compiled = compile_native_node(constant)
+      [:and, compiled, pattern] if compiled
+    end
+
+    # Nodes can only be matched natively against node classes.
+    def compile_native_constant_name(name)
+      clazz = Prism.const_get(name) if Prism.const_defined?(name, false)
+      [:type, clazz] if clazz.is_a?(Class) && clazz <= Node
+    end
+
+    # Parse the query and return the node that represents the pattern.
+    def parse_pattern
+      result = Prism.parse("case nil\nin #{query}\nend")
+
+      case_match_node = result.value.statements.body.last
+      raise CompilationError, case_match_node.inspect unless case_match_node.is_a?(CaseMatchNode)
+
+      in_node = case_match_node.conditions.last
+      raise CompilationError, in_node.inspect unless in_node.is_a?(InNode)
+
+      in_node.pattern
+    end
+
     # Shortcut for combining two procs into one that returns true if both return
     # true.
     def combine_and(left, right)
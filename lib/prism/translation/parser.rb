@@ -242,10 +242,14 @@ module Prism
       #
       # If the bytesize of the source is the same as the length, then we can
       # just use the offset directly. Otherwise, we build an array where the
-      # index is the byte offset and the value is the character offset.
+      # index is the byte offset and the value is the character offset. This
+      # is done by the extension if it is available, since walking every
+      # character of a large file in Ruby is expensive.
       def build_offset_cache(source)
         if source.bytesize == source.length
           -> (offset) { offset }
+        elsif Source.respond_to?(:byte_character_offsets)
+          Source.byte_character_offsets(source)
         else
           offset_cache = []
           offset = 0
@@ -267,7 +271,7 @@ module Prism
       # Build the parser gem comments from the prism comments.
       def build_comments(comments, offset_cache)
         comments.map do |comment|
-          ::Parser::Source::Comment.new(build_range(comment.location, offset_cache))
+          ::Parser::Source::Comment.new(::Parser::Source::Range.new(source_buffer, offset_cache[comment.start_offset], offset_cache[comment.end_offset]))
         end
       end
 
@@ -108,12 +108,12 @@ module Prism
           if in_pattern
             if node.value.is_a?(ImplicitNode)
               if node.key.is_a?(SymbolNode)
-                builder.match_hash_var([node.key.unescaped, srange(node.key.location)])
+                builder.match_hash_var([node.key.unescaped, srange_offsets(node.key.start_offset, node.key.end_offset)])
               else
                 builder.match_hash_var_from_str(token(node.key.opening_loc), visit_all(node.key.parts), token(node.key.closing_loc))
               end
             else
-              builder.pair_keyword([node.key.unescaped, srange(node.key.location)], visit(node.value))
+              builder.pair_keyword([node.key.unescaped, srange_offsets(node.key.start_offset, node.key.end_offset)], visit(node.value))
             end
           elsif node.value.is_a?(ImplicitNode)
             if (value = node.value.value).is_a?(LocalVariableReadNode)
@@ -122,12 +122,12 @@ module Prism
                 builder.ident([value.name, srange(node.key.value_loc)]).updated(:lvar)
               )
             else
-              builder.pair_label([node.key.unescaped, srange(node.key.location)])
+              builder.pair_label([node.key.unescaped, srange_offsets(node.key.start_offset, node.key.end_offset)])
             end
           elsif node.operator_loc
             builder.pair(visit(node.key), token(node.operator_loc), visit(node.value))
           elsif node.key.is_a?(SymbolNode) && node.key.opening_loc.nil?
-            builder.pair_keyword([node.key.unescaped, srange(node.key.location)], visit(node.value))
+            builder.pair_keyword([node.key.unescaped, srange_offsets(node.key.start_offset, node.key.end_offset)], visit(node.value))
           else
             parts =
               if node.key.is_a?(SymbolNode)
@@ -167,7 +167,7 @@ module Prism
           if (rescue_clause = node.rescue_clause)
             begin
               find_start_offset = (rescue_clause.reference&.location || rescue_clause.exceptions.last&.location || rescue_clause.keyword_loc).end_offset
-              find_end_offset = (rescue_clause.statements&.location&.start_offset || rescue_clause.consequent&.location&.start_offset || (find_start_offset + 1))
+              find_end_offset = (rescue_clause.statements&.start_offset || rescue_clause.consequent&.start_offset || (find_start_offset + 1))
 
               rescue_bodies << builder.rescue_body(
                 token(rescue_clause.keyword_loc),
@@ -280,7 +280,7 @@ module Prism
                       visit_all(arguments),
                       token(node.closing_loc),
                     ),
-                    srange_find(node.message_loc.end_offset, node.arguments.arguments.last.location.start_offset, ["="]),
+                    srange_find(node.message_loc.end_offset, node.arguments.arguments.last.start_offset, ["="]),
                     visit(node.arguments.arguments.last)
                   ),
                   block
@@ -297,7 +297,7 @@ module Prism
             if name.end_with?("=") && !message_loc.slice.end_with?("=") && node.arguments && block.nil?
               builder.assign(
                 builder.attr_asgn(visit(node.receiver), call_operator, token(message_loc)),
-                srange_find(message_loc.end_offset, node.arguments.location.start_offset, ["="]),
+                srange_find(message_loc.end_offset, node.arguments.start_offset, ["="]),
                 visit(node.arguments.arguments.last)
               )
             else
@@ -483,7 +483,7 @@ module Prism
         # Foo
         # ^^^
         def visit_constant_read_node(node)
-          builder.const([node.name, srange(node.location)])
+          builder.const([node.name, srange_offsets(node.start_offset, node.end_offset)])
         end
 
         # Foo = 1
@@ -528,7 +528,7 @@ module Prism
         # Foo, = bar
         # ^^^
         def visit_constant_target_node(node)
-          builder.assignable(builder.const([node.name, srange(node.location)]))
+          builder.assignable(builder.const([node.name, srange_offsets(node.start_offset, node.end_offset)]))
         end
 
         # Foo::Bar
@@ -708,7 +708,7 @@ module Prism
         # 1.0
         # ^^^
         def visit_float_node(node)
-          visit_numeric(node, builder.float([node.value, srange(node.location)]))
+          visit_numeric(node, builder.float([node.value, srange_offsets(node.start_offset, node.end_offset)]))
         end
 
         # for foo in bar do end
@@ -722,7 +722,7 @@ module Prism
             if node.do_keyword_loc
               token(node.do_keyword_loc)
             else
-              srange_find(node.collection.location.end_offset, (node.statements&.location || node.end_keyword_loc).start_offset, [";"])
+              srange_find(node.collection.end_offset, (node.statements&.location || node.end_keyword_loc).start_offset, [";"])
             end,
             visit(node.statements),
             token(node.end_keyword_loc)
@@ -750,7 +750,7 @@ module Prism
           visit_block(
             builder.keyword_cmd(
               :zsuper,
-              ["super", srange_offsets(node.location.start_offset, node.location.start_offset + 5)]
+              ["super", srange_offsets(node.start_offset, node.start_offset + 5)]
             ),
             node.block
           )
@@ -805,7 +805,7 @@ module Prism
         # $foo, = bar
         # ^^^^
         def visit_global_variable_target_node(node)
-          builder.assignable(builder.gvar([node.slice, srange(node.location)]))
+          builder.assignable(builder.gvar([node.slice, srange_offsets(node.start_offset, node.end_offset)]))
         end
 
         # {}
@@ -847,14 +847,14 @@ module Prism
               token(node.consequent.else_keyword_loc),
               visit(node.consequent)
             )
-          elsif node.if_keyword_loc.start_offset == node.location.start_offset
+          elsif node.if_keyword_loc.start_offset == node.start_offset
             builder.condition(
               token(node.if_keyword_loc),
               visit(node.predicate),
               if node.then_keyword_loc
                 token(node.then_keyword_loc)
               else
-                srange_find(node.predicate.location.end_offset, (node.statements&.location || node.consequent&.location || node.end_keyword_loc).start_offset, [";"])
+                srange_find(node.predicate.end_offset, (node.statements&.location || node.consequent&.location || node.end_keyword_loc).start_offset, [";"])
               end,
               visit(node.statements),
               case node.consequent
@@ -881,7 +881,7 @@ module Prism
         # 1i
         # ^^
         def visit_imaginary_node(node)
-          visit_numeric(node, builder.complex([Complex(0, node.numeric.value), srange(node.location)]))
+          visit_numeric(node, builder.complex([Complex(0, node.numeric.value), srange_offsets(node.start_offset, node.end_offset)]))
         end
 
         # { foo: }
@@ -917,7 +917,7 @@ module Prism
             token(node.in_loc),
             pattern,
             guard,
-            srange_find(node.pattern.location.end_offset, node.statements&.location&.start_offset, [";", "then"]),
+            srange_find(node.pattern.end_offset, node.statements&.start_offset, [";", "then"]),
             visit(node.statements)
           )
         end
@@ -1042,7 +1042,7 @@ module Prism
         # 1
         # ^
         def visit_integer_node(node)
-          visit_numeric(node, builder.integer([node.value, srange(node.location)]))
+          visit_numeric(node, builder.integer([node.value, srange_offsets(node.start_offset, node.end_offset)]))
         end
 
         # /foo #{bar}/
@@ -1068,7 +1068,7 @@ module Prism
             opening = token(node.opening_loc)
 
             start_offset = node.opening_loc.end_offset + 1
-            end_offset = node.parts.first.location.start_offset
+            end_offset = node.parts.first.start_offset
 
             # In the below case, the offsets should be the same:
             #
@@ -1151,7 +1151,7 @@ module Prism
         # -> { it }
         #      ^^
         def visit_it_local_variable_read_node(node)
-          builder.ident([:it, srange(node.location)]).updated(:lvar)
+          builder.ident([:it, srange_offsets(node.start_offset, node.end_offset)]).updated(:lvar)
         end
 
         # -> { it }
@@ -1207,7 +1207,7 @@ module Prism
         # foo
         # ^^^
         def visit_local_variable_read_node(node)
-          builder.ident([node.name, srange(node.location)]).updated(:lvar)
+          builder.ident([node.name, srange_offsets(node.start_offset, node.end_offset)]).updated(:lvar)
         end
 
         # foo = 1
@@ -1254,7 +1254,7 @@ module Prism
         # ^^^
         def visit_local_variable_target_node(node)
           if in_pattern
-            builder.assignable(builder.match_var([node.name, srange(node.location)]))
+            builder.assignable(builder.match_var([node.name, srange_offsets(node.start_offset, node.end_offset)]))
           else
             builder.assignable(builder.ident(token(node.location)))
           end
@@ -1294,7 +1294,7 @@ module Prism
         # case of a syntax error. The parser gem doesn't have such a concept, so
         # we invent our own here.
         def visit_missing_node(node)
-          ::AST::Node.new(:missing, [], location: ::Parser::Source::Map.new(srange(node.location)))
+          ::AST::Node.new(:missing, [], location: ::Parser::Source::Map.new(srange_offsets(node.start_offset, node.end_offset)))
         end
 
         # module Foo; end
@@ -1380,7 +1380,7 @@ module Prism
         # $1
         # ^^
         def visit_numbered_reference_read_node(node)
-          builder.nth_ref([node.number, srange(node.location)])
+          builder.nth_ref([node.number, srange_offsets(node.start_offset, node.end_offset)])
         end
 
         # def foo(bar: baz); end
@@ -1513,7 +1513,7 @@ module Prism
         # 1r
         # ^^
         def visit_rational_node(node)
-          visit_numeric(node, builder.rational([node.value, srange(node.location)]))
+          visit_numeric(node, builder.rational([node.value, srange_offsets(node.start_offset, node.end_offset)]))
         end
 
         # redo
@@ -1676,7 +1676,7 @@ module Prism
             children, closing = visit_heredoc(node.to_interpolated)
             builder.string_compose(token(node.opening_loc), children, closing)
           elsif node.opening == "?"
-            builder.character([node.unescaped, srange(node.location)])
+            builder.character([node.unescaped, srange_offsets(node.start_offset, node.end_offset)])
           else
             content_lines = node.content.lines
             unescaped_lines = node.unescaped.lines
@@ -1738,9 +1738,9 @@ module Prism
         def visit_symbol_node(node)
           if node.closing_loc.nil?
             if node.opening_loc.nil?
-              builder.symbol_internal([node.unescaped, srange(node.location)])
+              builder.symbol_internal([node.unescaped, srange_offsets(node.start_offset, node.end_offset)])
             else
-              builder.symbol([node.unescaped, srange(node.location)])
+              builder.symbol([node.unescaped, srange_offsets(node.start_offset, node.end_offset)])
             end
           else
             parts = if node.value.lines.one?
@@ -1783,14 +1783,14 @@ module Prism
         # bar unless foo
         # ^^^^^^^^^^^^^^
         def visit_unless_node(node)
-          if node.keyword_loc.start_offset == node.location.start_offset
+          if node.keyword_loc.start_offset == node.start_offset
             builder.condition(
               token(node.keyword_loc),
               visit(node.predicate),
               if node.then_keyword_loc
                 token(node.then_keyword_loc)
               else
-                srange_find(node.predicate.location.end_offset, (node.statements&.location || node.consequent&.location || node.end_keyword_loc).start_offset, [";"])
+                srange_find(node.predicate.end_offset, (node.statements&.location || node.consequent&.location || node.end_keyword_loc).start_offset, [";"])
               end,
               visit(node.consequent),
               token(node.consequent&.else_keyword_loc),
@@ -1813,12 +1813,12 @@ module Prism
         # bar until foo
         # ^^^^^^^^^^^^^
         def visit_until_node(node)
-          if node.location.start_offset == node.keyword_loc.start_offset
+          if node.start_offset == node.keyword_loc.start_offset
             builder.loop(
               :until,
               token(node.keyword_loc),
               visit(node.predicate),
-              srange_find(node.predicate.location.end_offset, (node.statements&.location || node.closing_loc).start_offset, [";", "do"]),
+              srange_find(node.predicate.end_offset, (node.statements&.location || node.closing_loc).start_offset, [";", "do"]),
               visit(node.statements),
               token(node.closing_loc)
             )
@@ -1841,7 +1841,7 @@ module Prism
             if node.then_keyword_loc
               token(node.then_keyword_loc)
             else
-              srange_find(node.conditions.last.location.end_offset, node.statements&.location&.start_offset, [";"])
+              srange_find(node.conditions.last.end_offset, node.statements&.start_offset, [";"])
             end,
             visit(node.statements)
           )
@@ -1853,12 +1853,12 @@ module Prism
         # bar while foo
         # ^^^^^^^^^^^^^
         def visit_while_node(node)
-          if node.location.start_offset == node.keyword_loc.start_offset
+          if node.start_offset == node.keyword_loc.start_offset
             builder.loop(
               :while,
               token(node.keyword_loc),
               visit(node.predicate),
-              srange_find(node.predicate.location.end_offset, (node.statements&.location || node.closing_loc).start_offset, [";", "do"]),
+              srange_find(node.predicate.end_offset, (node.statements&.location || node.closing_loc).start_offset, [";", "do"]),
               visit(node.statements),
               token(node.closing_loc)
             )
@@ -2054,7 +2054,7 @@ module Prism
                     escaped.chunk_while { |before, after| before.match?(/(?<!\\)\\$/) }.map { |line| line.join.bytesize + line.length }
                   end
 
-                start_offset = part.location.start_offset
+                start_offset = part.start_offset
                 end_offset = nil
 
                 unescaped.zip(escaped_lengths).map do |unescaped_line, escaped_length|
@@ -2088,7 +2088,7 @@ module Prism
         def visit_numeric(node, value)
           if (slice = node.slice).match?(/^[+-]/)
             builder.unary_num(
-              [slice[0].to_sym, srange_offsets(node.location.start_offset, node.location.start_offset + 1)],
+              [slice[0].to_sym, srange_offsets(node.start_offset, node.start_offset + 1)],
               value
             )
           else
@@ -226,7 +226,7 @@ module Prism
 
             type = TYPES.fetch(token.type)
             value = token.value
-            location = Range.new(source_buffer, offset_cache[token.location.start_offset], offset_cache[token.location.end_offset])
+            location = Range.new(source_buffer, offset_cache[token.start_offset], offset_cache[token.end_offset])
 
             case type
             when :tCHARACTER
@@ -242,12 +242,12 @@ module Prism
 
                 if start_index != index
                   value += next_token.value
-                  location = Range.new(source_buffer, offset_cache[token.location.start_offset], offset_cache[lexed[index][0].location.end_offset])
+                  location = Range.new(source_buffer, offset_cache[token.start_offset], offset_cache[lexed[index][0].end_offset])
                   index += 1
                 end
               else
                 value.chomp!
-                location = Range.new(source_buffer, offset_cache[token.location.start_offset], offset_cache[token.location.end_offset - 1])
+                location = Range.new(source_buffer, offset_cache[token.start_offset], offset_cache[token.end_offset - 1])
               end
             when :tNL
               value = nil
@@ -257,8 +257,8 @@ module Prism
               value = parse_complex(value)
             when :tINTEGER
               if value.start_with?("+")
-                tokens << [:tUNARY_NUM, ["+", Range.new(source_buffer, offset_cache[token.location.start_offset], offset_cache[token.location.start_offset + 1])]]
-                location = Range.new(source_buffer, offset_cache[token.location.start_offset + 1], offset_cache[token.location.end_offset])
+                tokens << [:tUNARY_NUM, ["+", Range.new(source_buffer, offset_cache[token.start_offset], offset_cache[token.start_offset + 1])]]
+                location = Range.new(source_buffer, offset_cache[token.start_offset + 1], offset_cache[token.end_offset])
               end
 
               value = parse_integer(value)
@@ -303,7 +303,7 @@ module Prism
               end
             when :tSTRING_CONTENT
               unless (lines = token.value.lines).one?
-                start_offset = offset_cache[token.location.start_offset]
+                start_offset = offset_cache[token.start_offset]
                 lines.map do |line|
                   newline = line.end_with?("\r\n") ? "\r\n" : "\n"
                   chomped_line = line.chomp
@@ -333,10 +333,10 @@ module Prism
               if token.type == :HEREDOC_END && value.end_with?("\n")
                 newline_length = value.end_with?("\r\n") ? 2 : 1
                 value = heredoc_identifier_stack.pop
-                location = Range.new(source_buffer, offset_cache[token.location.start_offset], offset_cache[token.location.end_offset - newline_length])
+                location = Range.new(source_buffer, offset_cache[token.start_offset], offset_cache[token.end_offset - newline_length])
               elsif token.type == :REGEXP_END
                 value = value[0]
-                location = Range.new(source_buffer, offset_cache[token.location.start_offset], offset_cache[token.location.start_offset + 1])
+                location = Range.new(source_buffer, offset_cache[token.start_offset], offset_cache[token.start_offset + 1])
               end
             when :tSYMBEG
               if (next_token = lexed[index][0]) && next_token.type != :STRING_CONTENT && next_token.type != :EMBEXPR_BEGIN && next_token.type != :EMBVAR
@@ -360,7 +360,7 @@ module Prism
             tokens << [type, [value, location]]
 
             if token.type == :REGEXP_END
-              tokens << [:tREGEXP_OPT, [token.value[1..], Range.new(source_buffer, offset_cache[token.location.start_offset + 1], offset_cache[token.location.end_offset])]]
+              tokens << [:tREGEXP_OPT, [token.value[1..], Range.new(source_buffer, offset_cache[token.start_offset + 1], offset_cache[token.end_offset])]]
             end
           end
 
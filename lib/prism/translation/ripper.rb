@@ -744,7 +744,7 @@ module Prism
       # of list literals.
       private def visit_words_sep(opening_loc, previous, current)
         end_offset = (previous.nil? ? opening_loc : previous.location).end_offset
-        start_offset = current.location.start_offset
+        start_offset = current.start_offset
 
         if end_offset != start_offset
           bounds(current.location.copy(start_offset: end_offset))
@@ -1912,7 +1912,7 @@ module Prism
 
           bounds(node.location)
           on_ifop(predicate, truthy, falsy)
-        elsif node.statements.nil? || (node.predicate.location.start_offset < node.statements.location.start_offset)
+        elsif node.statements.nil? || (node.predicate.start_offset < node.statements.start_offset)
           predicate = visit(node.predicate)
           statements =
             if node.statements.nil?
@@ -3123,7 +3123,7 @@ module Prism
       # bar unless foo
       # ^^^^^^^^^^^^^^
       def visit_unless_node(node)
-        if node.statements.nil? || (node.predicate.location.start_offset < node.statements.location.start_offset)
+        if node.statements.nil? || (node.predicate.start_offset < node.statements.start_offset)
           predicate = visit(node.predicate)
           statements =
             if node.statements.nil?
@@ -3151,7 +3151,7 @@ module Prism
       # bar until foo
       # ^^^^^^^^^^^^^
       def visit_until_node(node)
-        if node.statements.nil? || (node.predicate.location.start_offset < node.statements.location.start_offset)
+        if node.statements.nil? || (node.predicate.start_offset < node.statements.start_offset)
           predicate = visit(node.predicate)
           statements =
             if node.statements.nil?
@@ -3196,7 +3196,7 @@ module Prism
       # bar while foo
       # ^^^^^^^^^^^^^
       def visit_while_node(node)
-        if node.statements.nil? || (node.predicate.location.start_offset < node.statements.location.start_offset)
+        if node.statements.nil? || (node.predicate.start_offset < node.statements.start_offset)
           predicate = visit(node.predicate)
           statements =
             if node.statements.nil?
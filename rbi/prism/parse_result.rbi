@@ -165,8 +165,14 @@ class Prism::Comment
   sig { returns(Prism::Location) }
   def location; end
 
-  sig { params(location: Prism::Location).void }
-  def initialize(location); end
+  sig { params(source: T.any(Prism::Source, Prism::Location), location: T.nilable(T.any(Prism::Location, Integer))).void }
+  def initialize(source, location = nil); end
+
+  sig { returns(Integer) }
+  def start_offset; end
+
+  sig { returns(Integer) }
+  def end_offset; end
 
   sig { params(keys: T.nilable(T::Array[Symbol])).returns(T::Hash[Symbol, T.untyped]) }
   def deconstruct_keys(keys); end
@@ -350,6 +356,12 @@ class Prism::Token
   sig { returns(Prism::Location) }
   def location; end
 
+  sig { returns(Integer) }
+  def start_offset; end
+
+  sig { returns(Integer) }
+  def end_offset; end
+
   sig { params(q: T.untyped).void }
   def pretty_print(q); end
 
@@ -114,6 +114,7 @@ fn generate_bindings(ruby_include_path: &Path) -> bindgen::Bindings {
         .size_t_is_usize(true)
         .sort_semantically(true)
         // Structs
+        .allowlist_type("pm_arena_t")
         .allowlist_type("pm_comment_t")
         .allowlist_type("pm_diagnostic_t")
         .allowlist_type("pm_list_t")
@@ -137,13 +138,16 @@ fn generate_bindings(ruby_include_path: &Path) -> bindgen::Bindings {
         .rustified_non_exhaustive_enum("pm_pack_type")
         .rustified_non_exhaustive_enum("pm_pack_variant")
         // Functions
+        .allowlist_function("pm_arena_free")
         .allowlist_function("pm_list_empty_p")
         .allowlist_function("pm_list_free")
         .allowlist_function("pm_node_destroy")
         .allowlist_function("pm_pack_parse")
         .allowlist_function("pm_parse")
+        .allowlist_function("pm_parser_arena_set")
         .allowlist_function("pm_parser_free")
         .allowlist_function("pm_parser_init")
+        .allowlist_function("pm_parser_reset")
         .allowlist_function("pm_size_to_native")
         .allowlist_function("pm_string_free")
         .allowlist_function("pm_string_length")
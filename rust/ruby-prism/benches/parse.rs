@@ -0,0 +1,85 @@
+//! Benchmarks parsing the Ruby files in the prism repository, first with a new
+//! parser for every file, then with a single reused parser, and finally with a
+//! reused parser on each of several threads.
+//!
+//! Run with `cargo bench`. The number of threads defaults to the number of
+//! available CPUs and can be set with the `PRISM_BENCH_THREADS` environment
+//! variable.
+
+use std::path::{Path, PathBuf};
+use std::time::{Duration, Instant};
+
+use ruby_prism::{parse, Parser};
+
+/// The number of times each benchmark parses every file.
+const ITERATIONS: usize = 5;
+
+/// Collect the paths of the Ruby files in the given directory, recursively.
+fn ruby_files(directory: &Path, paths: &mut Vec<PathBuf>) {
+    for entry in std::fs::read_dir(directory).unwrap() {
+        let path = entry.unwrap().path();
+
+        if path.is_dir() {
+            ruby_files(&path, paths);
+        } else if path.extension().is_some_and(|extension| extension == "rb") {
+            paths.push(path);
+        }
+    }
+}
+
+/// Print the throughput of a benchmark that parsed the given number of bytes
+/// in the given amount of time.
+fn report(name: &str, bytes: usize, elapsed: Duration) {
+    #[allow(clippy::cast_precision_loss)]
+    let megabytes = (bytes * ITERATIONS) as f64 / (1024.0 * 1024.0);
+    println!("{name:<24} {:>10.3}s {:>10.2} MB/s", elapsed.as_secs_f64(), megabytes / elapsed.as_secs_f64());
+}
+
+fn main() {
+    let root = Path::new(env!("CARGO_MANIFEST_DIR")).join("../..");
+    let mut paths = Vec::new();
+    ruby_files(&root.join("lib"), &mut paths);
+    ruby_files(&root.join("test"), &mut paths);
+
+    let sources = paths.iter().map(|path| std::fs::read(path).unwrap()).collect::<Vec<_>>();
+    let bytes = sources.iter().map(Vec::len).sum::<usize>();
+    println!("{} files, {bytes} bytes", sources.len());
+
+    let start = Instant::now();
+    for _ in 0..ITERATIONS {
+        for source in &sources {
+            let result = parse(source);
+            std::hint::black_box(result.node());
+        }
+    }
+    report("parse", bytes, start.elapsed());
+
+    let start = Instant::now();
+    let mut parser = Parser::new();
+    for _ in 0..ITERATIONS {
+        for source in &sources {
+            let result = parser.parse(source);
+            std::hint::black_box(result.node());
+        }
+    }
+    report("Parser::parse", bytes, start.elapsed());
+
+    let threads = std::env::var("PRISM_BENCH_THREADS").ok().and_then(|threads| threads.parse().ok()).unwrap_or_else(|| std::thread::available_parallelism().map_or(1, std::num::NonZeroUsize::get));
+    let chunk = sources.len().div_ceil(threads).max(1);
+
+    let start = Instant::now();
+    std::thread::scope(|scope| {
+        for chunk in sources.chunks(chunk) {
+            scope.spawn(move || {
+                let mut parser = Parser::new();
+                for _ in 0..ITERATIONS {
+                    for source in chunk {
+                        let result = parser.parse(source);
+                        std::hint::black_box(result.node());
+                    }
+                }
+            });
+        }
+    });
+    report(&format!("Parser::parse x{threads}"), bytes, start.elapsed());
+}
@@ -19,7 +19,7 @@ use std::mem::MaybeUninit;
 use std::ptr::NonNull;
 
 pub use self::bindings::*;
-use ruby_prism_sys::{pm_comment_t, pm_diagnostic_t, pm_node_destroy, pm_node_t, pm_parse, pm_parser_free, pm_parser_init, pm_parser_t};
+use ruby_prism_sys::{pm_arena_free, pm_arena_t, pm_comment_t, pm_diagnostic_t, pm_node_t, pm_parse, pm_parser_arena_set, pm_parser_free, pm_parser_init, pm_parser_reset, pm_parser_t};
 
 /// A diagnostic message that came back from the parser.
 #[derive(Debug)]
@@ -121,13 +121,26 @@ impl<'pr> Iterator for Comments<'pr> {
 }
 
 /// The result of parsing a source string.
+///
+/// The result either owns the parser that produced it (when it was returned
+/// from `parse`) or mutably borrows it (when it was returned from
+/// `Parser::parse`). In both cases nothing else can reach the syntax tree while
+/// the result is alive, so it can be sent to another thread.
 #[derive(Debug)]
 pub struct ParseResult<'pr> {
     source: &'pr [u8],
     parser: NonNull<pm_parser_t>,
     node: NonNull<pm_node_t>,
+    /// The parser that produced this result, if the result owns it. It is only
+    /// held so that it is dropped along with the result.
+    _owner: Option<Parser>,
+    marker: PhantomData<&'pr mut Parser>,
 }
 
+// SAFETY: the parser and syntax tree behind a parse result are only reachable
+// through the result itself, and prism keeps no global mutable state.
+unsafe impl Send for ParseResult<'_> {}
+
 impl<'pr> ParseResult<'pr> {
     /// Returns the source string that was parsed.
     #[must_use]
@@ -205,37 +218,106 @@ impl<'pr> ParseResult<'pr> {
     }
 }
 
-impl<'pr> Drop for ParseResult<'pr> {
-    fn drop(&mut self) {
+/// A parser that can be reused to parse many source strings in a row.
+///
+/// The syntax tree of each parse is allocated out of an arena that belongs to
+/// the parser, and the parser is reset between parses with `pm_parser_reset`.
+/// This means that once the parser's buffers have grown to fit the sources
+/// being parsed, subsequent parses allocate very little, and freeing a tree is
+/// a matter of rewinding the arena rather than visiting every node.
+///
+/// Each `ParseResult` mutably borrows the parser, so the previous result must
+/// be dropped before the parser can be used again. Parsers can be sent to other
+/// threads, so a pool of threads can each keep one of their own.
+#[derive(Debug)]
+pub struct Parser {
+    raw: NonNull<MaybeUninit<pm_parser_t>>,
+    arena: NonNull<pm_arena_t>,
+    initialized: bool,
+}
+
+// SAFETY: the parser and its arena are owned exclusively by this handle, and
+// prism keeps no global mutable state.
+unsafe impl Send for Parser {}
+
+impl Parser {
+    /// Creates a new parser. No memory is allocated for parsing until the first
+    /// call to `parse`.
+    #[must_use]
+    pub fn new() -> Self {
+        let raw = NonNull::from(Box::leak(Box::new(MaybeUninit::<pm_parser_t>::uninit())));
+        let arena = NonNull::from(Box::leak(Box::new(pm_arena_t::default())));
+
+        Self { raw, arena, initialized: false }
+    }
+
+    /// Parses the given source string and returns a parse result that borrows
+    /// this parser until it is dropped.
+    #[must_use]
+    pub fn parse<'pr>(&'pr mut self, source: &'pr [u8]) -> ParseResult<'pr> {
+        let (parser, node) = self.parse_raw(source);
+        ParseResult {
+            source,
+            parser,
+            node,
+            _owner: None,
+            marker: PhantomData,
+        }
+    }
+
+    /// Parses the given source string with this parser, initializing it the
+    /// first time and resetting it every time after that.
+    fn parse_raw(&mut self, source: &[u8]) -> (NonNull<pm_parser_t>, NonNull<pm_node_t>) {
         unsafe {
-            pm_node_destroy(self.parser.as_ptr(), self.node.as_ptr());
-            pm_parser_free(self.parser.as_ptr());
-            drop(Box::from_raw(self.parser.as_ptr()));
+            let parser = (*self.raw.as_ptr()).as_mut_ptr();
+
+            if self.initialized {
+                pm_parser_reset(parser, source.as_ptr(), source.len(), std::ptr::null());
+            } else {
+                pm_parser_init(parser, source.as_ptr(), source.len(), std::ptr::null());
+                pm_parser_arena_set(parser, self.arena.as_ptr());
+                self.initialized = true;
+            }
+
+            let node = pm_parse(parser);
+            (NonNull::new_unchecked(parser), NonNull::new_unchecked(node))
         }
     }
 }
 
-/// Parses the given source string and returns a parse result.
-///
-/// # Panics
-///
-/// Panics if the parser fails to initialize.
-///
-#[must_use]
-pub fn parse(source: &[u8]) -> ParseResult<'_> {
-    unsafe {
-        let uninit = Box::new(MaybeUninit::<pm_parser_t>::uninit());
-        let uninit = Box::into_raw(uninit);
-
-        pm_parser_init((*uninit).as_mut_ptr(), source.as_ptr(), source.len(), std::ptr::null());
+impl Default for Parser {
+    fn default() -> Self {
+        Self::new()
+    }
+}
 
-        let parser = (*uninit).assume_init_mut();
-        let parser = NonNull::new_unchecked(parser);
+impl Drop for Parser {
+    fn drop(&mut self) {
+        unsafe {
+            if self.initialized {
+                pm_parser_free((*self.raw.as_ptr()).as_mut_ptr());
+            }
 
-        let node = pm_parse(parser.as_ptr());
-        let node = NonNull::new_unchecked(node);
+            pm_arena_free(self.arena.as_ptr());
+            drop(Box::from_raw(self.arena.as_ptr()));
+            drop(Box::from_raw(self.raw.as_ptr()));
+        }
+    }
+}
 
-        ParseResult { source, parser, node }
+/// Parses the given source string and returns a parse result. This creates a
+/// new parser for every call, so when parsing many source strings it is cheaper
+/// to reuse a `Parser`.
+#[must_use]
+pub fn parse(source: &[u8]) -> ParseResult<'_> {
+    let mut owner = Parser::new();
+    let (parser, node) = owner.parse_raw(source);
+    ParseResult {
+        source,
+        parser,
+        node,
+        _owner: Some(owner),
+        marker: PhantomData,
     }
 }
 
@@ -254,6 +336,49 @@ mod tests {
         }
     }
 
+    #[test]
+    fn parser_reuse_test() {
+        use super::Parser;
+
+        let mut parser = Parser::new();
+
+        for source in ["foo(1)", "class Foo; end", "# comment\nbar"] {
+            let result = parser.parse(source.as_ref());
+            let node = result.node();
+            let node = node.as_program_node().unwrap().statements().body().iter().next().unwrap();
+
+            assert_eq!(result.as_slice(&node.location()), source.lines().last().unwrap().as_bytes());
+            assert_eq!(result.errors().count(), 0);
+        }
+
+        let result = parser.parse(b"foo(");
+        assert!(result.errors().count() > 0);
+    }
+
+    #[test]
+    fn send_test() {
+        use super::Parser;
+
+        let sources = ["foo", "bar(1, 2)", "class Baz; end"];
+        let handles = sources
+            .iter()
+            .map(|&source| {
+                std::thread::spawn(move || {
+                    let mut parser = Parser::new();
+                    let result = parser.parse(source.as_bytes());
+                    result.node().location().as_slice().len()
+                })
+            })
+            .collect::<Vec<_>>();
+
+        let lengths = handles.into_iter().map(|handle| handle.join().unwrap()).collect::<Vec<_>>();
+        assert_eq!(lengths, sources.iter().map(|source| source.len()).collect::<Vec<_>>());
+
+        let result = parse(b"foo");
+        let length = std::thread::spawn(move || result.node().location().as_slice().len()).join().unwrap();
+        assert_eq!(length, 3);
+    }
+
     #[test]
     fn location_test() {
         let source = "111 + 222 + 333";
@@ -32,6 +32,14 @@ pm_options_frozen_string_literal_set(pm_options_t *options, bool frozen_string_l
     options->frozen_string_literal = frozen_string_literal ? PM_OPTIONS_FROZEN_STRING_LITERAL_ENABLED : PM_OPTIONS_FROZEN_STRING_LITERAL_DISABLED;
 }
 
+/**
+ * Set the newline index option on the given options struct.
+ */
+PRISM_EXPORTED_FUNCTION void
+pm_options_newline_index_set(pm_options_t *options, bool newline_index) {
+    options->newline_index = newline_index;
+}
+
 /**
  * Sets the command line option on the given options struct.
  */
@@ -40,6 +48,14 @@ pm_options_command_line_set(pm_options_t *options, uint8_t command_line) {
     options->command_line = command_line;
 }
 
+/**
+ * Sets the serialization option on the given options struct.
+ */
+PRISM_EXPORTED_FUNCTION void
+pm_options_serialization_set(pm_options_t *options, uint8_t serialization) {
+    options->serialization = serialization;
+}
+
 /**
  * Set the version option on the given options struct by parsing the given
  * string. If the string contains an invalid option, this returns false.
@@ -215,6 +231,7 @@ pm_options_read(pm_options_t *options, const char *data) {
     options->frozen_string_literal = (int8_t) *data++;
     options->command_line = (uint8_t) *data++;
     options->version = (pm_options_version_t) *data++;
+    options->serialization = (uint8_t) *data++;
 
     uint32_t scopes_count = pm_options_read_u32(data);
     data += 4;
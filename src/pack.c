@@ -11,6 +11,7 @@ void pm_pack_parse(void) {}
 
 #include <stdbool.h>
 #include <errno.h>
+#include <string.h>
 
 static uintmax_t
 strtoumaxc(const char **format) {
@@ -480,6 +481,185 @@ exit_modifier_loop:
     return PM_PACK_OK;
 }
 
+PRISM_EXPORTED_FUNCTION pm_pack_result
+pm_pack_compile(pm_pack_variant variant, const char *format, size_t length, pm_pack_format_t *compiled) {
+    *compiled = (pm_pack_format_t) { .encoding = PM_PACK_ENCODING_START, .result = PM_PACK_OK };
+
+    const char *cursor = format;
+    const char *format_end = format + length;
+    size_t capacity = 0;
+
+    while (cursor < format_end) {
+        pm_pack_directive_t directive;
+        const char *directive_start = cursor;
+
+        pm_pack_result result = pm_pack_parse(
+            variant, &cursor, format_end, &directive.type, &directive.signed_type, &directive.endian,
+            &directive.size, &directive.length_type, &directive.length, &compiled->encoding
+        );
+
+        if (result != PM_PACK_OK) {
+            compiled->result = result;
+            break;
+        }
+
+        if (directive.type == PM_PACK_END) break;
+
+        if (compiled->size == capacity) {
+            capacity = capacity == 0 ? 4 : capacity * 2;
+            pm_pack_directive_t *directives = xrealloc(compiled->directives, capacity * sizeof(pm_pack_directive_t));
+
+            if (directives == NULL) {
+                compiled->result = PM_PACK_ERROR_NO_MEMORY;
+                break;
+            }
+
+            compiled->directives = directives;
+        }
+
+        directive.start = (size_t) (directive_start - format);
+        directive.source_length = (size_t) (cursor - directive_start);
+        compiled->directives[compiled->size++] = directive;
+    }
+
+    return compiled->result;
+}
+
+PRISM_EXPORTED_FUNCTION void
+pm_pack_format_free(pm_pack_format_t *compiled) {
+    xfree(compiled->directives);
+    *compiled = (pm_pack_format_t) { 0 };
+}
+
+/**
+ * Hash the variant and the format string with FNV-1a.
+ */
+static uint32_t
+pm_pack_cache_hash(pm_pack_variant variant, const char *format, size_t length) {
+    uint32_t hash = 2166136261u ^ (uint32_t) variant;
+
+    for (size_t index = 0; index < length; index++) {
+        hash ^= (uint8_t) format[index];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/**
+ * Remove the given entry from the list of entries in order of use.
+ */
+static void
+pm_pack_cache_unlink(pm_pack_cache_t *cache, pm_pack_cache_entry_t *entry) {
+    if (entry->newer != NULL) entry->newer->older = entry->older;
+    else cache->newest = entry->older;
+
+    if (entry->older != NULL) entry->older->newer = entry->newer;
+    else cache->oldest = entry->newer;
+
+    entry->newer = NULL;
+    entry->older = NULL;
+}
+
+/**
+ * Add the given entry to the list of entries in order of use as the most
+ * recently used one.
+ */
+static void
+pm_pack_cache_link(pm_pack_cache_t *cache, pm_pack_cache_entry_t *entry) {
+    entry->older = cache->newest;
+    if (cache->newest != NULL) cache->newest->newer = entry;
+    cache->newest = entry;
+    if (cache->oldest == NULL) cache->oldest = entry;
+}
+
+/**
+ * Remove the least recently used entry from the cache and free it.
+ */
+static void
+pm_pack_cache_evict(pm_pack_cache_t *cache) {
+    pm_pack_cache_entry_t *entry = cache->oldest;
+    pm_pack_cache_unlink(cache, entry);
+
+    pm_pack_cache_entry_t **link = &cache->buckets[entry->hash & (cache->buckets_size - 1)];
+    while (*link != entry) link = &(*link)->next;
+    *link = entry->next;
+
+    pm_pack_format_free(&entry->format);
+    xfree(entry->source);
+    xfree(entry);
+    cache->size--;
+}
+
+PRISM_EXPORTED_FUNCTION bool
+pm_pack_cache_init(pm_pack_cache_t *cache, size_t capacity) {
+    size_t buckets_size = 1;
+    while (buckets_size < capacity) buckets_size <<= 1;
+
+    pm_pack_cache_entry_t **buckets = xcalloc(buckets_size, sizeof(pm_pack_cache_entry_t *));
+    if (buckets == NULL) return false;
+
+    *cache = (pm_pack_cache_t) { .buckets = buckets, .buckets_size = buckets_size, .capacity = capacity == 0 ? 1 : capacity };
+    return true;
+}
+
+PRISM_EXPORTED_FUNCTION const pm_pack_format_t *
+pm_pack_cache_fetch(pm_pack_cache_t *cache, pm_pack_variant variant, const char *format, size_t length) {
+    uint32_t hash = pm_pack_cache_hash(variant, format, length);
+    pm_pack_cache_entry_t **bucket = &cache->buckets[hash & (cache->buckets_size - 1)];
+
+    for (pm_pack_cache_entry_t *entry = *bucket; entry != NULL; entry = entry->next) {
+        if (entry->hash == hash && entry->variant == variant && entry->source_length == length && memcmp(entry->source, format, length) == 0) {
+            if (entry != cache->newest) {
+                pm_pack_cache_unlink(cache, entry);
+                pm_pack_cache_link(cache, entry);
+            }
+
+            return &entry->format;
+        }
+    }
+
+    pm_pack_cache_entry_t *entry = xcalloc(1, sizeof(pm_pack_cache_entry_t));
+    if (entry == NULL) return NULL;
+
+    // Always allocate at least one byte so that an empty format string can be
+    // told apart from a failed allocation.
+    entry->source = xmalloc(length + 1);
+    if (entry->source == NULL) {
+        xfree(entry);
+        return NULL;
+    }
+
+    pm_pack_compile(variant, format, length, &entry->format);
+    if (entry->format.result == PM_PACK_ERROR_NO_MEMORY) {
+        pm_pack_format_free(&entry->format);
+        xfree(entry->source);
+        xfree(entry);
+        return NULL;
+    }
+
+    if (cache->size == cache->capacity) pm_pack_cache_evict(cache);
+
+    memcpy(entry->source, format, length);
+    entry->source_length = length;
+    entry->hash = hash;
+    entry->variant = variant;
+    entry->next = *bucket;
+    *bucket = entry;
+
+    pm_pack_cache_link(cache, entry);
+    cache->size++;
+
+    return &entry->format;
+}
+
+PRISM_EXPORTED_FUNCTION void
+pm_pack_cache_free(pm_pack_cache_t *cache) {
+    while (cache->oldest != NULL) pm_pack_cache_evict(cache);
+    xfree(cache->buckets);
+    *cache = (pm_pack_cache_t) { 0 };
+}
+
 PRISM_EXPORTED_FUNCTION size_t
 pm_size_to_native(pm_pack_size size) {
     switch (size) {
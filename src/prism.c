@@ -236,18 +236,26 @@ lex_mode_terminator(const uint8_t start) {
 /**
  * Push a new lex state onto the stack. If we're still within the pre-allocated
  * space of the lex state stack, then we'll just use a new slot. Otherwise we'll
- * allocate a new pointer and use that.
+ * reuse a previously popped lex state, or allocate a new one if there are none.
  */
 static bool
 lex_mode_push(pm_parser_t *parser, pm_lex_mode_t lex_mode) {
+    PM_STATS_ADD(parser, lex_mode_pushes, 1);
     lex_mode.prev = parser->lex_modes.current;
     parser->lex_modes.index++;
 
     if (parser->lex_modes.index > PM_LEX_STACK_SIZE - 1) {
-        parser->lex_modes.current = (pm_lex_mode_t *) xmalloc(sizeof(pm_lex_mode_t));
-        if (parser->lex_modes.current == NULL) return false;
+        pm_lex_mode_t *current = parser->lex_modes.free;
 
-        *parser->lex_modes.current = lex_mode;
+        if (current != NULL) {
+            parser->lex_modes.free = current->prev;
+        } else {
+            current = (pm_lex_mode_t *) xmalloc(sizeof(pm_lex_mode_t));
+            if (current == NULL) return false;
+        }
+
+        *current = lex_mode;
+        parser->lex_modes.current = current;
     } else {
         parser->lex_modes.stack[parser->lex_modes.index] = lex_mode;
         parser->lex_modes.current = &parser->lex_modes.stack[parser->lex_modes.index];
@@ -402,7 +410,7 @@ lex_mode_push_string_eof(pm_parser_t *parser) {
 /**
  * Pop the current lex state off the stack. If we're within the pre-allocated
  * space of the lex state stack, then we'll just decrement the index. Otherwise
- * we'll free the current pointer and use the previous pointer.
+ * we'll keep the current pointer for reuse and use the previous pointer.
  */
 static void
 lex_mode_pop(pm_parser_t *parser) {
@@ -413,9 +421,11 @@ lex_mode_pop(pm_parser_t *parser) {
         parser->lex_modes.current = &parser->lex_modes.stack[parser->lex_modes.index];
     } else {
         parser->lex_modes.index--;
-        pm_lex_mode_t *prev = parser->lex_modes.current->prev;
-        xfree(parser->lex_modes.current);
-        parser->lex_modes.current = prev;
+        pm_lex_mode_t *current = parser->lex_modes.current;
+        parser->lex_modes.current = current->prev;
+
+        current->prev = parser->lex_modes.free;
+        parser->lex_modes.free = current;
     }
 }
 
@@ -697,16 +707,26 @@ pm_parser_err_heredoc_term(pm_parser_t *parser, pm_lex_mode_t *lex_mode) {
 /******************************************************************************/
 
 /**
- * Allocate and initialize a new scope. Push it onto the scope stack.
+ * Initialize a new scope and push it onto the scope stack. The memory for the
+ * scope (and its locals) is taken from the previously popped scopes if there
+ * are any, and is only allocated otherwise.
  */
 static bool
 pm_parser_scope_push(pm_parser_t *parser, bool closed) {
-    pm_scope_t *scope = (pm_scope_t *) xmalloc(sizeof(pm_scope_t));
-    if (scope == NULL) return false;
+    pm_scope_t *scope = parser->free_scopes;
+    pm_locals_t locals = { 0 };
+
+    if (scope != NULL) {
+        parser->free_scopes = scope->previous;
+        locals = scope->locals;
+    } else {
+        scope = (pm_scope_t *) xmalloc(sizeof(pm_scope_t));
+        if (scope == NULL) return false;
+    }
 
     *scope = (pm_scope_t) {
         .previous = parser->current_scope,
-        .locals = { 0 },
+        .locals = locals,
         .parameters = PM_SCOPE_PARAMETERS_NONE,
         .implicit_parameters = { 0 },
         .shareable_constant = (closed || parser->current_scope == NULL) ? PM_SCOPE_SHAREABLE_CONSTANT_NONE : parser->current_scope->shareable_constant,
@@ -872,6 +892,13 @@ pm_parser_scope_shareable_constant_set(pm_parser_t *parser, pm_shareable_constan
  */
 #define PM_LOCALS_HASH_THRESHOLD 9
 
+/**
+ * The largest capacity of a set of locals whose memory is kept for reuse when
+ * its scope is popped. Larger sets are freed, since clearing them for reuse
+ * would cost more than allocating a small set again.
+ */
+#define PM_LOCALS_REUSE_CAPACITY 16
+
 static void
 pm_locals_free(pm_locals_t *locals) {
     if (locals->capacity > 0) {
@@ -880,14 +907,32 @@ pm_locals_free(pm_locals_t *locals) {
 }
 
 /**
- * Use as simple and fast a hash function as we can that still properly mixes
- * the bits.
+ * Empty the set of locals so that it can be reused by another scope, keeping
+ * its memory if it is small enough.
  */
-static uint32_t
+static void
+pm_locals_clear(pm_locals_t *locals) {
+    if (locals->capacity > PM_LOCALS_REUSE_CAPACITY) {
+        pm_locals_free(locals);
+        *locals = (pm_locals_t) { 0 };
+        return;
+    }
+
+    // Below the hash threshold the locals are stored contiguously, so only the
+    // ones that were written need to be cleared.
+    uint32_t length = locals->capacity < PM_LOCALS_HASH_THRESHOLD ? locals->size : locals->capacity;
+    if (length > 0) memset(locals->locals, 0, length * sizeof(pm_local_t));
+    locals->size = 0;
+}
+
+/**
+ * Constant ids are handed out sequentially as names are first seen, so locals
+ * that are declared near each other have nearby ids. That makes the id itself
+ * a good hash for the small tables that locals live in: it spreads these runs
+ * of ids across consecutive slots without any collisions.
+ */
+static inline uint32_t
 pm_locals_hash(pm_constant_id_t name) {
-    name = ((name >> 16) ^ name) * 0x45d9f3b;
-    name = ((name >> 16) ^ name) * 0x45d9f3b;
-    name = (name >> 16) ^ name;
     return name;
 }
 
@@ -1080,8 +1125,17 @@ pm_locals_reads(pm_locals_t *locals, pm_constant_id_t name) {
  * written but not read in certain contexts.
  */
 static void
-pm_locals_order(PRISM_ATTRIBUTE_UNUSED pm_parser_t *parser, pm_locals_t *locals, pm_constant_id_list_t *list, bool toplevel) {
-    pm_constant_id_list_init_capacity(list, locals->size);
+pm_locals_order(pm_parser_t *parser, pm_locals_t *locals, pm_constant_id_list_t *list, bool toplevel) {
+    if (parser->arena == NULL) {
+        pm_constant_id_list_init_capacity(list, locals->size);
+    } else {
+        size_t size = locals->size * sizeof(pm_constant_id_t);
+        pm_constant_id_t *ids = (pm_constant_id_t *) pm_arena_alloc(parser->arena, size);
+        if (ids == NULL) abort();
+
+        memset(ids, 0, size);
+        *list = (pm_constant_id_list_t) { .ids = ids, .size = 0, .capacity = locals->size };
+    }
 
     // If we're still below the threshold for switching to a hash, then we only
     // need to loop over the locals until we hit the size because the locals are
@@ -2001,21 +2055,96 @@ static size_t
 pm_statements_node_body_length(pm_statements_node_t *node);
 
 /**
- * This function is here to allow us a place to extend in the future when we
- * implement our own arena allocation.
+ * Allocate the memory for a node. If the parser has an arena attached, then the
+ * node is carved out of the arena. Otherwise it is allocated on the heap.
  */
 static inline void *
-pm_alloc_node(PRISM_ATTRIBUTE_UNUSED pm_parser_t *parser, size_t size) {
-    void *memory = xcalloc(1, size);
+pm_alloc_node(pm_parser_t *parser, size_t size) {
+    void *memory;
+
+    if (parser->arena == NULL) {
+        memory = xcalloc(1, size);
+    } else if ((memory = pm_arena_alloc(parser->arena, size)) != NULL) {
+        memset(memory, 0, size);
+    }
+
     if (memory == NULL) {
         fprintf(stderr, "Failed to allocate %d bytes\n", (int) size);
         abort();
     }
+
+    PM_STATS_ADD(parser, nodes_allocated, 1);
+    PM_STATS_ADD(parser, node_bytes_allocated, size);
     return memory;
 }
 
 #define PM_ALLOC_NODE(parser, type) (type *) pm_alloc_node(parser, sizeof(type))
 
+/**
+ * Free the memory for a single node without freeing any of its children. This
+ * is used when a node is being replaced by another node that has taken
+ * ownership of its children. When the node lives in an arena, its memory is
+ * reclaimed when the arena is freed, so there is nothing to do.
+ */
+static inline void
+pm_free_node(pm_parser_t *parser, void *node) {
+    if (parser->arena == NULL) xfree(node);
+}
+
+/**
+ * Integers that do not fit into 32 bits allocate their digits on the heap. If
+ * the integer belongs to a node in an arena, then move those digits into the
+ * arena as well so that they are released along with the rest of the tree.
+ */
+static void
+pm_integer_arena_move(pm_parser_t *parser, pm_integer_t *integer) {
+    if (parser->arena == NULL || integer->values == NULL) return;
+
+    uint32_t *values = (uint32_t *) pm_arena_memdup(parser->arena, integer->values, integer->length * sizeof(uint32_t));
+    if (values == NULL) abort();
+
+    xfree(integer->values);
+    integer->values = values;
+}
+
+/**
+ * Set the current string on the parser to the given heap-allocated memory,
+ * transferring ownership of it. If the parser has an arena, then the contents
+ * are copied into the arena and the heap memory is released immediately, so
+ * that no node in the tree ends up owning memory outside of the arena.
+ */
+static void
+pm_parser_current_string_owned_init(pm_parser_t *parser, uint8_t *source, size_t length) {
+    if (parser->arena == NULL) {
+        pm_string_owned_init(&parser->current_string, source, length);
+        return;
+    }
+
+    void *memory = pm_arena_memdup(parser->arena, source, length);
+    if (memory == NULL) abort();
+
+    xfree(source);
+    pm_string_constant_init(&parser->current_string, (const char *) memory, length);
+}
+
+/**
+ * Ensure that the given string owns its memory so that it can be modified in
+ * place. If the parser has an arena, then the copy is made inside of the arena.
+ */
+static void
+pm_parser_string_ensure_owned(pm_parser_t *parser, pm_string_t *string) {
+    if (parser->arena == NULL) {
+        pm_string_ensure_owned(string);
+        return;
+    }
+
+    size_t length = pm_string_length(string);
+    void *memory = pm_arena_memdup(parser->arena, pm_string_source(string), length);
+    if (memory == NULL) abort();
+
+    pm_string_constant_init(string, (const char *) memory, length);
+}
+
 /**
  * Allocate a new MissingNode node.
  */
@@ -2152,13 +2281,13 @@ pm_arguments_node_size(pm_arguments_node_t *node) {
  * Append an argument to an arguments node.
  */
 static void
-pm_arguments_node_arguments_append(pm_arguments_node_t *node, pm_node_t *argument) {
+pm_arguments_node_arguments_append(pm_parser_t *parser, pm_arguments_node_t *node, pm_node_t *argument) {
     if (pm_arguments_node_size(node) == 0) {
         node->base.location.start = argument->location.start;
     }
 
     node->base.location.end = argument->location.end;
-    pm_node_list_append(&node->arguments, argument);
+    pm_node_list_arena_append(parser->arena, &node->arguments, argument);
 }
 
 /**
@@ -2194,12 +2323,12 @@ pm_array_node_size(pm_array_node_t *node) {
  * Append an argument to an array node.
  */
 static inline void
-pm_array_node_elements_append(pm_array_node_t *node, pm_node_t *element) {
+pm_array_node_elements_append(pm_parser_t *parser, pm_array_node_t *node, pm_node_t *element) {
     if (!node->elements.size && !node->opening_loc.start) {
         node->base.location.start = element->location.start;
     }
 
-    pm_node_list_append(&node->elements, element);
+    pm_node_list_arena_append(parser->arena, &node->elements, element);
     node->base.location.end = element->location.end;
 
     // If the element is not a static literal, then the array is not a static
@@ -2257,9 +2386,9 @@ pm_array_pattern_node_node_list_create(pm_parser_t *parser, pm_node_list_t *node
             node->rest = child;
             found_rest = true;
         } else if (found_rest) {
-            pm_node_list_append(&node->posts, child);
+            pm_node_list_arena_append(parser->arena, &node->posts, child);
         } else {
-            pm_node_list_append(&node->requireds, child);
+            pm_node_list_arena_append(parser->arena, &node->requireds, child);
         }
     }
 
@@ -2344,8 +2473,8 @@ pm_array_pattern_node_empty_create(pm_parser_t *parser, const pm_token_t *openin
 }
 
 static inline void
-pm_array_pattern_node_requireds_append(pm_array_pattern_node_t *node, pm_node_t *inner) {
-    pm_node_list_append(&node->requireds, inner);
+pm_array_pattern_node_requireds_append(pm_parser_t *parser, pm_array_pattern_node_t *node, pm_node_t *inner) {
+    pm_node_list_arena_append(parser->arena, &node->requireds, inner);
 }
 
 /**
@@ -2645,8 +2774,8 @@ pm_block_local_variable_node_create(pm_parser_t *parser, const pm_token_t *name)
  * Append a new block-local variable to a BlockParametersNode node.
  */
 static void
-pm_block_parameters_node_append_local(pm_block_parameters_node_t *node, const pm_block_local_variable_node_t *local) {
-    pm_node_list_append(&node->locals, (pm_node_t *) local);
+pm_block_parameters_node_append_local(pm_parser_t *parser, pm_block_parameters_node_t *node, const pm_block_local_variable_node_t *local) {
+    pm_node_list_arena_append(parser->arena, &node->locals, (pm_node_t *) local);
 
     if (node->base.location.start == NULL) node->base.location.start = local->base.location.start;
     node->base.location.end = local->base.location.end;
@@ -2766,7 +2895,7 @@ pm_call_node_binary_create(pm_parser_t *parser, pm_node_t *receiver, pm_token_t
     node->message_loc = PM_OPTIONAL_LOCATION_TOKEN_VALUE(operator);
 
     pm_arguments_node_t *arguments = pm_arguments_node_create(parser);
-    pm_arguments_node_arguments_append(arguments, argument);
+    pm_arguments_node_arguments_append(parser, arguments, argument);
     node->arguments = arguments;
 
     node->name = pm_parser_constant_id_token(parser, operator);
@@ -3017,7 +3146,7 @@ pm_call_and_write_node_create(pm_parser_t *parser, pm_call_node_t *target, const
     // Here we're going to free the target, since it is no longer necessary.
     // However, we don't want to call `pm_node_destroy` because we want to keep
     // around all of its children since we just reused them.
-    xfree(target);
+    pm_free_node(parser, target);
 
     return node;
 }
@@ -3077,7 +3206,7 @@ pm_index_and_write_node_create(pm_parser_t *parser, pm_call_node_t *target, cons
     // Here we're going to free the target, since it is no longer necessary.
     // However, we don't want to call `pm_node_destroy` because we want to keep
     // around all of its children since we just reused them.
-    xfree(target);
+    pm_free_node(parser, target);
 
     return node;
 }
@@ -3114,7 +3243,7 @@ pm_call_operator_write_node_create(pm_parser_t *parser, pm_call_node_t *target,
     // Here we're going to free the target, since it is no longer necessary.
     // However, we don't want to call `pm_node_destroy` because we want to keep
     // around all of its children since we just reused them.
-    xfree(target);
+    pm_free_node(parser, target);
 
     return node;
 }
@@ -3151,7 +3280,7 @@ pm_index_operator_write_node_create(pm_parser_t *parser, pm_call_node_t *target,
     // Here we're going to free the target, since it is no longer necessary.
     // However, we don't want to call `pm_node_destroy` because we want to keep
     // around all of its children since we just reused them.
-    xfree(target);
+    pm_free_node(parser, target);
 
     return node;
 }
@@ -3188,7 +3317,7 @@ pm_call_or_write_node_create(pm_parser_t *parser, pm_call_node_t *target, const
     // Here we're going to free the target, since it is no longer necessary.
     // However, we don't want to call `pm_node_destroy` because we want to keep
     // around all of its children since we just reused them.
-    xfree(target);
+    pm_free_node(parser, target);
 
     return node;
 }
@@ -3225,7 +3354,7 @@ pm_index_or_write_node_create(pm_parser_t *parser, pm_call_node_t *target, const
     // Here we're going to free the target, since it is no longer necessary.
     // However, we don't want to call `pm_node_destroy` because we want to keep
     // around all of its children since we just reused them.
-    xfree(target);
+    pm_free_node(parser, target);
 
     return node;
 }
@@ -3253,7 +3382,7 @@ pm_call_target_node_create(pm_parser_t *parser, pm_call_node_t *target) {
     // Here we're going to free the target, since it is no longer necessary.
     // However, we don't want to call `pm_node_destroy` because we want to keep
     // around all of its children since we just reused them.
-    xfree(target);
+    pm_free_node(parser, target);
 
     return node;
 }
@@ -3285,7 +3414,7 @@ pm_index_target_node_create(pm_parser_t *parser, pm_call_node_t *target) {
     // Here we're going to free the target, since it is no longer necessary.
     // However, we don't want to call `pm_node_destroy` because we want to keep
     // around all of its children since we just reused them.
-    xfree(target);
+    pm_free_node(parser, target);
 
     return node;
 }
@@ -3342,10 +3471,10 @@ pm_case_node_create(pm_parser_t *parser, const pm_token_t *case_keyword, pm_node
  * Append a new condition to a CaseNode node.
  */
 static void
-pm_case_node_condition_append(pm_case_node_t *node, pm_node_t *condition) {
+pm_case_node_condition_append(pm_parser_t *parser, pm_case_node_t *node, pm_node_t *condition) {
     assert(PM_NODE_TYPE_P(condition, PM_WHEN_NODE));
 
-    pm_node_list_append(&node->conditions, condition);
+    pm_node_list_arena_append(parser->arena, &node->conditions, condition);
     node->base.location.end = condition->location.end;
 }
 
@@ -3396,10 +3525,10 @@ pm_case_match_node_create(pm_parser_t *parser, const pm_token_t *case_keyword, p
  * Append a new condition to a CaseMatchNode node.
  */
 static void
-pm_case_match_node_condition_append(pm_case_match_node_t *node, pm_node_t *condition) {
+pm_case_match_node_condition_append(pm_parser_t *parser, pm_case_match_node_t *node, pm_node_t *condition) {
     assert(PM_NODE_TYPE_P(condition, PM_IN_NODE));
 
-    pm_node_list_append(&node->conditions, condition);
+    pm_node_list_arena_append(parser->arena, &node->conditions, condition);
     node->base.location.end = condition->location.end;
 }
 
@@ -4187,11 +4316,10 @@ pm_find_pattern_node_create(pm_parser_t *parser, pm_node_list_t *nodes) {
         .closing_loc = PM_OPTIONAL_LOCATION_NOT_PROVIDED_VALUE
     };
 
-    // For now we're going to just copy over each pointer manually. This could be
-    // much more efficient, as we could instead resize the node list to only point
-    // to 1...-1.
-    for (size_t index = 1; index < nodes->size - 1; index++) {
-        pm_node_list_append(&node->requireds, nodes->nodes[index]);
+    // Copy over the pointers between the left and right rest patterns.
+    if (nodes->size > 2) {
+        pm_node_list_t requireds = { .size = nodes->size - 2, .capacity = nodes->size - 2, .nodes = nodes->nodes + 1 };
+        pm_node_list_arena_concat(parser->arena, &node->requireds, &requireds);
     }
 
     return node;
@@ -4363,6 +4491,9 @@ pm_float_node_rational_create(pm_parser_t *parser, const pm_token_t *token) {
     free(digits);
 
     pm_integers_reduce(&node->numerator, &node->denominator);
+    pm_integer_arena_move(parser, &node->numerator);
+    pm_integer_arena_move(parser, &node->denominator);
+
     return node;
 }
 
@@ -4542,10 +4673,7 @@ pm_hash_pattern_node_node_list_create(pm_parser_t *parser, pm_node_list_t *eleme
         .closing_loc = PM_OPTIONAL_LOCATION_NOT_PROVIDED_VALUE
     };
 
-    pm_node_t *element;
-    PM_NODE_LIST_FOREACH(elements, index, element) {
-        pm_node_list_append(&node->elements, element);
-    }
+    pm_node_list_arena_concat(parser->arena, &node->elements, elements);
 
     return node;
 }
@@ -4752,8 +4880,8 @@ pm_hash_node_create(pm_parser_t *parser, const pm_token_t *opening) {
  * Append a new element to a hash node.
  */
 static inline void
-pm_hash_node_elements_append(pm_hash_node_t *hash, pm_node_t *element) {
-    pm_node_list_append(&hash->elements, element);
+pm_hash_node_elements_append(pm_parser_t *parser, pm_hash_node_t *hash, pm_node_t *element) {
+    pm_node_list_arena_append(parser->arena, &hash->elements, element);
 
     bool static_literal = PM_NODE_TYPE_P(element, PM_ASSOC_NODE);
     if (static_literal) {
@@ -4967,6 +5095,8 @@ pm_integer_node_create(pm_parser_t *parser, pm_node_flags_t base, const pm_token
     }
 
     pm_integer_parse(&node->value, integer_base, token->start, token->end);
+    pm_integer_arena_move(parser, &node->value);
+
     return node;
 }
 
@@ -5024,6 +5154,7 @@ pm_integer_node_rational_create(pm_parser_t *parser, pm_node_flags_t base, const
     }
 
     pm_integer_parse(&node->numerator, integer_base, token->start, token->end - 1);
+    pm_integer_arena_move(parser, &node->numerator);
 
     return node;
 }
@@ -5210,7 +5341,7 @@ pm_instance_variable_write_node_create(pm_parser_t *parser, pm_instance_variable
  * literals.
  */
 static void
-pm_interpolated_node_append(pm_node_t *node, pm_node_list_t *parts, pm_node_t *part) {
+pm_interpolated_node_append(pm_parser_t *parser, pm_node_t *node, pm_node_list_t *parts, pm_node_t *part) {
     switch (PM_NODE_TYPE(part)) {
         case PM_STRING_NODE:
             pm_node_flag_set(part, PM_NODE_FLAG_STATIC_LITERAL | PM_STRING_FLAGS_FROZEN);
@@ -5245,7 +5376,7 @@ pm_interpolated_node_append(pm_node_t *node, pm_node_list_t *parts, pm_node_t *p
             break;
     }
 
-    pm_node_list_append(parts, part);
+    pm_node_list_arena_append(parser->arena, parts, part);
 }
 
 /**
@@ -5273,7 +5404,7 @@ pm_interpolated_regular_expression_node_create(pm_parser_t *parser, const pm_tok
 }
 
 static inline void
-pm_interpolated_regular_expression_node_append(pm_interpolated_regular_expression_node_t *node, pm_node_t *part) {
+pm_interpolated_regular_expression_node_append(pm_parser_t *parser, pm_interpolated_regular_expression_node_t *node, pm_node_t *part) {
     if (node->base.location.start > part->location.start) {
         node->base.location.start = part->location.start;
     }
@@ -5281,7 +5412,7 @@ pm_interpolated_regular_expression_node_append(pm_interpolated_regular_expressio
         node->base.location.end = part->location.end;
     }
 
-    pm_interpolated_node_append((pm_node_t *) node, &node->parts, part);
+    pm_interpolated_node_append(parser, (pm_node_t *) node, &node->parts, part);
 }
 
 static inline void
@@ -5315,7 +5446,7 @@ pm_interpolated_regular_expression_node_closing_set(pm_parser_t *parser, pm_inte
  * which could potentially use a chilled string otherwise.
  */
 static inline void
-pm_interpolated_string_node_append(pm_interpolated_string_node_t *node, pm_node_t *part) {
+pm_interpolated_string_node_append(pm_parser_t *parser, pm_interpolated_string_node_t *node, pm_node_t *part) {
 #define CLEAR_FLAGS(node) \
     node->base.flags = (pm_node_flags_t) (node->base.flags & ~(PM_NODE_FLAG_STATIC_LITERAL | PM_INTERPOLATED_STRING_NODE_FLAGS_FROZEN | PM_INTERPOLATED_STRING_NODE_FLAGS_MUTABLE))
 
@@ -5384,7 +5515,7 @@ pm_interpolated_string_node_append(pm_interpolated_string_node_t *node, pm_node_
             break;
     }
 
-    pm_node_list_append(&node->parts, part);
+    pm_node_list_arena_append(parser->arena, &node->parts, part);
 
 #undef CLEAR_FLAGS
 #undef MUTABLE_FLAGS
@@ -5424,7 +5555,7 @@ pm_interpolated_string_node_create(pm_parser_t *parser, const pm_token_t *openin
     if (parts != NULL) {
         pm_node_t *part;
         PM_NODE_LIST_FOREACH(parts, index, part) {
-            pm_interpolated_string_node_append(node, part);
+            pm_interpolated_string_node_append(parser, node, part);
         }
     }
 
@@ -5441,12 +5572,12 @@ pm_interpolated_string_node_closing_set(pm_interpolated_string_node_t *node, con
 }
 
 static void
-pm_interpolated_symbol_node_append(pm_interpolated_symbol_node_t *node, pm_node_t *part) {
+pm_interpolated_symbol_node_append(pm_parser_t *parser, pm_interpolated_symbol_node_t *node, pm_node_t *part) {
     if (node->parts.size == 0 && node->opening_loc.start == NULL) {
         node->base.location.start = part->location.start;
     }
 
-    pm_interpolated_node_append((pm_node_t *) node, &node->parts, part);
+    pm_interpolated_node_append(parser, (pm_node_t *) node, &node->parts, part);
     node->base.location.end = MAX(node->base.location.end, part->location.end);
 }
 
@@ -5480,7 +5611,7 @@ pm_interpolated_symbol_node_create(pm_parser_t *parser, const pm_token_t *openin
     if (parts != NULL) {
         pm_node_t *part;
         PM_NODE_LIST_FOREACH(parts, index, part) {
-            pm_interpolated_symbol_node_append(node, part);
+            pm_interpolated_symbol_node_append(parser, node, part);
         }
     }
 
@@ -5511,8 +5642,8 @@ pm_interpolated_xstring_node_create(pm_parser_t *parser, const pm_token_t *openi
 }
 
 static inline void
-pm_interpolated_xstring_node_append(pm_interpolated_x_string_node_t *node, pm_node_t *part) {
-    pm_interpolated_node_append((pm_node_t *) node, &node->parts, part);
+pm_interpolated_xstring_node_append(pm_parser_t *parser, pm_interpolated_x_string_node_t *node, pm_node_t *part) {
+    pm_interpolated_node_append(parser, (pm_node_t *) node, &node->parts, part);
     node->base.location.end = part->location.end;
 }
 
@@ -5582,14 +5713,14 @@ pm_keyword_hash_node_create(pm_parser_t *parser) {
  * Append an element to a KeywordHashNode node.
  */
 static void
-pm_keyword_hash_node_elements_append(pm_keyword_hash_node_t *hash, pm_node_t *element) {
+pm_keyword_hash_node_elements_append(pm_parser_t *parser, pm_keyword_hash_node_t *hash, pm_node_t *element) {
     // If the element being added is not an AssocNode or does not have a symbol
     // key, then we want to turn the SYMBOL_KEYS flag off.
     if (!PM_NODE_TYPE_P(element, PM_ASSOC_NODE) || !PM_NODE_TYPE_P(((pm_assoc_node_t *) element)->key, PM_SYMBOL_NODE)) {
         pm_node_flag_unset((pm_node_t *)hash, PM_KEYWORD_HASH_NODE_FLAGS_SYMBOL_KEYS);
     }
 
-    pm_node_list_append(&hash->elements, element);
+    pm_node_list_arena_append(parser->arena, &hash->elements, element);
     if (hash->base.location.start == NULL) {
         hash->base.location.start = element->location.start;
     }
@@ -6019,19 +6150,19 @@ pm_multi_target_node_targets_append(pm_parser_t *parser, pm_multi_target_node_t
             node->rest = target;
         } else {
             pm_parser_err_node(parser, target, PM_ERR_MULTI_ASSIGN_MULTI_SPLATS);
-            pm_node_list_append(&node->rights, target);
+            pm_node_list_arena_append(parser->arena, &node->rights, target);
         }
     } else if (PM_NODE_TYPE_P(target, PM_IMPLICIT_REST_NODE)) {
         if (node->rest == NULL) {
             node->rest = target;
         } else {
             PM_PARSER_ERR_TOKEN_FORMAT_CONTENT(parser, parser->current, PM_ERR_MULTI_ASSIGN_UNEXPECTED_REST);
-            pm_node_list_append(&node->rights, target);
+            pm_node_list_arena_append(parser->arena, &node->rights, target);
         }
     } else if (node->rest == NULL) {
-        pm_node_list_append(&node->lefts, target);
+        pm_node_list_arena_append(parser->arena, &node->lefts, target);
     } else {
-        pm_node_list_append(&node->rights, target);
+        pm_node_list_arena_append(parser->arena, &node->rights, target);
     }
 
     if (node->base.location.start == NULL || (node->base.location.start > target->location.start)) {
@@ -6087,7 +6218,7 @@ pm_multi_write_node_create(pm_parser_t *parser, pm_multi_target_node_t *target,
 
     // Explicitly do not call pm_node_destroy here because we want to keep
     // around all of the information within the MultiWriteNode node.
-    xfree(target);
+    pm_free_node(parser, target);
 
     return node;
 }
@@ -6334,27 +6465,27 @@ pm_parameters_node_location_set(pm_parameters_node_t *params, pm_node_t *param)
  * Append a required parameter to a ParametersNode node.
  */
 static void
-pm_parameters_node_requireds_append(pm_parameters_node_t *params, pm_node_t *param) {
+pm_parameters_node_requireds_append(pm_parser_t *parser, pm_parameters_node_t *params, pm_node_t *param) {
     pm_parameters_node_location_set(params, param);
-    pm_node_list_append(&params->requireds, param);
+    pm_node_list_arena_append(parser->arena, &params->requireds, param);
 }
 
 /**
  * Append an optional parameter to a ParametersNode node.
  */
 static void
-pm_parameters_node_optionals_append(pm_parameters_node_t *params, pm_optional_parameter_node_t *param) {
+pm_parameters_node_optionals_append(pm_parser_t *parser, pm_parameters_node_t *params, pm_optional_parameter_node_t *param) {
     pm_parameters_node_location_set(params, (pm_node_t *) param);
-    pm_node_list_append(&params->optionals, (pm_node_t *) param);
+    pm_node_list_arena_append(parser->arena, &params->optionals, (pm_node_t *) param);
 }
 
 /**
  * Append a post optional arguments parameter to a ParametersNode node.
  */
 static void
-pm_parameters_node_posts_append(pm_parameters_node_t *params, pm_node_t *param) {
+pm_parameters_node_posts_append(pm_parser_t *parser, pm_parameters_node_t *params, pm_node_t *param) {
     pm_parameters_node_location_set(params, param);
-    pm_node_list_append(&params->posts, param);
+    pm_node_list_arena_append(parser->arena, &params->posts, param);
 }
 
 /**
@@ -6370,9 +6501,9 @@ pm_parameters_node_rest_set(pm_parameters_node_t *params, pm_node_t *param) {
  * Append a keyword parameter to a ParametersNode node.
  */
 static void
-pm_parameters_node_keywords_append(pm_parameters_node_t *params, pm_node_t *param) {
+pm_parameters_node_keywords_append(pm_parser_t *parser, pm_parameters_node_t *params, pm_node_t *param) {
     pm_parameters_node_location_set(params, param);
-    pm_node_list_append(&params->keywords, param);
+    pm_node_list_arena_append(parser->arena, &params->keywords, param);
 }
 
 /**
@@ -6725,8 +6856,8 @@ pm_rescue_node_consequent_set(pm_rescue_node_t *node, pm_rescue_node_t *conseque
  * Append an exception node to a rescue node, and update the location.
  */
 static void
-pm_rescue_node_exceptions_append(pm_rescue_node_t *node, pm_node_t *exception) {
-    pm_node_list_append(&node->exceptions, exception);
+pm_rescue_node_exceptions_append(pm_parser_t *parser, pm_rescue_node_t *node, pm_node_t *exception) {
+    pm_node_list_arena_append(parser->arena, &node->exceptions, exception);
     node->base.location.end = exception->location.end;
 }
 
@@ -7008,7 +7139,7 @@ pm_statements_node_body_append(pm_parser_t *parser, pm_statements_node_t *node,
         }
     }
 
-    pm_node_list_append(&node->body, statement);
+    pm_node_list_arena_append(parser->arena, &node->body, statement);
     pm_node_flag_set(statement, PM_NODE_FLAG_NEWLINE);
 }
 
@@ -7016,9 +7147,9 @@ pm_statements_node_body_append(pm_parser_t *parser, pm_statements_node_t *node,
  * Prepend a new node to the given StatementsNode node's body.
  */
 static void
-pm_statements_node_body_prepend(pm_statements_node_t *node, pm_node_t *statement) {
+pm_statements_node_body_prepend(pm_parser_t *parser, pm_statements_node_t *node, pm_node_t *statement) {
     pm_statements_node_body_update(node, statement);
-    pm_node_list_prepend(&node->body, statement);
+    pm_node_list_arena_prepend(parser->arena, &node->body, statement);
     pm_node_flag_set(statement, PM_NODE_FLAG_NEWLINE);
 }
 
@@ -7469,7 +7600,7 @@ pm_string_node_to_symbol_node(pm_parser_t *parser, pm_string_node_t *node, const
     // We are explicitly _not_ using pm_node_destroy here because we don't want
     // to trash the unescaped string. We could instead copy the string if we
     // know that it is owned, but we're taking the fast path for now.
-    xfree(node);
+    pm_free_node(parser, node);
 
     return new_node;
 }
@@ -7506,7 +7637,7 @@ pm_symbol_node_to_string_node(pm_parser_t *parser, pm_symbol_node_t *node) {
     // We are explicitly _not_ using pm_node_destroy here because we don't want
     // to trash the unescaped string. We could instead copy the string if we
     // know that it is owned, but we're taking the fast path for now.
-    xfree(node);
+    pm_free_node(parser, node);
 
     return new_node;
 }
@@ -7568,9 +7699,9 @@ pm_undef_node_create(pm_parser_t *parser, const pm_token_t *token) {
  * Append a name to an undef node.
  */
 static void
-pm_undef_node_append(pm_undef_node_t *node, pm_node_t *name) {
+pm_undef_node_append(pm_parser_t *parser, pm_undef_node_t *node, pm_node_t *name) {
     node->base.location.end = name->location.end;
-    pm_node_list_append(&node->names, name);
+    pm_node_list_arena_append(parser->arena, &node->names, name);
 }
 
 /**
@@ -7725,9 +7856,9 @@ pm_when_node_create(pm_parser_t *parser, const pm_token_t *keyword) {
  * Append a new condition to a when node.
  */
 static void
-pm_when_node_conditions_append(pm_when_node_t *node, pm_node_t *condition) {
+pm_when_node_conditions_append(pm_parser_t *parser, pm_when_node_t *node, pm_node_t *condition) {
     node->base.location.end = condition->location.end;
-    pm_node_list_append(&node->conditions, condition);
+    pm_node_list_arena_append(parser->arena, &node->conditions, condition);
 }
 
 /**
@@ -8005,9 +8136,28 @@ static void
 pm_parser_scope_pop(pm_parser_t *parser) {
     pm_scope_t *scope = parser->current_scope;
     parser->current_scope = scope->previous;
-    pm_locals_free(&scope->locals);
+    pm_locals_clear(&scope->locals);
     pm_node_list_free(&scope->implicit_parameters);
-    xfree(scope);
+
+    scope->previous = parser->free_scopes;
+    parser->free_scopes = scope;
+}
+
+/**
+ * Free the scopes that have been popped and kept for reuse.
+ */
+static void
+pm_parser_scopes_free(pm_parser_t *parser) {
+    pm_scope_t *scope = parser->free_scopes;
+
+    while (scope != NULL) {
+        pm_scope_t *previous = scope->previous;
+        pm_locals_free(&scope->locals);
+        xfree(scope);
+        scope = previous;
+    }
+
+    parser->free_scopes = NULL;
 }
 
 /******************************************************************************/
@@ -8303,6 +8453,11 @@ parser_lex_magic_comment(pm_parser_t *parser, bool semantic_token_seen) {
     const uint8_t *end = parser->current.end;
     if (end - start <= 7) return false;
 
+    // Every magic comment has a colon between its key and its value, and the
+    // return value only matters for the comment that could set the encoding.
+    // This lets us skip the scan below for most comments, which are prose.
+    if ((parser->current.start != parser->encoding_comment_start) && (memchr(start, ':', (size_t) (end - start)) == NULL)) return false;
+
     const uint8_t *cursor;
     bool indicator = false;
 
@@ -8553,28 +8708,38 @@ context_recoverable(const pm_parser_t *parser, pm_token_t *token) {
     return PM_CONTEXT_NONE;
 }
 
+/**
+ * Push a new context onto the stack, reusing a previously popped context node
+ * if there is one.
+ */
 static bool
 context_push(pm_parser_t *parser, pm_context_t context) {
-    pm_context_node_t *context_node = (pm_context_node_t *) xmalloc(sizeof(pm_context_node_t));
-    if (context_node == NULL) return false;
+    PM_STATS_ADD(parser, context_pushes, 1);
+    pm_context_node_t *context_node = parser->free_contexts;
 
-    *context_node = (pm_context_node_t) { .context = context, .prev = NULL };
-
-    if (parser->current_context == NULL) {
-        parser->current_context = context_node;
+    if (context_node != NULL) {
+        parser->free_contexts = context_node->prev;
     } else {
-        context_node->prev = parser->current_context;
-        parser->current_context = context_node;
+        context_node = (pm_context_node_t *) xmalloc(sizeof(pm_context_node_t));
+        if (context_node == NULL) return false;
     }
 
+    *context_node = (pm_context_node_t) { .context = context, .prev = parser->current_context };
+    parser->current_context = context_node;
+
     return true;
 }
 
+/**
+ * Pop the current context off the stack, keeping its node for reuse.
+ */
 static void
 context_pop(pm_parser_t *parser) {
-    pm_context_node_t *prev = parser->current_context->prev;
-    xfree(parser->current_context);
-    parser->current_context = prev;
+    pm_context_node_t *context_node = parser->current_context;
+    parser->current_context = context_node->prev;
+
+    context_node->prev = parser->free_contexts;
+    parser->free_contexts = context_node;
 }
 
 static bool
@@ -9074,7 +9239,11 @@ lex_identifier(pm_parser_t *parser, bool previous_command_start) {
             current_end += width;
         }
     } else {
-        while (current_end < end && (width = char_is_identifier_utf8(current_end, end)) > 0) {
+        // Most identifiers are entirely ASCII, so each run of ASCII is skipped
+        // in bulk, and only the characters in between are checked one by one.
+        while (current_end < end) {
+            current_end += pm_strspn_identifier(current_end, end - current_end);
+            if (current_end >= end || (width = char_is_identifier_utf8(current_end, end)) == 0) break;
             current_end += width;
         }
     }
@@ -9948,7 +10117,7 @@ lex_question_mark(pm_parser_t *parser) {
         pm_buffer_init_capacity(&buffer, 3);
 
         escape_read(parser, &buffer, NULL, PM_ESCAPE_FLAG_SINGLE);
-        pm_string_owned_init(&parser->current_string, (uint8_t *) buffer.value, buffer.length);
+        pm_parser_current_string_owned_init(parser, (uint8_t *) buffer.value, buffer.length);
 
         return PM_TOKEN_CHARACTER_LITERAL;
     } else {
@@ -10259,13 +10428,13 @@ pm_regexp_token_buffer_push_escaped(pm_regexp_token_buffer_t *token_buffer, pm_p
     parser->current.end += width;
 }
 
-static bool
+/**
+ * Returns true if every byte in the given slice is ASCII. This runs over every
+ * regular expression body, so it uses the vectorized ASCII span.
+ */
+static inline bool
 pm_slice_ascii_only_p(const uint8_t *value, size_t length) {
-    for (size_t index = 0; index < length; index++) {
-        if (value[index] & 0x80) return false;
-    }
-
-    return true;
+    return pm_strspn_ascii(value, (ptrdiff_t) length) == length;
 }
 
 /**
@@ -10276,12 +10445,12 @@ pm_slice_ascii_only_p(const uint8_t *value, size_t length) {
  */
 static inline void
 pm_token_buffer_copy(pm_parser_t *parser, pm_token_buffer_t *token_buffer) {
-    pm_string_owned_init(&parser->current_string, (uint8_t *) pm_buffer_value(&token_buffer->buffer), pm_buffer_length(&token_buffer->buffer));
+    pm_parser_current_string_owned_init(parser, (uint8_t *) pm_buffer_value(&token_buffer->buffer), pm_buffer_length(&token_buffer->buffer));
 }
 
 static inline void
 pm_regexp_token_buffer_copy(pm_parser_t *parser, pm_regexp_token_buffer_t *token_buffer) {
-    pm_string_owned_init(&parser->current_string, (uint8_t *) pm_buffer_value(&token_buffer->base.buffer), pm_buffer_length(&token_buffer->base.buffer));
+    pm_parser_current_string_owned_init(parser, (uint8_t *) pm_buffer_value(&token_buffer->base.buffer), pm_buffer_length(&token_buffer->base.buffer));
     parser->current_regular_expression_ascii_only = pm_slice_ascii_only_p((const uint8_t *) pm_buffer_value(&token_buffer->regexp_buffer), pm_buffer_length(&token_buffer->regexp_buffer));
     pm_buffer_free(&token_buffer->regexp_buffer);
 }
@@ -10429,21 +10598,28 @@ pm_lex_percent_delimiter(pm_parser_t *parser) {
 
 /**
  * This is a convenience macro that will set the current token type, call the
- * lex callback, and then return from the parser_lex function.
+ * lex callback, and then return from the parser_lex_token function.
  */
 #define LEX(token_type) parser->current.type = token_type; parser_lex_callback(parser); return
 
 /**
- * Called when the parser requires a new token. The parser maintains a moving
- * window of two tokens at a time: parser.previous and parser.current. This
- * function will move the current token into the previous token and then
- * lex a new token into the current token.
+ * Move the current token into the previous token and then lex a new token into
+ * the current token. This is called through parser_lex.
  */
 static void
-parser_lex(pm_parser_t *parser) {
+parser_lex_token(pm_parser_t *parser) {
     assert(parser->current.end <= parser->end);
     parser->previous = parser->current;
 
+    // If the caller only wants to know if the source is valid, then once an
+    // error has been found we skip straight to the end of the source. The
+    // parser then unwinds as if the source had been truncated here.
+    if (parser->stop_at_first_error && parser->error_list.size > 0) {
+        parser->current.end = parser->end;
+        parser->next_start = NULL;
+        parser->heredoc_end = NULL;
+    }
+
     // This value mirrors cmd_state from CRuby.
     bool previous_command_start = parser->command_start;
     parser->command_start = false;
@@ -10487,7 +10663,7 @@ parser_lex(pm_parser_t *parser) {
                     case '\t':
                     case '\f':
                     case '\v':
-                        parser->current.end++;
+                        parser->current.end += pm_strspn_blank(parser->current.end, parser->end - parser->current.end);
                         space_seen = true;
                         break;
                     case '\r':
@@ -12666,6 +12842,24 @@ parser_lex(pm_parser_t *parser) {
 
 #undef LEX
 
+/**
+ * Called when the parser requires a new token. The parser maintains a moving
+ * window of two tokens at a time: parser.previous and parser.current. This
+ * function will move the current token into the previous token and then
+ * lex a new token into the current token.
+ */
+static inline void
+parser_lex(pm_parser_t *parser) {
+#ifdef PRISM_BUILD_STATS
+    uint64_t start = pm_stats_time();
+    parser_lex_token(parser);
+    parser->stats.lex_time += pm_stats_time() - start;
+    parser->stats.tokens++;
+#else
+    parser_lex_token(parser);
+#endif
+}
+
 /******************************************************************************/
 /* Parse functions                                                            */
 /******************************************************************************/
@@ -13511,7 +13705,7 @@ parse_write(pm_parser_t *parser, pm_node_t *target, pm_token_t *operator, pm_nod
                     pm_arguments_node_t *arguments = pm_arguments_node_create(parser);
                     call->arguments = arguments;
 
-                    pm_arguments_node_arguments_append(arguments, value);
+                    pm_arguments_node_arguments_append(parser, arguments, value);
                     call->base.location.end = arguments->base.location.end;
 
                     parse_write_name(parser, &call->name);
@@ -13528,7 +13722,7 @@ parse_write(pm_parser_t *parser, pm_node_t *target, pm_token_t *operator, pm_nod
                     call->arguments = pm_arguments_node_create(parser);
                 }
 
-                pm_arguments_node_arguments_append(call->arguments, value);
+                pm_arguments_node_arguments_append(parser, call->arguments, value);
                 target->location.end = value->location.end;
 
                 // Replace the name with "[]=".
@@ -13874,9 +14068,9 @@ parse_assocs(pm_parser_t *parser, pm_static_literals_t *literals, pm_node_t *nod
         }
 
         if (PM_NODE_TYPE_P(node, PM_HASH_NODE)) {
-            pm_hash_node_elements_append((pm_hash_node_t *) node, element);
+            pm_hash_node_elements_append(parser, (pm_hash_node_t *) node, element);
         } else {
-            pm_keyword_hash_node_elements_append((pm_keyword_hash_node_t *) node, element);
+            pm_keyword_hash_node_elements_append(parser, (pm_keyword_hash_node_t *) node, element);
         }
 
         // If there's no comma after the element, then we're done.
@@ -13906,7 +14100,7 @@ parse_arguments_append(pm_parser_t *parser, pm_arguments_t *arguments, pm_node_t
         arguments->arguments = pm_arguments_node_create(parser);
     }
 
-    pm_arguments_node_arguments_append(arguments->arguments, argument);
+    pm_arguments_node_arguments_append(parser, arguments->arguments, argument);
 }
 
 /**
@@ -14062,7 +14256,7 @@ parse_arguments(pm_parser_t *parser, pm_arguments_t *arguments, bool accepts_for
                     pm_node_t *value = parse_value_expression(parser, PM_BINDING_POWER_DEFINED, false, PM_ERR_HASH_VALUE);
                     argument = (pm_node_t *) pm_assoc_node_create(parser, argument, &operator, value);
 
-                    pm_keyword_hash_node_elements_append(bare_hash, argument);
+                    pm_keyword_hash_node_elements_append(parser, bare_hash, argument);
                     argument = (pm_node_t *) bare_hash;
 
                     // Then parse more if we have a comma
@@ -14280,9 +14474,9 @@ parse_parameters(
                 pm_node_t *param = (pm_node_t *) parse_required_destructured_parameter(parser);
 
                 if (order > PM_PARAMETERS_ORDER_AFTER_OPTIONAL) {
-                    pm_parameters_node_requireds_append(params, param);
+                    pm_parameters_node_requireds_append(parser, params, param);
                 } else {
-                    pm_parameters_node_posts_append(params, param);
+                    pm_parameters_node_posts_append(parser, params, param);
                 }
                 break;
             }
@@ -14312,7 +14506,7 @@ parse_parameters(
                     pm_parameters_node_block_set(params, param);
                 } else {
                     pm_parser_err_node(parser, (pm_node_t *) param, PM_ERR_PARAMETER_BLOCK_MULTI);
-                    pm_parameters_node_posts_append(params, (pm_node_t *) param);
+                    pm_parameters_node_posts_append(parser, params, (pm_node_t *) param);
                 }
 
                 break;
@@ -14332,7 +14526,7 @@ parse_parameters(
                     // If we already have a keyword rest parameter, then we replace it with the
                     // forwarding parameter and move the keyword rest parameter to the posts list.
                     pm_node_t *keyword_rest = params->keyword_rest;
-                    pm_parameters_node_posts_append(params, keyword_rest);
+                    pm_parameters_node_posts_append(parser, params, keyword_rest);
                     if (succeeded) pm_parser_err_previous(parser, PM_ERR_PARAMETER_UNEXPECTED_FWD);
                     params->keyword_rest = NULL;
                 }
@@ -14389,7 +14583,7 @@ parse_parameters(
                     if (repeated) {
                         pm_node_flag_set_repeated_parameter((pm_node_t *)param);
                     }
-                    pm_parameters_node_optionals_append(params, param);
+                    pm_parameters_node_optionals_append(parser, params, param);
 
                     // If the value of the parameter increased the number of
                     // reads of that parameter, then we need to warn that we
@@ -14412,13 +14606,13 @@ parse_parameters(
                     if (repeated) {
                         pm_node_flag_set_repeated_parameter((pm_node_t *)param);
                     }
-                    pm_parameters_node_requireds_append(params, (pm_node_t *) param);
+                    pm_parameters_node_requireds_append(parser, params, (pm_node_t *) param);
                 } else {
                     pm_required_parameter_node_t *param = pm_required_parameter_node_create(parser, &name);
                     if (repeated) {
                         pm_node_flag_set_repeated_parameter((pm_node_t *)param);
                     }
-                    pm_parameters_node_posts_append(params, (pm_node_t *) param);
+                    pm_parameters_node_posts_append(parser, params, (pm_node_t *) param);
                 }
 
                 break;
@@ -14449,7 +14643,7 @@ parse_parameters(
                         if (repeated) {
                             pm_node_flag_set_repeated_parameter(param);
                         }
-                        pm_parameters_node_keywords_append(params, param);
+                        pm_parameters_node_keywords_append(parser, params, param);
                         break;
                     }
                     case PM_TOKEN_SEMICOLON:
@@ -14463,7 +14657,7 @@ parse_parameters(
                         if (repeated) {
                             pm_node_flag_set_repeated_parameter(param);
                         }
-                        pm_parameters_node_keywords_append(params, param);
+                        pm_parameters_node_keywords_append(parser, params, param);
                         break;
                     }
                     default: {
@@ -14490,7 +14684,7 @@ parse_parameters(
                         if (repeated) {
                             pm_node_flag_set_repeated_parameter(param);
                         }
-                        pm_parameters_node_keywords_append(params, param);
+                        pm_parameters_node_keywords_append(parser, params, param);
 
                         // If parsing the value of the parameter resulted in error recovery,
                         // then we can put a missing node in its place and stop parsing the
@@ -14532,7 +14726,7 @@ parse_parameters(
                     pm_parameters_node_rest_set(params, param);
                 } else {
                     pm_parser_err_node(parser, param, PM_ERR_PARAMETER_SPLAT_MULTI);
-                    pm_parameters_node_posts_append(params, param);
+                    pm_parameters_node_posts_append(parser, params, param);
                 }
 
                 break;
@@ -14575,7 +14769,7 @@ parse_parameters(
                     pm_parameters_node_keyword_rest_set(params, param);
                 } else {
                     pm_parser_err_node(parser, param, PM_ERR_PARAMETER_ASSOC_SPLAT_MULTI);
-                    pm_parameters_node_posts_append(params, param);
+                    pm_parameters_node_posts_append(parser, params, param);
                 }
 
                 break;
@@ -14591,7 +14785,7 @@ parse_parameters(
                             pm_parameters_node_rest_set(params, param);
                         } else {
                             pm_parser_err_node(parser, (pm_node_t *) param, PM_ERR_PARAMETER_SPLAT_MULTI);
-                            pm_parameters_node_posts_append(params, (pm_node_t *) param);
+                            pm_parameters_node_posts_append(parser, params, (pm_node_t *) param);
                         }
                     } else {
                         pm_parser_err_previous(parser, PM_ERR_PARAMETER_WILD_LOOSE_COMMA);
@@ -14666,7 +14860,7 @@ parse_rescues(pm_parser_t *parser, pm_begin_node_t *parent_node, pm_rescues_type
 
                     do {
                         pm_node_t *expression = parse_starred_expression(parser, PM_BINDING_POWER_DEFINED, false, PM_ERR_RESCUE_EXPRESSION);
-                        pm_rescue_node_exceptions_append(rescue, expression);
+                        pm_rescue_node_exceptions_append(parser, rescue, expression);
 
                         // If we hit a newline, then this is the end of the rescue expression. We
                         // can continue on to parse the statements.
@@ -14875,7 +15069,7 @@ parse_block_parameters(
                 pm_block_local_variable_node_t *local = pm_block_local_variable_node_create(parser, &parser->previous);
                 if (repeated) pm_node_flag_set_repeated_parameter((pm_node_t *) local);
 
-                pm_block_parameters_node_append_local(block_parameters, local);
+                pm_block_parameters_node_append_local(parser, block_parameters, local);
             } while (accept1(parser, PM_TOKEN_COMMA));
         }
     }
@@ -15124,7 +15318,7 @@ parse_arguments_list(pm_parser_t *parser, pm_arguments_t *arguments, bool accept
                     if (arguments->arguments == NULL) {
                         arguments->arguments = pm_arguments_node_create(parser);
                     }
-                    pm_arguments_node_arguments_append(arguments->arguments, arguments->block);
+                    pm_arguments_node_arguments_append(parser, arguments->arguments, arguments->block);
                 }
                 arguments->block = (pm_node_t *) block;
             }
@@ -15755,11 +15949,11 @@ parse_symbol(pm_parser_t *parser, pm_lex_mode_t *lex_mode, pm_lex_state_t next_s
         }
 
         pm_interpolated_symbol_node_t *symbol = pm_interpolated_symbol_node_create(parser, &opening, NULL, &opening);
-        if (part) pm_interpolated_symbol_node_append(symbol, part);
+        if (part) pm_interpolated_symbol_node_append(parser, symbol, part);
 
         while (!match2(parser, PM_TOKEN_STRING_END, PM_TOKEN_EOF)) {
             if ((part = parse_string_part(parser)) != NULL) {
-                pm_interpolated_symbol_node_append(symbol, part);
+                pm_interpolated_symbol_node_append(parser, symbol, part);
             }
         }
 
@@ -15796,10 +15990,10 @@ parse_symbol(pm_parser_t *parser, pm_lex_mode_t *lex_mode, pm_lex_state_t next_s
             pm_token_t bounds = not_provided(parser);
 
             pm_node_t *part = (pm_node_t *) pm_string_node_create_unescaped(parser, &bounds, &content, &bounds, &unescaped);
-            pm_interpolated_symbol_node_append(symbol, part);
+            pm_interpolated_symbol_node_append(parser, symbol, part);
 
             part = (pm_node_t *) pm_string_node_create_unescaped(parser, &bounds, &parser->current, &bounds, &parser->current_string);
-            pm_interpolated_symbol_node_append(symbol, part);
+            pm_interpolated_symbol_node_append(parser, symbol, part);
 
             if (next_state != PM_LEX_STATE_NONE) {
                 lex_state_set(parser, next_state);
@@ -16008,10 +16202,10 @@ parse_method_definition_name(pm_parser_t *parser) {
 }
 
 static void
-parse_heredoc_dedent_string(pm_string_t *string, size_t common_whitespace) {
+parse_heredoc_dedent_string(pm_parser_t *parser, pm_string_t *string, size_t common_whitespace) {
     // Get a reference to the string struct that is being held by the string
     // node. This is the value we're going to actually manipulate.
-    pm_string_ensure_owned(string);
+    pm_parser_string_ensure_owned(parser, string);
 
     // Now get the bounds of the existing string. We'll use this as a
     // destination to move bytes into. We'll also use it for bounds checking
@@ -16072,7 +16266,7 @@ parse_heredoc_dedent(pm_parser_t *parser, pm_node_list_t *nodes, size_t common_w
 
         pm_string_node_t *string_node = ((pm_string_node_t *) node);
         if (dedent_next) {
-            parse_heredoc_dedent_string(&string_node->unescaped, common_whitespace);
+            parse_heredoc_dedent_string(parser, &string_node->unescaped, common_whitespace);
         }
 
         if (string_node->unescaped.length == 0) {
@@ -16228,7 +16422,7 @@ parse_pattern_constant_path(pm_parser_t *parser, pm_constant_id_list_t *captures
     // attaching its constant. In this case we'll create an array pattern and
     // attach our constant to it.
     pm_array_pattern_node_t *pattern_node = pm_array_pattern_node_constant_create(parser, node, &opening, &closing);
-    pm_array_pattern_node_requireds_append(pattern_node, inner);
+    pm_array_pattern_node_requireds_append(parser, pattern_node, inner);
     return (pm_node_t *) pattern_node;
 }
 
@@ -16551,7 +16745,7 @@ parse_pattern_primitive(pm_parser_t *parser, pm_constant_id_list_t *captures, pm
             }
 
             pm_array_pattern_node_t *node = pm_array_pattern_node_empty_create(parser, &opening, &closing);
-            pm_array_pattern_node_requireds_append(node, inner);
+            pm_array_pattern_node_requireds_append(parser, node, inner);
             return (pm_node_t *) node;
         }
         case PM_TOKEN_BRACE_LEFT: {
@@ -17183,11 +17377,11 @@ parse_strings(pm_parser_t *parser, pm_node_t *current) {
                 pm_token_t bounds = not_provided(parser);
 
                 pm_interpolated_string_node_t *container = pm_interpolated_string_node_create(parser, &bounds, NULL, &bounds);
-                pm_interpolated_string_node_append(container, current);
+                pm_interpolated_string_node_append(parser, container, current);
                 current = (pm_node_t *) container;
             }
 
-            pm_interpolated_string_node_append((pm_interpolated_string_node_t *) current, node);
+            pm_interpolated_string_node_append(parser, (pm_interpolated_string_node_t *) current, node);
         }
     }
 
@@ -17471,7 +17665,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
 
                         pm_node_t *value = parse_value_expression(parser, PM_BINDING_POWER_DEFINED, false, PM_ERR_HASH_VALUE);
                         pm_node_t *assoc = (pm_node_t *) pm_assoc_node_create(parser, element, &operator, value);
-                        pm_keyword_hash_node_elements_append(hash, assoc);
+                        pm_keyword_hash_node_elements_append(parser, hash, assoc);
 
                         element = (pm_node_t *) hash;
                         if (accept1(parser, PM_TOKEN_COMMA) && !match1(parser, PM_TOKEN_BRACKET_RIGHT)) {
@@ -17483,7 +17677,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                     }
                 }
 
-                pm_array_node_elements_append(array, element);
+                pm_array_node_elements_append(parser, array, element);
                 if (PM_NODE_TYPE_P(element, PM_MISSING_NODE)) break;
             }
 
@@ -17930,7 +18124,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
 
                 size_t common_whitespace = lex_mode->as.heredoc.common_whitespace;
                 if (indent == PM_HEREDOC_INDENT_TILDE && (common_whitespace != (size_t) -1) && (common_whitespace != 0)) {
-                    parse_heredoc_dedent_string(&cast->unescaped, common_whitespace);
+                    parse_heredoc_dedent_string(parser, &cast->unescaped, common_whitespace);
                 }
 
                 node = (pm_node_t *) cast;
@@ -17954,7 +18148,14 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                 // interpolated node.
                 if (quote == PM_HEREDOC_QUOTE_BACKTICK) {
                     pm_interpolated_x_string_node_t *cast = pm_interpolated_xstring_node_create(parser, &opening, &opening);
-                    cast->parts = parts;
+                    if (parser->arena == NULL) {
+                        cast->parts = parts;
+                    } else {
+                        // The parts were accumulated on the heap, so they need
+                        // to be copied into the arena that owns the node.
+                        pm_node_list_arena_concat(parser->arena, &cast->parts, &parts);
+                        pm_node_list_free(&parts);
+                    }
 
                     expect1_heredoc_term(parser, lex_mode);
                     pm_interpolated_xstring_node_closing_set(cast, &parser->previous);
@@ -18117,12 +18318,12 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                             pm_node_t *expression = parse_value_expression(parser, PM_BINDING_POWER_DEFINED, false, PM_ERR_EXPECT_EXPRESSION_AFTER_STAR);
 
                             pm_splat_node_t *splat_node = pm_splat_node_create(parser, &operator, expression);
-                            pm_when_node_conditions_append(when_node, (pm_node_t *) splat_node);
+                            pm_when_node_conditions_append(parser, when_node, (pm_node_t *) splat_node);
 
                             if (PM_NODE_TYPE_P(expression, PM_MISSING_NODE)) break;
                         } else {
                             pm_node_t *condition = parse_value_expression(parser, PM_BINDING_POWER_DEFINED, false, PM_ERR_CASE_EXPRESSION_AFTER_WHEN);
-                            pm_when_node_conditions_append(when_node, condition);
+                            pm_when_node_conditions_append(parser, when_node, condition);
 
                             // If we found a missing node, then this is a syntax
                             // error and we should stop looping.
@@ -18154,7 +18355,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                         }
                     }
 
-                    pm_case_node_condition_append(case_node, (pm_node_t *) when_node);
+                    pm_case_node_condition_append(parser, case_node, (pm_node_t *) when_node);
                 }
 
                 // If we didn't parse any conditions (in or when) then we need
@@ -18233,7 +18434,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                     // Now that we have the full pattern and statements, we can
                     // create the node and attach it to the case node.
                     pm_node_t *condition = (pm_node_t *) pm_in_node_create(parser, pattern, statements, &in_keyword, &then_keyword);
-                    pm_case_match_node_condition_append(case_node, condition);
+                    pm_case_match_node_condition_append(parser, case_node, condition);
                 }
 
                 // If we didn't parse any conditions (in or when) then we need
@@ -18921,7 +19122,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
             if (PM_NODE_TYPE_P(name, PM_MISSING_NODE)) {
                 pm_node_destroy(parser, name);
             } else {
-                pm_undef_node_append(undef, name);
+                pm_undef_node_append(parser, undef, name);
 
                 while (match1(parser, PM_TOKEN_COMMA)) {
                     lex_state_set(parser, PM_LEX_STATE_FNAME | PM_LEX_STATE_FITEM);
@@ -18933,7 +19134,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                         break;
                     }
 
-                    pm_undef_node_append(undef, name);
+                    pm_undef_node_append(parser, undef, name);
                 }
             }
 
@@ -19115,7 +19316,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                 if (match1(parser, PM_TOKEN_STRING_CONTENT)) {
                     pm_token_t opening = not_provided(parser);
                     pm_token_t closing = not_provided(parser);
-                    pm_array_node_elements_append(array, (pm_node_t *) pm_symbol_node_create_current_string(parser, &opening, &parser->current, &closing));
+                    pm_array_node_elements_append(parser, array, (pm_node_t *) pm_symbol_node_create_current_string(parser, &opening, &parser->current, &closing));
                 }
 
                 expect1(parser, PM_TOKEN_STRING_CONTENT, PM_ERR_LIST_I_LOWER_ELEMENT);
@@ -19150,7 +19351,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                         } else {
                             // If we hit a separator after we've hit content, then we need to
                             // append that content to the list and reset the current node.
-                            pm_array_node_elements_append(array, current);
+                            pm_array_node_elements_append(parser, array, current);
                             current = NULL;
                         }
 
@@ -19174,7 +19375,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                             pm_node_t *string = (pm_node_t *) pm_string_node_create_current_string(parser, &opening, &parser->current, &closing);
                             parser_lex(parser);
 
-                            pm_interpolated_symbol_node_append((pm_interpolated_symbol_node_t *) current, string);
+                            pm_interpolated_symbol_node_append(parser, (pm_interpolated_symbol_node_t *) current, string);
                         } else if (PM_NODE_TYPE_P(current, PM_SYMBOL_NODE)) {
                             // If we hit string content and the current node is a symbol node,
                             // then we need to convert the current node into an interpolated
@@ -19188,10 +19389,10 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                             parser_lex(parser);
 
                             pm_interpolated_symbol_node_t *interpolated = pm_interpolated_symbol_node_create(parser, &opening, NULL, &closing);
-                            pm_interpolated_symbol_node_append(interpolated, first_string);
-                            pm_interpolated_symbol_node_append(interpolated, second_string);
+                            pm_interpolated_symbol_node_append(parser, interpolated, first_string);
+                            pm_interpolated_symbol_node_append(parser, interpolated, second_string);
 
-                            xfree(current);
+                            pm_free_node(parser, current);
                             current = (pm_node_t *) interpolated;
                         } else {
                             assert(false && "unreachable");
@@ -19217,7 +19418,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                             pm_interpolated_symbol_node_t *interpolated = pm_interpolated_symbol_node_create(parser, &opening, NULL, &closing);
 
                             current = (pm_node_t *) pm_symbol_node_to_string_node(parser, (pm_symbol_node_t *) current);
-                            pm_interpolated_symbol_node_append(interpolated, current);
+                            pm_interpolated_symbol_node_append(parser, interpolated, current);
                             interpolated->base.location.start = current->location.start;
                             start_location_set = true;
                             current = (pm_node_t *) interpolated;
@@ -19227,7 +19428,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                         }
 
                         pm_node_t *part = parse_string_part(parser);
-                        pm_interpolated_symbol_node_append((pm_interpolated_symbol_node_t *) current, part);
+                        pm_interpolated_symbol_node_append(parser, (pm_interpolated_symbol_node_t *) current, part);
                         if (!start_location_set) {
                             current->location.start = part->location.start;
                         }
@@ -19252,7 +19453,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                             pm_interpolated_symbol_node_t *interpolated = pm_interpolated_symbol_node_create(parser, &opening, NULL, &closing);
 
                             current = (pm_node_t *) pm_symbol_node_to_string_node(parser, (pm_symbol_node_t *) current);
-                            pm_interpolated_symbol_node_append(interpolated, current);
+                            pm_interpolated_symbol_node_append(parser, interpolated, current);
                             interpolated->base.location.start = current->location.start;
                             start_location_set = true;
                             current = (pm_node_t *) interpolated;
@@ -19264,7 +19465,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                         }
 
                         pm_node_t *part = parse_string_part(parser);
-                        pm_interpolated_symbol_node_append((pm_interpolated_symbol_node_t *) current, part);
+                        pm_interpolated_symbol_node_append(parser, (pm_interpolated_symbol_node_t *) current, part);
                         if (!start_location_set) {
                             current->location.start = part->location.start;
                         }
@@ -19279,7 +19480,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
 
             // If we have a current node, then we need to append it to the list.
             if (current) {
-                pm_array_node_elements_append(array, current);
+                pm_array_node_elements_append(parser, array, current);
             }
 
             pm_token_t closing = parser->current;
@@ -19310,7 +19511,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                     pm_token_t closing = not_provided(parser);
 
                     pm_node_t *string = (pm_node_t *) pm_string_node_create_current_string(parser, &opening, &parser->current, &closing);
-                    pm_array_node_elements_append(array, string);
+                    pm_array_node_elements_append(parser, array, string);
                 }
 
                 expect1(parser, PM_TOKEN_STRING_CONTENT, PM_ERR_LIST_W_LOWER_ELEMENT);
@@ -19350,7 +19551,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                             // If we hit a separator after we've hit content,
                             // then we need to append that content to the list
                             // and reset the current node.
-                            pm_array_node_elements_append(array, current);
+                            pm_array_node_elements_append(parser, array, current);
                             current = NULL;
                         }
 
@@ -19375,15 +19576,15 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                             // If we hit string content and the current node is
                             // an interpolated string, then we need to append
                             // the string content to the list of child nodes.
-                            pm_interpolated_string_node_append((pm_interpolated_string_node_t *) current, string);
+                            pm_interpolated_string_node_append(parser, (pm_interpolated_string_node_t *) current, string);
                         } else if (PM_NODE_TYPE_P(current, PM_STRING_NODE)) {
                             // If we hit string content and the current node is
                             // a string node, then we need to convert the
                             // current node into an interpolated string and add
                             // the string content to the list of child nodes.
                             pm_interpolated_string_node_t *interpolated = pm_interpolated_string_node_create(parser, &opening, NULL, &closing);
-                            pm_interpolated_string_node_append(interpolated, current);
-                            pm_interpolated_string_node_append(interpolated, string);
+                            pm_interpolated_string_node_append(parser, interpolated, current);
+                            pm_interpolated_string_node_append(parser, interpolated, string);
                             current = (pm_node_t *) interpolated;
                         } else {
                             assert(false && "unreachable");
@@ -19408,7 +19609,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                             pm_token_t opening = not_provided(parser);
                             pm_token_t closing = not_provided(parser);
                             pm_interpolated_string_node_t *interpolated = pm_interpolated_string_node_create(parser, &opening, NULL, &closing);
-                            pm_interpolated_string_node_append(interpolated, current);
+                            pm_interpolated_string_node_append(parser, interpolated, current);
                             current = (pm_node_t *) interpolated;
                         } else {
                             // If we hit an embedded variable and the current
@@ -19417,7 +19618,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                         }
 
                         pm_node_t *part = parse_string_part(parser);
-                        pm_interpolated_string_node_append((pm_interpolated_string_node_t *) current, part);
+                        pm_interpolated_string_node_append(parser, (pm_interpolated_string_node_t *) current, part);
                         break;
                     }
                     case PM_TOKEN_EMBEXPR_BEGIN: {
@@ -19437,7 +19638,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                             pm_token_t opening = not_provided(parser);
                             pm_token_t closing = not_provided(parser);
                             pm_interpolated_string_node_t *interpolated = pm_interpolated_string_node_create(parser, &opening, NULL, &closing);
-                            pm_interpolated_string_node_append(interpolated, current);
+                            pm_interpolated_string_node_append(parser, interpolated, current);
                             current = (pm_node_t *) interpolated;
                         } else if (PM_NODE_TYPE_P(current, PM_INTERPOLATED_STRING_NODE)) {
                             // If we hit an embedded expression and the current
@@ -19448,7 +19649,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                         }
 
                         pm_node_t *part = parse_string_part(parser);
-                        pm_interpolated_string_node_append((pm_interpolated_string_node_t *) current, part);
+                        pm_interpolated_string_node_append(parser, (pm_interpolated_string_node_t *) current, part);
                         break;
                     }
                     default:
@@ -19460,7 +19661,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
 
             // If we have a current node, then we need to append it to the list.
             if (current) {
-                pm_array_node_elements_append(array, current);
+                pm_array_node_elements_append(parser, array, current);
             }
 
             pm_token_t closing = parser->current;
@@ -19532,7 +19733,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                     pm_node_flag_set(part, PM_STRING_FLAGS_FORCED_BINARY_ENCODING);
                 }
 
-                pm_interpolated_regular_expression_node_append(interpolated, part);
+                pm_interpolated_regular_expression_node_append(parser, interpolated, part);
             } else {
                 // If the first part of the body of the regular expression is not a
                 // string content, then we have interpolation and we need to create an
@@ -19545,7 +19746,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
             pm_node_t *part;
             while (!match2(parser, PM_TOKEN_REGEXP_END, PM_TOKEN_EOF)) {
                 if ((part = parse_string_part(parser)) != NULL) {
-                    pm_interpolated_regular_expression_node_append(interpolated, part);
+                    pm_interpolated_regular_expression_node_append(parser, interpolated, part);
                 }
             }
 
@@ -19611,7 +19812,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
                 pm_node_t *part = (pm_node_t *) pm_string_node_create_unescaped(parser, &opening, &parser->previous, &closing, &unescaped);
                 pm_node_flag_set(part, parse_unescaped_encoding(parser));
 
-                pm_interpolated_xstring_node_append(node, part);
+                pm_interpolated_xstring_node_append(parser, node, part);
             } else {
                 // If the first part of the body of the string is not a string
                 // content, then we have interpolation and we need to create an
@@ -19622,7 +19823,7 @@ parse_expression_prefix(pm_parser_t *parser, pm_binding_power_t binding_power, b
             pm_node_t *part;
             while (!match2(parser, PM_TOKEN_STRING_END, PM_TOKEN_EOF)) {
                 if ((part = parse_string_part(parser)) != NULL) {
-                    pm_interpolated_xstring_node_append(node, part);
+                    pm_interpolated_xstring_node_append(parser, node, part);
                 }
             }
 
@@ -19936,13 +20137,13 @@ parse_assignment_values(pm_parser_t *parser, pm_binding_power_t previous_binding
         pm_token_t opening = not_provided(parser);
         pm_array_node_t *array = pm_array_node_create(parser, &opening);
 
-        pm_array_node_elements_append(array, value);
+        pm_array_node_elements_append(parser, array, value);
         value = (pm_node_t *) array;
 
         while (accept1(parser, PM_TOKEN_COMMA)) {
             pm_node_t *element = parse_starred_expression(parser, binding_power, false, PM_ERR_ARRAY_ELEMENT);
 
-            pm_array_node_elements_append(array, element);
+            pm_array_node_elements_append(parser, array, element);
             if (PM_NODE_TYPE_P(element, PM_MISSING_NODE)) break;
 
             parse_assignment_value_local(parser, element);
@@ -19999,12 +20200,39 @@ parse_call_operator_write(pm_parser_t *parser, pm_call_node_t *call_node, const
     }
 }
 
+/**
+ * Returns true if the given regular expression source could contain a named
+ * capture group. Every named group starts with "(?<" or "(?'", so a body
+ * without a "?" (the common case) can skip running the regular expression
+ * parser entirely. This may return true for sources that do not have any named
+ * groups (e.g., lookbehinds), in which case the regular expression parser makes
+ * the final determination.
+ */
+static bool
+pm_regexp_named_capture_candidate_p(const uint8_t *source, size_t length) {
+    if (length == 0) return false;
+
+    const uint8_t *end = source + length;
+    const uint8_t *cursor = source;
+
+    while (cursor < end && (cursor = memchr(cursor, '?', (size_t) (end - cursor))) != NULL) {
+        if (cursor > source && cursor[-1] == '(' && cursor + 1 < end && (cursor[1] == '<' || cursor[1] == '\'')) return true;
+        cursor++;
+    }
+
+    return false;
+}
+
 /**
  * Potentially change a =~ with a regular expression with named captures into a
  * match write node.
  */
 static pm_node_t *
 parse_regular_expression_named_captures(pm_parser_t *parser, const pm_string_t *content, pm_call_node_t *call) {
+    if (!pm_regexp_named_capture_candidate_p(pm_string_source(content), pm_string_length(content))) {
+        return (pm_node_t *) call;
+    }
+
     pm_string_list_t named_captures = { 0 };
     pm_node_t *result;
 
@@ -20066,7 +20294,7 @@ parse_regular_expression_named_captures(pm_parser_t *parser, const pm_string_t *
                 // Next, create the local variable target and add it to the
                 // list of targets for the match.
                 pm_node_t *target = (pm_node_t *) pm_local_variable_target_node_create(parser, &location, name, depth == -1 ? 0 : (uint32_t) depth);
-                pm_node_list_append(&match->targets, target);
+                pm_node_list_arena_append(parser->arena, &match->targets, target);
             }
         }
 
@@ -20527,19 +20755,26 @@ parse_expression_infix(pm_parser_t *parser, pm_node_t *node, pm_binding_power_t
                 pm_node_list_t *parts = &((pm_interpolated_regular_expression_node_t *) node)->parts;
 
                 bool interpolated = false;
+                bool question = false;
                 size_t total_length = 0;
 
                 pm_node_t *part;
                 PM_NODE_LIST_FOREACH(parts, index, part) {
                     if (PM_NODE_TYPE_P(part, PM_STRING_NODE)) {
-                        total_length += pm_string_length(&((pm_string_node_t *) part)->unescaped);
+                        const pm_string_t *unescaped = &((pm_string_node_t *) part)->unescaped;
+                        size_t length = pm_string_length(unescaped);
+
+                        total_length += length;
+                        question |= length > 0 && memchr(pm_string_source(unescaped), '?', length) != NULL;
                     } else {
                         interpolated = true;
                         break;
                     }
                 }
 
-                if (!interpolated && total_length > 0) {
+                // A named capture group always contains a "?", so we can skip
+                // concatenating the parts if none of them has one.
+                if (!interpolated && question) {
                     void *memory = xmalloc(total_length);
                     if (!memory) abort();
 
@@ -20847,7 +21082,7 @@ parse_expression_infix(pm_parser_t *parser, pm_node_t *node, pm_binding_power_t
                     if (arguments.arguments == NULL) {
                         arguments.arguments = pm_arguments_node_create(parser);
                     }
-                    pm_arguments_node_arguments_append(arguments.arguments, arguments.block);
+                    pm_arguments_node_arguments_append(parser, arguments.arguments, arguments.block);
                 }
 
                 arguments.block = (pm_node_t *) block;
@@ -21026,7 +21261,7 @@ static pm_statements_node_t *
 wrap_statements(pm_parser_t *parser, pm_statements_node_t *statements) {
     if (PM_PARSER_COMMAND_LINE_OPTION_P(parser)) {
         pm_arguments_node_t *arguments = pm_arguments_node_create(parser);
-        pm_arguments_node_arguments_append(
+        pm_arguments_node_arguments_append(parser, 
             arguments,
             (pm_node_t *) pm_global_variable_read_node_synthesized_create(parser, pm_parser_constant_id_constant(parser, "$_", 2))
         );
@@ -21041,7 +21276,7 @@ wrap_statements(pm_parser_t *parser, pm_statements_node_t *statements) {
     if (PM_PARSER_COMMAND_LINE_OPTION_N(parser)) {
         if (PM_PARSER_COMMAND_LINE_OPTION_A(parser)) {
             pm_arguments_node_t *arguments = pm_arguments_node_create(parser);
-            pm_arguments_node_arguments_append(
+            pm_arguments_node_arguments_append(parser, 
                 arguments,
                 (pm_node_t *) pm_global_variable_read_node_synthesized_create(parser, pm_parser_constant_id_constant(parser, "$;", 2))
             );
@@ -21055,25 +21290,25 @@ wrap_statements(pm_parser_t *parser, pm_statements_node_t *statements) {
                 (pm_node_t *) call
             );
 
-            pm_statements_node_body_prepend(statements, (pm_node_t *) write);
+            pm_statements_node_body_prepend(parser, statements, (pm_node_t *) write);
         }
 
         pm_arguments_node_t *arguments = pm_arguments_node_create(parser);
-        pm_arguments_node_arguments_append(
+        pm_arguments_node_arguments_append(parser, 
             arguments,
             (pm_node_t *) pm_global_variable_read_node_synthesized_create(parser, pm_parser_constant_id_constant(parser, "$/", 2))
         );
 
         if (PM_PARSER_COMMAND_LINE_OPTION_L(parser)) {
             pm_keyword_hash_node_t *keywords = pm_keyword_hash_node_create(parser);
-            pm_keyword_hash_node_elements_append(keywords, (pm_node_t *) pm_assoc_node_create(
+            pm_keyword_hash_node_elements_append(parser, keywords, (pm_node_t *) pm_assoc_node_create(
                 parser,
                 (pm_node_t *) pm_symbol_node_synthesized_create(parser, "chomp"),
                 &(pm_token_t) { .type = PM_TOKEN_NOT_PROVIDED, .start = parser->start, .end = parser->start },
                 (pm_node_t *) pm_true_node_synthesized_create(parser)
             ));
 
-            pm_arguments_node_arguments_append(arguments, (pm_node_t *) keywords);
+            pm_arguments_node_arguments_append(parser, arguments, (pm_node_t *) keywords);
         }
 
         pm_statements_node_t *wrapped_statements = pm_statements_node_create(parser);
@@ -21171,10 +21406,11 @@ pm_parser_warn_shebang_carriage_return(pm_parser_t *parser, const uint8_t *start
 }
 
 /**
- * Initialize a parser with the given start and end pointers.
+ * Set every field of the parser to its initial state for the given source. This
+ * does not allocate anything.
  */
-PRISM_EXPORTED_FUNCTION void
-pm_parser_init(pm_parser_t *parser, const uint8_t *source, size_t size, const pm_options_t *options) {
+static void
+pm_parser_init_state(pm_parser_t *parser, const uint8_t *source, size_t size) {
     assert(source != NULL);
 
     *parser = (pm_parser_t) {
@@ -21188,6 +21424,7 @@ pm_parser_init(pm_parser_t *parser, const uint8_t *source, size_t size, const pm
             .index = 0,
             .stack = {{ .mode = PM_LEX_DEFAULT }},
             .current = &parser->lex_modes.stack[0],
+            .free = NULL
         },
         .start = source,
         .end = source + size,
@@ -21201,7 +21438,9 @@ pm_parser_init(pm_parser_t *parser, const uint8_t *source, size_t size, const pm
         .warning_list = { 0 },
         .error_list = { 0 },
         .current_scope = NULL,
+        .free_scopes = NULL,
         .current_context = NULL,
+        .free_contexts = NULL,
         .encoding = PM_ENCODING_UTF_8_ENTRY,
         .encoding_changed_callback = NULL,
         .encoding_comment_start = source,
@@ -21209,11 +21448,13 @@ pm_parser_init(pm_parser_t *parser, const uint8_t *source, size_t size, const pm
         .filepath = { 0 },
         .constant_pool = { 0 },
         .newline_list = { 0 },
+        .arena = NULL,
         .integer_base = 0,
         .current_string = PM_STRING_EMPTY,
         .start_line = 1,
         .explicit_encoding = NULL,
         .command_line = 0,
+        .serialization = 0,
         .parsing_eval = false,
         .command_start = true,
         .recovering = false,
@@ -21223,32 +21464,18 @@ pm_parser_init(pm_parser_t *parser, const uint8_t *source, size_t size, const pm
         .current_block_exits = NULL,
         .semantic_token_seen = false,
         .frozen_string_literal = PM_OPTIONS_FROZEN_STRING_LITERAL_UNSET,
-        .current_regular_expression_ascii_only = false
+        .current_regular_expression_ascii_only = false,
+        .stop_at_first_error = false
     };
+}
 
-    // Initialize the constant pool. We're going to completely guess as to the
-    // number of constants that we'll need based on the size of the input. The
-    // ratio we chose here is actually less arbitrary than you might think.
-    //
-    // We took ~50K Ruby files and measured the size of the file versus the
-    // number of constants that were found in those files. Then we found the
-    // average and standard deviation of the ratios of constants/bytesize. Then
-    // we added 1.34 standard deviations to the average to get a ratio that
-    // would fit 75% of the files (for a two-tailed distribution). This works
-    // because there was about a 0.77 correlation and the distribution was
-    // roughly normal.
-    //
-    // This ratio will need to change if we add more constants to the constant
-    // pool for another node type.
-    uint32_t constant_size = ((uint32_t) size) / 95;
-    pm_constant_pool_init(&parser->constant_pool, constant_size < 4 ? 4 : constant_size);
-
-    // Initialize the newline list. Similar to the constant pool, we're going to
-    // guess at the number of newlines that we'll need based on the size of the
-    // input.
-    size_t newline_size = size / 22;
-    pm_newline_list_init(&parser->newline_list, source, newline_size < 4 ? 4 : newline_size);
-
+/**
+ * Apply the given options to the parser and prepare it to begin lexing the
+ * source. This assumes that the constant pool and newline list have already
+ * been initialized.
+ */
+static void
+pm_parser_init_source(pm_parser_t *parser, const uint8_t *source, size_t size, const pm_options_t *options) {
     // If options were provided to this parse, establish them here.
     if (options != NULL) {
         // filepath option
@@ -21270,9 +21497,19 @@ pm_parser_init(pm_parser_t *parser, const uint8_t *source, size_t size, const pm
         // command_line option
         parser->command_line = options->command_line;
 
+        // serialization option
+        parser->serialization = options->serialization;
+
         // version option
         parser->version = options->version;
 
+        // newline_index option
+        if (options->newline_index && !pm_newline_list_index(&parser->newline_list, source, size) && parser->newline_list.offsets == NULL) {
+            // If we could not allocate the index, then fall back to recording
+            // the newlines as they are lexed.
+            pm_newline_list_init(&parser->newline_list, source, 4);
+        }
+
         // scopes option
         parser->parsing_eval = options->scopes_count > 0;
 
@@ -21382,6 +21619,42 @@ pm_parser_init(pm_parser_t *parser, const uint8_t *source, size_t size, const pm
     parser->encoding_comment_start += pm_strspn_inline_whitespace(parser->encoding_comment_start, parser->end - parser->encoding_comment_start);
 }
 
+/**
+ * Initialize a parser with the given start and end pointers.
+ */
+PRISM_EXPORTED_FUNCTION void
+pm_parser_init(pm_parser_t *parser, const uint8_t *source, size_t size, const pm_options_t *options) {
+    pm_parser_init_state(parser, source, size);
+
+    // Initialize the constant pool. We're going to completely guess as to the
+    // number of constants that we'll need based on the size of the input. The
+    // ratio we chose here is actually less arbitrary than you might think.
+    //
+    // We took ~50K Ruby files and measured the size of the file versus the
+    // number of constants that were found in those files. Then we found the
+    // average and standard deviation of the ratios of constants/bytesize. Then
+    // we added 1.34 standard deviations to the average to get a ratio that
+    // would fit 75% of the files (for a two-tailed distribution). This works
+    // because there was about a 0.77 correlation and the distribution was
+    // roughly normal.
+    //
+    // This ratio will need to change if we add more constants to the constant
+    // pool for another node type.
+    uint32_t constant_size = ((uint32_t) size) / 95;
+    pm_constant_pool_init(&parser->constant_pool, constant_size < 4 ? 4 : constant_size);
+
+    // Initialize the newline list. If every newline is going to be found
+    // upfront, then pm_parser_init_source will size the list exactly.
+    // Otherwise, similar to the constant pool, we're going to guess at the
+    // number of newlines that we'll need based on the size of the input.
+    if (options == NULL || !options->newline_index) {
+        size_t newline_size = size / 22;
+        pm_newline_list_init(&parser->newline_list, source, newline_size < 4 ? 4 : newline_size);
+    }
+
+    pm_parser_init_source(parser, source, size, options);
+}
+
 /**
  * Register a callback that will be called whenever prism changes the encoding
  * it is using to parse based on the magic comment.
@@ -21391,6 +21664,14 @@ pm_parser_register_encoding_changed_callback(pm_parser_t *parser, pm_encoding_ch
     parser->encoding_changed_callback = callback;
 }
 
+/**
+ * Attach an arena to the parser from which the syntax tree will be allocated.
+ */
+PRISM_EXPORTED_FUNCTION void
+pm_parser_arena_set(pm_parser_t *parser, pm_arena_t *arena) {
+    parser->arena = arena;
+}
+
 /**
  * Free all of the memory associated with the comment list.
  */
@@ -21422,17 +21703,16 @@ pm_magic_comment_list_free(pm_list_t *list) {
 }
 
 /**
- * Free any memory associated with the given parser.
+ * Free the memory associated with the given parser that is specific to a single
+ * parse, leaving the constant pool and newline list intact.
  */
-PRISM_EXPORTED_FUNCTION void
-pm_parser_free(pm_parser_t *parser) {
+static void
+pm_parser_free_state(pm_parser_t *parser) {
     pm_string_free(&parser->filepath);
     pm_diagnostic_list_free(&parser->error_list);
     pm_diagnostic_list_free(&parser->warning_list);
     pm_comment_list_free(&parser->comment_list);
     pm_magic_comment_list_free(&parser->magic_comment_list);
-    pm_constant_pool_free(&parser->constant_pool);
-    pm_newline_list_free(&parser->newline_list);
 
     while (parser->current_scope != NULL) {
         // Normally, popping the scope doesn't free the locals since it is
@@ -21445,81 +21725,357 @@ pm_parser_free(pm_parser_t *parser) {
     while (parser->lex_modes.index >= PM_LEX_STACK_SIZE) {
         lex_mode_pop(parser);
     }
+
+    while (parser->current_context != NULL) {
+        context_pop(parser);
+    }
 }
 
 /**
- * Parse the Ruby source associated with the given parser and return the tree.
+ * Free the lex modes and context nodes that have been popped and kept for
+ * reuse.
  */
-PRISM_EXPORTED_FUNCTION pm_node_t *
-pm_parse(pm_parser_t *parser) {
-    return parse_program(parser);
+static void
+pm_parser_free_lists_free(pm_parser_t *parser) {
+    pm_lex_mode_t *lex_mode = parser->lex_modes.free;
+    while (lex_mode != NULL) {
+        pm_lex_mode_t *prev = lex_mode->prev;
+        xfree(lex_mode);
+        lex_mode = prev;
+    }
+    parser->lex_modes.free = NULL;
+
+    pm_context_node_t *context_node = parser->free_contexts;
+    while (context_node != NULL) {
+        pm_context_node_t *prev = context_node->prev;
+        xfree(context_node);
+        context_node = prev;
+    }
+    parser->free_contexts = NULL;
 }
 
 /**
- * Read into the stream until the gets callback returns false. If the last read
- * line from the stream matches an __END__ marker, then halt and return false,
- * otherwise return true.
+ * Free any memory associated with the given parser.
  */
-static bool
-pm_parse_stream_read(pm_buffer_t *buffer, void *stream, pm_parse_stream_fgets_t *fgets) {
-#define LINE_SIZE 4096
-    char line[LINE_SIZE];
+PRISM_EXPORTED_FUNCTION void
+pm_parser_free(pm_parser_t *parser) {
+    pm_parser_free_state(parser);
+    pm_parser_scopes_free(parser);
+    pm_parser_free_lists_free(parser);
+    pm_constant_pool_free(&parser->constant_pool);
+    pm_newline_list_free(&parser->newline_list);
+}
 
-    while (fgets(line, LINE_SIZE, stream) != NULL) {
-        size_t length = strlen(line);
+/**
+ * Reset a parser that has already been used so that it can parse new source
+ * while reusing the memory that it has already allocated.
+ */
+PRISM_EXPORTED_FUNCTION void
+pm_parser_reset(pm_parser_t *parser, const uint8_t *source, size_t size, const pm_options_t *options) {
+    pm_parser_free_state(parser);
 
-        if (length == LINE_SIZE && line[length - 1] != '\n') {
-            // If we read a line that is the maximum size and it doesn't end
-            // with a newline, then we'll just append it to the buffer and
-            // continue reading.
-            pm_buffer_append_string(buffer, line, length);
-            continue;
-        }
+    // Hold on to the buffers that have already been grown by previous parses
+    // so that they survive reinitializing the rest of the parser.
+    pm_constant_pool_t constant_pool = parser->constant_pool;
+    pm_constant_pool_clear(&constant_pool);
 
-        // Append the line to the buffer.
-        pm_buffer_append_string(buffer, line, length);
+    pm_newline_list_t newline_list = parser->newline_list;
+    pm_newline_list_clear(&newline_list);
+    newline_list.start = source;
 
-        // Check if the line matches the __END__ marker. If it does, then stop
-        // reading and return false. In most circumstances, this means we should
-        // stop reading from the stream so that the DATA constant can pick it
-        // up.
-        switch (length) {
-            case 7:
-                if (strncmp(line, "__END__", 7) == 0) return false;
-                break;
-            case 8:
-                if (strncmp(line, "__END__\n", 8) == 0) return false;
-                break;
-            case 9:
-                if (strncmp(line, "__END__\r\n", 9) == 0) return false;
-                break;
-        }
-    }
+    pm_arena_t *arena = parser->arena;
+    if (arena != NULL) pm_arena_reset(arena);
 
-    return true;
-#undef LINE_SIZE
+    pm_scope_t *free_scopes = parser->free_scopes;
+    pm_lex_mode_t *free_lex_modes = parser->lex_modes.free;
+    pm_context_node_t *free_contexts = parser->free_contexts;
+
+    pm_parser_init_state(parser, source, size);
+    parser->constant_pool = constant_pool;
+    parser->newline_list = newline_list;
+    parser->arena = arena;
+    parser->free_scopes = free_scopes;
+    parser->lex_modes.free = free_lex_modes;
+    parser->free_contexts = free_contexts;
+
+    pm_parser_init_source(parser, source, size, options);
 }
 
+#ifdef PRISM_BUILD_STATS
+
 /**
- * Determine if there was an unterminated heredoc at the end of the input, which
- * would mean the stream isn't finished and we should keep reading.
- *
- * For the other lex modes we can check if the lex mode has been closed, but for
- * heredocs when we hit EOF we close the lex mode and then go back to parse the
- * rest of the line after the heredoc declaration so that we get more of the
- * syntax tree.
+ * Count a node of the resulting tree into the statistics of the parser.
  */
 static bool
-pm_parse_stream_unterminated_heredoc_p(pm_parser_t *parser) {
-    pm_diagnostic_t *diagnostic = (pm_diagnostic_t *) parser->error_list.head;
+pm_parse_stats_visit(const pm_node_t *node, void *data) {
+    ((pm_parser_t *) data)->stats.nodes[PM_NODE_TYPE(node)]++;
+    return true;
+}
+
+/**
+ * Parse the Ruby source associated with the given parser and return the tree,
+ * recording the time it took and the number of nodes of each type.
+ */
+PRISM_EXPORTED_FUNCTION pm_node_t *
+pm_parse(pm_parser_t *parser) {
+    uint64_t start = pm_stats_time();
+    pm_node_t *node = parse_program(parser);
+    parser->stats.parse_time += pm_stats_time() - start;
+
+    pm_visit_node(node, pm_parse_stats_visit, parser);
+    return node;
+}
+
+#else
+
+/**
+ * Parse the Ruby source associated with the given parser and return the tree.
+ */
+PRISM_EXPORTED_FUNCTION pm_node_t *
+pm_parse(pm_parser_t *parser) {
+    return parse_program(parser);
+}
+
+#endif
+
+/**
+ * The tokens that pm_lex has found but not yet handed out.
+ */
+typedef struct {
+    /** The callback that the tokens are handed out to. */
+    const pm_lex_tokens_callback_t *callback;
+
+    /** The number of tokens in the batch. */
+    size_t size;
+
+    /** The tokens in the batch. */
+    pm_lex_token_t tokens[PM_LEX_TOKENS_BATCH_SIZE];
+} pm_lex_batch_t;
+
+/**
+ * Hand out the tokens that have been accumulated so far, if there are any.
+ */
+static void
+pm_lex_batch_flush(pm_lex_batch_t *batch, pm_parser_t *parser) {
+    if (batch->size > 0) {
+        batch->callback->callback(batch->callback->data, parser, batch->tokens, batch->size);
+        batch->size = 0;
+    }
+}
+
+/**
+ * This is attached to the parser by pm_lex, and is called every time a new
+ * token is found.
+ */
+static void
+pm_lex_batch_token(void *data, pm_parser_t *parser, pm_token_t *token) {
+    pm_lex_batch_t *batch = (pm_lex_batch_t *) data;
+    batch->tokens[batch->size++] = (pm_lex_token_t) { .token = *token, .lex_state = parser->lex_state };
+    if (batch->size == PM_LEX_TOKENS_BATCH_SIZE) pm_lex_batch_flush(batch, parser);
+}
+
+/**
+ * Lex the source of the given parser, handing the tokens to the given callback
+ * in batches.
+ */
+PRISM_EXPORTED_FUNCTION void
+pm_lex(pm_parser_t *parser, const pm_lex_tokens_callback_t *callback) {
+    pm_lex_batch_t batch = { .callback = callback, .size = 0 };
+    pm_lex_callback_t lex_callback = { .data = (void *) &batch, .callback = pm_lex_batch_token };
+
+    pm_lex_callback_t *previous_lex_callback = parser->lex_callback;
+    parser->lex_callback = &lex_callback;
+
+    // The tree is never handed back, so if there is nowhere for it to have
+    // been allocated in bulk then we provide an arena here. That way it can be
+    // thrown away all at once instead of being walked node by node.
+    pm_arena_t arena = { 0 };
+    bool owns_arena = parser->arena == NULL;
+    if (owns_arena) parser->arena = &arena;
+
+    parse_program(parser);
+    pm_lex_batch_flush(&batch, parser);
+
+    if (owns_arena) {
+        parser->arena = NULL;
+        pm_arena_free(&arena);
+    }
+
+    parser->lex_callback = previous_lex_callback;
+}
+
+/**
+ * The maximum number of bytes of a terminator that pm_parse_stream holds on to
+ * between reads. Only looking for a prefix of a longer terminator is still
+ * correct, it can only cause the stream to be parsed again sooner than it
+ * needed to be.
+ */
+#define PM_PARSE_STREAM_TERMINATOR_SIZE 64
+
+/**
+ * When the source that has been read so far ends inside of a heredoc or a
+ * string-like literal, then every __END__ marker that comes before the literal
+ * could possibly be closed is part of its contents. This holds the bytes that
+ * have to appear in the stream before an __END__ marker can end it again.
+ */
+typedef struct {
+    /** The bytes of the terminator. */
+    uint8_t value[PM_PARSE_STREAM_TERMINATOR_SIZE];
+
+    /** The number of bytes in the terminator, or 0 if there is none. */
+    size_t length;
+} pm_parse_stream_terminator_t;
+
+/**
+ * Returns true if the given terminator appears within the given line.
+ */
+static bool
+pm_parse_stream_terminator_p(const pm_parse_stream_terminator_t *terminator, const uint8_t *line, size_t length) {
+    const uint8_t *cursor = line;
+    const uint8_t *end = line + length;
+
+    while ((size_t) (end - cursor) >= terminator->length) {
+        cursor = memchr(cursor, terminator->value[0], (size_t) (end - cursor) - terminator->length + 1);
+        if (cursor == NULL) return false;
+        if (memcmp(cursor, terminator->value, terminator->length) == 0) return true;
+        cursor++;
+    }
+
+    return false;
+}
+
+/**
+ * Read into the stream until the gets callback returns false. If the last read
+ * line from the stream matches an __END__ marker, then halt and return false,
+ * otherwise return true. __END__ markers are ignored until the given terminator
+ * has been read, since they cannot end the stream until then.
+ */
+static bool
+pm_parse_stream_read(pm_buffer_t *buffer, void *stream, pm_parse_stream_fgets_t *fgets, pm_parse_stream_terminator_t *terminator) {
+#define LINE_SIZE 4096
+    char line[LINE_SIZE];
+    size_t line_start = pm_buffer_length(buffer);
+
+    while (fgets(line, LINE_SIZE, stream) != NULL) {
+        size_t length = strlen(line);
+
+        // If the previous read did not end with a newline, then this is the
+        // rest of a line that cannot be an __END__ marker.
+        bool continuation = line_start != pm_buffer_length(buffer);
+
+        // Append the line to the buffer.
+        pm_buffer_append_string(buffer, line, length);
+
+        if (length == LINE_SIZE - 1 && line[length - 1] != '\n') {
+            // If we read a line that is the maximum size and it doesn't end
+            // with a newline, then we'll just continue reading the rest of
+            // the line.
+            continue;
+        }
+
+        // If we're still waiting for a terminator, then check the whole line
+        // for it. The line is read out of the buffer because it may have been
+        // split across multiple reads.
+        if (terminator->length > 0) {
+            const uint8_t *value = (const uint8_t *) pm_buffer_value(buffer);
+            if (pm_parse_stream_terminator_p(terminator, value + line_start, pm_buffer_length(buffer) - line_start)) terminator->length = 0;
+        }
+
+        line_start = pm_buffer_length(buffer);
+        if (continuation || terminator->length > 0) continue;
+
+        // Check if the line matches the __END__ marker. If it does, then stop
+        // reading and return false. In most circumstances, this means we should
+        // stop reading from the stream so that the DATA constant can pick it
+        // up.
+        switch (length) {
+            case 7:
+                if (strncmp(line, "__END__", 7) == 0) return false;
+                break;
+            case 8:
+                if (strncmp(line, "__END__\n", 8) == 0) return false;
+                break;
+            case 9:
+                if (strncmp(line, "__END__\r\n", 9) == 0) return false;
+                break;
+        }
+    }
+
+    return true;
+#undef LINE_SIZE
+}
+
+/**
+ * Determine if there was an unterminated heredoc at the end of the input, which
+ * would mean the stream isn't finished and we should keep reading. Returns the
+ * diagnostic of the unterminated heredoc, or NULL if there isn't one.
+ *
+ * For the other lex modes we can check if the lex mode has been closed, but for
+ * heredocs when we hit EOF we close the lex mode and then go back to parse the
+ * rest of the line after the heredoc declaration so that we get more of the
+ * syntax tree.
+ */
+static const pm_diagnostic_t *
+pm_parse_stream_unterminated_heredoc(pm_parser_t *parser) {
+    pm_diagnostic_t *diagnostic = (pm_diagnostic_t *) parser->error_list.head;
 
     for (; diagnostic != NULL; diagnostic = (pm_diagnostic_t *) diagnostic->node.next) {
         if (diagnostic->diag_id == PM_ERR_HEREDOC_TERM) {
-            return true;
+            return diagnostic;
         }
     }
 
-    return false;
+    return NULL;
+}
+
+/**
+ * Find the terminator of the literal that was left open at the end of the
+ * input, so that reading more of the stream does not stop at an __END__ marker
+ * that is part of its contents. Rather than parsing everything again at each
+ * such marker, the stream is then only parsed again once the literal could
+ * have been closed.
+ */
+static void
+pm_parse_stream_terminator(pm_parser_t *parser, const pm_diagnostic_t *heredoc, pm_parse_stream_terminator_t *terminator) {
+    const uint8_t *start = NULL;
+    size_t length = 0;
+
+    if (heredoc != NULL) {
+        // Heredocs that are open at the end of the input have already been
+        // popped off of the lex mode stack, but their error points at their
+        // identifier.
+        start = heredoc->location.start;
+        length = (size_t) (heredoc->location.end - heredoc->location.start);
+    } else if (parser->lex_modes.index > 0) {
+        const pm_lex_mode_t *lex_mode = parser->lex_modes.current;
+
+        switch (lex_mode->mode) {
+            case PM_LEX_HEREDOC:
+                start = lex_mode->as.heredoc.ident_start;
+                length = lex_mode->as.heredoc.ident_length;
+                break;
+            case PM_LEX_LIST:
+                start = &lex_mode->as.list.terminator;
+                length = 1;
+                break;
+            case PM_LEX_REGEXP:
+                start = &lex_mode->as.regexp.terminator;
+                length = 1;
+                break;
+            case PM_LEX_STRING:
+                start = &lex_mode->as.string.terminator;
+                length = 1;
+                break;
+            default:
+                // Embedded expressions are lexed as regular code, so there is
+                // no single terminator to wait for.
+                break;
+        }
+    }
+
+    if (length > PM_PARSE_STREAM_TERMINATOR_SIZE) length = PM_PARSE_STREAM_TERMINATOR_SIZE;
+    if (length > 0) memcpy(terminator->value, start, length);
+    terminator->length = length;
 }
 
 /**
@@ -21532,13 +22088,20 @@ PRISM_EXPORTED_FUNCTION pm_node_t *
 pm_parse_stream(pm_parser_t *parser, pm_buffer_t *buffer, void *stream, pm_parse_stream_fgets_t *fgets, const pm_options_t *options) {
     pm_buffer_init(buffer);
 
-    bool eof = pm_parse_stream_read(buffer, stream, fgets);
+    pm_parse_stream_terminator_t terminator = { .length = 0 };
+    bool eof = pm_parse_stream_read(buffer, stream, fgets, &terminator);
+
     pm_parser_init(parser, (const uint8_t *) pm_buffer_value(buffer), pm_buffer_length(buffer), options);
     pm_node_t *node = pm_parse(parser);
 
-    while (!eof && parser->error_list.size > 0 && (parser->lex_modes.index > 0 || pm_parse_stream_unterminated_heredoc_p(parser))) {
+    const pm_diagnostic_t *heredoc;
+    while (!eof && parser->error_list.size > 0 && ((heredoc = pm_parse_stream_unterminated_heredoc(parser)) != NULL || parser->lex_modes.index > 0)) {
         pm_node_destroy(parser, node);
-        eof = pm_parse_stream_read(buffer, stream, fgets);
+
+        // The terminator has to be copied out before reading, since reading
+        // may move the buffer that the parser is pointing into.
+        pm_parse_stream_terminator(parser, heredoc, &terminator);
+        eof = pm_parse_stream_read(buffer, stream, fgets, &terminator);
 
         pm_parser_free(parser);
         pm_parser_init(parser, (const uint8_t *) pm_buffer_value(buffer), pm_buffer_length(buffer), options);
@@ -21548,6 +22111,8 @@ pm_parse_stream(pm_parser_t *parser, pm_buffer_t *buffer, void *stream, pm_parse
     return node;
 }
 
+#undef PM_PARSE_STREAM_TERMINATOR_SIZE
+
 /**
  * Parse the source and return true if it parses without errors or warnings.
  */
@@ -21559,16 +22124,222 @@ pm_parse_success_p(const uint8_t *source, size_t size, const char *data) {
     pm_parser_t parser;
     pm_parser_init(&parser, source, size, &options);
 
-    pm_node_t *node = pm_parse(&parser);
-    pm_node_destroy(&parser, node);
+    pm_arena_t arena = { 0 };
+    pm_parser_arena_set(&parser, &arena);
+
+    parser.stop_at_first_error = true;
+    pm_parse(&parser);
 
     bool result = parser.error_list.size == 0;
     pm_parser_free(&parser);
+    pm_arena_free(&arena);
     pm_options_free(&options);
 
     return result;
 }
 
+/**
+ * An entry in the log of marks that were made inside of a block or lambda,
+ * which is used to restore the marks of the enclosing scope when leaving it.
+ */
+typedef struct {
+    /** The index of the line that was marked. */
+    size_t line;
+
+    /** The scope that had marked the line before. */
+    uint32_t previous;
+} pm_newline_mark_t;
+
+/**
+ * The state that is threaded through the visitor when marking newlines.
+ */
+typedef struct {
+    /** The parser that produced the tree, for looking up line numbers. */
+    const pm_parser_t *parser;
+
+    /**
+     * For every line, the scope that has marked it. A line is only marked in
+     * the current scope if this is equal to scope.
+     */
+    uint32_t *lines;
+
+    /** The number of lines in the source. */
+    size_t lines_size;
+
+    /** The hint passed to pm_newline_list_line_column_hint. */
+    size_t hint;
+
+    /** The identifier of the current scope. */
+    uint32_t scope;
+
+    /** The identifier that was given out to the most recent scope. */
+    uint32_t scopes;
+
+    /** The marks that were made inside of blocks and lambdas. */
+    pm_newline_mark_t *log;
+
+    /** The number of entries in the log. */
+    size_t log_size;
+
+    /** The capacity of the log. */
+    size_t log_capacity;
+
+    /** Whether or not an allocation failed. */
+    bool failed;
+} pm_newline_marker_t;
+
+/**
+ * Mark the given node as the one that fires the :line event for its line, if
+ * no other node has already done so in the current scope. This mirrors
+ * Node#newline! in lib/prism/parse_result/newlines.rb.
+ */
+static void
+pm_newline_mark(pm_newline_marker_t *marker, pm_node_t *node) {
+    switch (PM_NODE_TYPE(node)) {
+        case PM_BEGIN_NODE:
+        case PM_PARENTHESES_NODE:
+            // Never mark these nodes, mark their children instead.
+            return;
+        case PM_IF_NODE:
+            pm_newline_mark(marker, ((pm_if_node_t *) node)->predicate);
+            return;
+        case PM_UNLESS_NODE:
+            pm_newline_mark(marker, ((pm_unless_node_t *) node)->predicate);
+            return;
+        case PM_UNTIL_NODE:
+            pm_newline_mark(marker, ((pm_until_node_t *) node)->predicate);
+            return;
+        case PM_WHILE_NODE:
+            pm_newline_mark(marker, ((pm_while_node_t *) node)->predicate);
+            return;
+        case PM_RESCUE_MODIFIER_NODE:
+            pm_newline_mark(marker, ((pm_rescue_modifier_node_t *) node)->expression);
+            return;
+        case PM_INTERPOLATED_MATCH_LAST_LINE_NODE: {
+            const pm_node_list_t *parts = &((pm_interpolated_match_last_line_node_t *) node)->parts;
+            if (parts->size > 0) pm_newline_mark(marker, parts->nodes[0]);
+            return;
+        }
+        case PM_INTERPOLATED_REGULAR_EXPRESSION_NODE: {
+            const pm_node_list_t *parts = &((pm_interpolated_regular_expression_node_t *) node)->parts;
+            if (parts->size > 0) pm_newline_mark(marker, parts->nodes[0]);
+            return;
+        }
+        case PM_INTERPOLATED_STRING_NODE: {
+            const pm_node_list_t *parts = &((pm_interpolated_string_node_t *) node)->parts;
+            if (parts->size > 0) pm_newline_mark(marker, parts->nodes[0]);
+            return;
+        }
+        case PM_INTERPOLATED_SYMBOL_NODE: {
+            const pm_node_list_t *parts = &((pm_interpolated_symbol_node_t *) node)->parts;
+            if (parts->size > 0) pm_newline_mark(marker, parts->nodes[0]);
+            return;
+        }
+        case PM_INTERPOLATED_X_STRING_NODE: {
+            const pm_node_list_t *parts = &((pm_interpolated_x_string_node_t *) node)->parts;
+            if (parts->size > 0) pm_newline_mark(marker, parts->nodes[0]);
+            return;
+        }
+        default:
+            break;
+    }
+
+    const pm_parser_t *parser = marker->parser;
+    int32_t line = pm_newline_list_line_column_hint(&parser->newline_list, node->location.start, parser->start_line, &marker->hint).line;
+    size_t index = (size_t) (line - parser->start_line);
+
+    if (index >= marker->lines_size || marker->lines[index] == marker->scope) return;
+
+    if (marker->scope != 0) {
+        if (marker->log_size == marker->log_capacity) {
+            size_t capacity = marker->log_capacity == 0 ? 16 : marker->log_capacity * 2;
+            pm_newline_mark_t *log = xrealloc(marker->log, capacity * sizeof(pm_newline_mark_t));
+
+            if (log == NULL) {
+                marker->failed = true;
+                return;
+            }
+
+            marker->log = log;
+            marker->log_capacity = capacity;
+        }
+
+        marker->log[marker->log_size++] = (pm_newline_mark_t) { .line = index, .previous = marker->lines[index] };
+    }
+
+    marker->lines[index] = marker->scope;
+    node->flags |= PM_NODE_FLAG_MARKED_NEWLINE;
+}
+
+/**
+ * Visit a node while marking newlines. This mirrors the
+ * ParseResult::Newlines visitor in lib/prism/parse_result/newlines.rb.
+ */
+static bool
+pm_newline_visit(const pm_node_t *node, void *data) {
+    pm_newline_marker_t *marker = (pm_newline_marker_t *) data;
+    if (marker->failed) return false;
+
+    switch (PM_NODE_TYPE(node)) {
+        case PM_BLOCK_NODE:
+        case PM_LAMBDA_NODE: {
+            // Blocks and lambdas mark newlines within themselves as if none of
+            // the lines had been marked yet.
+            uint32_t scope = marker->scope;
+            size_t log_size = marker->log_size;
+
+            marker->scope = ++marker->scopes;
+            pm_visit_child_nodes(node, pm_newline_visit, data);
+            marker->scope = scope;
+
+            while (marker->log_size > log_size) {
+                const pm_newline_mark_t *mark = &marker->log[--marker->log_size];
+                marker->lines[mark->line] = mark->previous;
+            }
+
+            return false;
+        }
+        case PM_IF_NODE:
+        case PM_UNLESS_NODE:
+            pm_newline_mark(marker, (pm_node_t *) node);
+            return true;
+        case PM_STATEMENTS_NODE: {
+            const pm_node_list_t *body = &((const pm_statements_node_t *) node)->body;
+            for (size_t index = 0; index < body->size; index++) {
+                pm_newline_mark(marker, body->nodes[index]);
+            }
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
+/**
+ * Set PM_NODE_FLAG_MARKED_NEWLINE on the nodes that fire the :line event,
+ * following the same rules as ParseResult#mark_newlines!.
+ */
+PRISM_EXPORTED_FUNCTION bool
+pm_node_mark_newlines(const pm_parser_t *parser, pm_node_t *node) {
+    pm_newline_marker_t marker = {
+        .parser = parser,
+        .lines_size = parser->newline_list.size,
+        .scope = 0,
+        .scopes = 0
+    };
+
+    // Every line starts out as marked by a scope that is never entered.
+    marker.lines = xmalloc(marker.lines_size * sizeof(uint32_t));
+    if (marker.lines == NULL) return false;
+    memset(marker.lines, 0xff, marker.lines_size * sizeof(uint32_t));
+
+    pm_visit_node(node, pm_newline_visit, &marker);
+
+    xfree(marker.lines);
+    xfree(marker.log);
+    return !marker.failed;
+}
+
 #undef PM_CASE_KEYWORD
 #undef PM_CASE_OPERATOR
 #undef PM_CASE_WRITABLE
@@ -21583,13 +22354,31 @@ pm_parse_success_p(const uint8_t *source, size_t size, const char *data) {
 // PRISM_EXCLUDE_SERIALIZATION define.
 #ifndef PRISM_EXCLUDE_SERIALIZATION
 
+/**
+ * The size of the header that starts every serialized AST.
+ */
+#define PM_SERIALIZE_HEADER_SIZE 9
+
+/**
+ * The flags that are written into the header of every serialized AST, which
+ * indicate how the templates were configured when prism was built and which
+ * serialization options were given for this parse.
+ */
+static inline uint8_t
+pm_serialize_header_flags(uint8_t serialization) {
+    bool semantics_only = PRISM_SERIALIZE_ONLY_SEMANTICS_FIELDS || (serialization & PM_OPTIONS_SERIALIZATION_SEMANTICS_ONLY);
+    bool node_lengths = serialization & PM_OPTIONS_SERIALIZATION_NODE_LENGTHS;
+    bool delta_locations = serialization & PM_OPTIONS_SERIALIZATION_DELTA_LOCATIONS;
+    return (uint8_t) ((semantics_only ? 1 : 0) | (node_lengths ? 2 : 0) | (delta_locations ? 4 : 0));
+}
+
 static inline void
-pm_serialize_header(pm_buffer_t *buffer) {
+pm_serialize_header(const pm_parser_t *parser, pm_buffer_t *buffer) {
     pm_buffer_append_string(buffer, "PRISM", 5);
     pm_buffer_append_byte(buffer, PRISM_VERSION_MAJOR);
     pm_buffer_append_byte(buffer, PRISM_VERSION_MINOR);
     pm_buffer_append_byte(buffer, PRISM_VERSION_PATCH);
-    pm_buffer_append_byte(buffer, PRISM_SERIALIZE_ONLY_SEMANTICS_FIELDS ? 1 : 0);
+    pm_buffer_append_byte(buffer, pm_serialize_header_flags(parser->serialization));
 }
 
 /**
@@ -21597,9 +22386,17 @@ pm_serialize_header(pm_buffer_t *buffer) {
  */
 PRISM_EXPORTED_FUNCTION void
 pm_serialize(pm_parser_t *parser, pm_node_t *node, pm_buffer_t *buffer) {
-    pm_serialize_header(buffer);
+#ifdef PRISM_BUILD_STATS
+    uint64_t start = pm_stats_time();
+#endif
+
+    pm_serialize_header(parser, buffer);
     pm_serialize_content(parser, node, buffer);
     pm_buffer_append_byte(buffer, '\0');
+
+#ifdef PRISM_BUILD_STATS
+    parser->stats.serialize_time += pm_stats_time() - start;
+#endif
 }
 
 /**
@@ -21614,17 +22411,242 @@ pm_serialize_parse(pm_buffer_t *buffer, const uint8_t *source, size_t size, cons
     pm_parser_t parser;
     pm_parser_init(&parser, source, size, &options);
 
+    pm_arena_t arena = { 0 };
+    pm_parser_arena_set(&parser, &arena);
     pm_node_t *node = pm_parse(&parser);
 
-    pm_serialize_header(buffer);
+    pm_serialize_header(&parser, buffer);
     pm_serialize_content(&parser, node, buffer);
     pm_buffer_append_byte(buffer, '\0');
 
-    pm_node_destroy(&parser, node);
     pm_parser_free(&parser);
+    pm_arena_free(&arena);
     pm_options_free(&options);
 }
 
+/**
+ * Write out whatever is left in the buffer once serialization is complete, and
+ * then flush the sink.
+ */
+static bool
+pm_serialize_sink_finish(pm_serialize_sink_t *sink, pm_buffer_t *buffer, bool success) {
+    pm_buffer_append_byte(buffer, '\0');
+    if (success) success = sink->write(sink->data, (const uint8_t *) pm_buffer_value(buffer), pm_buffer_length(buffer));
+    if (success && sink->flush != NULL) success = sink->flush(sink->data);
+
+    pm_buffer_free(buffer);
+    return success;
+}
+
+/**
+ * Serialize the AST represented by the given node to the given sink.
+ */
+PRISM_EXPORTED_FUNCTION bool
+pm_serialize_sink(pm_parser_t *parser, pm_node_t *node, pm_serialize_sink_t *sink) {
+    pm_buffer_t buffer = { 0 };
+    pm_serialize_header(parser, &buffer);
+
+    bool success = pm_serialize_content_sink(parser, node, &buffer, sink);
+    return pm_serialize_sink_finish(sink, &buffer, success);
+}
+
+/**
+ * Parse the given source to the AST and dump the AST to the given sink.
+ */
+PRISM_EXPORTED_FUNCTION bool
+pm_serialize_parse_sink(pm_serialize_sink_t *sink, const uint8_t *source, size_t size, const char *data) {
+    pm_options_t options = { 0 };
+    pm_options_read(&options, data);
+
+    pm_parser_t parser;
+    pm_parser_init(&parser, source, size, &options);
+
+    pm_arena_t arena = { 0 };
+    pm_parser_arena_set(&parser, &arena);
+    pm_node_t *node = pm_parse(&parser);
+
+    bool success = pm_serialize_sink(&parser, node, sink);
+
+    pm_parser_free(&parser);
+    pm_arena_free(&arena);
+    pm_options_free(&options);
+
+    return success;
+}
+
+/**
+ * The magic bytes at the start of the trailer of every cache written by
+ * pm_serialize_parse_cache.
+ */
+#define PM_SERIALIZE_CACHE_MAGIC "PMCACHE"
+
+/**
+ * Mix a word into a running digest.
+ */
+static inline uint64_t
+pm_serialize_cache_mix(uint64_t digest, uint64_t word) {
+    digest ^= word * 0x87c37b91114253d5ULL;
+    digest = (digest << 31) | (digest >> 33);
+    return digest * 0x4cf5ad432745937fULL;
+}
+
+/**
+ * Add the given bytes to a running digest, a word at a time. The length is
+ * mixed in first, so that a sequence of calls cannot produce the same digest as
+ * a different split of the same bytes.
+ */
+static uint64_t
+pm_serialize_cache_digest(uint64_t digest, const uint8_t *source, size_t length) {
+    digest = pm_serialize_cache_mix(digest, (uint64_t) length);
+
+    size_t index = 0;
+    for (; length - index >= 8; index += 8) {
+        uint64_t word;
+        memcpy(&word, source + index, sizeof(word));
+        digest = pm_serialize_cache_mix(digest, word);
+    }
+
+    if (index < length) {
+        uint64_t word = 0;
+        memcpy(&word, source + index, length - index);
+        digest = pm_serialize_cache_mix(digest, word);
+    }
+
+    digest ^= digest >> 33;
+    digest *= 0xff51afd7ed558ccdULL;
+    digest ^= digest >> 33;
+    return digest;
+}
+
+/**
+ * Compute a digest of every option that can change the serialized result of a
+ * parse.
+ */
+static uint64_t
+pm_serialize_cache_options_digest(const pm_options_t *options) {
+    uint64_t digest = pm_serialize_cache_digest(0, pm_string_source(&options->filepath), pm_string_length(&options->filepath));
+    digest = pm_serialize_cache_digest(digest, pm_string_source(&options->encoding), pm_string_length(&options->encoding));
+
+    uint8_t values[8];
+    memcpy(values, &options->line, 4);
+    values[4] = (uint8_t) options->frozen_string_literal;
+    values[5] = options->command_line;
+    values[6] = (uint8_t) options->version;
+    values[7] = options->serialization;
+    digest = pm_serialize_cache_digest(digest, values, sizeof(values));
+
+    for (size_t scope_index = 0; scope_index < options->scopes_count; scope_index++) {
+        const pm_options_scope_t *scope = &options->scopes[scope_index];
+        digest = pm_serialize_cache_mix(digest, (uint64_t) scope->locals_count);
+
+        for (size_t local_index = 0; local_index < scope->locals_count; local_index++) {
+            const pm_string_t *local = &scope->locals[local_index];
+            digest = pm_serialize_cache_digest(digest, pm_string_source(local), pm_string_length(local));
+        }
+    }
+
+    return digest;
+}
+
+/**
+ * Append a 64-bit integer to the buffer in native byte order.
+ */
+static inline void
+pm_serialize_cache_append_u64(pm_buffer_t *buffer, uint64_t value) {
+    pm_buffer_append_bytes(buffer, (const uint8_t *) &value, sizeof(value));
+}
+
+/**
+ * Read a 64-bit integer in native byte order, regardless of alignment.
+ */
+static inline uint64_t
+pm_serialize_cache_read_u64(const uint8_t *source) {
+    uint64_t value;
+    memcpy(&value, source, sizeof(value));
+    return value;
+}
+
+/**
+ * Append the trailer of a cache for the given source and options.
+ */
+PRISM_EXPORTED_FUNCTION void
+pm_serialize_cache_trailer(pm_buffer_t *buffer, const uint8_t *source, size_t size, const pm_options_t *options) {
+    pm_buffer_append_bytes(buffer, (const uint8_t *) PM_SERIALIZE_CACHE_MAGIC, sizeof(PM_SERIALIZE_CACHE_MAGIC));
+    pm_serialize_cache_append_u64(buffer, (uint64_t) size);
+    pm_serialize_cache_append_u64(buffer, pm_serialize_cache_digest(0, source, size));
+    pm_serialize_cache_append_u64(buffer, pm_serialize_cache_options_digest(options));
+}
+
+/**
+ * Parse the given source to the AST and dump the AST to the given buffer,
+ * followed by a trailer that allows it to be validated before it is reused.
+ */
+PRISM_EXPORTED_FUNCTION void
+pm_serialize_parse_cache(pm_buffer_t *buffer, const uint8_t *source, size_t size, const char *data) {
+    pm_options_t options = { 0 };
+    pm_options_read(&options, data);
+
+    pm_parser_t parser;
+    pm_parser_init(&parser, source, size, &options);
+
+    pm_arena_t arena = { 0 };
+    pm_parser_arena_set(&parser, &arena);
+    pm_node_t *node = pm_parse(&parser);
+
+    // The serialized AST comes first, since the offsets within it are relative
+    // to the start of the buffer.
+    pm_serialize_header(&parser, buffer);
+    pm_serialize_content(&parser, node, buffer);
+    pm_buffer_append_byte(buffer, '\0');
+    pm_serialize_cache_trailer(buffer, source, size, &options);
+
+    pm_parser_free(&parser);
+    pm_arena_free(&arena);
+    pm_options_free(&options);
+}
+
+/**
+ * Check whether a cache written by pm_serialize_parse_cache can be used in
+ * place of parsing the given source with the given options.
+ */
+PRISM_EXPORTED_FUNCTION bool
+pm_serialize_cache_options_valid_p(const uint8_t *cache, size_t cache_size, const uint8_t *source, size_t size, const pm_options_t *options) {
+    if (cache_size < PM_SERIALIZE_HEADER_SIZE + PM_SERIALIZE_CACHE_TRAILER_SIZE) return false;
+
+    // The cache has to have been written by this version of prism.
+    if (memcmp(cache, "PRISM", 5) != 0) return false;
+    if (cache[5] != PRISM_VERSION_MAJOR || cache[6] != PRISM_VERSION_MINOR || cache[7] != PRISM_VERSION_PATCH) return false;
+
+    // The cache also has to have been written by a build with the same
+    // serialization flags, in case they were set when prism was built.
+    if (cache[8] != pm_serialize_header_flags(options->serialization)) return false;
+
+    const uint8_t *trailer = cache + cache_size - PM_SERIALIZE_CACHE_TRAILER_SIZE;
+    if (memcmp(trailer, PM_SERIALIZE_CACHE_MAGIC, sizeof(PM_SERIALIZE_CACHE_MAGIC)) != 0) return false;
+
+    // Check the cheap parts of the key before hashing the whole source.
+    if (pm_serialize_cache_read_u64(trailer + 8) != (uint64_t) size) return false;
+    if (pm_serialize_cache_read_u64(trailer + 24) != pm_serialize_cache_options_digest(options)) return false;
+    return pm_serialize_cache_read_u64(trailer + 16) == pm_serialize_cache_digest(0, source, size);
+}
+
+/**
+ * Check whether a cache written by pm_serialize_parse_cache can be used in
+ * place of parsing the given source with the given serialized options.
+ */
+PRISM_EXPORTED_FUNCTION bool
+pm_serialize_cache_valid_p(const uint8_t *cache, size_t cache_size, const uint8_t *source, size_t size, const char *data) {
+    pm_options_t options = { 0 };
+    pm_options_read(&options, data);
+
+    bool valid = pm_serialize_cache_options_valid_p(cache, cache_size, source, size, &options);
+    pm_options_free(&options);
+
+    return valid;
+}
+
+#undef PM_SERIALIZE_CACHE_MAGIC
+
 /**
  * Parse and serialize the AST represented by the source that is read out of the
  * given stream into to the given buffer.
@@ -21637,7 +22659,7 @@ pm_serialize_parse_stream(pm_buffer_t *buffer, void *stream, pm_parse_stream_fge
 
     pm_buffer_t parser_buffer;
     pm_node_t *node = pm_parse_stream(&parser, &parser_buffer, stream, fgets, &options);
-    pm_serialize_header(buffer);
+    pm_serialize_header(&parser, buffer);
     pm_serialize_content(&parser, node, buffer);
     pm_buffer_append_byte(buffer, '\0');
 
@@ -21658,14 +22680,17 @@ pm_serialize_parse_comments(pm_buffer_t *buffer, const uint8_t *source, size_t s
     pm_parser_t parser;
     pm_parser_init(&parser, source, size, &options);
 
-    pm_node_t *node = pm_parse(&parser);
-    pm_serialize_header(buffer);
+    pm_arena_t arena = { 0 };
+    pm_parser_arena_set(&parser, &arena);
+    pm_parse(&parser);
+
+    pm_serialize_header(&parser, buffer);
     pm_serialize_encoding(parser.encoding, buffer);
     pm_buffer_append_varsint(buffer, parser.start_line);
     pm_serialize_comment_list(&parser, &parser.comment_list, buffer);
 
-    pm_node_destroy(&parser, node);
     pm_parser_free(&parser);
+    pm_arena_free(&arena);
     pm_options_free(&options);
 }
 
@@ -21684,6 +22709,9 @@ typedef struct {
 
     /** The column end of the diagnostic message. */
     uint32_t column_end;
+
+    /** The position of the diagnostic in the list of errors. */
+    size_t order;
 } pm_error_t;
 
 /** The format that will be used to format the errors into the output. */
@@ -21708,38 +22736,40 @@ typedef struct {
 #define PM_COLOR_RED "\033[1;31m"
 #define PM_COLOR_RESET "\033[m"
 #define PM_ERROR_TRUNCATE 30
+#define PM_ERROR_RESERVE_WIDTH 1024
+
+/**
+ * Compare two errors by their starting position. Errors that start at the same
+ * position are ordered with the most recently added error first.
+ */
+static int
+pm_parser_errors_format_compare(const void *left_pointer, const void *right_pointer) {
+    const pm_error_t *left = (const pm_error_t *) left_pointer;
+    const pm_error_t *right = (const pm_error_t *) right_pointer;
+
+    if (left->line != right->line) return left->line < right->line ? -1 : 1;
+    if (left->column_start != right->column_start) return left->column_start < right->column_start ? -1 : 1;
+    if (left->order != right->order) return left->order > right->order ? -1 : 1;
+    return 0;
+}
 
 static inline pm_error_t *
 pm_parser_errors_format_sort(const pm_parser_t *parser, const pm_list_t *error_list, const pm_newline_list_t *newline_list) {
-    pm_error_t *errors = xcalloc(error_list->size, sizeof(pm_error_t));
+    pm_error_t *errors = xmalloc(error_list->size * sizeof(pm_error_t));
     if (errors == NULL) return NULL;
 
     int32_t start_line = parser->start_line;
-    for (pm_diagnostic_t *error = (pm_diagnostic_t *) error_list->head; error != NULL; error = (pm_diagnostic_t *) error->node.next) {
-        pm_line_column_t start = pm_newline_list_line_column(newline_list, error->location.start, start_line);
-        pm_line_column_t end = pm_newline_list_line_column(newline_list, error->location.end, start_line);
-
-        // We're going to insert this error into the array in sorted order. We
-        // do this by finding the first error that has a line number greater
-        // than the current error and then inserting the current error before
-        // that one.
-        size_t index = 0;
-        while (
-            (index < error_list->size) &&
-            (errors[index].error != NULL) &&
-            (
-                (errors[index].line < start.line) ||
-                ((errors[index].line == start.line) && (errors[index].column_start < start.column))
-            )
-        ) index++;
+    size_t hint = 0;
+    size_t index = 0;
+    bool sorted = true;
 
-        // Now we're going to shift all of the errors after this one down one
-        // index to make room for the new error.
-        if (index + 1 < error_list->size) {
-            memmove(&errors[index + 1], &errors[index], sizeof(pm_error_t) * (error_list->size - index - 1));
-        }
+    for (pm_diagnostic_t *error = (pm_diagnostic_t *) error_list->head; error != NULL; error = (pm_diagnostic_t *) error->node.next) {
+        // Errors are mostly appended in source order, and their ends are close
+        // to their starts, so we can reuse the line we found for each lookup.
+        pm_line_column_t start = pm_newline_list_line_column_hint(newline_list, error->location.start, start_line, &hint);
+        size_t end_hint = hint;
+        pm_line_column_t end = pm_newline_list_line_column_hint(newline_list, error->location.end, start_line, &end_hint);
 
-        // Finally, we'll insert the error into the array.
         uint32_t column_end;
         if (start.line == end.line) {
             column_end = end.column;
@@ -21754,10 +22784,17 @@ pm_parser_errors_format_sort(const pm_parser_t *parser, const pm_list_t *error_l
             .error = error,
             .line = start.line,
             .column_start = start.column,
-            .column_end = column_end
+            .column_end = column_end,
+            .order = index
         };
+
+        // Keep track of whether the errors are already in order, which they
+        // usually are, so that we only sort them when we have to.
+        if (index > 0 && pm_parser_errors_format_compare(&errors[index - 1], &errors[index]) > 0) sorted = false;
+        index++;
     }
 
+    if (!sorted) qsort(errors, error_list->size, sizeof(pm_error_t), pm_parser_errors_format_compare);
     return errors;
 }
 
@@ -21809,8 +22846,8 @@ PRISM_EXPORTED_FUNCTION void
 pm_parser_errors_format(const pm_parser_t *parser, const pm_list_t *error_list, pm_buffer_t *buffer, bool colorize, bool inline_messages) {
     assert(error_list->size != 0);
 
-    // First, we're going to sort all of the errors by line number using an
-    // insertion sort into a newly allocated array.
+    // First, we're going to sort all of the errors by their position into a
+    // newly allocated array.
     const int32_t start_line = parser->start_line;
     const pm_newline_list_t *newline_list = &parser->newline_list;
 
@@ -21906,6 +22943,26 @@ pm_parser_errors_format(const pm_parser_t *parser, const pm_list_t *error_list,
     error_format.blank_prefix_length = strlen(error_format.blank_prefix);
     error_format.divider_length = strlen(error_format.divider);
 
+    // Reserve enough space for the output up front. Each error displays the
+    // line it is on and a line of carets followed by its message, along with
+    // the prefixes for both lines. Both lines are truncated before the start
+    // of the error if it is far enough into the line, and the source line is
+    // truncated after its end. The width is capped so that a very wide error
+    // does not reserve more than it is likely to need, since the buffer will
+    // still grow if it has to.
+    size_t capacity = 0;
+    for (size_t index = 0; index < error_list->size; index++) {
+        const pm_error_t *error = &errors[index];
+        uint32_t column_start = error->column_start >= PM_ERROR_TRUNCATE ? error->column_start : 0;
+
+        size_t width = error->column_end > column_start ? (size_t) (error->column_end - column_start) : 0;
+        if (width > PM_ERROR_RESERVE_WIDTH) width = PM_ERROR_RESERVE_WIDTH;
+
+        capacity += 2 * (width + PM_ERROR_TRUNCATE + 16);
+        if (inline_messages) capacity += strlen(error->error->message);
+    }
+    pm_buffer_reserve(buffer, capacity);
+
     // Now we're going to iterate through every error in our error list and
     // display it. While we're iterating, we will display some padding lines of
     // the source before the error to give some context. We'll be careful not to
@@ -22029,6 +23086,7 @@ pm_parser_errors_format(const pm_parser_t *parser, const pm_list_t *error_list,
 }
 
 #undef PM_ERROR_TRUNCATE
+#undef PM_ERROR_RESERVE_WIDTH
 #undef PM_COLOR_GRAY
 #undef PM_COLOR_RED
 #undef PM_COLOR_RESET
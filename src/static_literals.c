@@ -156,12 +156,15 @@ node_hash(const pm_static_literals_metadata_t *metadata, const pm_node_t *node)
 static pm_node_t *
 pm_node_hash_insert(pm_node_hash_t *hash, const pm_static_literals_metadata_t *metadata, pm_node_t *node, int (*compare)(const pm_static_literals_metadata_t *metadata, const pm_node_t *left, const pm_node_t *right)) {
     // If we are out of space, we need to resize the hash. This will cause all
-    // of the nodes to be rehashed and reinserted into the new hash.
+    // of the nodes to be reinserted into the new hash using their stored
+    // hashes.
     if (hash->size * 2 >= hash->capacity) {
-        // First, allocate space for the new node list.
+        // First, allocate space for the new node list. The hashes are stored
+        // in the same allocation, directly after the nodes.
         uint32_t new_capacity = hash->capacity == 0 ? 4 : hash->capacity * 2;
-        pm_node_t **new_nodes = xcalloc(new_capacity, sizeof(pm_node_t *));
+        pm_node_t **new_nodes = xcalloc(new_capacity, sizeof(pm_node_t *) + sizeof(uint32_t));
         if (new_nodes == NULL) return NULL;
+        uint32_t *new_hashes = (uint32_t *) (new_nodes + new_capacity);
 
         // It turns out to be more efficient to mask the hash value than to use
         // the modulo operator. Because our capacities are always powers of two,
@@ -169,32 +172,40 @@ pm_node_hash_insert(pm_node_hash_t *hash, const pm_static_literals_metadata_t *m
         // operator.
         uint32_t mask = new_capacity - 1;
 
-        // Now, rehash all of the nodes into the new list.
+        // Now, reinsert all of the nodes into the new list. The nodes are all
+        // distinct, so we only need to probe for an empty slot.
         for (uint32_t index = 0; index < hash->capacity; index++) {
             pm_node_t *node = hash->nodes[index];
 
             if (node != NULL) {
-                uint32_t index = node_hash(metadata, node) & mask;
-                new_nodes[index] = node;
+                uint32_t stored = hash->hashes[index];
+                uint32_t new_index = stored & mask;
+
+                while (new_nodes[new_index] != NULL) new_index = (new_index + 1) & mask;
+                new_nodes[new_index] = node;
+                new_hashes[new_index] = stored;
             }
         }
 
         // Finally, free the old node list and update the hash.
-        xfree(hash->nodes);
+        if (hash->capacity > 0) xfree(hash->nodes);
         hash->nodes = new_nodes;
+        hash->hashes = new_hashes;
         hash->capacity = new_capacity;
     }
 
     // Now, insert the node into the hash.
     uint32_t mask = hash->capacity - 1;
-    uint32_t index = node_hash(metadata, node) & mask;
+    uint32_t hashed = node_hash(metadata, node);
+    uint32_t index = hashed & mask;
 
     // We use linear probing to resolve collisions. This means that if the
     // current index is occupied, we will move to the next index and try again.
     // We are guaranteed that this will eventually find an empty slot because we
-    // resize the hash when it gets too full.
+    // resize the hash when it gets too full. Equivalent nodes always have the
+    // same hash, so we only need to compare nodes whose hashes match.
     while (hash->nodes[index] != NULL) {
-        if (compare(metadata, hash->nodes[index], node) == 0) break;
+        if (hash->hashes[index] == hashed && compare(metadata, hash->nodes[index], node) == 0) break;
         index = (index + 1) & mask;
     }
 
@@ -205,6 +216,7 @@ pm_node_hash_insert(pm_node_hash_t *hash, const pm_static_literals_metadata_t *m
     if (result == NULL) hash->size++;
 
     hash->nodes[index] = node;
+    hash->hashes[index] = hashed;
     return result;
 }
 
@@ -0,0 +1,50 @@
+// clock_gettime is only declared when POSIX features are requested.
+#define _POSIX_C_SOURCE 200809L
+
+#include "prism.h"
+
+#ifdef PRISM_BUILD_STATS
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/**
+ * Return the current value of a monotonic clock in nanoseconds.
+ */
+uint64_t
+pm_stats_time(void) {
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (uint64_t) ((double) counter.QuadPart * 1e9 / (double) frequency.QuadPart);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+#endif
+}
+
+#endif
+
+/**
+ * Copy the statistics that the given parser has collected into the given
+ * struct, or return false if prism was not built to collect them.
+ */
+PRISM_EXPORTED_FUNCTION bool
+pm_parser_stats(const pm_parser_t *parser, pm_parser_stats_t *stats) {
+#ifdef PRISM_BUILD_STATS
+    *stats = parser->stats;
+    stats->constant_pool_inserts = parser->constant_pool.inserts;
+    stats->constant_pool_collisions = parser->constant_pool.collisions;
+    return true;
+#else
+    (void) parser;
+    (void) stats;
+    return false;
+#endif
+}
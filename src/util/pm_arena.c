@@ -0,0 +1,198 @@
+#include "prism/util/pm_arena.h"
+
+/**
+ * This struct is used to determine the alignment that every allocation out of
+ * the arena needs to respect. It covers every scalar type that is found inside
+ * of the nodes in the syntax tree.
+ */
+typedef struct {
+    /** A leading byte to force padding before the value. */
+    char padding;
+
+    /** A union of the most strictly aligned types we store. */
+    union {
+        void *pointer;
+        double floating;
+        uint64_t integer;
+        size_t size;
+    } value;
+} pm_arena_alignment_t;
+
+/**
+ * The alignment of every allocation that is handed out by the arena.
+ */
+#define PM_ARENA_ALIGNMENT (offsetof(pm_arena_alignment_t, value))
+
+/**
+ * Round the given size up to the nearest multiple of the arena alignment.
+ */
+static inline size_t
+pm_arena_align(size_t size) {
+    return (size + (PM_ARENA_ALIGNMENT - 1)) & ~(PM_ARENA_ALIGNMENT - 1);
+}
+
+/**
+ * The offset from the start of a block to the first byte of memory that can be
+ * handed out.
+ */
+#define PM_ARENA_HEADER_SIZE (pm_arena_align(sizeof(pm_arena_block_t)))
+
+/**
+ * Return a pointer to the first byte of memory that has not yet been handed out
+ * by the given block.
+ */
+static inline uint8_t *
+pm_arena_block_cursor(pm_arena_block_t *block) {
+    return ((uint8_t *) block) + PM_ARENA_HEADER_SIZE + block->size;
+}
+
+/**
+ * Initialize an arena with a hint as to how much memory it is going to need.
+ */
+void
+pm_arena_init(pm_arena_t *arena, size_t size_hint) {
+    size_t next_block_size = PM_ARENA_BLOCK_SIZE_MIN;
+    while (next_block_size < size_hint && next_block_size < PM_ARENA_BLOCK_SIZE_MAX) next_block_size *= 2;
+
+    *arena = (pm_arena_t) {
+        .current = NULL,
+        .next_block_size = next_block_size,
+        .capacity = 0
+    };
+}
+
+/**
+ * Allocate a new block that is large enough to hold at least the given number
+ * of bytes and push it onto the arena.
+ */
+static bool
+pm_arena_block_push(pm_arena_t *arena, size_t size) {
+    size_t capacity = arena->next_block_size == 0 ? PM_ARENA_BLOCK_SIZE_MIN : arena->next_block_size;
+    if (capacity < size) capacity = pm_arena_align(size);
+
+    pm_arena_block_t *block = (pm_arena_block_t *) xmalloc(PM_ARENA_HEADER_SIZE + capacity);
+    if (block == NULL) return false;
+
+    *block = (pm_arena_block_t) {
+        .previous = arena->current,
+        .capacity = capacity,
+        .size = 0
+    };
+
+    arena->current = block;
+    arena->capacity += capacity;
+
+    if (arena->next_block_size < PM_ARENA_BLOCK_SIZE_MAX) {
+        arena->next_block_size = (arena->next_block_size == 0 ? PM_ARENA_BLOCK_SIZE_MIN : arena->next_block_size) * 2;
+    }
+
+    return true;
+}
+
+/**
+ * Allocate memory from the arena.
+ */
+void *
+pm_arena_alloc(pm_arena_t *arena, size_t size) {
+    size_t aligned_size = pm_arena_align(size == 0 ? 1 : size);
+    pm_arena_block_t *block = arena->current;
+
+    if (block == NULL || (block->capacity - block->size) < aligned_size) {
+        if (!pm_arena_block_push(arena, aligned_size)) return NULL;
+        block = arena->current;
+    }
+
+    void *memory = pm_arena_block_cursor(block);
+    block->size += aligned_size;
+    return memory;
+}
+
+/**
+ * Resize an allocation that was previously made from the arena.
+ */
+void *
+pm_arena_realloc(pm_arena_t *arena, void *pointer, size_t old_size, size_t new_size) {
+    if (pointer == NULL) return pm_arena_alloc(arena, new_size);
+
+    pm_arena_block_t *block = arena->current;
+    size_t old_aligned = pm_arena_align(old_size == 0 ? 1 : old_size);
+    size_t new_aligned = pm_arena_align(new_size == 0 ? 1 : new_size);
+
+    // If this was the most recent allocation in the current block, then we can
+    // attempt to grow or shrink it in place.
+    if (block != NULL && ((uint8_t *) pointer) + old_aligned == pm_arena_block_cursor(block)) {
+        size_t base = block->size - old_aligned;
+
+        if (block->capacity - base >= new_aligned) {
+            block->size = base + new_aligned;
+            return pointer;
+        }
+    }
+
+    if (new_size <= old_size) return pointer;
+
+    void *memory = pm_arena_alloc(arena, new_size);
+    if (memory == NULL) return NULL;
+
+    memcpy(memory, pointer, old_size);
+    return memory;
+}
+
+/**
+ * Copy the given bytes into memory allocated from the arena.
+ */
+void *
+pm_arena_memdup(pm_arena_t *arena, const void *source, size_t size) {
+    void *memory = pm_arena_alloc(arena, size);
+    if (memory != NULL && size > 0) memcpy(memory, source, size);
+    return memory;
+}
+
+/**
+ * Returns the number of bytes that have been allocated for blocks within the
+ * arena.
+ */
+size_t
+pm_arena_memsize(const pm_arena_t *arena) {
+    return arena->capacity;
+}
+
+/**
+ * Release every allocation that has been made from the arena while retaining
+ * its memory for future allocations.
+ */
+void
+pm_arena_reset(pm_arena_t *arena) {
+    pm_arena_block_t *block = arena->current;
+    if (block == NULL) return;
+
+    // If there is more than one block, then replace all of them with a single
+    // block that can hold everything, so the next use of the arena of a similar
+    // size only needs one block.
+    if (block->previous != NULL) {
+        size_t capacity = arena->capacity;
+        pm_arena_free(arena);
+
+        if (!pm_arena_block_push(arena, capacity)) return;
+        block = arena->current;
+    }
+
+    block->size = 0;
+}
+
+/**
+ * Free all of the memory associated with the arena.
+ */
+PRISM_EXPORTED_FUNCTION void
+pm_arena_free(pm_arena_t *arena) {
+    pm_arena_block_t *block = arena->current;
+
+    while (block != NULL) {
+        pm_arena_block_t *previous = block->previous;
+        xfree(block);
+        block = previous;
+    }
+
+    arena->current = NULL;
+    arena->capacity = 0;
+}
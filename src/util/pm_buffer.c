@@ -44,6 +44,25 @@ pm_buffer_length(const pm_buffer_t *buffer) {
     return buffer->length;
 }
 
+/**
+ * Grow the buffer so that it can hold at least the given number of bytes. The
+ * capacity at least doubles so that appending stays amortized constant time,
+ * but if more than that is needed then it grows directly to the requested size
+ * instead of doubling repeatedly.
+ */
+static bool
+pm_buffer_grow(pm_buffer_t *buffer, size_t capacity) {
+    size_t next_capacity = buffer->capacity * 2;
+    if (next_capacity < capacity) next_capacity = capacity;
+
+    char *value = xrealloc(buffer->value, next_capacity);
+    if (value == NULL) return false;
+
+    buffer->value = value;
+    buffer->capacity = next_capacity;
+    return true;
+}
+
 /**
  * Append the given amount of space to the buffer.
  */
@@ -51,23 +70,24 @@ static inline bool
 pm_buffer_append_length(pm_buffer_t *buffer, size_t length) {
     size_t next_length = buffer->length + length;
 
-    if (next_length > buffer->capacity) {
-        if (buffer->capacity == 0) {
-            buffer->capacity = 1;
-        }
-
-        while (next_length > buffer->capacity) {
-            buffer->capacity *= 2;
-        }
-
-        buffer->value = xrealloc(buffer->value, buffer->capacity);
-        if (buffer->value == NULL) return false;
+    if (next_length > buffer->capacity && !pm_buffer_grow(buffer, next_length)) {
+        return false;
     }
 
     buffer->length = next_length;
     return true;
 }
 
+/**
+ * Ensure that the buffer has space for at least the given number of additional
+ * bytes.
+ */
+bool
+pm_buffer_reserve(pm_buffer_t *buffer, size_t length) {
+    size_t next_length = buffer->length + length;
+    return next_length <= buffer->capacity || pm_buffer_grow(buffer, next_length);
+}
+
 /**
  * Append a generic pointer to memory to the buffer.
  */
@@ -133,8 +153,8 @@ pm_buffer_append_bytes(pm_buffer_t *buffer, const uint8_t *value, size_t length)
  */
 void
 pm_buffer_append_byte(pm_buffer_t *buffer, uint8_t value) {
-    const void *source = &value;
-    pm_buffer_append(buffer, source, sizeof(uint8_t));
+    if (buffer->length == buffer->capacity && !pm_buffer_grow(buffer, buffer->length + 1)) return;
+    buffer->value[buffer->length++] = (char) value;
 }
 
 /**
@@ -142,16 +162,18 @@ pm_buffer_append_byte(pm_buffer_t *buffer, uint8_t value) {
  */
 void
 pm_buffer_append_varuint(pm_buffer_t *buffer, uint32_t value) {
-    if (value < 128) {
-        pm_buffer_append_byte(buffer, (uint8_t) value);
-    } else {
-        uint32_t n = value;
-        while (n >= 128) {
-            pm_buffer_append_byte(buffer, (uint8_t) (n | 128));
-            n >>= 7;
-        }
-        pm_buffer_append_byte(buffer, (uint8_t) n);
+    // A 32-bit value takes at most 5 bytes, so check the capacity once up
+    // front instead of for every byte.
+    if (!pm_buffer_reserve(buffer, 5)) return;
+    uint8_t *cursor = (uint8_t *) buffer->value + buffer->length;
+
+    while (value >= 128) {
+        *cursor++ = (uint8_t) (value | 128);
+        value >>= 7;
     }
+
+    *cursor++ = (uint8_t) value;
+    buffer->length = (size_t) (cursor - (uint8_t *) buffer->value);
 }
 
 /**
@@ -163,6 +185,25 @@ pm_buffer_append_varsint(pm_buffer_t *buffer, int32_t value) {
     pm_buffer_append_varuint(buffer, unsigned_int);
 }
 
+/**
+ * Append a 32-bit unsigned integer to the buffer as decimal digits. This is
+ * used in place of pm_buffer_append_format when writing out many numbers, as
+ * it skips parsing a format string.
+ */
+void
+pm_buffer_append_decimal(pm_buffer_t *buffer, uint32_t value) {
+    // A 32-bit value takes at most 10 digits.
+    char digits[10];
+    size_t index = sizeof(digits);
+
+    do {
+        digits[--index] = (char) ('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+
+    pm_buffer_append_string(buffer, digits + index, sizeof(digits) - index);
+}
+
 /**
  * Append a double to the buffer.
  */
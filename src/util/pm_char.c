@@ -1,8 +1,16 @@
 #include "prism/util/pm_char.h"
 
+#if defined(PRISM_HAS_SSE2)
+#include <emmintrin.h>
+#elif defined(PRISM_HAS_NEON)
+#include <arm_neon.h>
+#endif
+
 #define PRISM_CHAR_BIT_WHITESPACE (1 << 0)
 #define PRISM_CHAR_BIT_INLINE_WHITESPACE (1 << 1)
 #define PRISM_CHAR_BIT_REGEXP_OPTION (1 << 2)
+#define PRISM_CHAR_BIT_BLANK (1 << 3)
+#define PRISM_CHAR_BIT_IDENTIFIER (1 << 4)
 
 #define PRISM_NUMBER_BIT_BINARY_DIGIT (1 << 0)
 #define PRISM_NUMBER_BIT_BINARY_NUMBER (1 << 1)
@@ -14,23 +22,23 @@
 #define PRISM_NUMBER_BIT_HEXADECIMAL_NUMBER (1 << 7)
 
 static const uint8_t pm_byte_table[256] = {
-//  0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 1, 3, 3, 3, 0, 0, // 0x
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 1x
-    3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 2x
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 3x
-    0, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, // 4x
-    4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 0, 0, 0, 0, 0, // 5x
-    0, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, // 6x
-    4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 0, 0, 0, 0, 0, // 7x
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 8x
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 9x
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // Ax
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // Bx
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // Cx
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // Dx
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // Ex
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // Fx
+    // 0     1     2     3     4     5     6     7     8     9     A     B     C     D     E     F
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0b, 0x01, 0x0b, 0x0b, 0x03, 0x00, 0x00, // 0x
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 1x
+    0x0b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 2x
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 3x
+    0x00, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, // 4x
+    0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x00, 0x00, 0x00, 0x00, 0x10, // 5x
+    0x00, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, // 6x
+    0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, // 7x
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 8x
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 9x
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // Ax
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // Bx
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // Cx
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // Dx
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // Ex
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // Fx
 };
 
 static const uint8_t pm_number_table[256] = {
@@ -53,6 +61,262 @@ static const uint8_t pm_number_table[256] = {
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // Fx
 };
 
+/**
+ * The characters that match each of the whitespace kinds, in the order that
+ * they are most likely to be found in source files.
+ */
+static const uint8_t pm_whitespace_set[] = { ' ', '\n', '\t', '\r', '\f', '\v' };
+static const uint8_t pm_inline_whitespace_set[] = { ' ', '\t', '\r', '\f', '\v' };
+static const uint8_t pm_blank_set[] = { ' ', '\t', '\f', '\v' };
+
+/**
+ * The number of bytes that are checked one at a time before a span of
+ * whitespace is searched in bulk.
+ */
+#define PM_STRSPN_SET_THRESHOLD 16
+
+#if defined(PRISM_HAS_SSE2)
+
+/**
+ * Returns the number of bytes at the start of the string that are within the
+ * given set, looking at 16 bytes at a time using SSE2. If a newline list is
+ * given, then every newline that is skipped is appended to it. This may stop
+ * short of the end of the span if fewer than 16 bytes remain, in which case the
+ * caller is expected to finish the search.
+ */
+static inline size_t
+pm_strspn_set(const uint8_t *string, size_t maximum, const uint8_t *set, size_t set_length, pm_newline_list_t *newline_list) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t size = 0;
+
+    while (size + 16 <= maximum) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *) (string + size));
+
+        __m128i matches = _mm_cmpeq_epi8(chunk, _mm_set1_epi8((char) set[0]));
+        for (size_t index = 1; index < set_length; index++) {
+            matches = _mm_or_si128(matches, _mm_cmpeq_epi8(chunk, _mm_set1_epi8((char) set[index])));
+        }
+
+        uint32_t mask = ((uint32_t) _mm_movemask_epi8(matches)) ^ 0xFFFF;
+        size_t length = mask == 0 ? 16 : (size_t) __builtin_ctz(mask);
+
+        if (newline_list != NULL) {
+            uint32_t newlines = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+            if (length < 16) newlines &= (1U << length) - 1;
+
+            while (newlines != 0) {
+                pm_newline_list_append(newline_list, string + size + (size_t) __builtin_ctz(newlines));
+                newlines &= newlines - 1;
+            }
+        }
+
+        size += length;
+        if (length < 16) break;
+    }
+
+    return size;
+}
+
+#elif defined(PRISM_HAS_NEON)
+
+/**
+ * Returns the number of bytes at the start of the string that are within the
+ * given set, looking at 16 bytes at a time using NEON. If a newline list is
+ * given, then every newline that is skipped is appended to it. This may stop
+ * short of the end of the span if fewer than 16 bytes remain, in which case the
+ * caller is expected to finish the search.
+ */
+static inline size_t
+pm_strspn_set(const uint8_t *string, size_t maximum, const uint8_t *set, size_t set_length, pm_newline_list_t *newline_list) {
+    const uint8x16_t newline = vdupq_n_u8('\n');
+    size_t size = 0;
+
+    while (size + 16 <= maximum) {
+        uint8x16_t chunk = vld1q_u8(string + size);
+
+        uint8x16_t matches = vceqq_u8(chunk, vdupq_n_u8(set[0]));
+        for (size_t index = 1; index < set_length; index++) {
+            matches = vorrq_u8(matches, vceqq_u8(chunk, vdupq_n_u8(set[index])));
+        }
+
+        // Narrow each 16-bit lane by 4 bits, which leaves a 64-bit mask with
+        // one nibble per byte of the chunk.
+        uint64_t mask = ~vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+        size_t length = mask == 0 ? 16 : (((size_t) __builtin_ctzll(mask)) >> 2);
+
+        if (newline_list != NULL) {
+            uint64_t newlines = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(chunk, newline)), 4)), 0);
+            if (length < 16) newlines &= (((uint64_t) 1) << (length * 4)) - 1;
+
+            while (newlines != 0) {
+                pm_newline_list_append(newline_list, string + size + (((size_t) __builtin_ctzll(newlines)) >> 2));
+                newlines &= ~(((uint64_t) 0xF) << (__builtin_ctzll(newlines) & ~3));
+            }
+        }
+
+        size += length;
+        if (length < 16) break;
+    }
+
+    return size;
+}
+
+#else
+
+/**
+ * Returns the number of bytes at the start of the string that are within the
+ * given set, looking at 8 bytes at a time by treating them as a single 64-bit
+ * word. This stops at the first word that contains a byte outside of the set,
+ * or that contains a newline when a newline list is given. The caller is
+ * expected to finish the search from there.
+ */
+static inline size_t
+pm_strspn_set(const uint8_t *string, size_t maximum, const uint8_t *set, size_t set_length, pm_newline_list_t *newline_list) {
+    static const uint64_t ones = 0x0101010101010101ULL;
+    static const uint64_t lows = 0x7F7F7F7F7F7F7F7FULL;
+    static const uint64_t highs = 0x8080808080808080ULL;
+    size_t size = 0;
+
+    while (size + 8 <= maximum) {
+        uint64_t chunk;
+        memcpy(&chunk, string + size, sizeof(chunk));
+        if (newline_list != NULL && (((chunk ^ (ones * '\n')) - ones) & ~(chunk ^ (ones * '\n')) & highs) != 0) break;
+
+        // The high bit of each byte in ((word & lows) + lows) | word is set
+        // exactly when that byte of word is not zero. This does not suffer
+        // from the false positives of the cheaper subtraction based check,
+        // which matters here because every byte must be matched.
+        uint64_t matches = 0;
+        for (size_t index = 0; index < set_length; index++) {
+            uint64_t word = chunk ^ (ones * set[index]);
+            matches |= ~(((word & lows) + lows) | word) & highs;
+        }
+
+        if (matches != highs) break;
+        size += 8;
+    }
+
+    return size;
+}
+
+#endif
+
+#if defined(PRISM_HAS_SSE2)
+
+/**
+ * Returns the number of bytes at the start of the string that are ASCII
+ * letters, digits, or underscores, looking at 16 bytes at a time using SSE2.
+ * This may stop short of the end of the span if fewer than 16 bytes remain, in
+ * which case the caller is expected to finish the search.
+ */
+static inline size_t
+pm_strspn_identifier_chunks(const uint8_t *string, size_t maximum) {
+    size_t size = 0;
+
+    while (size + 16 <= maximum) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *) (string + size));
+
+        // Bytes of 0x80 and above are negative when compared as signed, so
+        // they fall outside of every range here.
+        __m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+        __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+        __m128i digits = _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1)));
+        __m128i underscores = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_'));
+
+        __m128i matches = _mm_or_si128(_mm_or_si128(letters, digits), underscores);
+        uint32_t mask = ((uint32_t) _mm_movemask_epi8(matches)) ^ 0xFFFF;
+
+        if (mask != 0) return size + (size_t) __builtin_ctz(mask);
+        size += 16;
+    }
+
+    return size;
+}
+
+/**
+ * Returns the number of bytes at the start of the string that are ASCII,
+ * looking at 16 bytes at a time using SSE2. This may stop short of the end of
+ * the span if fewer than 16 bytes remain, in which case the caller is expected
+ * to finish the search.
+ */
+static inline size_t
+pm_strspn_ascii_chunks(const uint8_t *string, size_t maximum) {
+    size_t size = 0;
+
+    while (size + 16 <= maximum) {
+        // The sign bit of each byte is set for every non-ASCII byte.
+        uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) (string + size)));
+
+        if (mask != 0) return size + (size_t) __builtin_ctz(mask);
+        size += 16;
+    }
+
+    return size;
+}
+
+#else
+
+/**
+ * Returns the number of bytes at the start of the string that are ASCII
+ * letters, digits, or underscores, looking at 8 bytes at a time by treating
+ * them as a single 64-bit word. This stops at the first word that contains a
+ * byte outside of the set, and the caller is expected to finish the search
+ * from there.
+ */
+static inline size_t
+pm_strspn_identifier_chunks(const uint8_t *string, size_t maximum) {
+    static const uint64_t ones = 0x0101010101010101ULL;
+    static const uint64_t lows = 0x7F7F7F7F7F7F7F7FULL;
+    static const uint64_t highs = 0x8080808080808080ULL;
+    size_t size = 0;
+
+    while (size + 8 <= maximum) {
+        uint64_t chunk;
+        memcpy(&chunk, string + size, sizeof(chunk));
+        if ((chunk & highs) != 0) break;
+
+        // Now that every byte is below 0x80, the high bit of each byte in
+        // chunk + ones * (0x80 - low) is set exactly when that byte is at least
+        // low, and in chunk + ones * (0x7F - high) exactly when that byte is
+        // greater than high. Neither sum can carry between bytes.
+        uint64_t lower = chunk | (ones * 0x20);
+        uint64_t letters = (lower + ones * (0x80 - 'a')) & ~(lower + ones * (0x7F - 'z'));
+        uint64_t digits = (chunk + ones * (0x80 - '0')) & ~(chunk + ones * (0x7F - '9'));
+
+        uint64_t word = chunk ^ (ones * '_');
+        uint64_t underscores = ~(((word & lows) + lows) | word);
+
+        if (((letters | digits | underscores) & highs) != highs) break;
+        size += 8;
+    }
+
+    return size;
+}
+
+/**
+ * Returns the number of bytes at the start of the string that are ASCII,
+ * looking at 8 bytes at a time by treating them as a single 64-bit word. This
+ * stops at the first word that contains a non-ASCII byte, and the caller is
+ * expected to finish the search from there.
+ */
+static inline size_t
+pm_strspn_ascii_chunks(const uint8_t *string, size_t maximum) {
+    static const uint64_t highs = 0x8080808080808080ULL;
+    size_t size = 0;
+
+    while (size + 8 <= maximum) {
+        uint64_t chunk;
+        memcpy(&chunk, string + size, sizeof(chunk));
+
+        if ((chunk & highs) != 0) break;
+        size += 8;
+    }
+
+    return size;
+}
+
+#endif
+
 /**
  * Returns the number of characters at the start of the string that match the
  * given kind. Disallows searching past the given maximum number of characters.
@@ -64,6 +328,25 @@ pm_strspn_char_kind(const uint8_t *string, ptrdiff_t length, uint8_t kind) {
     size_t size = 0;
     size_t maximum = (size_t) length;
 
+    // Most runs are short, so we check the first few bytes one at a time
+    // before switching over to searching in bulk.
+    while (size < maximum && size < PM_STRSPN_SET_THRESHOLD && (pm_byte_table[string[size]] & kind)) size++;
+    if (size < PM_STRSPN_SET_THRESHOLD) return size;
+
+    switch (kind) {
+        case PRISM_CHAR_BIT_WHITESPACE:
+            size += pm_strspn_set(string + size, maximum - size, pm_whitespace_set, sizeof(pm_whitespace_set), NULL);
+            break;
+        case PRISM_CHAR_BIT_INLINE_WHITESPACE:
+            size += pm_strspn_set(string + size, maximum - size, pm_inline_whitespace_set, sizeof(pm_inline_whitespace_set), NULL);
+            break;
+        case PRISM_CHAR_BIT_BLANK:
+            size += pm_strspn_set(string + size, maximum - size, pm_blank_set, sizeof(pm_blank_set), NULL);
+            break;
+        default:
+            break;
+    }
+
     while (size < maximum && (pm_byte_table[string[size]] & kind)) size++;
     return size;
 }
@@ -88,6 +371,7 @@ pm_strspn_whitespace_newlines(const uint8_t *string, ptrdiff_t length, pm_newlin
 
     size_t size = 0;
     size_t maximum = (size_t) length;
+    bool searched = false;
 
     while (size < maximum && (pm_byte_table[string[size]] & PRISM_CHAR_BIT_WHITESPACE)) {
         if (string[size] == '\n') {
@@ -95,6 +379,13 @@ pm_strspn_whitespace_newlines(const uint8_t *string, ptrdiff_t length, pm_newlin
         }
 
         size++;
+
+        // If this turns out to be a long run, then we switch over to
+        // searching in bulk.
+        if (!searched && size == PM_STRSPN_SET_THRESHOLD) {
+            size += pm_strspn_set(string + size, maximum - size, pm_whitespace_set, sizeof(pm_whitespace_set), newline_list);
+            searched = true;
+        }
     }
 
     return size;
@@ -109,6 +400,16 @@ pm_strspn_inline_whitespace(const uint8_t *string, ptrdiff_t length) {
     return pm_strspn_char_kind(string, length, PRISM_CHAR_BIT_INLINE_WHITESPACE);
 }
 
+/**
+ * Returns the number of characters at the start of the string that are spaces,
+ * tabs, form feeds, or vertical tabs. Disallows searching past the given
+ * maximum number of characters.
+ */
+size_t
+pm_strspn_blank(const uint8_t *string, ptrdiff_t length) {
+    return pm_strspn_char_kind(string, length, PRISM_CHAR_BIT_BLANK);
+}
+
 /**
  * Returns the number of characters at the start of the string that are regexp
  * options. Disallows searching past the given maximum number of characters.
@@ -118,6 +419,37 @@ pm_strspn_regexp_option(const uint8_t *string, ptrdiff_t length) {
     return pm_strspn_char_kind(string, length, PRISM_CHAR_BIT_REGEXP_OPTION);
 }
 
+/**
+ * Returns the number of characters at the start of the string that are ASCII
+ * letters, digits, or underscores. Disallows searching past the given maximum
+ * number of characters.
+ */
+size_t
+pm_strspn_identifier(const uint8_t *string, ptrdiff_t length) {
+    if (length <= 0) return 0;
+
+    size_t maximum = (size_t) length;
+    size_t size = pm_strspn_identifier_chunks(string, maximum);
+
+    while (size < maximum && (pm_byte_table[string[size]] & PRISM_CHAR_BIT_IDENTIFIER)) size++;
+    return size;
+}
+
+/**
+ * Returns the number of characters at the start of the string that are ASCII.
+ * Disallows searching past the given maximum number of characters.
+ */
+size_t
+pm_strspn_ascii(const uint8_t *string, ptrdiff_t length) {
+    if (length <= 0) return 0;
+
+    size_t maximum = (size_t) length;
+    size_t size = pm_strspn_ascii_chunks(string, maximum);
+
+    while (size < maximum && string[size] < 0x80) size++;
+    return size;
+}
+
 /**
  * Returns true if the given character matches the given kind.
  */
@@ -80,19 +80,70 @@ pm_constant_id_list_free(pm_constant_id_list_t *list) {
 }
 
 /**
- * A relatively simple hash function (djb2) that is used to hash strings. We are
- * optimizing here for simplicity and speed.
+ * Read 4 bytes from the given pointer into an integer, regardless of its
+ * alignment.
+ */
+static inline uint64_t
+pm_constant_pool_hash_read4(const uint8_t *source) {
+    uint32_t value;
+    memcpy(&value, source, sizeof(value));
+    return value;
+}
+
+/**
+ * Read 8 bytes from the given pointer into an integer, regardless of its
+ * alignment.
+ */
+static inline uint64_t
+pm_constant_pool_hash_read8(const uint8_t *source) {
+    uint64_t value;
+    memcpy(&value, source, sizeof(value));
+    return value;
+}
+
+/**
+ * Mix a word of input into the running value of the hash.
+ */
+static inline uint64_t
+pm_constant_pool_hash_mix(uint64_t value, uint64_t word) {
+    value ^= word * 0x87c37b91114253d5ULL;
+    value = (value << 31) | (value >> 33);
+    return value * 0x4cf5ad432745937fULL;
+}
+
+/**
+ * Hash a string a word at a time. Most constants are short identifiers, so
+ * strings shorter than a word are read with a couple of overlapping loads
+ * rather than one byte at a time. Overlapping reads are fine because the
+ * length is mixed into the hash as well. The result is finished with the
+ * murmur3 64-bit finalizer so that the low bits, which pick the bucket, depend
+ * on every byte of the input.
  */
 static inline uint32_t
 pm_constant_pool_hash(const uint8_t *start, size_t length) {
-    // This is a prime number used as the initial value for the hash function.
-    uint32_t value = 5381;
+    uint64_t value = 0x9e3779b97f4a7c15ULL ^ ((uint64_t) length);
+
+    if (length >= 8) {
+        const uint8_t *last = start + length - 8;
 
-    for (size_t index = 0; index < length; index++) {
-        value = ((value << 5) + value) + start[index];
+        for (const uint8_t *cursor = start; cursor < last; cursor += 8) {
+            value = pm_constant_pool_hash_mix(value, pm_constant_pool_hash_read8(cursor));
+        }
+
+        value = pm_constant_pool_hash_mix(value, pm_constant_pool_hash_read8(last));
+    } else if (length >= 4) {
+        value = pm_constant_pool_hash_mix(value, (pm_constant_pool_hash_read4(start) << 32) | pm_constant_pool_hash_read4(start + length - 4));
+    } else if (length > 0) {
+        value = pm_constant_pool_hash_mix(value, (((uint64_t) start[0]) << 16) | (((uint64_t) start[length >> 1]) << 8) | ((uint64_t) start[length - 1]));
     }
 
-    return value;
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+
+    return (uint32_t) value;
 }
 
 /**
@@ -193,6 +244,10 @@ pm_constant_pool_init(pm_constant_pool_t *pool, uint32_t capacity) {
     pool->constants = (void *)(((char *)memory) + capacity * sizeof(pm_constant_pool_bucket_t));
     pool->size = 0;
     pool->capacity = capacity;
+#ifdef PRISM_BUILD_STATS
+    pool->inserts = 0;
+    pool->collisions = 0;
+#endif
     return true;
 }
 
@@ -219,9 +274,13 @@ pm_constant_pool_find(const pm_constant_pool_t *pool, const uint8_t *start, size
     pm_constant_pool_bucket_t *bucket;
 
     while (bucket = &pool->buckets[index], bucket->id != PM_CONSTANT_ID_UNSET) {
-        pm_constant_t *constant = &pool->constants[bucket->id - 1];
-        if ((constant->length == length) && memcmp(constant->start, start, length) == 0) {
-            return bucket->id;
+        // Every bucket holds the full hash of its constant, so most
+        // mismatches are rejected without looking at the constant at all.
+        if (bucket->hash == hash) {
+            pm_constant_t *constant = &pool->constants[bucket->id - 1];
+            if ((constant->length == length) && memcmp(constant->start, start, length) == 0) {
+                return bucket->id;
+            }
         }
 
         index = (index + 1) & mask;
@@ -246,13 +305,19 @@ pm_constant_pool_insert(pm_constant_pool_t *pool, const uint8_t *start, size_t l
     uint32_t index = hash & mask;
     pm_constant_pool_bucket_t *bucket;
 
+#ifdef PRISM_BUILD_STATS
+    pool->inserts++;
+#endif
+
     while (bucket = &pool->buckets[index], bucket->id != PM_CONSTANT_ID_UNSET) {
         // If there is a collision, then we need to check if the content is the
         // same as the content we are trying to insert. If it is, then we can
-        // return the id of the existing constant.
+        // return the id of the existing constant. Every bucket holds the full
+        // hash of its constant, so most mismatches are rejected without
+        // looking at the constant at all.
         pm_constant_t *constant = &pool->constants[bucket->id - 1];
 
-        if ((constant->length == length) && memcmp(constant->start, start, length) == 0) {
+        if ((bucket->hash == hash) && (constant->length == length) && memcmp(constant->start, start, length) == 0) {
             // Since we have found a match, we need to check if this is
             // attempting to insert a shared or an owned constant. We want to
             // prefer shared constants since they don't require allocations.
@@ -263,17 +328,20 @@ pm_constant_pool_insert(pm_constant_pool_t *pool, const uint8_t *start, size_t l
                 // it's not necessary because we have a shared version.
                 xfree((void *) start);
             } else if (bucket->type == PM_CONSTANT_POOL_BUCKET_OWNED) {
-                // If we're attempting to insert a shared constant and the
-                // existing constant is owned, then we can free the owned
-                // constant and replace it with the shared constant.
+                // If we're attempting to insert a shared or constant constant
+                // and the existing constant is owned, then we can free the
+                // owned constant and replace it with the one being inserted.
                 xfree((void *) constant->start);
                 constant->start = start;
-                bucket->type = (unsigned int) (PM_CONSTANT_POOL_BUCKET_DEFAULT & 0x3);
+                bucket->type = (unsigned int) (type & 0x3);
             }
 
             return bucket->id;
         }
 
+#ifdef PRISM_BUILD_STATS
+        pool->collisions++;
+#endif
         index = (index + 1) & mask;
     }
 
@@ -312,6 +380,15 @@ pm_constant_pool_insert_shared(pm_constant_pool_t *pool, const uint8_t *start, s
  */
 pm_constant_id_t
 pm_constant_pool_insert_owned(pm_constant_pool_t *pool, uint8_t *start, size_t length) {
+    // If this is one of the common constants, then we can point at its static
+    // copy instead of holding on to the given memory.
+    pm_constant_id_t common_id = pm_constant_pool_common_find(start, length);
+
+    if (common_id != PM_CONSTANT_ID_UNSET) {
+        xfree(start);
+        return pm_constant_pool_insert(pool, pm_constant_pool_common_constant(common_id)->start, length, PM_CONSTANT_POOL_BUCKET_CONSTANT);
+    }
+
     return pm_constant_pool_insert(pool, start, length, PM_CONSTANT_POOL_BUCKET_OWNED);
 }
 
@@ -326,10 +403,10 @@ pm_constant_pool_insert_constant(pm_constant_pool_t *pool, const uint8_t *start,
 }
 
 /**
- * Free the memory associated with a constant pool.
+ * Free the contents of every constant that is owned by the pool.
  */
-void
-pm_constant_pool_free(pm_constant_pool_t *pool) {
+static void
+pm_constant_pool_free_owned(pm_constant_pool_t *pool) {
     // For each constant in the current constant pool, free the contents if the
     // contents are owned.
     for (uint32_t index = 0; index < pool->capacity; index++) {
@@ -341,6 +418,28 @@ pm_constant_pool_free(pm_constant_pool_t *pool) {
             xfree((void *) constant->start);
         }
     }
+}
 
+/**
+ * Remove all of the constants from a constant pool while keeping its buckets
+ * allocated.
+ */
+void
+pm_constant_pool_clear(pm_constant_pool_t *pool) {
+    pm_constant_pool_free_owned(pool);
+    memset(pool->buckets, 0, pool->capacity * sizeof(pm_constant_pool_bucket_t));
+    pool->size = 0;
+#ifdef PRISM_BUILD_STATS
+    pool->inserts = 0;
+    pool->collisions = 0;
+#endif
+}
+
+/**
+ * Free the memory associated with a constant pool.
+ */
+void
+pm_constant_pool_free(pm_constant_pool_t *pool) {
+    pm_constant_pool_free_owned(pool);
     xfree(pool->buckets);
 }
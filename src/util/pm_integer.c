@@ -442,11 +442,108 @@ pm_integer_parse_decimal(pm_integer_t *integer, const uint8_t *digits, size_t di
     xfree(values);
 }
 
+/**
+ * The number of 32-bit values below which integers are converted with
+ * schoolbook multiplication and division directly on the values, instead of
+ * going through pm_integer_convert_base. Below this size the quadratic
+ * algorithms win because they need a single allocation, whereas the
+ * divide-and-conquer conversion allocates at every level.
+ */
+#define PM_INTEGER_SCHOOLBOOK_LENGTH 64
+
+/**
+ * The number of values that are kept on the stack while parsing an integer
+ * with schoolbook multiplication, which is enough for a 512-bit integer.
+ */
+#define PM_INTEGER_STACK_LENGTH 16
+
+/**
+ * Multiply the given little-endian base 1<<32 values by the given factor and
+ * add the given addend, in place. Returns the new length of the values, which
+ * grows by at most one.
+ */
+static inline size_t
+pm_integer_multiply_add(uint32_t *values, size_t length, uint32_t factor, uint32_t addend) {
+    uint64_t carry = addend;
+
+    for (size_t index = 0; index < length; index++) {
+        uint64_t product = (uint64_t) values[index] * factor + carry;
+        values[index] = (uint32_t) product;
+        carry = product >> 32;
+    }
+
+    if (carry > 0) values[length++] = (uint32_t) carry;
+    return length;
+}
+
+/**
+ * Parse an integer by accumulating as many digits as fit in a uint32_t at a
+ * time and multiplying them into the values directly. The digits are read
+ * straight from the source, so the only allocation is the final copy of the
+ * values.
+ */
+static void
+pm_integer_parse_schoolbook(pm_integer_t *integer, uint32_t multiplier, const uint8_t *start, const uint8_t *end, size_t capacity) {
+    uint32_t stack_values[PM_INTEGER_STACK_LENGTH];
+    uint32_t *values = stack_values;
+
+    if (capacity > PM_INTEGER_STACK_LENGTH) {
+        values = (uint32_t *) xmalloc(sizeof(uint32_t) * capacity);
+        if (values == NULL) return;
+    }
+
+    // The largest power of the multiplier that fits into a uint32_t, which is
+    // how many digits we can batch together before multiplying.
+    uint32_t batch = 1;
+    while ((uint64_t) batch * multiplier <= UINT32_MAX) batch *= multiplier;
+
+    size_t length = 0;
+    uint32_t factor = 1;
+    uint32_t value = 0;
+
+    for (; start < end; start++) {
+        if (*start == '_') continue;
+
+        value = value * multiplier + pm_integer_parse_digit(*start);
+        factor *= multiplier;
+
+        if (factor == batch) {
+            length = pm_integer_multiply_add(values, length, factor, value);
+            factor = 1;
+            value = 0;
+        }
+    }
+
+    if (factor > 1) length = pm_integer_multiply_add(values, length, factor, value);
+    while (length > 1 && values[length - 1] == 0) length--;
+
+    if (length <= 1) {
+        *integer = (pm_integer_t) { .value = length == 0 ? 0 : values[0], .length = 0, .values = NULL, .negative = false };
+    } else if (values == stack_values) {
+        uint32_t *copied = (uint32_t *) xmalloc(sizeof(uint32_t) * length);
+        if (copied == NULL) return;
+
+        memcpy(copied, values, sizeof(uint32_t) * length);
+        *integer = (pm_integer_t) { .value = 0, .length = length, .values = copied, .negative = false };
+    } else {
+        *integer = (pm_integer_t) { .value = 0, .length = length, .values = values, .negative = false };
+    }
+}
+
 /**
  * Parse a large integer from a string that does not fit into uint32_t.
  */
 static void
 pm_integer_parse_big(pm_integer_t *integer, uint32_t multiplier, const uint8_t *start, const uint8_t *end) {
+    // Every digit holds at most 4 bits, so this is an upper bound on the
+    // number of values (with room for the final carry).
+    size_t capacity = (((size_t) (end - start)) * 4 + 31) / 32 + 1;
+
+    if (capacity <= PM_INTEGER_SCHOOLBOOK_LENGTH) {
+        pm_integer_parse_schoolbook(integer, multiplier, start, end, capacity);
+        return;
+    }
+
     // Allocate an array to store digits.
     uint8_t *digits = xmalloc(sizeof(uint8_t) * (size_t) (end - start));
     size_t digits_length = 0;
@@ -608,6 +705,42 @@ void pm_integers_reduce(pm_integer_t *numerator, pm_integer_t *denominator) {
     denominator->value /= divisor;
 }
 
+/**
+ * Convert a positive integer with at most PM_INTEGER_SCHOOLBOOK_LENGTH values
+ * to a decimal string using schoolbook division.
+ */
+static void
+pm_integer_string_schoolbook(pm_buffer_t *buffer, const pm_integer_t *integer) {
+    uint32_t values[PM_INTEGER_SCHOOLBOOK_LENGTH];
+    size_t length = integer->length;
+    memcpy(values, integer->values, sizeof(uint32_t) * length);
+
+    // Each value holds fewer than 10 decimal digits.
+    char digits[PM_INTEGER_SCHOOLBOOK_LENGTH * 10];
+    size_t start_offset = sizeof(digits);
+
+    while (length > 0) {
+        uint64_t remainder = 0;
+
+        for (size_t index = length; index > 0; index--) {
+            uint64_t dividend = (remainder << 32) | values[index - 1];
+            values[index - 1] = (uint32_t) (dividend / 1000000000);
+            remainder = dividend % 1000000000;
+        }
+
+        while (length > 0 && values[length - 1] == 0) length--;
+
+        // Every group of digits is zero-padded to 9 digits except for the
+        // most significant one.
+        for (size_t digit_index = 0; digit_index < 9 && (length > 0 || remainder > 0); digit_index++) {
+            digits[--start_offset] = (char) ('0' + remainder % 10);
+            remainder /= 10;
+        }
+    }
+
+    pm_buffer_append_string(buffer, digits + start_offset, sizeof(digits) - start_offset);
+}
+
 /**
  * Convert an integer to a decimal string.
  */
@@ -632,6 +765,13 @@ pm_integer_string(pm_buffer_t *buffer, const pm_integer_t *integer) {
         return;
     }
 
+    // If the integer is small enough, then repeatedly divide a copy of it by
+    // 10**9 and write out the remainders from the end.
+    if (integer->length <= PM_INTEGER_SCHOOLBOOK_LENGTH) {
+        pm_integer_string_schoolbook(buffer, integer);
+        return;
+    }
+
     // Otherwise, first we'll convert the base from 1<<32 to 10**9.
     pm_integer_t converted = { 0 };
     pm_integer_convert_base(&converted, integer, (uint64_t) 1 << 32, 1000000000);
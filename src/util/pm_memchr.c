@@ -1,4 +1,5 @@
 #include "prism/util/pm_memchr.h"
+#include "prism/util/pm_char.h"
 
 #define PRISM_MEMCHR_TRAILING_BYTE_MINIMUM 0x40
 
@@ -14,6 +15,18 @@ pm_memchr(const void *memory, int character, size_t number, bool encoding_change
         size_t index = 0;
 
         while (index < number) {
+            // Every byte in a run of ASCII is a character on its own, so the
+            // run cannot hold a trailing byte and can be searched in bulk.
+            size_t ascii = pm_strspn_ascii(source + index, (ptrdiff_t) (number - index));
+
+            if (ascii > 0) {
+                const void *found = memchr(source + index, character, ascii);
+                if (found != NULL) return (void *) found;
+
+                index += ascii;
+                continue;
+            }
+
             if (source[index] == character) {
                 return (void *) (source + index);
             }
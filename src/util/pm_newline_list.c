@@ -1,5 +1,11 @@
 #include "prism/util/pm_newline_list.h"
 
+#if defined(PRISM_HAS_SSE2)
+#include <emmintrin.h>
+#elif defined(PRISM_HAS_NEON)
+#include <arm_neon.h>
+#endif
+
 /**
  * Initialize a new newline list with the given capacity. Returns true if the
  * allocation of the offsets succeeds, otherwise returns false.
@@ -15,7 +21,116 @@ pm_newline_list_init(pm_newline_list_t *list, const uint8_t *start, size_t capac
     // file as having offset 0, which is set because of calloc.
     list->size = 1;
     list->capacity = capacity;
+    list->indexed = false;
+
+    return true;
+}
+
+/**
+ * Ensure that the list has room for at least the given number of additional
+ * offsets, growing it geometrically if it does not.
+ */
+static inline bool
+pm_newline_list_reserve(pm_newline_list_t *list, size_t additional) {
+    if (list->size + additional <= list->capacity) return true;
+
+    size_t capacity = list->capacity < 4 ? 4 : list->capacity;
+    while (capacity < list->size + additional) capacity = (capacity * 3) / 2;
+
+    size_t *offsets = (size_t *) xrealloc(list->offsets, capacity * sizeof(size_t));
+    if (offsets == NULL) return false;
 
+    list->offsets = offsets;
+    list->capacity = capacity;
+    return true;
+}
+
+/**
+ * Append the offset of every newline in the source to the list in a single
+ * pass.
+ */
+static bool
+pm_newline_list_index_fill(pm_newline_list_t *list, const uint8_t *start, size_t length) {
+    if (!pm_newline_list_reserve(list, length / 22)) return false;
+    list->offsets[0] = 0;
+
+    size_t index = 0;
+
+#if defined(PRISM_HAS_SSE2)
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    for (; index + 16 <= length; index += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *) (start + index));
+        uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        if (mask == 0) continue;
+
+        if (!pm_newline_list_reserve(list, 16)) return false;
+        while (mask != 0) {
+            list->offsets[list->size++] = index + (size_t) __builtin_ctz(mask) + 1;
+            mask &= mask - 1;
+        }
+    }
+#elif defined(PRISM_HAS_NEON)
+    const uint8x16_t newline = vdupq_n_u8('\n');
+
+    for (; index + 16 <= length; index += 16) {
+        uint8x16_t matches = vceqq_u8(vld1q_u8(start + index), newline);
+
+        // Narrow each 16-bit lane by 4 bits, which leaves a 64-bit mask with
+        // one nibble per byte of the chunk.
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0) & 0x8888888888888888ULL;
+        if (mask == 0) continue;
+
+        if (!pm_newline_list_reserve(list, 16)) return false;
+        while (mask != 0) {
+            list->offsets[list->size++] = index + (((size_t) __builtin_ctzll(mask)) >> 2) + 1;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    // Note that it's okay for us to use memchr here to look for \n because
+    // none of the encodings that we support have \n as a component of a
+    // multi-byte character.
+    const uint8_t *end = start + length;
+    const uint8_t *cursor = start + index;
+
+    while (cursor < end && (cursor = memchr(cursor, '\n', (size_t) (end - cursor))) != NULL) {
+        if (!pm_newline_list_reserve(list, 1)) return false;
+        list->offsets[list->size++] = (size_t) (++cursor - start);
+    }
+
+    return true;
+}
+
+/**
+ * Fill the list with the offset of every newline in the source. If the list
+ * had to grow, it is shrunk to fit exactly at the end.
+ */
+bool
+pm_newline_list_index(pm_newline_list_t *list, const uint8_t *start, size_t length) {
+    size_t capacity = list->capacity;
+
+    list->start = start;
+    list->size = 1;
+
+    if (!pm_newline_list_index_fill(list, start, length)) {
+        list->size = 1;
+        return false;
+    }
+
+    // If we had to grow the list, then give back the memory that we did not
+    // end up needing.
+    if (list->capacity > capacity && list->capacity > list->size) {
+        size_t *offsets = (size_t *) xrealloc(list->offsets, list->size * sizeof(size_t));
+
+        if (offsets != NULL) {
+            list->offsets = offsets;
+            list->capacity = list->size;
+        }
+    }
+
+    list->indexed = true;
     return true;
 }
 
@@ -25,6 +140,7 @@ pm_newline_list_init(pm_newline_list_t *list, const uint8_t *start, size_t capac
 void
 pm_newline_list_clear(pm_newline_list_t *list) {
     list->size = 1;
+    list->indexed = false;
 }
 
 /**
@@ -33,16 +149,9 @@ pm_newline_list_clear(pm_newline_list_t *list) {
  */
 bool
 pm_newline_list_append(pm_newline_list_t *list, const uint8_t *cursor) {
-    if (list->size == list->capacity) {
-        size_t *original_offsets = list->offsets;
+    if (list->indexed) return true;
 
-        list->capacity = (list->capacity * 3) / 2;
-        list->offsets = (size_t *) xcalloc(list->capacity, sizeof(size_t));
-        if (list->offsets == NULL) return false;
-
-        memcpy(list->offsets, original_offsets, list->size * sizeof(size_t));
-        xfree(original_offsets);
-    }
+    if (!pm_newline_list_reserve(list, 1)) return false;
 
     assert(*cursor == '\n');
     assert(cursor >= list->start);
@@ -55,38 +164,72 @@ pm_newline_list_append(pm_newline_list_t *list, const uint8_t *cursor) {
 }
 
 /**
- * Returns the line and column of the given offset. If the offset is not in the
- * list, the line and column of the closest offset less than the given offset
- * are returned.
+ * The number of lines that a lookup will step forward from its hint before it
+ * falls back to a binary search.
+ */
+#define PM_NEWLINE_LIST_HINT_STEPS 8
+
+/**
+ * Returns the line and column of the given offset, starting the search from
+ * the line at the given hint and updating it to the line that was found.
  */
 pm_line_column_t
-pm_newline_list_line_column(const pm_newline_list_t *list, const uint8_t *cursor, int32_t start_line) {
+pm_newline_list_line_column_hint(const pm_newline_list_t *list, const uint8_t *cursor, int32_t start_line, size_t *hint) {
     assert(cursor >= list->start);
     size_t offset = (size_t) (cursor - list->start);
+    size_t index = *hint;
+
+    // Lookups tend to come in increasing order, so first we'll check if the
+    // offset is on the hinted line or a few lines after it.
+    if (index < list->size && list->offsets[index] <= offset) {
+        for (size_t step = 0; step < PM_NEWLINE_LIST_HINT_STEPS; step++, index++) {
+            if (index + 1 == list->size || offset < list->offsets[index + 1]) {
+                *hint = index;
+                return ((pm_line_column_t) {
+                    .line = ((int32_t) index) + start_line,
+                    .column = (uint32_t) (offset - list->offsets[index])
+                });
+            }
+        }
+    }
 
+    // Otherwise, we'll binary search for the first line that starts after the
+    // offset. The line we're looking for is the one right before it.
     size_t left = 0;
-    size_t right = list->size - 1;
+    size_t right = list->size;
 
-    while (left <= right) {
+    while (left < right) {
         size_t mid = left + (right - left) / 2;
 
-        if (list->offsets[mid] == offset) {
-            return ((pm_line_column_t) { ((int32_t) mid) + start_line, 0 });
-        }
-
-        if (list->offsets[mid] < offset) {
+        if (list->offsets[mid] <= offset) {
             left = mid + 1;
         } else {
-            right = mid - 1;
+            right = mid;
         }
     }
 
+    index = left - 1;
+    *hint = index;
+
     return ((pm_line_column_t) {
-        .line = ((int32_t) left) + start_line - 1,
-        .column = (uint32_t) (offset - list->offsets[left - 1])
+        .line = ((int32_t) index) + start_line,
+        .column = (uint32_t) (offset - list->offsets[index])
     });
 }
 
+/**
+ * Returns the line and column of the given offset. If the offset is not in the
+ * list, the line and column of the closest offset less than the given offset
+ * are returned.
+ */
+pm_line_column_t
+pm_newline_list_line_column(const pm_newline_list_t *list, const uint8_t *cursor, int32_t start_line) {
+    // While parsing, most lookups are for the line that is currently being
+    // lexed, so we start by checking the last line in the list.
+    size_t hint = list->size - 1;
+    return pm_newline_list_line_column_hint(list, cursor, start_line, &hint);
+}
+
 /**
  * Free the internal memory allocated for the newline list.
  */
@@ -47,6 +47,54 @@ pm_string_constant_init(pm_string_t *string, const char *source, size_t length)
     };
 }
 
+#if !defined(_WIN32) && defined(_POSIX_MAPPED_FILES)
+
+/**
+ * Files smaller than this many bytes are read into an owned buffer by
+ * `pm_string_mapped_init` instead of being mapped. Setting up and tearing down
+ * a mapping costs a few system calls and a page fault for every page touched,
+ * which for small files is more than the cost of copying the bytes once.
+ */
+#define PM_STRING_MAPPED_READ_THRESHOLD (64 * 1024)
+
+/**
+ * Read size bytes from the given file descriptor into a newly allocated buffer
+ * and initialize the string as owning it. The file descriptor is closed in all
+ * cases. On failure errno is left as it was set by the failed call.
+ */
+static bool
+pm_string_file_read(pm_string_t *string, int fd, size_t size) {
+    uint8_t *source = xmalloc(size);
+    if (source == NULL) {
+        close(fd);
+        return false;
+    }
+
+    size_t offset = 0;
+    while (offset < size) {
+        ssize_t result = read(fd, source + offset, size - offset);
+
+        if (result > 0) {
+            offset += (size_t) result;
+        } else if (result == -1 && errno == EINTR) {
+            continue;
+        } else {
+            // Either the read failed or the file was truncated underneath us.
+            int error = result == -1 ? errno : EIO;
+            xfree(source);
+            close(fd);
+            errno = error;
+            return false;
+        }
+    }
+
+    close(fd);
+    *string = (pm_string_t) { .type = PM_STRING_OWNED, .source = source, .length = size };
+    return true;
+}
+
+#endif
+
 /**
  * Read the file indicated by the filepath parameter into source and load its
  * contents and size into the given `pm_string_t`. The given `pm_string_t`
@@ -56,7 +104,9 @@ pm_string_constant_init(pm_string_t *string, const char *source, size_t length)
  * read the entire file into memory (which could be detrimental to performance
  * for large files). This means that if we're on windows we'll use
  * `MapViewOfFile`, on POSIX systems that have access to `mmap` we'll use
- * `mmap`, and on other POSIX systems we'll use `read`.
+ * `mmap`, and on other POSIX systems we'll use `read`. Files below
+ * `PM_STRING_MAPPED_READ_THRESHOLD` are read on POSIX systems as well, since
+ * mapping them costs more than copying them.
  */
 PRISM_EXPORTED_FUNCTION bool
 pm_string_mapped_init(pm_string_t *string, const char *filepath) {
@@ -127,12 +177,30 @@ pm_string_mapped_init(pm_string_t *string, const char *filepath) {
         return true;
     }
 
+    if (size < PM_STRING_MAPPED_READ_THRESHOLD) {
+        return pm_string_file_read(string, fd, size);
+    }
+
     source = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
     if (source == MAP_FAILED) {
+        int error = errno;
+        close(fd);
+        errno = error;
         return false;
     }
 
     close(fd);
+
+    // The parser reads the source exactly once from front to back, so ask the
+    // kernel to read ahead aggressively and to drop pages behind us. These are
+    // only hints, so failures are ignored.
+#ifdef MADV_SEQUENTIAL
+    madvise(source, size, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_WILLNEED
+    madvise(source, size, MADV_WILLNEED);
+#endif
+
     *string = (pm_string_t) { .type = PM_STRING_MAPPED, .source = source, .length = size };
     return true;
 #else
@@ -199,44 +267,28 @@ pm_string_file_init(pm_string_t *string, const char *filepath) {
     *string = (pm_string_t) { .type = PM_STRING_OWNED, .source = source, .length = (size_t) file_size };
     return true;
 #elif defined(_POSIX_MAPPED_FILES)
-    FILE *file = fopen(filepath, "rb");
-    if (file == NULL) {
+    int fd = open(filepath, O_RDONLY);
+    if (fd == -1) {
         return false;
     }
 
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-
-    if (file_size == -1) {
-        fclose(file);
+    struct stat sb;
+    if (fstat(fd, &sb) == -1) {
+        int error = errno;
+        close(fd);
+        errno = error;
         return false;
     }
 
-    if (file_size == 0) {
-        fclose(file);
+    size_t size = (size_t) sb.st_size;
+    if (size == 0) {
+        close(fd);
         const uint8_t source[] = "";
         *string = (pm_string_t) { .type = PM_STRING_CONSTANT, .source = source, .length = 0 };
         return true;
     }
 
-    size_t length = (size_t) file_size;
-    uint8_t *source = xmalloc(length);
-    if (source == NULL) {
-        fclose(file);
-        return false;
-    }
-
-    fseek(file, 0, SEEK_SET);
-    size_t bytes_read = fread(source, length, 1, file);
-    fclose(file);
-
-    if (bytes_read != 1) {
-        xfree(source);
-        return false;
-    }
-
-    *string = (pm_string_t) { .type = PM_STRING_OWNED, .source = source, .length = length };
-    return true;
+    return pm_string_file_read(string, fd, size);
 #else
     (void) string;
     (void) filepath;
@@ -1,5 +1,11 @@
 #include "prism/util/pm_strpbrk.h"
 
+#if defined(PRISM_HAS_SSE2)
+#include <emmintrin.h>
+#elif defined(PRISM_HAS_NEON)
+#include <arm_neon.h>
+#endif
+
 /**
  * Add an invalid multibyte character error to the parser.
  */
@@ -29,12 +35,155 @@ pm_strpbrk_explicit_encoding_set(pm_parser_t *parser, const uint8_t *source, siz
     parser->explicit_encoding = parser->encoding;
 }
 
+/**
+ * The largest charset that we will attempt to search for in bulk. Every charset
+ * that the lexer uses is well below this limit.
+ */
+#define PM_STRPBRK_SKIP_CHARSET_MAX 16
+
+#if defined(PRISM_HAS_SSE2)
+
+/**
+ * Skip past bytes that the scalar loops would skip one at a time, 16 bytes at a
+ * time using SSE2. See pm_strpbrk_skip for the contract.
+ */
+static inline size_t
+pm_strpbrk_skip_bulk(const uint8_t *source, const uint8_t *charset, size_t length, size_t maximum) {
+    __m128i needles[PM_STRPBRK_SKIP_CHARSET_MAX];
+    for (size_t index = 0; index < length; index++) needles[index] = _mm_set1_epi8((char) charset[index]);
+
+    const __m128i zero = _mm_setzero_si128();
+    size_t index = 0;
+
+    while (index + 16 <= maximum) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *) (source + index));
+
+        // The sign bit of each byte is set for every non-ASCII byte, so the
+        // movemask of the raw chunk finds those for free.
+        __m128i matches = _mm_cmpeq_epi8(chunk, zero);
+        for (size_t needle = 0; needle < length; needle++) {
+            matches = _mm_or_si128(matches, _mm_cmpeq_epi8(chunk, needles[needle]));
+        }
+
+        uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_or_si128(matches, chunk));
+        if (mask != 0) return index + (size_t) __builtin_ctz(mask);
+
+        index += 16;
+    }
+
+    return index;
+}
+
+#elif defined(PRISM_HAS_NEON)
+
+/**
+ * Skip past bytes that the scalar loops would skip one at a time, 16 bytes at a
+ * time using NEON. See pm_strpbrk_skip for the contract.
+ */
+static inline size_t
+pm_strpbrk_skip_bulk(const uint8_t *source, const uint8_t *charset, size_t length, size_t maximum) {
+    uint8x16_t needles[PM_STRPBRK_SKIP_CHARSET_MAX];
+    for (size_t index = 0; index < length; index++) needles[index] = vdupq_n_u8(charset[index]);
+
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t high = vdupq_n_u8(0x80);
+    size_t index = 0;
+
+    while (index + 16 <= maximum) {
+        uint8x16_t chunk = vld1q_u8(source + index);
+
+        uint8x16_t matches = vorrq_u8(vceqq_u8(chunk, zero), vcgeq_u8(chunk, high));
+        for (size_t needle = 0; needle < length; needle++) {
+            matches = vorrq_u8(matches, vceqq_u8(chunk, needles[needle]));
+        }
+
+        // Narrow each 16-bit lane by 4 bits, which leaves a 64-bit mask with
+        // one nibble per byte of the chunk.
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+        if (mask != 0) return index + (((size_t) __builtin_ctzll(mask)) >> 2);
+
+        index += 16;
+    }
+
+    return index;
+}
+
+#else
+
+/**
+ * Skip past bytes that the scalar loops would skip one at a time, 8 bytes at a
+ * time by treating them as a single 64-bit word. See pm_strpbrk_skip for the
+ * contract.
+ */
+static inline size_t
+pm_strpbrk_skip_bulk(const uint8_t *source, const uint8_t *charset, size_t length, size_t maximum) {
+    static const uint64_t ones = 0x0101010101010101ULL;
+    static const uint64_t highs = 0x8080808080808080ULL;
+
+    uint64_t needles[PM_STRPBRK_SKIP_CHARSET_MAX];
+    for (size_t index = 0; index < length; index++) needles[index] = ones * charset[index];
+
+    size_t index = 0;
+
+    while (index + 8 <= maximum) {
+        uint64_t chunk;
+        memcpy(&chunk, source + index, sizeof(chunk));
+
+        // A byte in (word - ones) & ~word has its high bit set if the byte in
+        // word was zero. We check for zero bytes in the chunk itself and in the
+        // chunk xor each needle. The exact position of the match is left to
+        // the scalar loop, which keeps this independent of endianness.
+        uint64_t matches = (chunk & highs) | ((chunk - ones) & ~chunk & highs);
+        for (size_t needle = 0; needle < length; needle++) {
+            uint64_t word = chunk ^ needles[needle];
+            matches |= (word - ones) & ~word & highs;
+        }
+
+        if (matches != 0) break;
+        index += 8;
+    }
+
+    return index;
+}
+
+#endif
+
+/**
+ * Return the number of bytes at the start of source that are ASCII, not NUL,
+ * and not within the charset. Every one of these bytes would be skipped one at
+ * a time by the scalar loops below, so they can begin at the returned index
+ * without changing their result. The returned index may stop short of the
+ * first interesting byte, in which case the scalar loops will find it.
+ *
+ * The scalar loops call this again after every non-ASCII character, so that
+ * the runs of ASCII in between multibyte characters are also skipped in bulk.
+ * The length of the charset is computed once by pm_strpbrk_skip_length.
+ */
+static inline size_t
+pm_strpbrk_skip(const uint8_t *source, const uint8_t *charset, size_t length, size_t maximum) {
+    if (maximum < 16 || *source >= 0x80 || length > PM_STRPBRK_SKIP_CHARSET_MAX) return 0;
+    return pm_strpbrk_skip_bulk(source, charset, length, maximum);
+}
+
+/**
+ * Return the length of the charset for pm_strpbrk_skip.
+ */
+static inline size_t
+pm_strpbrk_skip_length(const uint8_t *charset) {
+    return strlen((const char *) charset);
+}
+
 /**
  * This is the default path.
  */
 static inline const uint8_t *
 pm_strpbrk_utf8(pm_parser_t *parser, const uint8_t *source, const uint8_t *charset, size_t maximum, bool validate) {
-    size_t index = 0;
+    size_t length = pm_strpbrk_skip_length(charset);
+
+    bool ascii = true;
+    for (size_t offset = 0; offset < length; offset++) ascii &= charset[offset] < 0x80;
+
+    size_t index = pm_strpbrk_skip(source, charset, length, maximum);
 
     while (index < maximum) {
         if (strchr((const char *) charset, source[index]) != NULL) {
@@ -44,10 +193,17 @@ pm_strpbrk_utf8(pm_parser_t *parser, const uint8_t *source, const uint8_t *chars
         if (source[index] < 0x80) {
             index++;
         } else {
-            size_t width = pm_encoding_utf_8_char_width(source + index, (ptrdiff_t) (maximum - index));
+            // When the charset only contains ASCII, none of the bytes of a
+            // multibyte character can match it, so a whole run of them can be
+            // validated at once. Otherwise the charset holds the delimiter of
+            // an invalid %-literal, and each character has to be checked.
+            size_t width = ascii ?
+                pm_encoding_utf_8_multibyte_run(source + index, (ptrdiff_t) (maximum - index)) :
+                pm_encoding_utf_8_char_width(source + index, (ptrdiff_t) (maximum - index));
 
             if (width > 0) {
                 index += width;
+                index += pm_strpbrk_skip(source + index, charset, length, maximum - index);
             } else if (!validate) {
                 index++;
             } else {
@@ -74,15 +230,21 @@ pm_strpbrk_utf8(pm_parser_t *parser, const uint8_t *source, const uint8_t *chars
  */
 static inline const uint8_t *
 pm_strpbrk_ascii_8bit(pm_parser_t *parser, const uint8_t *source, const uint8_t *charset, size_t maximum, bool validate) {
-    size_t index = 0;
+    size_t length = pm_strpbrk_skip_length(charset);
+    size_t index = pm_strpbrk_skip(source, charset, length, maximum);
 
     while (index < maximum) {
         if (strchr((const char *) charset, source[index]) != NULL) {
             return source + index;
         }
 
-        if (validate && source[index] >= 0x80) pm_strpbrk_explicit_encoding_set(parser, source, 1);
-        index++;
+        if (source[index] >= 0x80) {
+            if (validate) pm_strpbrk_explicit_encoding_set(parser, source, 1);
+            index++;
+            index += pm_strpbrk_skip(source + index, charset, length, maximum - index);
+        } else {
+            index++;
+        }
     }
 
     return NULL;
@@ -93,7 +255,8 @@ pm_strpbrk_ascii_8bit(pm_parser_t *parser, const uint8_t *source, const uint8_t
  */
 static inline const uint8_t *
 pm_strpbrk_multi_byte(pm_parser_t *parser, const uint8_t *source, const uint8_t *charset, size_t maximum, bool validate) {
-    size_t index = 0;
+    size_t length = pm_strpbrk_skip_length(charset);
+    size_t index = pm_strpbrk_skip(source, charset, length, maximum);
     const pm_encoding_t *encoding = parser->encoding;
 
     while (index < maximum) {
@@ -108,7 +271,11 @@ pm_strpbrk_multi_byte(pm_parser_t *parser, const uint8_t *source, const uint8_t
             if (validate) pm_strpbrk_explicit_encoding_set(parser, source, width);
 
             if (width > 0) {
+                // The next byte starts a character, so if it is ASCII then it
+                // cannot be the trailing byte of a multibyte character, and the
+                // run of ASCII that follows can be skipped in bulk.
                 index += width;
+                index += pm_strpbrk_skip(source + index, charset, length, maximum - index);
             } else if (!validate) {
                 index++;
             } else {
@@ -136,7 +303,8 @@ pm_strpbrk_multi_byte(pm_parser_t *parser, const uint8_t *source, const uint8_t
  */
 static inline const uint8_t *
 pm_strpbrk_single_byte(pm_parser_t *parser, const uint8_t *source, const uint8_t *charset, size_t maximum, bool validate) {
-    size_t index = 0;
+    size_t length = pm_strpbrk_skip_length(charset);
+    size_t index = pm_strpbrk_skip(source, charset, length, maximum);
     const pm_encoding_t *encoding = parser->encoding;
 
     while (index < maximum) {
@@ -144,14 +312,18 @@ pm_strpbrk_single_byte(pm_parser_t *parser, const uint8_t *source, const uint8_t
             return source + index;
         }
 
-        if (source[index] < 0x80 || !validate) {
+        if (source[index] < 0x80) {
+            index++;
+        } else if (!validate) {
             index++;
+            index += pm_strpbrk_skip(source + index, charset, length, maximum - index);
         } else {
             size_t width = encoding->char_width(source + index, (ptrdiff_t) (maximum - index));
             pm_strpbrk_explicit_encoding_set(parser, source, width);
 
             if (width > 0) {
                 index += width;
+                index += pm_strpbrk_skip(source + index, charset, length, maximum - index);
             } else {
                 // At this point we know we have an invalid multibyte character.
                 // We'll walk forward as far as we can until we find the next
@@ -192,15 +364,19 @@ pm_strpbrk_single_byte(pm_parser_t *parser, const uint8_t *source, const uint8_t
  */
 const uint8_t *
 pm_strpbrk(pm_parser_t *parser, const uint8_t *source, const uint8_t *charset, ptrdiff_t length, bool validate) {
-    if (length <= 0) {
-        return NULL;
-    } else if (!parser->encoding_changed) {
-        return pm_strpbrk_utf8(parser, source, charset, (size_t) length, validate);
+    if (length <= 0) return NULL;
+    const uint8_t *result;
+
+    if (!parser->encoding_changed) {
+        result = pm_strpbrk_utf8(parser, source, charset, (size_t) length, validate);
     } else if (parser->encoding == PM_ENCODING_ASCII_8BIT_ENTRY) {
-        return pm_strpbrk_ascii_8bit(parser, source, charset, (size_t) length, validate);
+        result = pm_strpbrk_ascii_8bit(parser, source, charset, (size_t) length, validate);
     } else if (parser->encoding->multibyte) {
-        return pm_strpbrk_multi_byte(parser, source, charset, (size_t) length, validate);
+        result = pm_strpbrk_multi_byte(parser, source, charset, (size_t) length, validate);
     } else {
-        return pm_strpbrk_single_byte(parser, source, charset, (size_t) length, validate);
+        result = pm_strpbrk_single_byte(parser, source, charset, (size_t) length, validate);
     }
+
+    PM_STATS_ADD(parser, strpbrk_bytes, result == NULL ? length : (result - source));
+    return result;
 }
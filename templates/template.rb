@@ -88,11 +88,21 @@ module Prism
       def should_be_serialized?
         SERIALIZE_ONLY_SEMANTICS_FIELDS ? semantic_field? : true
       end
+
+      # Whether or not loading this field requires the start of the node that
+      # contains it, since locations can be serialized as deltas from it.
+      def needs_node_start?
+        false
+      end
     end
 
     # Some node fields can be specialized if they point to a specific kind of
     # node and not just a generic node.
     class NodeKindField < Field
+      def needs_node_start?
+        true
+      end
+
       def c_type
         if specific_kind
           "pm_#{specific_kind.gsub(/(?<=.)[A-Z]/, "_\\0").downcase}"
@@ -151,9 +161,9 @@ module Prism
 
       def check_field_kind
         if union_kind
-          "[#{union_kind.join(', ')}].include?(#{name}.class)"
+          "#{name}.is_a?(Integer) || [#{union_kind.join(', ')}].include?(#{name}.class)"
         else
-          "#{name}.is_a?(#{ruby_type})"
+          "#{name}.is_a?(Integer) || #{name}.is_a?(#{ruby_type})"
         end
       end
     end
@@ -183,9 +193,9 @@ module Prism
 
       def check_field_kind
         if union_kind
-          "[#{union_kind.join(', ')}, NilClass].include?(#{name}.class)"
+          "[#{union_kind.join(', ')}, Integer, NilClass].include?(#{name}.class)"
         else
-          "#{name}.nil? || #{name}.is_a?(#{ruby_type})"
+          "#{name}.nil? || #{name}.is_a?(Integer) || #{name}.is_a?(#{ruby_type})"
         end
       end
     end
@@ -219,9 +229,9 @@ module Prism
 
       def check_field_kind
         if union_kind
-          "#{name}.all? { |n| [#{union_kind.join(', ')}].include?(n.class) }"
+          "#{name}.all? { |n| [#{union_kind.join(', ')}, Integer].include?(n.class) }"
         else
-          "#{name}.all? { |n| n.is_a?(#{ruby_type}) }"
+          "#{name}.all? { |n| n.is_a?(Integer) || n.is_a?(#{ruby_type}) }"
         end
       end
     end
@@ -291,6 +301,10 @@ module Prism
 
     # This represents a field on a node that is a location.
     class LocationField < Field
+      def needs_node_start?
+        true
+      end
+
       def semantic_field?
         false
       end
@@ -310,6 +324,10 @@ module Prism
 
     # This represents a field on a node that is a location that is optional.
     class OptionalLocationField < Field
+      def needs_node_start?
+        true
+      end
+
       def semantic_field?
         false
       end
@@ -454,7 +472,8 @@ module Prism
       end
 
       # Should emit serialized length of node so implementations can skip
-      # the node to enable lazy parsing.
+      # the node to enable lazy parsing. Every node has one if the
+      # PM_OPTIONS_SERIALIZATION_NODE_LENGTHS option is set.
       def needs_serialized_length?
         name == "DefNode"
       end
@@ -516,6 +535,90 @@ module Prism
       end
     end
 
+    # Represents the set of common constants that are known ahead of time. Each
+    # one is given a stable id that is its 1-based position in the list. A
+    # perfect hash is computed over the set so that looking up a string takes a
+    # single hash and at most one comparison. Keys are distributed across
+    # buckets, and each bucket is given a displacement that places all of its
+    # keys into distinct slots. This mirrors pm_constant_pool_common_find.
+    class Constants
+      # The mask used to emulate 64-bit unsigned arithmetic.
+      MASK = (1 << 64) - 1
+
+      attr_reader :names, :seed, :displacements, :slots
+
+      def initialize(names)
+        names.each do |name|
+          raise "Invalid common constant: #{name.inspect}" if !name.ascii_only? || name.match?(/["\\\s]/)
+        end
+
+        raise "Common constants must be unique" if names.uniq.length != names.length
+
+        @names = names
+        @slots = Array.new(2 << names.length.bit_length, 0)
+        @displacements = Array.new(@slots.length / 8, 0)
+
+        # The seed is varied until every bucket can be displaced, which in
+        # practice almost always happens with the first seed.
+        @seed = 0xcbf29ce484222325
+        @seed = (@seed * 0x5851f42d4c957f2d + 1) & MASK until displace
+      end
+
+      # The length of the longest common constant, used to reject most strings
+      # without hashing them.
+      def maximum_length
+        names.map(&:bytesize).max
+      end
+
+      private
+
+      # Attempt to find a displacement for every bucket with the current seed.
+      # Returns whether or not it succeeded.
+      def displace
+        slots.fill(0)
+        displacements.fill(0)
+
+        hashes = names.map { |name| digest(name) }
+        buckets = hashes.each_index.group_by { |index| (hashes[index] >> 32) & (displacements.length - 1) }
+
+        # Place the largest buckets first, since they are the hardest to fit.
+        buckets.sort_by { |bucket, indices| [-indices.length, bucket] }.each do |bucket, indices|
+          displacement =
+            (0..0xffff).find do |candidate|
+              placed = indices.map { |index| slot(hashes[index], candidate) }
+              placed.uniq.length == placed.length && placed.all? { |index| slots[index] == 0 }
+            end
+
+          return false unless displacement
+
+          displacements[bucket] = displacement
+          indices.each { |index| slots[slot(hashes[index], displacement)] = index + 1 }
+        end
+
+        true
+      end
+
+      # The FNV-1a hash of the name, finished with the murmur3 64-bit mixing
+      # step. This mirrors pm_constant_pool_common_hash.
+      def digest(name)
+        value = seed
+
+        name.each_byte do |byte|
+          value = ((value ^ byte) * 0x100000001b3) & MASK
+        end
+
+        value ^= value >> 33
+        value = (value * 0xff51afd7ed558ccd) & MASK
+        value ^ (value >> 33)
+      end
+
+      # The slot that a hash is placed into given the displacement of its
+      # bucket.
+      def slot(hash, displacement)
+        ((hash & 0xffffffff) + displacement * ((hash >> 32) | 1)) & (slots.length - 1)
+      end
+    end
+
     class << self
       # This templates out a file using ERB with the given locals. The locals are
       # derived from the config.yml file.
@@ -609,7 +712,8 @@ module Prism
               warnings: config.fetch("warnings").map { |name| Warning.new(name) },
               nodes: config.fetch("nodes").map { |node| NodeType.new(node) }.sort_by(&:name),
               tokens: config.fetch("tokens").map { |token| Token.new(token) },
-              flags: config.fetch("flags").map { |flags| Flags.new(flags) }
+              flags: config.fetch("flags").map { |flags| Flags.new(flags) },
+              constants: Constants.new(config.fetch("constants"))
             }
           end
       end
@@ -635,6 +739,7 @@ module Prism
       "lib/prism/reflection.rb",
       "lib/prism/serialize.rb",
       "lib/prism/visitor.rb",
+      "src/constants.c",
       "src/diagnostic.c",
       "src/node.c",
       "src/prettyprint.c",
@@ -119,6 +119,16 @@ module Prism
       assert_equal("# baz invocation", call_node.location.comments.map { |c| c.location.slice }.join("\n"))
     end
 
+    def test_comment_new
+      source = Prism.parse("# comment").source
+      location = Location.new(source, 0, 9)
+
+      assert_equal "# comment", InlineComment.new(location).slice
+      assert_equal "# comment", InlineComment.new(source, location).slice
+      assert_equal "# comment", InlineComment.new(source, 9).slice
+      assert_equal 9, InlineComment.new(location).end_offset
+    end
+
     private
 
     def assert_comment(source, type, start_offset:, end_offset:, start_line:, end_line:, start_column:, end_column:)
@@ -42,5 +42,64 @@ module Prism
       dispatcher.dispatch_once(root.statements.body.first.body.body.first)
       assert_equal([:on_call_node_enter, :on_call_node_leave], listener.events_received)
     end
+
+    class SourceListener
+      attr_reader :events_received
+
+      def initialize
+        @events_received = []
+      end
+
+      def on_call_node_enter(node)
+        events_received << [:on_call_node_enter, node]
+      end
+
+      def on_call_node_leave(node)
+        events_received << [:on_call_node_leave, node]
+      end
+
+      def on_integer_node_enter(node)
+        events_received << [:on_integer_node_enter, node]
+      end
+    end
+
+    def test_dispatch_source
+      source = <<~RUBY
+        def foo
+          something(1, bar(2), 3)
+        end
+      RUBY
+
+      expected = SourceListener.new
+      dispatcher = Dispatcher.new
+      dispatcher.register(expected, :on_call_node_enter, :on_call_node_leave, :on_integer_node_enter)
+      dispatcher.dispatch(Prism.parse(source).value)
+
+      actual = SourceListener.new
+      dispatcher = Dispatcher.new
+      dispatcher.register(actual, :on_call_node_enter, :on_call_node_leave, :on_integer_node_enter)
+      dispatcher.dispatch_source(source)
+
+      assert_equal expected.events_received.map { |event, node| [event, node.slice] }, actual.events_received.map { |event, node| [event, node.slice] }
+
+      # The nodes that are dispatched are the same objects as the ones that are
+      # reached through the accessors of the nodes that were dispatched before.
+      call = actual.events_received.first.last
+      assert_same call.arguments.arguments.first, actual.events_received[1].last
+    end
+
+    def test_dispatch_file
+      expected = TestListener.new
+      dispatcher = Dispatcher.new
+      dispatcher.register(expected, :on_call_node_leave, :on_integer_node_enter)
+      dispatcher.dispatch(Prism.parse_file(__FILE__).value)
+
+      actual = TestListener.new
+      dispatcher = Dispatcher.new
+      dispatcher.register(actual, :on_call_node_leave, :on_integer_node_enter)
+      dispatcher.dispatch_file(__FILE__)
+
+      assert_equal expected.events_received, actual.events_received
+    end
   end
 end
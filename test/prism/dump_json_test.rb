@@ -0,0 +1,105 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+return if Prism::BACKEND == :FFI
+
+require "json"
+
+module Prism
+  class DumpJSONTest < TestCase
+    # The values of pm_dump_json_fields_t.
+    LOCATIONS = 1 << 0
+    FLAGS = 1 << 1
+    VALUES = 1 << 2
+    ALL = LOCATIONS | FLAGS | VALUES
+
+    def test_stream
+      source = "foo(bar) { |baz| baz + 1.0 }\n"
+      result = Debug.dump_json_stream(source, ALL, nil)
+
+      assert result[:success]
+      assert_equal [Debug.dump_json(source)], result[:chunks]
+    end
+
+    def test_stream_chunks
+      source = File.read(File.expand_path("../../lib/prism/node.rb", __dir__), binmode: true, external_encoding: Encoding::UTF_8)
+      expected = Debug.dump_json(source)
+      result = Debug.dump_json_stream(source, ALL, nil)
+
+      chunks = result[:chunks]
+      assert result[:success]
+      assert_operator chunks.length, :>, 1
+      assert chunks[0...-1].all? { |chunk| chunk.bytesize >= 65536 }
+      assert_equal expected, chunks.join
+    end
+
+    def test_stream_failing_write
+      source = File.read(File.expand_path("../../lib/prism/node.rb", __dir__), binmode: true, external_encoding: Encoding::UTF_8)
+      expected = Debug.dump_json(source)
+
+      [0, 1, 2].each do |limit|
+        result = Debug.dump_json_stream(source, ALL, limit)
+        chunks = result[:chunks]
+
+        refute result[:success]
+        assert_equal limit + 1, chunks.length
+        assert expected.start_with?(chunks.join)
+      end
+    end
+
+    def test_stream_invalid_arguments
+      assert_raise(TypeError) { Debug.dump_json_stream("foo", "1", nil) }
+      assert_raise(TypeError) { Debug.dump_json_stream("foo", ALL, "1") }
+      assert_raise(TypeError) { Debug.dump_json_stream(:foo, ALL, nil) }
+    end
+
+    def test_stream_fields
+      source = <<~RUBY
+        class Foo < Bar
+          def foo(a, b = 1, *c, d:, **e, &f) = [a, b, c&.d, 1.5, 2r, 3i, "\#{e}", :f]
+          FOO ||= /foo/i =~ 'bar'
+        end
+      RUBY
+
+      all = JSON.parse(Debug.dump_json(source))
+
+      8.times do |fields|
+        result = Debug.dump_json_stream(source, fields, nil)
+
+        assert result[:success]
+        assert_equal select_fields(all, fields), JSON.parse(result[:chunks].join), "fields #{fields}"
+      end
+    end
+
+    private
+
+    # Remove the fields that were not selected from the JSON of every node,
+    # using the reflection API to find the kind of each field.
+    def select_fields(json, fields)
+      case json
+      when Array
+        json.map { |element| select_fields(element, fields) }
+      when Hash
+        return json unless json.key?("type")
+
+        kinds = Reflection.fields_for(Prism.const_get(json["type"])).to_h { |field| [field.name.to_s, field] }
+
+        json.each_with_object({}) do |(key, value), selected|
+          kind =
+            case kinds[key]
+            when nil then key == "location" ? LOCATIONS : nil
+            when Reflection::LocationField, Reflection::OptionalLocationField then LOCATIONS
+            when Reflection::FlagsField then FLAGS
+            when Reflection::NodeField, Reflection::OptionalNodeField, Reflection::NodeListField then nil
+            else VALUES
+            end
+
+          selected[key] = select_fields(value, fields) if kind.nil? || (fields & kind) != 0
+        end
+      else
+        json
+      end
+    end
+  end
+end
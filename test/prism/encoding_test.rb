@@ -226,6 +226,38 @@ module Prism
       assert_equal Encoding.find("ascii-8bit"), encoding
     end
 
+    def test_long_identifiers
+      [
+        "a" * 40,
+        "_0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ",
+        "abcdefghijklmnop\u00e9abcdefghijklmnop",
+        "\u5909\u6570_with_a_long_ascii_suffix_\u5024",
+        "abcdefgh\u00e9"
+      ].each do |name|
+        [name, "#{name}.x", "#{name}+1", "#{name} = 1"].each do |source|
+          assert_equal name, Prism.lex(source).value.first.first.value
+        end
+      end
+
+      assert_equal :CONSTANT, Prism.lex("\u00c9abcdefghijklmnopqrstuvwxyz").value.first.first.type
+      assert_equal :IDENTIFIER, Prism.lex("\u00e9ABCDEFGHIJKLMNOPQRSTUVWXYZ").value.first.first.type
+      assert_equal :CONSTANT, Prism.lex("\u03a3abcdefghijklmnopqrstuvwxyz").value.first.first.type
+      assert_equal :IDENTIFIER, Prism.lex("\u5909ABCDEFGHIJKLMNOPQRSTUVWXYZ").value.first.first.type
+    end
+
+    def test_multibyte_runs
+      ascii = "a" * 20
+      source = "\"\u3042\u3044\u3046#{ascii}\u00e9\u{1f600}#{ascii}\xff#{ascii}\u3042\""
+      result = Prism.parse(source)
+
+      assert_equal 1, result.errors.length
+      assert_equal :invalid_multibyte_character, result.errors.first.type
+      assert_equal source.b.index("\xff".b), result.errors.first.location.start_offset
+
+      string = result.value.statements.body.first
+      assert_equal source.bytesize - 1, string.closing_loc.start_offset
+    end
+
     if !ENV["PRISM_BUILD_MINIMAL"]
       # This test may be a little confusing. Basically when we use our strpbrk,
       # it takes into account the encoding of the file.
@@ -242,6 +274,18 @@ module Prism
         )
       end
 
+      def test_strpbrk_multibyte_runs
+        ascii = "a" * 20
+        source = "# encoding: Shift_JIS\n\"\x82\xa0#{ascii}\x82\\#{ascii}\\\\#{ascii}\""
+        result = Prism.parse(source)
+
+        assert(result.errors.empty?)
+        assert_equal(
+          (+"\x82\xa0#{ascii}\x82\\#{ascii}\\#{ascii}").force_encoding(Encoding::Shift_JIS),
+          result.value.statements.body.first.unescaped
+        )
+      end
+
       def test_slice_encoding
         slice = Prism.parse("# encoding: Shift_JIS\nア").value.slice
         assert_equal (+"ア").force_encoding(Encoding::SHIFT_JIS), slice
@@ -27,6 +27,20 @@ module Prism
       assert_equal expected, Debug.format_errors('"%W"\u"', false)
     end
 
+    def test_out_of_order
+      expected = <<~ERROR
+        > 1 | foo(1,,2)
+            | ^~~~~~ unexpected write target
+            |      ^ expected an argument
+            |       ^ unexpected ','; expected a `)` to close the arguments
+            |        ^ unexpected write target
+            |         ^ unexpected ')', ignoring it
+            |         ^ unexpected ')', expecting end-of-input
+      ERROR
+
+      assert_equal expected, Debug.format_errors("foo(1,,2)", false)
+    end
+
     def test_truncate_start
       expected = <<~ERROR
         > 1 | ... <>
@@ -54,5 +68,14 @@ module Prism
 
       assert_equal expected, Debug.format_errors("#{" " * 30}<#{" " * 30}a", false)
     end
+
+    def test_truncate_start_far_into_line
+      expected = <<~ERROR
+        > 1 | ... <#{" " * 30} ...
+            |     ^ unexpected '<', ignoring it
+      ERROR
+
+      assert_equal expected, Debug.format_errors("#{" " * 100_000}<#{" " * 100_000}a", false)
+    end
   end
 end
@@ -32,6 +32,15 @@ module Prism
       assert_integer_parse(num, "0o#{num.to_s(8)}")
       assert_integer_parse(num, "0d#{num.to_s(10)}")
       assert_integer_parse(num, "0x#{num.to_s(16)}")
+
+      # Sizes on either side of the switch from schoolbook conversion to the
+      # divide-and-conquer conversion.
+      [2**64 - 1, 10**38, 2**2000 - 1, 2**2100 + 1, 7**2000].each do |num|
+        assert_integer_parse(num)
+        assert_integer_parse(num, num.to_s.chars.each_slice(3).map(&:join).join("_"))
+        assert_integer_parse(num, "0o#{num.to_s(8)}")
+        assert_integer_parse(num, "0x#{num.to_s(16)}")
+      end
     end
 
     private
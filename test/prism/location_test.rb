@@ -925,6 +925,19 @@ module Prism
       assert_equal expected, actual
     end
 
+    def test_source_line_lookups
+      source = Prism.parse("foo\n\nbar\nbaz\n" * 20).source
+      offsets = (0..source.source.bytesize).to_a
+      expected = offsets.map { |offset| source.offsets.rindex { |line_offset| line_offset <= offset } + 1 }
+
+      # In order, in reverse, and in a random order, so that the cache of the
+      # most recently found line is exercised in every direction.
+      [offsets, offsets.reverse, offsets.shuffle(random: Random.new(42))].each do |order|
+        actual = order.to_h { |offset| [offset, source.line(offset)] }
+        assert_equal expected, offsets.map { |offset| actual.fetch(offset) }
+      end
+    end
+
     private
 
     def assert_location(kind, source, expected = 0...source.length, **options)
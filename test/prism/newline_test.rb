@@ -1,6 +1,7 @@
 # frozen_string_literal: true
 
 require_relative "test_helper"
+require "stringio"
 
 return unless defined?(RubyVM::InstructionSequence)
 
@@ -24,8 +25,51 @@ module Prism
       end
     end
 
+    def test_newline_flags_match_visitor
+      Dir[File.expand_path("fixtures/**/*.txt", __dir__)].each do |filepath|
+        source = File.read(filepath, binmode: true, external_encoding: Encoding::UTF_8)
+
+        expected = Prism.parse(source)
+        assert_nil expected.instance_variable_get(:@newline_nodes)
+
+        assert_equal newline_nodes(expected), newline_nodes(Prism.parse(source, mark_newlines: true)), filepath
+      end
+    end
+
+    def test_newline_flags_keyword
+      source = "foo\nbar do\n  baz\nend\n"
+      expected = newline_nodes(Prism.parse(source))
+
+      assert_equal expected, newline_nodes(Prism.parse_stream(StringIO.new(source), mark_newlines: true))
+      Tempfile.create(["newline", ".rb"]) do |file|
+        file.write(source)
+        file.close
+
+        assert_equal expected, newline_nodes(Prism.parse_file(file.path, mark_newlines: true))
+      end
+
+      if Prism::BACKEND == :CEXT
+        refute_nil Prism.parse(source, mark_newlines: true).instance_variable_get(:@newline_nodes)
+        assert_raise(ArgumentError) { Prism.lex(source, mark_newlines: true) }
+      end
+    end
+
     private
 
+    def newline_nodes(result)
+      result.mark_newlines!
+
+      queue = [result.value]
+      nodes = []
+
+      while node = queue.shift
+        queue.concat(node.compact_child_nodes)
+        nodes << [node.type, node.location.start_offset] if node.newline?
+      end
+
+      nodes
+    end
+
     def assert_newlines(base, relative)
       filepath = File.join(base, relative)
       source = File.read(filepath, binmode: true, external_encoding: Encoding::UTF_8)
@@ -0,0 +1,91 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+return if Prism::BACKEND == :FFI
+
+module Prism
+  class PackTest < TestCase
+    def test_parse
+      format = Pack.parse(:v3_2_0, :unpack, "C2 a*")
+
+      assert_equal ["C2", " ", "a*"], format.directives.map(&:source)
+      assert_equal Encoding::BINARY, format.encoding
+      assert_raise(ArgumentError) { Pack.parse(:v3_2_0, :unpack, "~") }
+    end
+
+    def test_parse_all
+      sources = ["C2 a*", "~", "U*", "", "C2 a*", "l!<"]
+      results = Pack.parse_all(:v3_2_0, :pack, sources)
+
+      assert_equal sources.length, results.length
+      sources.zip(results).each do |source, result|
+        if source == "~"
+          assert_kind_of ArgumentError, result
+          assert_raise(ArgumentError) { Pack.parse(:v3_2_0, :pack, source) }
+        else
+          assert_equal Pack.parse(:v3_2_0, :pack, source).describe, result.describe
+        end
+      end
+
+      assert_raise(ArgumentError) { Pack.parse_all(:v3_3_0, :pack, sources) }
+      assert_raise(TypeError) { Pack.parse_all(:v3_2_0, :pack, "C") }
+    end
+
+    def test_parse_many
+      # More templates than the cache holds, so that entries are evicted while
+      # the same templates are parsed again.
+      sources = 600.times.map { |index| "C#{index} a*" }
+      expected = sources.map { |source| Pack.parse(:v3_2_0, :unpack, source).describe }
+
+      assert_equal expected, Pack.parse_all(:v3_2_0, :unpack, sources).map(&:describe)
+      assert_equal expected.reverse, sources.reverse.map { |source| Pack.parse(:v3_2_0, :unpack, source).describe }
+    end
+
+    def test_parse_threads
+      sources = 600.times.map { |index| "C#{index} a* U" }
+      expected = sources.map { |source| Pack.parse(:v3_2_0, :unpack, source).describe }
+
+      threads = 4.times.map do |offset|
+        Thread.new do
+          sources.rotate(offset * 150).map { |source| Pack.parse(:v3_2_0, :unpack, source).describe }
+        end
+      end
+
+      threads.each_with_index do |thread, offset|
+        assert_equal expected.rotate(offset * 150), thread.value
+      end
+    end
+
+    def test_cache_hits
+      hits, order = Debug.pack_cache(4, ["C", "S", "C", "L", "S", "C"])
+
+      assert_equal [false, false, true, false, true, true], hits
+      assert_equal ["C", "S", "L"], order
+    end
+
+    def test_cache_eviction
+      # The least recently used template is evicted, not the oldest one.
+      hits, order = Debug.pack_cache(2, ["C", "S", "C", "L", "S"])
+
+      assert_equal [false, false, true, false, false], hits
+      assert_equal ["S", "L"], order
+    end
+
+    def test_cache_capacity
+      sources = 10.times.map { |index| "C#{index}" }
+      hits, order = Debug.pack_cache(3, sources + sources.last(3).reverse)
+
+      assert_equal [false] * 10 + [true] * 3, hits
+      assert_equal ["C7", "C8", "C9"], order
+
+      # A capacity of zero still holds the most recent template.
+      assert_equal [[false, true, false], ["S"]], Debug.pack_cache(0, ["C", "C", "S"])
+    end
+
+    def test_cache_errors
+      # Templates that fail to parse are cached like any other.
+      assert_equal [[false, true], ["~"]], Debug.pack_cache(2, ["~", "~"])
+    end
+  end
+end
@@ -70,5 +70,23 @@ module Prism
       assert result.success?
       assert_equal 4, result.value.statements.body.length
     end
+
+    def test_many_false___END___in_heredoc
+      io = StringIO.new("<<~EOF\n#{"__END__\n" * 100}EOF\n1 + 2\n__END__\n3 + 4")
+      result = Prism.parse_stream(io)
+
+      assert result.success?
+      assert_equal 2, result.value.statements.body.length
+      assert_equal "3 + 4", io.read
+    end
+
+    def test_false___END___at_end_of_long_line
+      io = StringIO.new("#{"a" * 4095}__END__\n1 + 2")
+      result = Prism.parse_stream(io)
+
+      assert result.success?
+      assert_equal 2, result.value.statements.body.length
+      assert_equal "", io.read
+    end
   end
 end
@@ -256,6 +256,7 @@ module Prism
           # Next, assert that the value can be serialized and deserialized
           # without changing the shape of the tree.
           assert_equal_nodes(result.value, Prism.load(source, Prism.dump(source, filepath: relative)).value)
+          assert_equal_nodes(result.value, Prism.load(source, Prism.dump(source, filepath: relative, delta_locations: true)).value)
         end
 
         # Next, check that the location ranges of each node in the tree are a
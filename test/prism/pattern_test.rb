@@ -123,8 +123,57 @@ module Prism
       assert_equal 1, results.length
     end
 
+    def test_scan_source
+      source = "foo.where(bar: 1)\nbaz.where(1, 2) { |x| x }\n[1, 2].map(&:to_s)\n"
+      queries = [
+        "CallNode[name: :where, arguments: ArgumentsNode[arguments: [KeywordHashNode]]]",
+        "CallNode[name: :where, block: nil] | IntegerNode",
+        "{ receiver: nil, name: :x }",
+        "BlockNode[parameters: BlockParametersNode, locals: [:x]]",
+        "{ name: /^[[:punct:]]$/ }"
+      ]
+
+      queries.each do |query|
+        pattern = Prism::Pattern.new(query)
+        expected = pattern.scan(Prism.parse(source).value).to_a
+
+        assert_equal_nodes_list expected, pattern.scan_source(source)
+      end
+    end
+
+    def test_scan_file
+      pattern = Prism::Pattern.new("DefNode[name: :test_scan_file]")
+      results = pattern.scan_file(__FILE__)
+
+      assert_equal 1, results.length
+      assert_equal "test_scan_file", results.first.name.to_s
+      assert_kind_of StatementsNode, results.first.body
+    end
+
+    def test_scan_invalid_native
+      return if Prism::BACKEND == :FFI
+
+      assert_invalid_native :array
+      assert_invalid_native []
+      assert_invalid_native [:bogus]
+      assert_invalid_native [:and, [:nil]]
+      assert_invalid_native [:string, :foo]
+      assert_invalid_native [:hash, [[:name]]]
+      assert_invalid_native [:array, [[:nil], [:bogus]]]
+      assert_invalid_native [:or, [:nil], [:hash, [[:name, [:array, [1]]]]]]
+    end
+
     private
 
+    def assert_invalid_native(native)
+      assert_raise(ArgumentError) { LazyTree.scan(native, "foo(bar)") }
+    end
+
+    def assert_equal_nodes_list(expected, actual)
+      assert_equal expected.length, actual.length
+      expected.zip(actual).each { |left, right| assert_equal_nodes left, right }
+    end
+
     def scan(source, query)
       Prism::Pattern.new(query).scan(Prism.parse(source).value).to_a
     end
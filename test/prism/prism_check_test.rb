@@ -0,0 +1,72 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+require "open3"
+require "tmpdir"
+
+module Prism
+  # Tests for the standalone prism-check executable, which is built with
+  # `make prism-check`.
+  class PrismCheckTest < TestCase
+    def setup
+      super
+
+      @prism_check = File.expand_path("../../build/prism-check", __dir__)
+      omit "build/prism-check has not been built" unless File.executable?(@prism_check)
+    end
+
+    def test_valid
+      Dir.mktmpdir do |directory|
+        File.write(File.join(directory, "good.rb"), "def foo(bar) = bar\n")
+        stdout, stderr, status = run_check(directory)
+
+        assert_equal 0, status.exitstatus
+        assert_empty stdout
+        assert_includes stderr, "1 files"
+        assert_includes stderr, "0 with syntax errors"
+      end
+    end
+
+    def test_syntax_errors
+      Dir.mktmpdir do |directory|
+        path = File.join(directory, "bad.rb")
+        File.write(path, "foo\ndef foo(\n")
+        stdout, _, status = run_check(path)
+
+        assert_equal 1, status.exitstatus
+        assert_includes stdout, "#{path}: 3 syntax errors"
+
+        # Lines are numbered from 1, as they are by ruby.
+        assert_includes stdout, "  1 | foo\n"
+        assert_includes stdout, "> 2 | def foo(\n"
+      end
+    end
+
+    def test_quiet
+      Dir.mktmpdir do |directory|
+        File.write(File.join(directory, "bad.rb"), "def foo(\n")
+        stdout, _, status = run_check("-q", directory)
+
+        assert_equal 1, status.exitstatus
+        assert_empty stdout
+      end
+    end
+
+    def test_unreadable
+      Dir.mktmpdir do |directory|
+        path = File.join(directory, "missing.rb")
+        _, stderr, status = run_check(path)
+
+        assert_equal 2, status.exitstatus
+        assert_includes stderr, path
+      end
+    end
+
+    private
+
+    def run_check(*arguments)
+      Open3.capture3(@prism_check, *arguments)
+    end
+  end
+end
@@ -239,8 +239,21 @@ module Prism
       assert_equal Regexp::NOENCODING, option
     end
 
+    def test_match_write_targets
+      assert_equal [], match_write_targets("/foo?(bar)?/ =~ ''")
+      assert_equal [], match_write_targets("/(?<=foo)(?:bar)/ =~ ''")
+      assert_equal [:foo], match_write_targets("/(?<=a)(?<foo>b)/ =~ ''")
+      assert_equal [:foo, :bar], match_write_targets("/(?'foo'a)?(?<bar>b)/ =~ ''")
+      assert_equal [:ab], match_write_targets("<<A; /(?<ab>\nA\n)/ =~ ''")
+    end
+
     private
 
+    def match_write_targets(source)
+      node = Prism.parse(source).value.statements.body.last
+      node.is_a?(MatchWriteNode) ? node.targets.map(&:name) : []
+    end
+
     def named_captures(source)
       Debug.named_captures(source)
     end
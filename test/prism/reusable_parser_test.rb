@@ -0,0 +1,83 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+module Prism
+  class ReusableParserTest < TestCase
+    def test_parse
+      parser = ReusableParser.new
+      filepaths = Dir[File.expand_path("fixtures/**/*.txt", __dir__)].sort.first(50)
+
+      # Parse every file twice so that the second pass only ever operates on a
+      # parser whose buffers have already been grown.
+      2.times do
+        filepaths.each do |filepath|
+          source = File.read(filepath, binmode: true, external_encoding: Encoding::UTF_8)
+
+          expected = Prism.parse(source, filepath: filepath)
+          actual = parser.parse(source, filepath: filepath)
+
+          assert_equal_nodes expected.value, actual.value
+          assert_equal expected.comments.map(&:location), actual.comments.map(&:location)
+          assert_equal expected.errors.map(&:message), actual.errors.map(&:message)
+        end
+      end
+    end
+
+    def test_parse_file
+      parser = ReusableParser.new
+
+      assert_equal_nodes Prism.parse_file(__FILE__).value, parser.parse_file(__FILE__).value
+      assert_equal_nodes Prism.parse_file(__FILE__).value, parser.parse_file(__FILE__).value
+    end
+
+    def test_options_do_not_leak
+      parser = ReusableParser.new
+
+      assert_equal "foo.rb", parser.parse("__FILE__", filepath: "foo.rb").value.statements.body[0].filepath
+      assert_equal "", parser.parse("__FILE__").value.statements.body[0].filepath
+
+      assert_equal 10, parser.parse("foo", line: 10).value.statements.body[0].location.start_line
+      assert_equal 1, parser.parse("foo").value.statements.body[0].location.start_line
+
+      assert_kind_of LocalVariableReadNode, parser.parse("foo", scopes: [[:foo]]).value.statements.body[0]
+      assert_kind_of CallNode, parser.parse("foo").value.statements.body[0]
+    end
+
+    def test_threads
+      # Large enough that the GVL is released while parsing.
+      source = File.read(File.expand_path("../../lib/prism/node.rb", __dir__), 100_000)
+      expected = Prism.parse(source).value
+
+      # An instance that is shared between threads either parses or raises a
+      # ThreadError when another thread is already parsing with it.
+      parser = ReusableParser.new
+      threads = 4.times.map do
+        Thread.new do
+          5.times.map do
+            parser.parse(source).value
+          rescue ThreadError
+            nil
+          end
+        end
+      end
+
+      threads.flat_map(&:value).compact.each { |actual| assert expected === actual }
+
+      # Instances that are owned by a single thread always parse.
+      threads = 4.times.map { Thread.new { ReusableParser.new.then { |owned| 2.times.map { owned.parse(source).value } } } }
+      threads.flat_map(&:value).each { |actual| assert expected === actual }
+    end
+
+    def test_does_not_shadow_the_parser_gem
+      refute Prism.const_defined?(:Parser, false)
+    end
+
+    def test_errors_do_not_leak
+      parser = ReusableParser.new
+
+      assert parser.parse("<>").failure?
+      assert parser.parse("1").success?
+    end
+  end
+end
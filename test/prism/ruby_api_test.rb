@@ -27,10 +27,220 @@ module Prism
       refute Prism.parse_success?("<>")
     end
 
+    def test_parse_success_stops_at_first_error
+      source = "<>\n#{"foo(<<~HEREDOC, \"\#{bar}\")\n  baz\nHEREDOC\n" * 1000}"
+
+      refute Prism.parse_success?(source)
+      refute Prism.parse_success?("foo <<~HEREDOC\n  <>\nHEREDOC\n1 +")
+      assert_operator Prism.parse("<>\n<>").errors.length, :>, 2
+    end
+
     def test_parse_file_success?
       assert Prism.parse_file_success?(__FILE__)
     end
 
+    def test_parse_files
+      filepaths = Dir[File.expand_path("fixtures/*.txt", __dir__)].sort.first(20)
+      results = Prism.parse_files(filepaths, threads: 4)
+
+      assert_equal filepaths.length, results.length
+      filepaths.zip(results).each do |filepath, result|
+        assert_equal_nodes Prism.parse_file(filepath).value, result.value
+      end
+
+      assert_equal [], Prism.parse_files([])
+      assert_raise(Errno::ENOENT) { Prism.parse_files([__FILE__, "#{__FILE__}.missing"], threads: 2) }
+      assert_raise(ArgumentError) { Prism.parse_files([__FILE__], threads: 0) }
+    end
+
+    def test_parse_lazy
+      filepath = __FILE__
+      source = File.read(filepath, binmode: true, external_encoding: Encoding::UTF_8)
+
+      assert_equal_nodes Prism.parse(source, filepath: filepath).value, Prism.parse_lazy(source, filepath: filepath).value
+      assert_equal_nodes Prism.parse_file(filepath).value, Prism.parse_file_lazy(filepath).value
+
+      # The tree outlives the string that it was parsed from.
+      source = +"__FILE__; foo(bar, baz) { qux }"
+      filepath = +"lazy.rb"
+      node = Prism.parse_lazy(source, filepath: filepath).value
+      source.replace("nil")
+      filepath.replace("x")
+      GC.start
+
+      call = node.statements.body.last
+      assert_equal "lazy.rb", node.statements.body.first.filepath
+      assert_equal [:bar, :baz], call.arguments.arguments.map(&:name)
+      assert_same call.block, call.block
+    end
+
+    def test_parse_lazy_marshal
+      filepath = __FILE__
+      source = File.read(filepath, binmode: true, external_encoding: Encoding::UTF_8)
+      expected = Prism.parse(source, filepath: filepath)
+
+      # The children that were never accessed are filled in before dumping.
+      result = Marshal.load(Marshal.dump(Prism.parse_lazy(source, filepath: filepath)))
+      assert_equal_nodes expected.value, result.value
+      assert_equal expected.comments.map(&:slice), result.comments.map(&:slice)
+
+      # A single node can be dumped without its parent.
+      node = Prism.parse_lazy("foo(bar) { |baz| baz }; qux").value.statements.body.first
+      loaded = Marshal.load(Marshal.dump(node))
+      assert_equal_nodes Prism.parse("foo(bar) { |baz| baz }; qux").value.statements.body.first, loaded
+      assert_equal "foo(bar) { |baz| baz }", loaded.slice
+
+      # Trees that were not parsed lazily can still be dumped and loaded.
+      assert_equal_nodes expected.value, Marshal.load(Marshal.dump(expected.value))
+    end
+
+    def test_comment_offsets
+      source = "foo # bar\n=begin\nbaz\n=end\n"
+
+      [Prism.parse(source), Prism.load(source, Prism.dump(source))].each do |result|
+        inline, embdoc = result.comments
+
+        assert_equal [4, 9], [inline.start_offset, inline.end_offset]
+        assert_equal [10, 26], [embdoc.start_offset, embdoc.end_offset]
+        assert_equal "# bar", inline.slice
+        assert_equal 2, embdoc.location.start_line
+      end
+    end
+
+    def test_token_offsets
+      tokens = Prism.lex("foo + bar").value.map(&:first)
+
+      assert_equal [[0, 3], [4, 5], [6, 9]], tokens.take(3).map { |token| [token.start_offset, token.end_offset] }
+      assert_equal [4, 5], [tokens[1].location.start_offset, tokens[1].location.end_offset]
+      assert_equal [4, 5], [tokens[1].start_offset, tokens[1].end_offset]
+    end
+
+    def test_byte_character_offsets
+      omit "not defined by the FFI backend" unless Source.respond_to?(:byte_character_offsets)
+
+      ["", "foo", "ü😀x\n\xFFy", (+"\x82\xA0a").force_encoding(Encoding::Shift_JIS)].each do |source|
+        expected = []
+        offset = 0
+
+        source.each_char do |char|
+          char.bytesize.times { expected << offset }
+          offset += 1
+        end
+
+        assert_equal expected << offset, Source.byte_character_offsets(source)
+      end
+    end
+
+    def test_dump_semantics_only
+      source = "# comment\nfoo(bar) { |baz| baz }\n"
+
+      full = Prism.dump(source)
+      semantics_only = Prism.dump(source, semantics_only: true)
+
+      assert_equal 0, full.getbyte(8) & 1
+      assert_equal 1, semantics_only.getbyte(8) & 1
+      assert_operator semantics_only.bytesize, :<, full.bytesize
+
+      assert_equal full, Prism.dump(source, semantics_only: false)
+      assert_raise(RuntimeError) { Prism.load(source, semantics_only) }
+    end
+
+    def test_dump_delta_locations
+      source = File.read(__FILE__, binmode: true, external_encoding: Encoding::UTF_8)
+
+      absolute = Prism.dump(source)
+      delta = Prism.dump(source, delta_locations: true)
+
+      assert_equal 0, absolute.getbyte(8) & 4
+      assert_equal 4, delta.getbyte(8) & 4
+      assert_operator delta.bytesize, :<, absolute.bytesize
+      assert_equal_nodes Prism.load(source, absolute).value, Prism.load(source, delta).value
+    end
+
+    def test_dump_node_lengths
+      source = File.read(__FILE__, binmode: true, external_encoding: Encoding::UTF_8)
+      expected = Prism.parse(source).value
+
+      [{}, { delta_locations: true }].each do |options|
+        without = Prism.dump(source, **options)
+        with = Prism.dump(source, node_lengths: true, **options)
+
+        assert_equal 0, without.getbyte(8) & 2
+        assert_equal 2, with.getbyte(8) & 2
+        assert_operator with.bytesize, :>, without.bytesize
+
+        assert_equal_nodes expected, Prism.load(source, with).value
+        assert_equal_nodes expected, Prism::Serialize.load_lazy(source, with).value
+      end
+
+      assert_raise(RuntimeError) { Prism::Serialize.load_lazy(source, Prism.dump(source)) }
+    end
+
+    def test_load_lazy
+      source = "class Foo\n  def foo = 1\n  def bar = [2, 3]\n  def baz = 4\nend\n"
+      serialized = Prism.dump(source, node_lengths: true, delta_locations: true)
+      statements = Prism::Serialize.load_lazy(source, serialized).value.statements.body.first.body
+
+      # Each method was skipped over by its length, and is only loaded once it
+      # is accessed.
+      offsets = statements.instance_variable_get(:@body)
+      assert offsets.all?(Integer)
+      assert_equal offsets, offsets.sort
+
+      bar = Prism::Serialize.load_lazy(source, serialized).value.statements.body.first.body.body[1]
+      assert_equal_nodes Prism.parse(source).value.statements.body.first.body.body[1], bar
+      assert_equal "def bar = [2, 3]", bar.slice
+      assert_equal [2, 3], bar.body.body.first.elements.map(&:value)
+    end
+
+    def test_dump_cache
+      source = File.read(__FILE__, binmode: true, external_encoding: Encoding::UTF_8)
+      serialized = Prism.dump(source, filepath: __FILE__)
+      cache = Prism.dump_cache(source, filepath: __FILE__)
+
+      # The cache is the serialized AST followed by a 32 byte trailer.
+      assert_equal serialized, cache.byteslice(0, cache.bytesize - 32)
+      assert_equal "PMCACHE\0", cache.byteslice(-32, 8)
+      assert Prism.cache_valid?(cache, source, filepath: __FILE__)
+
+      # The loader reads the cache as-is, without the trailer being removed.
+      assert_equal_nodes Prism.parse(source, filepath: __FILE__).value, Prism.load(source, cache).value
+    end
+
+    def test_dump_cache_invalid
+      source = "foo(bar) { |baz| baz }\n"
+      cache = Prism.dump_cache(source, line: 2)
+      assert Prism.cache_valid?(cache, source, line: 2)
+
+      # A different source or different options.
+      refute Prism.cache_valid?(cache, "foo(bar) { |baz| qux }\n", line: 2)
+      refute Prism.cache_valid?(cache, source + "\n", line: 2)
+      refute Prism.cache_valid?(cache, source)
+      refute Prism.cache_valid?(cache, source, line: 2, filepath: "foo.rb")
+      refute Prism.cache_valid?(cache, source, line: 2, frozen_string_literal: true)
+      refute Prism.cache_valid?(cache, source, line: 2, delta_locations: true)
+      refute Prism.cache_valid?(Prism.dump_cache(source, line: 2, delta_locations: true), source, line: 2)
+
+      # A different version of prism, or different serialization flags.
+      [5, 6, 7, 8].each do |index|
+        corrupted = cache.b
+        corrupted.setbyte(index, corrupted.getbyte(index) ^ 0x80)
+        refute Prism.cache_valid?(corrupted, source, line: 2), "byte #{index}"
+      end
+
+      # A truncated cache, or a corrupted trailer.
+      refute Prism.cache_valid?("", source, line: 2)
+      refute Prism.cache_valid?(cache.byteslice(0, 40), source, line: 2)
+      refute Prism.cache_valid?(cache.byteslice(0, cache.bytesize - 1), source, line: 2)
+      refute Prism.cache_valid?(Prism.dump(source, line: 2), source, line: 2)
+
+      (cache.bytesize - 32...cache.bytesize).each do |index|
+        corrupted = cache.b
+        corrupted.setbyte(index, corrupted.getbyte(index) ^ 1)
+        refute Prism.cache_valid?(corrupted, source, line: 2), "byte #{index}"
+      end
+    end
+
     def test_options
       assert_equal "", Prism.parse("__FILE__").value.statements.body[0].filepath
       assert_equal "foo.rb", Prism.parse("__FILE__", filepath: "foo.rb").value.statements.body[0].filepath
@@ -118,6 +328,27 @@ module Prism
       assert_equal 7, location.end_character_column
     end
 
+    def test_location_offsets_across_lines
+      source = "# 😀 ünïcode\n" * 50 + "foo = \"𝔘\"\n" + "bar\n"
+      result = Prism.parse(source)
+      bar = result.value.statements.body.last.location
+
+      assert_equal source.index("bar"), bar.start_character_offset
+      assert_equal source[0...source.index("bar")].encode(Encoding::UTF_16LE).bytesize / 2, bar.start_code_units_offset(Encoding::UTF_16LE)
+      assert_equal source.index("bar"), bar.start_code_units_offset(Encoding::UTF_32LE)
+      assert_equal 0, bar.start_code_units_column(Encoding::UTF_16LE)
+
+      frozen = Prism.parse(source).source.freeze
+      refute_nil frozen.instance_variable_get(:@character_offsets)
+      refute_nil frozen.instance_variable_get(:@utf16_offsets)
+      assert_equal bar.start_character_offset, frozen.character_offset(bar.start_offset)
+      assert_equal bar.start_code_units_offset(Encoding::UTF_16LE), frozen.code_units_offset(bar.start_offset, Encoding::UTF_16LE)
+
+      shareable = Ractor.make_shareable(Prism.parse(source).source)
+      assert_equal bar.start_character_offset, shareable.character_offset(bar.start_offset)
+      assert_equal bar.start_code_units_offset(Encoding::UTF_16LE), shareable.code_units_offset(bar.start_offset, Encoding::UTF_16LE)
+    end
+
     def test_location_code_units
       program = Prism.parse("😀 + 😀\n😍 ||= 😍").value
 
@@ -0,0 +1,87 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+return if Prism::BACKEND == :FFI
+
+module Prism
+  class SerializeSinkTest < TestCase
+    def test_chunk_sizes
+      source = File.read(File.expand_path("../../lib/prism/node.rb", __dir__), binmode: true, external_encoding: Encoding::UTF_8)
+      expected = Prism.dump(source)
+
+      [1, 7, 64, 4096, 65536, expected.bytesize * 2].each do |chunk_size|
+        result = Debug.dump_sink(source, chunk_size, nil)
+
+        assert result[:success]
+        assert_equal 1, result[:flushes]
+        assert_equal expected, result[:chunks].join, "chunk_size #{chunk_size}"
+      end
+    end
+
+    def test_chunks
+      source = "foo(bar) { |baz| baz + 1 }\n" * 1000
+      result = Debug.dump_sink(source, 256, nil)
+
+      chunks = result[:chunks]
+      assert_operator chunks.length, :>, 10
+      assert chunks.none?(&:empty?)
+      assert_equal Prism.dump(source), chunks.join
+    end
+
+    def test_node_lengths
+      source = "foo(bar) { |baz| baz + 1 }\n" * 1000
+      expected = Prism.dump(source, node_lengths: true)
+
+      [1, 256, 65536].each do |chunk_size|
+        chunks = Debug.dump_sink(source, chunk_size, nil, node_lengths: true)[:chunks]
+        assert_equal expected, chunks.join, "chunk_size #{chunk_size}"
+      end
+
+      # Since the lengths are known before each node is written, chunks are cut
+      # between nodes even when every node has a length. The first chunk holds
+      # the metadata and the last one holds the constant pool.
+      chunks = Debug.dump_sink(source, 256, nil, node_lengths: true)[:chunks]
+      assert_operator chunks.length, :>, 10
+      assert chunks[1...-1].all? { |chunk| chunk.bytesize < 512 }
+    end
+
+    def test_empty
+      assert_equal Prism.dump(""), Debug.dump_sink("", 1, nil)[:chunks].join
+    end
+
+    def test_failing_write
+      source = "foo(bar) { |baz| baz + 1 }\n" * 1000
+      expected = Prism.dump(source)
+
+      [0, 1, 5].each do |limit|
+        result = Debug.dump_sink(source, 256, limit)
+        chunks = result[:chunks]
+
+        refute result[:success]
+        assert_equal 0, result[:flushes]
+
+        # The write that failed is the last one the sink sees.
+        assert_equal limit + 1, chunks.length
+        assert expected.start_with?(chunks.join)
+      end
+    end
+
+    def test_failing_final_write
+      source = "foo(bar)"
+      chunks = Debug.dump_sink(source, 1 << 20, nil)[:chunks]
+      result = Debug.dump_sink(source, 1 << 20, chunks.length - 1)
+
+      refute result[:success]
+      assert_equal 0, result[:flushes]
+      assert_equal chunks, result[:chunks]
+    end
+
+    def test_invalid_arguments
+      assert_raise(TypeError) { Debug.dump_sink("foo", "256", nil) }
+      assert_raise(TypeError) { Debug.dump_sink("foo", 256, "1") }
+      assert_raise(TypeError) { Debug.dump_sink(:foo, 256, nil) }
+      assert_raise(ArgumentError) { Debug.dump_sink("foo", 256, nil, bogus: true) }
+    end
+  end
+end
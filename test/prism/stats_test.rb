@@ -0,0 +1,27 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+return if Prism::BACKEND == :FFI
+
+module Prism
+  class StatsTest < TestCase
+    def test_stats
+      result = Debug.stats("foo(1, \"bar\#{baz}\")")
+      omit "prism was not built with PRISM_BUILD_STATS" if result.nil?
+
+      assert_operator result[:tokens], :>=, 9
+      assert_operator result[:nodes_allocated], :>=, 8
+      assert_operator result[:node_bytes_allocated], :>, 0
+      assert_equal 1, result[:nodes][:program_node]
+      assert_equal 2, result[:nodes][:call_node]
+      assert_equal 1, result[:nodes][:interpolated_string_node]
+      assert_operator result[:constant_pool_inserts], :>=, 2
+      assert_operator result[:lex_mode_pushes], :>=, 2
+      assert_operator result[:context_pushes], :>, 0
+      assert_operator result[:strpbrk_bytes], :>, 0
+      assert_operator result[:parse_time], :>=, result[:lex_time]
+      assert_kind_of Integer, result[:serialize_time]
+    end
+  end
+end
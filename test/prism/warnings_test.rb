@@ -64,6 +64,13 @@ module Prism
       assert_warning("{ a: 1, **{ a: 2 } }", "duplicated and overwritten")
     end
 
+    def test_duplicated_hash_keys_in_large_hash
+      keys = (1..1000).map { |index| "#{index * 37} => 1" }
+      warnings = Prism.parse("{ #{keys.join(", ")}, #{keys.join(", ")} }").warnings
+
+      assert_equal 1000, warnings.count { |warning| warning.message.include?("duplicated and overwritten") }
+    end
+
     def test_duplicated_when_clause
       assert_warning("case 1; when 1, 1; end", "clause with line")
     end
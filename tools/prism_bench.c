@@ -0,0 +1,461 @@
+/**
+ * @file prism_bench.c
+ *
+ * A command line tool that benchmarks prism against a corpus of Ruby files.
+ * Every file is read into memory up front, and then each phase below is run
+ * over the whole corpus a number of times. The fastest run of each phase is
+ * reported, along with the allocations that it made, in JSON so that results
+ * can be compared between commits.
+ *
+ *     prism-bench [-n ITERATIONS] [-o OUTPUT] [-l LIST] PATH...
+ *
+ * Paths are collected in the same way as prism-check. This tool is compiled
+ * together with the prism sources using the allocator in prism_xallocator.h, so
+ * that every allocation the parser makes is counted.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "prism.h"
+#include "prism_paths.h"
+
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * The header that is placed in front of every allocation, so that the number
+ * of live bytes can be tracked when memory is freed. It is a union so that the
+ * memory after it is aligned as malloc would align it.
+ */
+typedef union {
+    /** The size of the allocation that follows the header. */
+    size_t size;
+
+    /** Unused, only here for alignment. */
+    long double alignment_long_double;
+
+    /** Unused, only here for alignment. */
+    void *alignment_pointer;
+
+    /** Unused, only here for alignment. */
+    long long alignment_long_long;
+} bench_header_t;
+
+/**
+ * The allocation counters, which are reset at the start of each phase.
+ */
+static struct {
+    /** The number of calls to malloc, calloc, and realloc. */
+    size_t allocations;
+
+    /** The total number of bytes that were requested. */
+    size_t allocated;
+
+    /** The number of bytes that are currently allocated. */
+    size_t live;
+
+    /** The largest number of bytes that were allocated at any one time. */
+    size_t peak;
+} bench_counters;
+
+/**
+ * Record an allocation of the given size.
+ */
+static void *
+bench_track(bench_header_t *header, size_t size) {
+    if (header == NULL) return NULL;
+    header->size = size;
+
+    bench_counters.allocations++;
+    bench_counters.allocated += size;
+    bench_counters.live += size;
+    if (bench_counters.live > bench_counters.peak) bench_counters.peak = bench_counters.live;
+
+    return header + 1;
+}
+
+void *
+prism_bench_malloc(size_t size) {
+    return bench_track(malloc(sizeof(bench_header_t) + size), size);
+}
+
+void *
+prism_bench_calloc(size_t count, size_t size) {
+    bench_header_t *header = calloc(1, sizeof(bench_header_t) + (count * size));
+    return bench_track(header, count * size);
+}
+
+void *
+prism_bench_realloc(void *pointer, size_t size) {
+    if (pointer == NULL) return prism_bench_malloc(size);
+
+    bench_header_t *header = ((bench_header_t *) pointer) - 1;
+    bench_counters.live -= header->size;
+
+    return bench_track(realloc(header, sizeof(bench_header_t) + size), size);
+}
+
+void
+prism_bench_free(void *pointer) {
+    if (pointer == NULL) return;
+
+    bench_header_t *header = ((bench_header_t *) pointer) - 1;
+    bench_counters.live -= header->size;
+    free(header);
+}
+
+/**
+ * The corpus that is being benchmarked.
+ */
+typedef struct {
+    /** The contents of each of the files. */
+    pm_string_t *sources;
+
+    /** The number of files. */
+    size_t size;
+
+    /** The total number of bytes across all of the files. */
+    size_t bytes;
+} bench_corpus_t;
+
+/**
+ * The name of each phase that is benchmarked, in the order they are run.
+ */
+typedef enum {
+    BENCH_PHASE_PARSE,
+    BENCH_PHASE_PARSE_ARENA,
+    BENCH_PHASE_PARSE_SUCCESS,
+    BENCH_PHASE_LEX,
+    BENCH_PHASE_SERIALIZE,
+    BENCH_PHASE_SIZE
+} bench_phase_t;
+
+/** The names of the phases as they are reported. */
+static const char *bench_phase_names[BENCH_PHASE_SIZE] = {
+    "parse",
+    "parse_arena",
+    "parse_success",
+    "lex",
+    "serialize"
+};
+
+/**
+ * The results of a single phase.
+ */
+typedef struct {
+    /** The fastest time that the phase took over the whole corpus. */
+    double seconds;
+
+    /** The number of allocations that the phase made. */
+    size_t allocations;
+
+    /** The number of bytes that the phase requested be allocated. */
+    size_t allocated;
+
+    /** The largest number of bytes that were allocated at any one time. */
+    size_t peak;
+} bench_result_t;
+
+/**
+ * Returns the current time in seconds from a monotonic clock.
+ */
+static double
+bench_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1e9);
+}
+
+/**
+ * Ignore the tokens that are handed out while lexing.
+ */
+static void
+bench_lex_tokens(PRISM_ATTRIBUTE_UNUSED void *data, PRISM_ATTRIBUTE_UNUSED pm_parser_t *parser, PRISM_ATTRIBUTE_UNUSED const pm_lex_token_t *tokens, PRISM_ATTRIBUTE_UNUSED size_t size) {
+}
+
+/**
+ * Run one phase over a single source. Only the work of the phase itself is
+ * timed, which for serialization means that the tree is parsed beforehand.
+ */
+static double
+bench_run(bench_phase_t phase, const pm_string_t *source) {
+    const uint8_t *start = pm_string_source(source);
+    size_t length = pm_string_length(source);
+    double elapsed = 0;
+
+    pm_parser_t parser;
+    pm_arena_t arena = { 0 };
+
+    switch (phase) {
+        case BENCH_PHASE_PARSE: {
+            double before = bench_now();
+            pm_parser_init(&parser, start, length, NULL);
+            pm_node_t *node = pm_parse(&parser);
+            pm_node_destroy(&parser, node);
+            pm_parser_free(&parser);
+            elapsed = bench_now() - before;
+            break;
+        }
+        case BENCH_PHASE_PARSE_ARENA: {
+            double before = bench_now();
+            pm_parser_init(&parser, start, length, NULL);
+            pm_parser_arena_set(&parser, &arena);
+            pm_parse(&parser);
+            pm_parser_free(&parser);
+            pm_arena_free(&arena);
+            elapsed = bench_now() - before;
+            break;
+        }
+        case BENCH_PHASE_PARSE_SUCCESS: {
+            double before = bench_now();
+            pm_parse_success_p(start, length, NULL);
+            elapsed = bench_now() - before;
+            break;
+        }
+        case BENCH_PHASE_LEX: {
+            pm_lex_tokens_callback_t callback = { .data = NULL, .callback = bench_lex_tokens };
+
+            double before = bench_now();
+            pm_parser_init(&parser, start, length, NULL);
+            pm_lex(&parser, &callback);
+            pm_parser_free(&parser);
+            elapsed = bench_now() - before;
+            break;
+        }
+        case BENCH_PHASE_SERIALIZE: {
+            // Only the allocations made while serializing are counted, so the
+            // counters are put back to how they were before the tree was
+            // parsed once the serialization is done.
+            size_t allocations = bench_counters.allocations;
+            size_t allocated = bench_counters.allocated;
+            size_t peak = bench_counters.peak;
+
+            pm_parser_init(&parser, start, length, NULL);
+            pm_parser_arena_set(&parser, &arena);
+            pm_node_t *node = pm_parse(&parser);
+
+            size_t parsed_allocations = bench_counters.allocations;
+            size_t parsed_allocated = bench_counters.allocated;
+            size_t parsed_live = bench_counters.live;
+            bench_counters.peak = parsed_live;
+
+            pm_buffer_t buffer = { 0 };
+            double before = bench_now();
+            pm_serialize(&parser, node, &buffer);
+            pm_buffer_free(&buffer);
+            elapsed = bench_now() - before;
+
+            allocations += bench_counters.allocations - parsed_allocations;
+            allocated += bench_counters.allocated - parsed_allocated;
+            size_t serialize_peak = bench_counters.peak - parsed_live;
+
+            pm_parser_free(&parser);
+            pm_arena_free(&arena);
+
+            bench_counters.allocations = allocations;
+            bench_counters.allocated = allocated;
+            if (bench_counters.live + serialize_peak > peak) peak = bench_counters.live + serialize_peak;
+            bench_counters.peak = peak;
+            break;
+        }
+        case BENCH_PHASE_SIZE:
+            assert(false && "unreachable");
+            break;
+    }
+
+    return elapsed;
+}
+
+/**
+ * Run one phase over the whole corpus the given number of times, and return the
+ * fastest of the runs. Allocations are counted on the first run, since every
+ * run makes the same allocations.
+ */
+static bench_result_t
+bench_phase(bench_phase_t phase, const bench_corpus_t *corpus, int iterations) {
+    bench_result_t result = { 0 };
+
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        bench_counters.allocations = 0;
+        bench_counters.allocated = 0;
+        bench_counters.peak = bench_counters.live;
+
+        size_t base = bench_counters.live;
+        double elapsed = 0;
+
+        for (size_t index = 0; index < corpus->size; index++) {
+            elapsed += bench_run(phase, &corpus->sources[index]);
+        }
+
+        if (iteration == 0 || elapsed < result.seconds) result.seconds = elapsed;
+
+        if (iteration == 0) {
+            result.allocations = bench_counters.allocations;
+            result.allocated = bench_counters.allocated;
+            result.peak = bench_counters.peak - base;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Returns the peak resident set size of the process in kilobytes.
+ */
+static long
+bench_peak_rss(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+/**
+ * Print how to use the tool to the given stream.
+ */
+static void
+bench_usage(FILE *stream) {
+    fprintf(stream, "usage: prism-bench [-n ITERATIONS] [-o OUTPUT] [-l LIST] PATH...\n");
+    fprintf(stream, "    -n ITERATIONS  the number of times to run each phase (default: 5)\n");
+    fprintf(stream, "    -o OUTPUT      write the JSON results to OUTPUT instead of stdout\n");
+    fprintf(stream, "    -l LIST        also benchmark the paths listed in LIST, one per line (- for stdin)\n");
+}
+
+int
+main(int argc, char **argv) {
+    prism_paths_t paths = { 0 };
+    const char *output_path = NULL;
+    int iterations = 5;
+    bool found = true;
+    int option;
+
+    while ((option = getopt(argc, argv, "hl:n:o:")) != -1) {
+        switch (option) {
+            case 'l': {
+                if (strcmp(optarg, "-") == 0) {
+                    found &= prism_paths_add_list(&paths, "prism-bench", stdin);
+                } else {
+                    FILE *list = fopen(optarg, "r");
+
+                    if (list == NULL) {
+                        fprintf(stderr, "prism-bench: %s: %s\n", optarg, strerror(errno));
+                        return 2;
+                    }
+
+                    found &= prism_paths_add_list(&paths, "prism-bench", list);
+                    fclose(list);
+                }
+                break;
+            }
+            case 'n': {
+                char *end;
+                long value = strtol(optarg, &end, 10);
+
+                if (*end != '\0' || value < 1 || value > 1000) {
+                    fprintf(stderr, "prism-bench: invalid number of iterations: %s\n", optarg);
+                    return 2;
+                }
+
+                iterations = (int) value;
+                break;
+            }
+            case 'o':
+                output_path = optarg;
+                break;
+            case 'h':
+                bench_usage(stdout);
+                return 0;
+            default:
+                bench_usage(stderr);
+                return 2;
+        }
+    }
+
+    for (int index = optind; index < argc; index++) {
+        found &= prism_paths_add(&paths, "prism-bench", argv[index], true);
+    }
+
+    if (!found) return 2;
+    if (paths.size == 0) {
+        bench_usage(stderr);
+        return 2;
+    }
+
+    bench_corpus_t corpus = { .sources = calloc(paths.size, sizeof(pm_string_t)), .size = 0, .bytes = 0 };
+    if (corpus.sources == NULL) abort();
+
+    for (size_t index = 0; index < paths.size; index++) {
+        if (!pm_string_file_init(&corpus.sources[corpus.size], paths.paths[index])) {
+            fprintf(stderr, "prism-bench: %s: could not be read\n", paths.paths[index]);
+            return 2;
+        }
+
+        corpus.bytes += pm_string_length(&corpus.sources[corpus.size]);
+        corpus.size++;
+    }
+
+    bench_result_t results[BENCH_PHASE_SIZE];
+    for (int phase = 0; phase < BENCH_PHASE_SIZE; phase++) {
+        results[phase] = bench_phase((bench_phase_t) phase, &corpus, iterations);
+    }
+
+    FILE *output = stdout;
+    if (output_path != NULL && (output = fopen(output_path, "w")) == NULL) {
+        fprintf(stderr, "prism-bench: %s: %s\n", output_path, strerror(errno));
+        return 2;
+    }
+
+    double megabytes = ((double) corpus.bytes) / (1024.0 * 1024.0);
+    double kilobytes = ((double) corpus.bytes) / 1024.0;
+
+    fprintf(output, "{\n");
+    fprintf(output, "  \"version\": \"%s\",\n", PRISM_VERSION);
+    fprintf(output, "  \"files\": %zu,\n", corpus.size);
+    fprintf(output, "  \"bytes\": %zu,\n", corpus.bytes);
+    fprintf(output, "  \"iterations\": %d,\n", iterations);
+    fprintf(output, "  \"peak_rss_kb\": %ld,\n", bench_peak_rss());
+    fprintf(output, "  \"phases\": {\n");
+
+    fprintf(stderr, "%zu files (%.2f MB), best of %d\n", corpus.size, megabytes, iterations);
+    fprintf(stderr, "%-14s %10s %10s %12s %14s %14s\n", "phase", "seconds", "MB/s", "files/s", "allocs/KB", "peak heap KB");
+
+    for (int phase = 0; phase < BENCH_PHASE_SIZE; phase++) {
+        const bench_result_t *result = &results[phase];
+        double seconds = result->seconds > 0 ? result->seconds : 1e-9;
+
+        fprintf(output, "    \"%s\": {\n", bench_phase_names[phase]);
+        fprintf(output, "      \"seconds\": %.6f,\n", result->seconds);
+        fprintf(output, "      \"mb_per_s\": %.3f,\n", megabytes / seconds);
+        fprintf(output, "      \"files_per_s\": %.1f,\n", ((double) corpus.size) / seconds);
+        fprintf(output, "      \"allocations\": %zu,\n", result->allocations);
+        fprintf(output, "      \"allocations_per_kb\": %.3f,\n", ((double) result->allocations) / kilobytes);
+        fprintf(output, "      \"allocated_bytes\": %zu,\n", result->allocated);
+        fprintf(output, "      \"peak_heap_bytes\": %zu\n", result->peak);
+        fprintf(output, "    }%s\n", phase == BENCH_PHASE_SIZE - 1 ? "" : ",");
+
+        fprintf(
+            stderr,
+            "%-14s %10.4f %10.2f %12.0f %14.3f %14.1f\n",
+            bench_phase_names[phase],
+            result->seconds,
+            megabytes / seconds,
+            ((double) corpus.size) / seconds,
+            ((double) result->allocations) / kilobytes,
+            ((double) result->peak) / 1024.0
+        );
+    }
+
+    fprintf(output, "  }\n");
+    fprintf(output, "}\n");
+    if (output != stdout) fclose(output);
+
+    for (size_t index = 0; index < corpus.size; index++) pm_string_free(&corpus.sources[index]);
+    free(corpus.sources);
+    prism_paths_free(&paths);
+
+    return 0;
+}
@@ -0,0 +1,276 @@
+/**
+ * @file prism_check.c
+ *
+ * A command line tool that checks the syntax of Ruby files using prism. Files
+ * are memory mapped and parsed in parallel, and any syntax errors are printed
+ * with pm_parser_errors_format. Once every file has been checked, the number of
+ * files and bytes that were parsed per second is printed, so this doubles as a
+ * benchmark for the parser.
+ *
+ *     prism-check [-j THREADS] [-q] [-l LIST] PATH...
+ *
+ * Each PATH is either a file, which is always checked, or a directory, which is
+ * searched recursively for files ending in .rb. If -l is given, paths are also
+ * read from LIST (or from standard input if LIST is -), one per line.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "prism.h"
+#include "prism_paths.h"
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * The list of files to check, along with the state that is shared between all
+ * of the worker threads.
+ */
+typedef struct {
+    /** The paths of the files to check. */
+    prism_paths_t paths;
+
+    /** The index of the next path that a worker should check. */
+    size_t next;
+
+    /** Guards next, and the totals that the workers add to. */
+    pthread_mutex_t lock;
+
+    /** Guards standard output, so that diagnostics are not interleaved. */
+    pthread_mutex_t output_lock;
+
+    /** Whether or not to print the diagnostics of each file. */
+    bool quiet;
+
+    /** Whether or not to colorize the diagnostics. */
+    bool colorize;
+
+    /** The number of bytes that have been parsed. */
+    size_t bytes;
+
+    /** The number of files that had syntax errors. */
+    size_t failed;
+
+    /** The number of files that could not be read. */
+    size_t unreadable;
+} check_t;
+
+/**
+ * Check a single file with the given parser, which is initialized the first
+ * time it is used and reset every time after that.
+ */
+static void
+check_file(check_t *check, const char *path, pm_parser_t *parser, bool *initialized, pm_arena_t *arena, pm_buffer_t *output) {
+    pm_string_t source;
+
+    if (!pm_string_mapped_init(&source, path)) {
+        pthread_mutex_lock(&check->lock);
+        check->unreadable++;
+        pthread_mutex_unlock(&check->lock);
+
+        pthread_mutex_lock(&check->output_lock);
+        fprintf(stderr, "prism-check: %s: could not be read\n", path);
+        pthread_mutex_unlock(&check->output_lock);
+        return;
+    }
+
+    pm_options_t options = { 0 };
+    pm_options_filepath_set(&options, path);
+    pm_options_line_set(&options, 1);
+
+    const uint8_t *start = pm_string_source(&source);
+    size_t length = pm_string_length(&source);
+
+    if (*initialized) {
+        pm_parser_reset(parser, start, length, &options);
+    } else {
+        pm_parser_init(parser, start, length, &options);
+        pm_parser_arena_set(parser, arena);
+        *initialized = true;
+    }
+
+    // When the diagnostics are not going to be printed, all that matters is
+    // whether or not the file is valid.
+    parser->stop_at_first_error = check->quiet;
+    pm_parse(parser);
+
+    bool failed = parser->error_list.size > 0;
+
+    if (failed && !check->quiet) {
+        pm_buffer_clear(output);
+        pm_buffer_append_format(output, "%s: %zu syntax error%s\n", path, parser->error_list.size, parser->error_list.size == 1 ? "" : "s");
+        pm_parser_errors_format(parser, &parser->error_list, output, check->colorize, true);
+
+        size_t output_length = pm_buffer_length(output);
+        if (output_length > 0 && pm_buffer_value(output)[output_length - 1] != '\n') pm_buffer_append_byte(output, '\n');
+
+        pthread_mutex_lock(&check->output_lock);
+        fwrite(pm_buffer_value(output), 1, pm_buffer_length(output), stdout);
+        pthread_mutex_unlock(&check->output_lock);
+    }
+
+    pthread_mutex_lock(&check->lock);
+    check->bytes += length;
+    if (failed) check->failed++;
+    pthread_mutex_unlock(&check->lock);
+
+    pm_options_free(&options);
+    pm_string_free(&source);
+}
+
+/**
+ * The entry point of each worker thread. Each worker keeps its own parser and
+ * arena, and takes the next unchecked file off of the list until there are none
+ * left.
+ */
+static void *
+check_worker(void *argument) {
+    check_t *check = (check_t *) argument;
+
+    pm_parser_t parser;
+    bool initialized = false;
+    pm_arena_t arena = { 0 };
+    pm_buffer_t output = { 0 };
+
+    while (true) {
+        pthread_mutex_lock(&check->lock);
+        size_t index = check->next++;
+        pthread_mutex_unlock(&check->lock);
+
+        if (index >= check->paths.size) break;
+        check_file(check, check->paths.paths[index], &parser, &initialized, &arena, &output);
+    }
+
+    if (initialized) pm_parser_free(&parser);
+    pm_arena_free(&arena);
+    pm_buffer_free(&output);
+
+    return NULL;
+}
+
+/**
+ * Returns the current time in seconds from a monotonic clock.
+ */
+static double
+check_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1e9);
+}
+
+/**
+ * Print how to use the tool to the given stream.
+ */
+static void
+check_usage(FILE *stream) {
+    fprintf(stream, "usage: prism-check [-j THREADS] [-q] [-l LIST] PATH...\n");
+    fprintf(stream, "    -j THREADS  the number of threads to parse with (default: number of CPUs)\n");
+    fprintf(stream, "    -q          do not print diagnostics, only the summary\n");
+    fprintf(stream, "    -l LIST     also check the paths listed in LIST, one per line (- for stdin)\n");
+}
+
+int
+main(int argc, char **argv) {
+    check_t check = { 0 };
+    pthread_mutex_init(&check.lock, NULL);
+    pthread_mutex_init(&check.output_lock, NULL);
+
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    bool found = true;
+    int option;
+
+    while ((option = getopt(argc, argv, "hj:l:q")) != -1) {
+        switch (option) {
+            case 'j': {
+                char *end;
+                threads = strtol(optarg, &end, 10);
+
+                if (*end != '\0' || threads < 1) {
+                    fprintf(stderr, "prism-check: invalid number of threads: %s\n", optarg);
+                    return 2;
+                }
+                break;
+            }
+            case 'l': {
+                if (strcmp(optarg, "-") == 0) {
+                    found &= prism_paths_add_list(&check.paths, "prism-check", stdin);
+                } else {
+                    FILE *list = fopen(optarg, "r");
+
+                    if (list == NULL) {
+                        fprintf(stderr, "prism-check: %s: %s\n", optarg, strerror(errno));
+                        return 2;
+                    }
+
+                    found &= prism_paths_add_list(&check.paths, "prism-check", list);
+                    fclose(list);
+                }
+                break;
+            }
+            case 'q':
+                check.quiet = true;
+                break;
+            case 'h':
+                check_usage(stdout);
+                return 0;
+            default:
+                check_usage(stderr);
+                return 2;
+        }
+    }
+
+    for (int index = optind; index < argc; index++) {
+        found &= prism_paths_add(&check.paths, "prism-check", argv[index], true);
+    }
+
+    if (check.paths.size == 0 && found) {
+        check_usage(stderr);
+        return 2;
+    }
+
+    check.colorize = isatty(STDOUT_FILENO);
+    if (threads < 1) threads = 1;
+    if ((size_t) threads > check.paths.size) threads = (long) (check.paths.size > 0 ? check.paths.size : 1);
+
+    pthread_t *workers = malloc(((size_t) threads) * sizeof(pthread_t));
+    if (workers == NULL) abort();
+
+    double start = check_now();
+
+    for (long index = 0; index < threads; index++) {
+        if (pthread_create(&workers[index], NULL, check_worker, &check) != 0) {
+            fprintf(stderr, "prism-check: could not create thread\n");
+            return 2;
+        }
+    }
+
+    for (long index = 0; index < threads; index++) {
+        pthread_join(workers[index], NULL);
+    }
+
+    double elapsed = check_now() - start;
+    if (elapsed <= 0) elapsed = 1e-9;
+
+    double megabytes = ((double) check.bytes) / (1024.0 * 1024.0);
+    fprintf(
+        stderr,
+        "%zu files (%.2f MB) checked in %.3fs on %ld thread%s, %.2f MB/s, %.0f files/s, %zu with syntax errors\n",
+        check.paths.size,
+        megabytes,
+        elapsed,
+        threads,
+        threads == 1 ? "" : "s",
+        megabytes / elapsed,
+        ((double) check.paths.size) / elapsed,
+        check.failed
+    );
+
+    prism_paths_free(&check.paths);
+    free(workers);
+
+    pthread_mutex_destroy(&check.lock);
+    pthread_mutex_destroy(&check.output_lock);
+
+    if (!found || check.unreadable > 0) return 2;
+    return check.failed > 0 ? 1 : 0;
+}
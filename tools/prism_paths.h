@@ -0,0 +1,139 @@
+/**
+ * @file prism_paths.h
+ *
+ * Collecting the paths of the Ruby files that the command line tools operate
+ * on. This is shared between the tools as a set of static functions, so each
+ * tool that includes it must define _POSIX_C_SOURCE before any other include.
+ */
+#ifndef PRISM_PATHS_H
+#define PRISM_PATHS_H
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+/**
+ * A list of paths to files.
+ */
+typedef struct {
+    /** The paths in the list. */
+    char **paths;
+
+    /** The number of paths in the list. */
+    size_t size;
+
+    /** The number of paths that have been allocated in the list. */
+    size_t capacity;
+} prism_paths_t;
+
+/**
+ * Append a copy of the given path to the list.
+ */
+static inline void
+prism_paths_append(prism_paths_t *paths, const char *path) {
+    if (paths->size == paths->capacity) {
+        paths->capacity = paths->capacity == 0 ? 64 : paths->capacity * 2;
+        paths->paths = realloc(paths->paths, paths->capacity * sizeof(char *));
+        if (paths->paths == NULL) abort();
+    }
+
+    size_t length = strlen(path);
+    char *copy = malloc(length + 1);
+    if (copy == NULL) abort();
+
+    memcpy(copy, path, length + 1);
+    paths->paths[paths->size++] = copy;
+}
+
+/**
+ * Returns true if the given path ends in .rb.
+ */
+static inline bool
+prism_paths_ruby_p(const char *path) {
+    size_t length = strlen(path);
+    return length > 3 && strcmp(path + length - 3, ".rb") == 0;
+}
+
+/**
+ * Add the given path to the list. Directories are searched recursively for
+ * Ruby files, while any other path is added as long as it was named explicitly
+ * or ends in .rb. Errors are reported to stderr prefixed with the given program
+ * name. Returns false if the path could not be found.
+ */
+static inline bool
+prism_paths_add(prism_paths_t *paths, const char *program, const char *path, bool explicit) {
+    struct stat status;
+
+    if (stat(path, &status) != 0) {
+        fprintf(stderr, "%s: %s: %s\n", program, path, strerror(errno));
+        return false;
+    }
+
+    if (!S_ISDIR(status.st_mode)) {
+        if (explicit || prism_paths_ruby_p(path)) prism_paths_append(paths, path);
+        return true;
+    }
+
+    DIR *directory = opendir(path);
+    if (directory == NULL) {
+        fprintf(stderr, "%s: %s: %s\n", program, path, strerror(errno));
+        return false;
+    }
+
+    bool result = true;
+    size_t path_length = strlen(path);
+    struct dirent *entry;
+
+    while ((entry = readdir(directory)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+
+        size_t name_length = strlen(entry->d_name);
+        char *child = malloc(path_length + name_length + 2);
+        if (child == NULL) abort();
+
+        memcpy(child, path, path_length);
+        child[path_length] = '/';
+        memcpy(child + path_length + 1, entry->d_name, name_length + 1);
+
+        result &= prism_paths_add(paths, program, child, false);
+        free(child);
+    }
+
+    closedir(directory);
+    return result;
+}
+
+/**
+ * Add each of the paths listed in the given stream, one per line.
+ */
+static inline bool
+prism_paths_add_list(prism_paths_t *paths, const char *program, FILE *stream) {
+    bool result = true;
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+
+    while ((length = getline(&line, &capacity, stream)) != -1) {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) line[--length] = '\0';
+        if (length > 0) result &= prism_paths_add(paths, program, line, true);
+    }
+
+    free(line);
+    return result;
+}
+
+/**
+ * Free the memory associated with the list.
+ */
+static inline void
+prism_paths_free(prism_paths_t *paths) {
+    for (size_t index = 0; index < paths->size; index++) free(paths->paths[index]);
+    free(paths->paths);
+}
+
+#endif
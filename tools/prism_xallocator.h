@@ -0,0 +1,30 @@
+/**
+ * @file prism_xallocator.h
+ *
+ * The allocator that prism-bench compiles prism with through the
+ * PRISM_XALLOCATOR define, so that it can count every allocation that the
+ * parser makes. The functions are defined in prism_bench.c.
+ */
+#ifndef PRISM_XALLOCATOR_H
+#define PRISM_XALLOCATOR_H
+
+#include <stddef.h>
+
+/** Allocate memory, counting the allocation. */
+void * prism_bench_malloc(size_t size);
+
+/** Reallocate memory, counting the allocation. */
+void * prism_bench_realloc(void *pointer, size_t size);
+
+/** Allocate zeroed memory, counting the allocation. */
+void * prism_bench_calloc(size_t count, size_t size);
+
+/** Free memory, counting the free. */
+void prism_bench_free(void *pointer);
+
+#define xmalloc prism_bench_malloc
+#define xrealloc prism_bench_realloc
+#define xcalloc prism_bench_calloc
+#define xfree prism_bench_free
+
+#endif